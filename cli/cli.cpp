@@ -12,6 +12,32 @@ static const char help[] =
   "  --list                       List devices connected to computer.\n"
   "  --pause                      Pause program at the end.\n"
   "  --pause-on-error             Pause program at the end if an error happens.\n"
+  "  --script FILE                Run options from a file, one line at a time.\n"
+  "  --stdin-commands             Run options from standard input, one line at a\n"
+  "                               time.\n"
+  "  --timing                     Print how long it took to find the device,\n"
+  "                               open it, do the first transfer, and run the\n"
+  "                               rest of the commands.  With --script\n"
+  "                               or --stdin-commands, also print how long each\n"
+  "                               line took.  The times go to standard error.\n"
+  "  --stats                      Print statistics about the transfers to the\n"
+  "                               device to standard error at the end.\n"
+  "  --via-daemon                 Send commands through " DAEMON_NAME " instead of\n"
+  "                               opening the device directly.\n"
+  "  --emulate PRODUCT            Use an emulated Tic instead of a real one.\n"
+  "                               PRODUCT is T825, T834, T500, N825, T249, or\n"
+  "                               36v4.\n"
+  "  --gcode FILE                 Run G-code from FILE on the Tics given by --axis.\n"
+  "  --axis L:SERIAL[:SCALE]      Drive G-code axis L (e.g. X) with the Tic with\n"
+  "                               that serial number.  SCALE is the number of\n"
+  "                               microsteps per unit (default 1).\n"
+  "  --serve-metrics ADDR         Keep running and serve the variables of the\n"
+  "                               device (or of every connected device if there\n"
+  "                               are several) as OpenMetrics text over HTTP.\n"
+  "                               ADDR is PORT, HOST:PORT, or unix:PATH.  With\n"
+  "                               no HOST, only local clients can connect.\n"
+  "  --metrics-interval MS        How often to read the variables for\n"
+  "                               --serve-metrics (default 1000).\n"
   "  -h, --help                   Show this help screen.\n"
   "\n"
   "Control commands:\n"
@@ -21,6 +47,13 @@ static const char help[] =
   "  --halt-and-set-position NUM  Set where the controller thinks it currently is.\n"
   "  --halt-and-hold              Abruptly stop the motor.\n"
   "  --home DIR                   Drive to limit switch; DIR is 'fwd' or 'rev'.\n"
+  "  --stream FILE                Send the timed targets from FILE (see below).\n"
+  "  --stream-max-late MS         Skip streamed targets this late (default 0:\n"
+  "                               never skip).\n"
+  "  --wait                       Wait until the target position is reached.\n"
+  "  --wait-home                  Wait until homing is complete.\n"
+  "  --wait-timeout MS            Give up waiting after this many ms (default\n"
+  "                               60000).\n"
   "  --reset-command-timeout      Clears the command timeout error.\n"
   "  --deenergize                 Disable the motor driver.\n"
   "  --energize                   Stop disabling the driver.\n"
@@ -57,6 +90,19 @@ static const char help[] =
   "  --get-settings FILE          Read device settings and write to file.\n"
   "  --fix-settings IN OUT        Read settings from a file and fix them.\n"
   "\n"
+  "Stream files for --stream have one target per line, with the time in ms\n"
+  "since the start, 'position' or 'velocity', and the target, separated by\n"
+  "commas (e.g. '12.5,position,400').  Lines starting with '#' are ignored.\n"
+  "Binary stream files start with 'TICSTRM1', followed by 16-byte little-endian\n"
+  "records: a 64-bit time in us, a 32-bit target, an 8-bit command (1 for\n"
+  "position, 2 for velocity), and 3 reserved bytes.\n"
+  "\n"
+  "G-code for --gcode can use G0, G1 (with F in units per minute), G4 (P in ms\n"
+  "or S in s), G28, G21, G90, G91, M17 (energize and exit safe start), and\n"
+  "M18/M84 (de-energize).  G28 homes in reverse, or forward for axes given a\n"
+  "positive value (e.g. 'G28 X1').  With --emulate, each axis uses its own\n"
+  "emulated Tic.\n"
+  "\n"
   "For more help, see: " DOCUMENTATION_URL "\n"
   "\n";
 
@@ -77,6 +123,28 @@ struct arguments
 
   bool show_help = false;
 
+  bool run_script = false;
+  std::string script_filename;
+
+  bool stdin_commands = false;
+
+  bool timing = false;
+
+  bool show_stats = false;
+
+  bool via_daemon = false;
+
+  bool emulate = false;
+  uint8_t emulated_product = 0;
+
+  bool run_gcode = false;
+  std::string gcode_filename;
+  std::vector<gcode_axis> gcode_axes;
+
+  bool serve_metrics = false;
+  std::string serve_metrics_address;
+  uint32_t metrics_interval_ms = 1000;
+
   bool set_target_position = false;
   int32_t target_position;
 
@@ -94,6 +162,17 @@ struct arguments
   bool go_home = false;
   uint8_t homing_direction;
 
+  bool stream = false;
+  std::string stream_filename;
+
+  uint32_t stream_max_late_ms = 0;
+
+  bool wait_for_position = false;
+
+  bool wait_for_homing = false;
+
+  uint32_t wait_timeout_ms = 60000;
+
   bool reset_command_timeout = false;
 
   bool deenergize = false;
@@ -162,12 +241,19 @@ struct arguments
     return show_status ||
       show_list ||
       show_help ||
+      run_script ||
+      stdin_commands ||
+      run_gcode ||
+      serve_metrics ||
       set_target_position ||
       set_target_position_relative ||
       set_target_velocity ||
       halt_and_set_position ||
       halt_and_hold ||
       go_home ||
+      stream ||
+      wait_for_position ||
+      wait_for_homing ||
       reset_command_timeout ||
       deenergize ||
       energize ||
@@ -445,6 +531,62 @@ static uint8_t parse_arg_homing_direction(arg_reader & arg_reader)
   }
 }
 
+static uint8_t parse_arg_product(arg_reader & arg_reader)
+{
+  std::string str = parse_arg_string(arg_reader);
+  for (uint8_t product = 1; product <= TIC_PRODUCT_36V4; product++)
+  {
+    std::string name = tic_look_up_product_name_short(product);
+    if (str.size() == name.size() &&
+      std::equal(str.begin(), str.end(), name.begin(),
+        [](char a, char b) { return tolower(a) == tolower(b); }))
+    {
+      return product;
+    }
+  }
+  throw exception_with_exit_code(EXIT_BAD_ARGS,
+    "The product specified is invalid.");
+}
+
+static gcode_axis parse_arg_gcode_axis(arg_reader & arg_reader)
+{
+  std::string str = parse_arg_string(arg_reader);
+  auto bad_axis = [&]() {
+    return exception_with_exit_code(EXIT_BAD_ARGS,
+      "The axis after '" + std::string(arg_reader.last()) + "' is invalid.  "
+      "Expected LETTER:SERIALNUMBER or LETTER:SERIALNUMBER:SCALE.");
+  };
+
+  gcode_axis axis;
+  size_t first_colon = str.find(':');
+  if (first_colon != 1 || !std::isalpha((unsigned char)str[0]))
+  {
+    throw bad_axis();
+  }
+  axis.letter = (char)std::toupper((unsigned char)str[0]);
+  if (std::string("GMNFPS").find(axis.letter) != std::string::npos)
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "The letter " + std::string(1, axis.letter) + " cannot be used for an axis.");
+  }
+
+  size_t second_colon = str.find(':', first_colon + 1);
+  axis.serial_number = str.substr(first_colon + 1,
+    second_colon == std::string::npos ? std::string::npos :
+    second_colon - first_colon - 1);
+  if (axis.serial_number.empty()) { throw bad_axis(); }
+
+  if (second_colon != std::string::npos)
+  {
+    std::string scale = str.substr(second_colon + 1);
+    char * end;
+    axis.steps_per_unit = strtod(scale.c_str(), &end);
+    if (scale.empty() || *end || !(axis.steps_per_unit > 0)) { throw bad_axis(); }
+  }
+
+  return axis;
+}
+
 static arguments parse_args(int argc, char ** argv)
 {
   arg_reader arg_reader(argc, argv);
@@ -497,6 +639,57 @@ static arguments parse_args(int argc, char ** argv)
     {
       args.show_help = true;
     }
+    else if (arg == "--script")
+    {
+      args.run_script = true;
+      args.stdin_commands = false;
+      args.script_filename = parse_arg_string(arg_reader);
+    }
+    else if (arg == "--stdin-commands")
+    {
+      args.stdin_commands = true;
+      args.run_script = false;
+    }
+    else if (arg == "--timing")
+    {
+      args.timing = true;
+    }
+    else if (arg == "--stats")
+    {
+      args.show_stats = true;
+    }
+    else if (arg == "--via-daemon")
+    {
+      args.via_daemon = true;
+    }
+    else if (arg == "--emulate")
+    {
+      args.emulate = true;
+      args.emulated_product = parse_arg_product(arg_reader);
+    }
+    else if (arg == "--gcode")
+    {
+      args.run_gcode = true;
+      args.gcode_filename = parse_arg_string(arg_reader);
+    }
+    else if (arg == "--axis")
+    {
+      args.gcode_axes.push_back(parse_arg_gcode_axis(arg_reader));
+    }
+    else if (arg == "--serve-metrics")
+    {
+      args.serve_metrics = true;
+      args.serve_metrics_address = parse_arg_string(arg_reader);
+    }
+    else if (arg == "--metrics-interval")
+    {
+      args.metrics_interval_ms = parse_arg_int<uint32_t>(arg_reader);
+      if (args.metrics_interval_ms == 0)
+      {
+        throw exception_with_exit_code(EXIT_BAD_ARGS,
+          "The metrics interval must be at least 1 ms.");
+      }
+    }
     else if (arg == "-p" || arg == "--position")
     {
       args.set_target_position = true;
@@ -528,6 +721,27 @@ static arguments parse_args(int argc, char ** argv)
       args.go_home = true;
       args.homing_direction = parse_arg_homing_direction(arg_reader);
     }
+    else if (arg == "--stream")
+    {
+      args.stream = true;
+      args.stream_filename = parse_arg_string(arg_reader);
+    }
+    else if (arg == "--stream-max-late")
+    {
+      args.stream_max_late_ms = parse_arg_int<uint32_t>(arg_reader);
+    }
+    else if (arg == "--wait")
+    {
+      args.wait_for_position = true;
+    }
+    else if (arg == "--wait-home")
+    {
+      args.wait_for_homing = true;
+    }
+    else if (arg == "--wait-timeout")
+    {
+      args.wait_timeout_ms = parse_arg_int<uint32_t>(arg_reader);
+    }
     else if (arg == "--reset-command-timeout")
     {
       args.reset_command_timeout = true;
@@ -655,10 +869,9 @@ static arguments parse_args(int argc, char ** argv)
   return args;
 }
 
-static tic::handle handle(device_selector & selector)
+static tic::handle & handle(device_selector & selector)
 {
-  tic::device device = selector.select_device();
-  return tic::handle(device);
+  return selector.select_handle();
 }
 
 static void print_list(device_selector & selector)
@@ -672,27 +885,10 @@ static void print_list(device_selector & selector)
   }
 }
 
-static void set_current_limit_after_warning(device_selector & selector, uint32_t current_limit)
-{
-  tic::handle handle = ::handle(selector);
-  uint8_t product = handle.get_device().get_product();
-
-  uint32_t max_current = tic_get_max_allowed_current(product);
-  if (current_limit > max_current)
-  {
-    current_limit = max_current;
-    std::cerr
-      << "Warning: The current limit was too high "
-      << "so it will be lowered to " << current_limit << " mA." << std::endl;
-  }
-
-  handle.set_current_limit(current_limit);
-}
-
 static void get_status(device_selector & selector, bool full_output)
 {
   tic::device device = selector.select_device();
-  tic::handle handle(device);
+  tic::handle & handle = ::handle(selector);
   tic::settings settings = handle.get_settings();
   tic::variables vars = handle.get_variables(true);
   std::string name = device.get_name();
@@ -737,8 +933,8 @@ static void set_settings(device_selector & selector,
   settings.fix(&warnings);
   std::cerr << warnings;
 
-  tic::handle handle(device);
-  handle.set_settings(settings);
+  tic::handle & handle = ::handle(selector);
+  handle.set_settings_diff(settings);
   handle.reinitialize();
 }
 
@@ -755,21 +951,9 @@ static void fix_settings(const std::string & input_filename,
   write_string_to_file_or_pipe(output_filename, settings.to_string());
 }
 
-static void set_target_position_relative(device_selector & selector,
-  int32_t target_position_relative)
-{
-  tic::device device = selector.select_device();
-  tic::handle handle(device);
-  tic::variables variables = handle.get_variables();
-  int32_t position = (uint32_t)variables.get_current_position() +
-    (uint32_t)target_position_relative;
-  handle.set_target_position(position);
-}
-
 static void print_debug_data(device_selector & selector)
 {
-  tic::device device = selector.select_device();
-  tic::handle handle(device);
+  tic::handle & handle = ::handle(selector);
 
   std::vector<uint8_t> data(4096, 0);
   handle.get_debug_data(data);
@@ -801,15 +985,30 @@ static void test_procedure(device_selector & selector, uint32_t procedure)
   {
     tic::device device = selector.select_device();
     tic::handle handle(device);
+    tic::variables vars;
+    const uint32_t fields = TIC_VARIABLES_FIELD_PIN_INFO |
+      TIC_VARIABLES_FIELD_TARGET_POSITION |
+      TIC_VARIABLES_FIELD_ACTING_TARGET_POSITION |
+      TIC_VARIABLES_FIELD_CURRENT_POSITION |
+      TIC_VARIABLES_FIELD_CURRENT_VELOCITY;
+    tic::monitor monitor(handle, 1000, 1024, fields);
+    monitor.start();
     while (1)
     {
-      tic::variables vars = handle.get_variables();
-      std::cout << vars.get_analog_reading(TIC_PIN_NUM_SDA) << ','
-                << vars.get_target_position() << ','
-                << vars.get_acting_target_position() << ','
-                << vars.get_current_position() << ','
-                << vars.get_current_velocity() << ','
-                << std::endl;
+      uint64_t host_time_us;
+      while (monitor.read_sample(vars, &host_time_us))
+      {
+        std::cout << host_time_us << ','
+                  << vars.get_up_time() << ','
+                  << vars.get_analog_reading(TIC_PIN_NUM_SDA) << ','
+                  << vars.get_target_position() << ','
+                  << vars.get_acting_target_position() << ','
+                  << vars.get_current_position() << ','
+                  << vars.get_current_velocity() << ','
+                  << std::endl;
+      }
+      if (!monitor.is_running()) { monitor.throw_if_failed(); }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
   }
   else if (procedure == 3)
@@ -878,27 +1077,331 @@ static void test_procedure(device_selector & selector, uint32_t procedure)
   }
 }
 
-// A note about ordering: We want to do all the setting stuff first because it
-// could affect subsequent options.  We want to show the status last, because it
-// could be affected by options before it.
-static void run(const arguments & args)
+static const char stream_file_magic[] = "TICSTRM1";
+
+static void add_binary_stream_points(tic::streamer & streamer,
+  const std::string & contents)
 {
-  if (args.show_help || !args.action_specified())
+  const size_t header_size = sizeof(stream_file_magic) - 1;
+  const size_t record_size = 16;
+  if ((contents.size() - header_size) % record_size)
   {
-    std::cout << help;
-    return;
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "The binary stream file has an incomplete record at the end.");
   }
 
-  device_selector selector;
-  if (args.serial_number_specified)
+  const uint8_t * p = (const uint8_t *)contents.data() + header_size;
+  const uint8_t * end = (const uint8_t *)contents.data() + contents.size();
+  for (size_t record = 1; p < end; p += record_size, record++)
   {
-    selector.specify_serial_number(args.serial_number);
+    uint64_t time_us = 0;
+    for (int i = 7; i >= 0; i--) { time_us = time_us << 8 | p[i]; }
+    uint32_t value = p[8] | p[9] << 8 | p[10] << 16 | (uint32_t)p[11] << 24;
+    try
+    {
+      streamer.add_point(time_us, p[12], (int32_t)value);
+    }
+    catch (const tic::error & error)
+    {
+      throw exception_with_exit_code(EXIT_BAD_ARGS,
+        "Record " + std::to_string(record) + " of the stream file: " +
+        error.message());
+    }
   }
+}
 
-  if (args.show_list)
+static void add_text_stream_points(tic::streamer & streamer,
+  const std::string & contents)
+{
+  std::istringstream input(contents);
+  std::string line;
+  for (uint32_t line_number = 1; std::getline(input, line); line_number++)
+  {
+    size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#') { continue; }
+
+    std::istringstream fields(line);
+    std::string time_str, command_str, value_str;
+    std::getline(fields, time_str, ',');
+    std::getline(fields, command_str, ',');
+    std::getline(fields, value_str);
+
+    auto trim = [](std::string & str) {
+      size_t first = str.find_first_not_of(" \t\r");
+      size_t last = str.find_last_not_of(" \t\r");
+      str = first == std::string::npos ? "" : str.substr(first, last - first + 1);
+    };
+    trim(time_str);
+    trim(command_str);
+    trim(value_str);
+
+    auto bad_line = [&](const std::string & what) {
+      return exception_with_exit_code(EXIT_BAD_ARGS,
+        "Line " + std::to_string(line_number) + " of the stream file: " + what);
+    };
+
+    char * time_end;
+    double time_ms = strtod(time_str.c_str(), &time_end);
+    if (time_str.empty() || *time_end || !(time_ms >= 0))
+    {
+      throw bad_line("Invalid time.");
+    }
+
+    uint8_t command;
+    if (command_str == "position" || command_str == "p")
+    {
+      command = TIC_STREAM_TARGET_POSITION;
+    }
+    else if (command_str == "velocity" || command_str == "v")
+    {
+      command = TIC_STREAM_TARGET_VELOCITY;
+    }
+    else
+    {
+      throw bad_line("Expected 'position' or 'velocity'.");
+    }
+
+    int32_t value;
+    if (string_to_int(value_str.c_str(), &value))
+    {
+      throw bad_line("Invalid target.");
+    }
+
+    try
+    {
+      streamer.add_point((uint64_t)(time_ms * 1000 + 0.5), command, value);
+    }
+    catch (const tic::error & error)
+    {
+      throw bad_line(error.message());
+    }
+  }
+}
+
+static void print_latency_histogram(std::ostream & out, const char * name,
+  const std::vector<uint32_t> & counts)
+{
+  out << name << ":" << std::endl;
+  for (size_t i = 0; i < counts.size(); i++)
   {
-    print_list(selector);
-    return;
+    if (counts[i] == 0) { continue; }
+    std::ostringstream range;
+    if (i == 0) { range << "< 1 us"; }
+    else if (i + 1 == counts.size()) { range << ">= " << (1ull << (i - 1)) << " us"; }
+    else { range << (1ull << (i - 1)) << "-" << (1ull << i) << " us"; }
+    out << "  " << std::left << std::setw(20) << range.str()
+      << std::right << counts[i] << std::endl;
+  }
+}
+
+static void stream_targets(device_selector & selector,
+  const std::string & filename, uint32_t max_late_ms)
+{
+  tic::streamer streamer(handle(selector), max_late_ms * 1000);
+
+  std::string contents = read_string_from_file_or_pipe(filename);
+  if (contents.compare(0, sizeof(stream_file_magic) - 1, stream_file_magic) == 0)
+  {
+    add_binary_stream_points(streamer, contents);
+  }
+  else
+  {
+    add_text_stream_points(streamer, contents);
+  }
+
+  streamer.start();
+  streamer.wait();
+  streamer.throw_if_failed();
+
+  std::cout << "Points sent: " << streamer.get_sent_count() << std::endl;
+  std::cout << "Points merged: " << streamer.get_merged_count() << std::endl;
+  std::cout << "Points dropped: " << streamer.get_dropped_count() << std::endl;
+  std::cout << "Max jitter: " << streamer.get_max_jitter_us() << " us" << std::endl;
+  std::cout << "Max latency: " << streamer.get_max_latency_us() << " us" << std::endl;
+  print_latency_histogram(std::cout, "Jitter",
+    streamer.get_jitter_histogram());
+  print_latency_histogram(std::cout, "Latency",
+    streamer.get_latency_histogram());
+}
+
+void print_handle_stats(const tic::handle_stats & stats)
+{
+  std::cerr << std::left << std::setw(40) << "Command" << std::right
+    << std::setw(10) << "Transfers" << std::setw(8) << "Errors"
+    << std::setw(10) << "Timeouts" << std::setw(10) << "Bytes"
+    << std::setw(10) << "Avg us" << std::setw(10) << "Max us" << std::endl;
+
+  uint32_t total_transfers = 0, total_errors = 0, total_timeouts = 0;
+  uint32_t total_max = 0;
+  uint64_t total_bytes = 0, total_latency = 0;
+  std::vector<uint32_t> total_histogram(TIC_HANDLE_STATS_HISTOGRAM_SIZE);
+
+  auto print_row = [](const std::string & name, uint32_t transfers,
+    uint32_t errors, uint32_t timeouts, uint64_t bytes, uint64_t latency,
+    uint32_t max) {
+    std::cerr << std::left << std::setw(40) << name << std::right
+      << std::setw(10) << transfers << std::setw(8) << errors
+      << std::setw(10) << timeouts << std::setw(10) << bytes
+      << std::setw(10) << (transfers ? latency / transfers : 0)
+      << std::setw(10) << max << std::endl;
+  };
+
+  for (uint32_t request = 0; request < 256; request++)
+  {
+    uint32_t transfers = stats.get_transfer_count(request);
+    if (transfers == 0) { continue; }
+
+    std::ostringstream name;
+    name << tic_look_up_command_name_ui(request) << " (0x"
+      << std::hex << std::uppercase << std::setfill('0') << std::setw(2)
+      << request << ")";
+    print_row(name.str(), transfers, stats.get_error_count(request),
+      stats.get_timeout_count(request), stats.get_byte_count(request),
+      stats.get_total_latency_us(request), stats.get_max_latency_us(request));
+
+    total_transfers += transfers;
+    total_errors += stats.get_error_count(request);
+    total_timeouts += stats.get_timeout_count(request);
+    total_bytes += stats.get_byte_count(request);
+    total_latency += stats.get_total_latency_us(request);
+    total_max = std::max(total_max, stats.get_max_latency_us(request));
+    std::vector<uint32_t> histogram = stats.get_latency_histogram(request);
+    for (size_t i = 0; i < histogram.size(); i++)
+    {
+      total_histogram[i] += histogram[i];
+    }
+  }
+
+  print_row("Total", total_transfers, total_errors, total_timeouts,
+    total_bytes, total_latency, total_max);
+  print_latency_histogram(std::cerr, "Latency", total_histogram);
+}
+
+// run_actions() does its work through one of these, so that the same actions
+// run in the same order whether we open the device ourselves or send requests
+// to the daemon.
+class action_target
+{
+public:
+  virtual ~action_target() = default;
+
+  // Sends a command with one of the TIC_CMD_* codes.  The value is encoded
+  // the same way as in TICD_REQUEST_COMMAND.
+  virtual void command(uint8_t cmd, int32_t value = 0) = 0;
+
+  virtual uint8_t get_product() = 0;
+  virtual int32_t get_current_position() = 0;
+  virtual void get_settings(const std::string & filename) = 0;
+  virtual void set_settings(const std::string & filename) = 0;
+  virtual void restore_defaults() = 0;
+  virtual void wait_for_homing(uint32_t timeout_ms) = 0;
+  virtual void wait_for_position(uint32_t timeout_ms) = 0;
+  virtual void show_status(bool full_output) = 0;
+
+  // Returns the device selector, for actions that need to use the device
+  // directly.  Returns NULL if we are going through the daemon.
+  virtual device_selector * get_selector() = 0;
+};
+
+// Talks to the device directly.
+class direct_target : public action_target
+{
+public:
+  explicit direct_target(device_selector & selector) : selector(selector)
+  {
+  }
+
+  void command(uint8_t cmd, int32_t value) override
+  {
+    if (!ticd_run_command(handle(selector), cmd, value))
+    {
+      throw std::logic_error("Unknown command.");
+    }
+  }
+
+  uint8_t get_product() override
+  {
+    return handle(selector).get_device().get_product();
+  }
+
+  int32_t get_current_position() override
+  {
+    return handle(selector).get_variables().get_current_position();
+  }
+
+  void get_settings(const std::string & filename) override
+  {
+    ::get_settings(selector, filename);
+  }
+
+  void set_settings(const std::string & filename) override
+  {
+    ::set_settings(selector, filename);
+  }
+
+  void restore_defaults() override
+  {
+    ::restore_defaults(selector);
+  }
+
+  void wait_for_homing(uint32_t timeout_ms) override
+  {
+    handle(selector).wait_for_homing_complete(timeout_ms);
+  }
+
+  void wait_for_position(uint32_t timeout_ms) override
+  {
+    handle(selector).wait_for_position_reached(timeout_ms);
+  }
+
+  void show_status(bool full_output) override
+  {
+    get_status(selector, full_output);
+  }
+
+  device_selector * get_selector() override
+  {
+    return &selector;
+  }
+
+private:
+  device_selector & selector;
+};
+
+static void set_current_limit_after_warning(action_target & target,
+  uint32_t current_limit)
+{
+  uint32_t max_current = tic_get_max_allowed_current(target.get_product());
+  if (current_limit > max_current)
+  {
+    current_limit = max_current;
+    std::cerr
+      << "Warning: The current limit was too high "
+      << "so it will be lowered to " << current_limit << " mA." << std::endl;
+  }
+
+  target.command(TIC_CMD_SET_CURRENT_LIMIT, current_limit);
+}
+
+static void set_target_position_relative(action_target & target,
+  int32_t target_position_relative)
+{
+  int32_t position = (uint32_t)target.get_current_position() +
+    (uint32_t)target_position_relative;
+  target.command(TIC_CMD_SET_TARGET_POSITION, position);
+}
+
+// A note about ordering: We want to do all the setting stuff first because it
+// could affect subsequent options.  We want to show the status last, because it
+// could be affected by options before it.
+static void run_actions(const arguments & args, action_target & target)
+{
+  device_selector * selector = target.get_selector();
+  if (selector == NULL &&
+    (args.get_debug_data || args.test_procedure || args.stream))
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "That option cannot be used with --via-daemon.");
   }
 
   if (args.fix_settings)
@@ -909,158 +1412,658 @@ static void run(const arguments & args)
 
   if (args.get_settings)
   {
-    get_settings(selector, args.get_settings_filename);
+    target.get_settings(args.get_settings_filename);
   }
 
   if (args.restore_defaults)
   {
-    restore_defaults(selector);
+    target.restore_defaults();
   }
 
   if (args.set_settings)
   {
-    set_settings(selector, args.set_settings_filename);
+    target.set_settings(args.set_settings_filename);
   }
 
   if (args.reset)
   {
-    handle(selector).reset();
+    target.command(TIC_CMD_RESET);
   }
 
   if (args.set_max_speed)
   {
-    handle(selector).set_max_speed(args.max_speed);
+    target.command(TIC_CMD_SET_MAX_SPEED, args.max_speed);
   }
 
   if (args.set_starting_speed)
   {
-    handle(selector).set_starting_speed(args.starting_speed);
+    target.command(TIC_CMD_SET_STARTING_SPEED, args.starting_speed);
   }
 
   if (args.set_max_accel)
   {
-    handle(selector).set_max_accel(args.max_accel);
+    target.command(TIC_CMD_SET_MAX_ACCEL, args.max_accel);
   }
 
   if (args.set_max_decel)
   {
-    handle(selector).set_max_decel(args.max_decel);
+    target.command(TIC_CMD_SET_MAX_DECEL, args.max_decel);
   }
 
   // Should be before any commands that might start the motor moving again so
   // the Tic does not mistakenly use an old target value for a few milliseconds.
   if (args.set_target_position)
   {
-    handle(selector).set_target_position(args.target_position);
+    target.command(TIC_CMD_SET_TARGET_POSITION, args.target_position);
   }
 
   if (args.set_target_position_relative)
   {
-    set_target_position_relative(selector, args.target_position_relative);
+    set_target_position_relative(target, args.target_position_relative);
   }
 
   // Should be before any commands that might start the motor moving again so
   // the Tic does not mistakenly use an old target value for a few milliseconds.
   if (args.set_target_velocity)
   {
-    handle(selector).set_target_velocity(args.target_velocity);
+    target.command(TIC_CMD_SET_TARGET_VELOCITY, args.target_velocity);
   }
 
   if (args.halt_and_hold)
   {
-    handle(selector).halt_and_hold();
+    target.command(TIC_CMD_HALT_AND_HOLD);
   }
 
   if (args.go_home)
   {
-    handle(selector).go_home(args.homing_direction);
+    target.command(TIC_CMD_GO_HOME, args.homing_direction);
   }
 
   if (args.reset_command_timeout)
   {
-    handle(selector).reset_command_timeout();
+    target.command(TIC_CMD_RESET_COMMAND_TIMEOUT);
   }
 
   if (args.energize)
   {
-    handle(selector).energize();
+    target.command(TIC_CMD_ENERGIZE);
   }
 
   // This should be after energize so that --resume does things in the same
   // order as the GUI.
   if (args.exit_safe_start)
   {
-    handle(selector).exit_safe_start();
+    target.command(TIC_CMD_EXIT_SAFE_START);
   }
 
   if (args.enter_safe_start)
   {
-    handle(selector).enter_safe_start();
+    target.command(TIC_CMD_ENTER_SAFE_START);
   }
 
   if (args.halt_and_set_position)
   {
-    handle(selector).halt_and_set_position(args.position);
+    target.command(TIC_CMD_HALT_AND_SET_POSITION, args.position);
   }
 
   if (args.set_step_mode)
   {
-    handle(selector).set_step_mode(args.step_mode);
+    target.command(TIC_CMD_SET_STEP_MODE, args.step_mode);
   }
 
   if (args.set_current_limit)
   {
-    set_current_limit_after_warning(selector, args.current_limit);
+    set_current_limit_after_warning(target, args.current_limit);
   }
 
   if (args.set_decay_mode)
   {
-    handle(selector).set_decay_mode(args.decay_mode);
+    target.command(TIC_CMD_SET_DECAY_MODE, args.decay_mode);
   }
 
   if (args.set_agc_mode)
   {
-    handle(selector).set_agc_mode(args.agc_mode);
+    target.command(TIC_CMD_SET_AGC_OPTION,
+      TIC_AGC_OPTION_MODE << 4 | args.agc_mode);
   }
 
   if (args.set_agc_bottom_current_limit)
   {
-    handle(selector).set_agc_bottom_current_limit(args.agc_bottom_current_limit);
+    target.command(TIC_CMD_SET_AGC_OPTION,
+      TIC_AGC_OPTION_BOTTOM_CURRENT_LIMIT << 4 | args.agc_bottom_current_limit);
   }
 
   if (args.set_agc_current_boost_steps)
   {
-    handle(selector).set_agc_current_boost_steps(args.agc_current_boost_steps);
+    target.command(TIC_CMD_SET_AGC_OPTION,
+      TIC_AGC_OPTION_CURRENT_BOOST_STEPS << 4 | args.agc_current_boost_steps);
   }
 
   if (args.set_agc_frequency_limit)
   {
-    handle(selector).set_agc_frequency_limit(args.agc_frequency_limit);
+    target.command(TIC_CMD_SET_AGC_OPTION,
+      TIC_AGC_OPTION_FREQUENCY_LIMIT << 4 | args.agc_frequency_limit);
   }
 
   if (args.clear_driver_error)
   {
-    handle(selector).clear_driver_error();
+    target.command(TIC_CMD_CLEAR_DRIVER_ERROR);
   }
 
   if (args.deenergize)
   {
-    handle(selector).deenergize();
+    target.command(TIC_CMD_DEENERGIZE);
   }
 
   if (args.get_debug_data)
   {
-    print_debug_data(selector);
+    print_debug_data(*selector);
   }
 
   if (args.test_procedure)
   {
-    test_procedure(selector, args.test_procedure);
+    test_procedure(*selector, args.test_procedure);
+  }
+
+  // Stream after sending all the other commands, since some of them (like
+  // --resume) might be needed for the motor to move.
+  if (args.stream)
+  {
+    stream_targets(*selector, args.stream_filename, args.stream_max_late_ms);
+  }
+
+  // Wait after sending all the commands, since some of them (like --resume)
+  // might be needed for the motor to move.
+  if (args.wait_for_homing)
+  {
+    target.wait_for_homing(args.wait_timeout_ms);
+  }
+
+  if (args.wait_for_position)
+  {
+    target.wait_for_position(args.wait_timeout_ms);
   }
 
   if (args.show_status)
   {
-    get_status(selector, args.full_output);
+    target.show_status(args.full_output);
+  }
+}
+
+// Splits a line of a script into words, the same way a simple shell would.
+// Words are separated by whitespace, and can be quoted with single or double
+// quotes.  A '#' at the beginning of a word starts a comment.
+static std::vector<std::string> split_script_line(const std::string & line)
+{
+  std::vector<std::string> words;
+  std::string word;
+  bool in_word = false;
+  char quote = 0;
+
+  for (char c : line)
+  {
+    if (quote)
+    {
+      if (c == quote) { quote = 0; }
+      else { word += c; }
+    }
+    else if (c == '\'' || c == '"')
+    {
+      quote = c;
+      in_word = true;
+    }
+    else if (std::isspace((unsigned char)c))
+    {
+      if (in_word) { words.push_back(word); }
+      word.clear();
+      in_word = false;
+    }
+    else if (c == '#' && !in_word)
+    {
+      break;
+    }
+    else
+    {
+      word += c;
+      in_word = true;
+    }
+  }
+
+  if (quote)
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS, "Unterminated quote.");
+  }
+
+  if (in_word) { words.push_back(word); }
+
+  return words;
+}
+
+static arguments parse_script_line(const std::string & line)
+{
+  std::vector<std::string> words = split_script_line(line);
+
+  std::vector<char *> argv;
+  argv.push_back(const_cast<char *>(CLI_NAME));
+  for (std::string & word : words) { argv.push_back(&word[0]); }
+  argv.push_back(NULL);
+
+  arguments args = parse_args((int)words.size() + 1, argv.data());
+
+  if (args.serial_number_specified || args.show_list || args.show_help ||
+    args.run_script || args.stdin_commands || args.run_gcode || args.timing ||
+    args.show_stats || args.serve_metrics ||
+    args.via_daemon || args.emulate || args.pause || args.pause_on_error)
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "That option can only be used on the command line.");
+  }
+
+  return args;
+}
+
+// Runs each line of the input as if its words were given on the command line,
+// using the same device handle or daemon connection for all of them.  Stops
+// at the first error.
+static void run_script(std::istream & input, bool timing,
+  std::function<void (const arguments &)> run_line)
+{
+  std::string line;
+  for (uint32_t line_number = 1; std::getline(input, line); line_number++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    bool blank = false;
+
+    try
+    {
+      arguments line_args = parse_script_line(line);
+      blank = !line_args.action_specified();
+      run_line(line_args);
+    }
+    catch (const exception_with_exit_code & error)
+    {
+      throw exception_with_exit_code(error.get_code(),
+        "Line " + std::to_string(line_number) + ": " + error.message());
+    }
+    catch (const std::exception & error)
+    {
+      throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+        "Line " + std::to_string(line_number) + ": " + error.what());
+    }
+
+    if (timing && !blank)
+    {
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      std::ostringstream message;
+      message << "Line " << line_number << ": " << std::fixed
+        << std::setprecision(3)
+        << std::chrono::duration<double, std::milli>(elapsed).count()
+        << " ms";
+      std::cerr << message.str() << std::endl;
+    }
+    else
+    {
+      std::cout.flush();
+    }
+  }
+}
+
+static void daemon_command(daemon_client & client,
+  const std::string & serial_number, uint8_t cmd, int32_t value = 0)
+{
+  ticd_writer request;
+  request.u8(TICD_REQUEST_COMMAND);
+  request.str(serial_number);
+  request.u8(cmd);
+  request.i32(value);
+  client.request(request);
+}
+
+static ticd_variables daemon_get_variables(daemon_client & client,
+  const std::string & serial_number, bool clear_errors_occurred)
+{
+  ticd_writer request;
+  request.u8(TICD_REQUEST_GET_VARIABLES);
+  request.str(serial_number);
+  request.u8(clear_errors_occurred);
+  std::vector<uint8_t> response = client.request(request);
+  ticd_reader reader(response);
+  ticd_variables vars;
+  vars.read(reader);
+  return vars;
+}
+
+static void daemon_print_list(daemon_client & client)
+{
+  ticd_writer request;
+  request.u8(TICD_REQUEST_LIST);
+  std::vector<uint8_t> response = client.request(request);
+  ticd_reader reader(response);
+  uint8_t count = reader.u8();
+  for (uint8_t i = 0; i < count; i++)
+  {
+    reader.u8();  // product
+    reader.u16();  // firmware version
+    std::string serial_number = reader.str();
+    std::string name = reader.str();
+    std::cout << std::left << std::setfill(' ');
+    std::cout << std::setw(17) << serial_number + "," << " ";
+    std::cout << std::setw(45) << name;
+    std::cout << std::endl;
+  }
+}
+
+static void daemon_get_settings(daemon_client & client,
+  const std::string & serial_number, const std::string & filename)
+{
+  ticd_writer request;
+  request.u8(TICD_REQUEST_GET_SETTINGS);
+  request.str(serial_number);
+  std::vector<uint8_t> response = client.request(request);
+  ticd_reader reader(response);
+  std::string settings_string = reader.str();
+  std::cerr << reader.str();
+  write_string_to_file_or_pipe(filename, settings_string);
+}
+
+static void daemon_set_settings(daemon_client & client,
+  const std::string & serial_number, const std::string & filename)
+{
+  ticd_writer request;
+  request.u8(TICD_REQUEST_SET_SETTINGS);
+  request.str(serial_number);
+  request.str(read_string_from_file_or_pipe(filename));
+  std::vector<uint8_t> response = client.request(request);
+  ticd_reader reader(response);
+  std::cerr << reader.str();
+}
+
+static void daemon_get_status(daemon_client & client,
+  const std::string & serial_number, bool full_output)
+{
+  ticd_writer request;
+  request.u8(TICD_REQUEST_GET_STATUS);
+  request.str(serial_number);
+  request.u8(full_output);
+  std::vector<uint8_t> response = client.request(request);
+  ticd_reader reader(response);
+  std::cout << reader.str();
+}
+
+// Waits for a move or homing to finish like tic_wait_for_position_reached()
+// and tic_wait_for_homing_complete(), but gets the variables from the daemon.
+// It reads them as often as those functions do and, like them, keeps
+// resetting the command timeout while waiting.
+static void daemon_wait(daemon_client & client,
+  const std::string & serial_number, bool homing, uint32_t timeout_ms)
+{
+  auto last_keep_alive = std::chrono::steady_clock::now();
+  auto deadline = last_keep_alive + std::chrono::milliseconds(timeout_ms);
+  while (true)
+  {
+    ticd_variables vars = daemon_get_variables(client, serial_number, false);
+    if (vars.operation_state != TIC_OPERATION_STATE_NORMAL)
+    {
+      throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+        std::string("The motor stopped because the Tic is not in normal "
+          "operation (operation state: ") +
+        tic_look_up_operation_state_name_ui(vars.operation_state) + ").");
+    }
+
+    if (homing && !vars.homing_active)
+    {
+      if (vars.position_uncertain)
+      {
+        throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+          "Homing stopped before it was complete.");
+      }
+      return;
+    }
+
+    if (!homing)
+    {
+      if (vars.planning_mode != TIC_PLANNING_MODE_TARGET_POSITION)
+      {
+        throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+          "The Tic is not moving to a target position.");
+      }
+      if (vars.current_position == vars.target_position &&
+        vars.current_velocity == 0)
+      {
+        return;
+      }
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline)
+    {
+      throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+        "Timed out after " + std::to_string(timeout_ms) + " ms waiting for " +
+        (homing ? "homing to finish." : "the target position."));
+    }
+
+    auto keep_alive_interval = std::chrono::microseconds(TIC_WAIT_KEEP_ALIVE_US);
+    if (now - last_keep_alive >= keep_alive_interval)
+    {
+      daemon_command(client, serial_number, TIC_CMD_RESET_COMMAND_TIMEOUT);
+      last_keep_alive = now;
+    }
+
+    uint32_t interval_us = homing ? TIC_WAIT_HOMING_INTERVAL_US :
+      tic::wait_get_position_interval_us(vars.target_position,
+        vars.current_position, vars.current_velocity);
+    std::this_thread::sleep_until(std::min(
+      now + std::chrono::microseconds(interval_us), deadline));
+  }
+}
+
+// Sends requests to the daemon instead of opening the device.
+class daemon_target : public action_target
+{
+public:
+  daemon_target(daemon_client & client, const std::string & serial_number)
+    : client(client), serial_number(serial_number)
+  {
+  }
+
+  void command(uint8_t cmd, int32_t value) override
+  {
+    daemon_command(client, serial_number, cmd, value);
+  }
+
+  uint8_t get_product() override
+  {
+    return daemon_get_variables(client, serial_number, false).product;
+  }
+
+  int32_t get_current_position() override
+  {
+    return daemon_get_variables(client, serial_number, false).current_position;
+  }
+
+  void get_settings(const std::string & filename) override
+  {
+    daemon_get_settings(client, serial_number, filename);
+  }
+
+  void set_settings(const std::string & filename) override
+  {
+    daemon_set_settings(client, serial_number, filename);
+  }
+
+  void restore_defaults() override
+  {
+    ticd_writer request;
+    request.u8(TICD_REQUEST_RESTORE_DEFAULTS);
+    request.str(serial_number);
+    client.request(request);
+  }
+
+  void wait_for_homing(uint32_t timeout_ms) override
+  {
+    daemon_wait(client, serial_number, true, timeout_ms);
+  }
+
+  void wait_for_position(uint32_t timeout_ms) override
+  {
+    daemon_wait(client, serial_number, false, timeout_ms);
+  }
+
+  void show_status(bool full_output) override
+  {
+    daemon_get_status(client, serial_number, full_output);
+  }
+
+  device_selector * get_selector() override
+  {
+    return NULL;
+  }
+
+private:
+  daemon_client & client;
+  std::string serial_number;
+};
+
+static void run_via_daemon(const arguments & args)
+{
+  if (args.run_gcode || args.show_stats || args.serve_metrics)
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "That option cannot be used with --via-daemon.");
+  }
+
+  daemon_client client;
+
+  if (args.show_list)
+  {
+    daemon_print_list(client);
+    return;
+  }
+
+  std::string serial_number;
+  if (args.serial_number_specified) { serial_number = args.serial_number; }
+
+  daemon_target target(client, serial_number);
+  run_actions(args, target);
+
+  auto run_line = [&](const arguments & line_args) {
+    run_actions(line_args, target);
+  };
+
+  if (args.run_script)
+  {
+    auto input = open_file_or_pipe_input(args.script_filename);
+    run_script(*input, args.timing, run_line);
+  }
+
+  if (args.stdin_commands)
+  {
+    run_script(std::cin, args.timing, run_line);
+  }
+}
+
+// Prints how the time taken by the actions on the command line was split
+// between finding the device, opening it, doing the first transfer, and
+// everything else, which includes the time spent in --wait options.
+static void print_startup_timing(device_selector & selector,
+  std::chrono::steady_clock::duration elapsed)
+{
+  auto find_time = selector.get_find_time();
+  auto open_time = selector.get_open_time();
+  std::chrono::steady_clock::duration first_transfer_time{};
+  if (selector.handle_open())
+  {
+    first_transfer_time = std::chrono::microseconds(
+      handle(selector).get_stats().get_first_transfer_latency_us());
+  }
+  auto ms = [](std::chrono::steady_clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+  };
+
+  std::ostringstream message;
+  message << std::fixed << std::setprecision(3)
+    << "Finding device: " << ms(find_time) << " ms\n"
+    << "Opening device: " << ms(open_time) << " ms\n"
+    << "First transfer: " << ms(first_transfer_time) << " ms\n"
+    << "Other actions: "
+    << ms(elapsed - find_time - open_time - first_transfer_time) << " ms";
+  std::cerr << message.str() << std::endl;
+}
+
+static void run(const arguments & args)
+{
+  if (args.show_help || !args.action_specified())
+  {
+    std::cout << help;
+    return;
+  }
+
+  if (args.via_daemon && args.emulate)
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "The --emulate and --via-daemon options cannot be used together.");
+  }
+
+  if (args.via_daemon)
+  {
+    run_via_daemon(args);
+    return;
+  }
+
+  device_selector selector;
+  if (args.serial_number_specified)
+  {
+    selector.specify_serial_number(args.serial_number);
+  }
+  if (args.emulate)
+  {
+    selector.specify_emulated_product(args.emulated_product);
+  }
+
+  if (args.show_list)
+  {
+    print_list(selector);
+    return;
+  }
+
+  direct_target target(selector);
+  auto start = std::chrono::steady_clock::now();
+  run_actions(args, target);
+  if (args.timing)
+  {
+    print_startup_timing(selector, std::chrono::steady_clock::now() - start);
+  }
+
+  auto run_line = [&](const arguments & line_args) {
+    run_actions(line_args, target);
+  };
+
+  if (args.run_script)
+  {
+    auto input = open_file_or_pipe_input(args.script_filename);
+    run_script(*input, args.timing, run_line);
+  }
+
+  if (args.stdin_commands)
+  {
+    run_script(std::cin, args.timing, run_line);
+  }
+
+  if (args.run_gcode)
+  {
+    run_gcode(args.gcode_filename, args.gcode_axes, args.emulated_product,
+      args.show_stats);
+  }
+
+  if (args.serve_metrics)
+  {
+    serve_metrics(args.serve_metrics_address, args.metrics_interval_ms,
+      selector);
+  }
+
+  if (args.show_stats && selector.handle_open())
+  {
+    print_handle_stats(handle(selector).get_stats());
   }
 }
 
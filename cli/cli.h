@@ -9,20 +9,54 @@
 #include "device_selector.h"
 #include "exit_codes.h"
 #include "exception_with_exit_code.h"
+#include "daemon_client.h"
 
 #include <algorithm>
 #include <bitset>
 #include <cassert>
+#include <cctype>
 #include <chrono>
+#include <functional>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
 #include <thread>
 
+// The bits in missed_errors_occurred are reported as errors that occurred in
+// addition to the ones in vars.  ticd uses this for errors that were cleared
+// by a read from another client.
 void print_status(const tic::variables & vars,
   const tic::settings & settings,
   const std::string & name,
   const std::string & serial_number,
   const std::string & firmware_version,
-  bool full_output);
+  bool full_output,
+  uint32_t missed_errors_occurred = 0);
+
+// Prints the statistics from tic::handle::get_stats() to standard error, for
+// --stats.
+void print_handle_stats(const tic::handle_stats & stats);
+
+// An axis for --gcode: the letter used for it in the G-code, the serial
+// number of the Tic that drives it, and how many microsteps make one unit.
+struct gcode_axis
+{
+  char letter;
+  std::string serial_number;
+  double steps_per_unit = 1;
+};
+
+// Runs the G-code in the specified file.  If emulated_product is not 0, each
+// axis uses a new emulated Tic instead of a real one.  If show_stats is true,
+// prints the transfer statistics of each axis at the end.
+void run_gcode(const std::string & filename,
+  const std::vector<gcode_axis> & axes, uint8_t emulated_product,
+  bool show_stats);
+
+// Serves the variables of the selected Tic, or of every connected Tic if
+// there are several to choose from, as OpenMetrics text on the specified
+// address until the program is interrupted.  The variables are read every
+// interval_ms milliseconds.
+void serve_metrics(const std::string & address, uint32_t interval_ms,
+  device_selector & selector);
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "exit_codes.h"
+#include "exception_with_exit_code.h"
+#include "ticd_protocol.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// Sends requests to ticd over its Unix domain socket.  See ticd_protocol.h.
+class daemon_client
+{
+public:
+  daemon_client()
+  {
+  }
+
+  ~daemon_client()
+  {
+#ifndef _WIN32
+    if (fd >= 0) { close(fd); }
+#endif
+  }
+
+  void connect_to_daemon()
+  {
+#ifdef _WIN32
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "The daemon is not supported on Windows.");
+#else
+    const char * env_path = getenv(TICD_SOCKET_ENV);
+    std::string path_string = (env_path == NULL || env_path[0] == 0) ?
+      ticd_default_socket_path() : env_path;
+    const char * path = path_string.c_str();
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path))
+    {
+      throw exception_with_exit_code(EXIT_BAD_ARGS,
+        "The daemon socket path is too long.");
+    }
+    strcpy(address.sun_path, path);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 ||
+      connect(fd, (struct sockaddr *)&address, sizeof(address)))
+    {
+      int error_code = errno;
+      throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+        std::string("Failed to connect to the daemon at ") + path + ": " +
+        strerror(error_code) + ".");
+    }
+#endif
+  }
+
+  // Sends a request and returns the payload of the response, not including
+  // the response code.  Throws an exception if the daemon reports an error.
+  std::vector<uint8_t> request(const ticd_writer & request)
+  {
+    if (fd < 0) { connect_to_daemon(); }
+
+    std::vector<uint8_t> frame = request.framed();
+    send_all(frame.data(), frame.size());
+
+    uint8_t size_buffer[4];
+    receive_all(size_buffer, 4);
+    uint32_t size = size_buffer[0] | size_buffer[1] << 8 |
+      size_buffer[2] << 16 | (uint32_t)size_buffer[3] << 24;
+    if (size == 0 || size > TICD_MAX_MESSAGE_SIZE)
+    {
+      throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+        "Invalid response from the daemon.");
+    }
+
+    std::vector<uint8_t> payload(size);
+    receive_all(payload.data(), size);
+
+    uint8_t code = payload[0];
+    payload.erase(payload.begin());
+
+    if (code == TICD_RESPONSE_ERROR)
+    {
+      ticd_reader reader(payload);
+      uint8_t error_code = reader.u8();
+      std::string message = reader.str();
+      throw exception_with_exit_code(exit_code_for_error(error_code), message);
+    }
+
+    return payload;
+  }
+
+private:
+  static uint8_t exit_code_for_error(uint8_t error_code)
+  {
+    switch (error_code)
+    {
+    case TICD_ERROR_DEVICE_NOT_FOUND: return EXIT_DEVICE_NOT_FOUND;
+    case TICD_ERROR_DEVICE_MULTIPLE_FOUND: return EXIT_DEVICE_MULTIPLE_FOUND;
+    default: return EXIT_OPERATION_FAILED;
+    }
+  }
+
+  void send_all(const uint8_t * data, size_t size)
+  {
+#ifndef _WIN32
+    while (size)
+    {
+      ssize_t sent = send(fd, data, size, send_flags);
+      if (sent < 0 && errno == EINTR) { continue; }
+      if (sent <= 0) { connection_lost(); }
+      data += sent;
+      size -= sent;
+    }
+#else
+    (void)data; (void)size;
+#endif
+  }
+
+  void receive_all(uint8_t * data, size_t size)
+  {
+#ifndef _WIN32
+    while (size)
+    {
+      ssize_t received = recv(fd, data, size, 0);
+      if (received < 0 && errno == EINTR) { continue; }
+      if (received <= 0) { connection_lost(); }
+      data += received;
+      size -= received;
+    }
+#else
+    (void)data; (void)size;
+#endif
+  }
+
+  [[noreturn]] void connection_lost()
+  {
+    throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+      "Lost the connection to the daemon.");
+  }
+
+#ifdef MSG_NOSIGNAL
+  static const int send_flags = MSG_NOSIGNAL;
+#else
+  static const int send_flags = 0;
+#endif
+
+  int fd = -1;
+};
@@ -3,6 +3,7 @@
 #include "exit_codes.h"
 #include "exception_with_exit_code.h"
 #include <cassert>
+#include <chrono>
 
 // Contains the logic for finding devices and choosing which one to use.
 class device_selector
@@ -15,10 +16,26 @@ public:
     this->serial_number_specified = true;
   }
 
+  // Makes the selector use a new emulated Tic instead of a real device.
+  void specify_emulated_product(uint8_t product)
+  {
+    assert(!handle);
+    emulated_product = product;
+  }
+
   std::vector<tic::device> list_devices()
   {
     if (list_initialized) { return list; }
 
+    if (emulated_product)
+    {
+      list.clear();
+      list.push_back(select_handle().get_device());
+      list_initialized = true;
+      return list;
+    }
+
+    auto start = std::chrono::steady_clock::now();
     list.clear();
     for (tic::device & device : tic::list_connected_devices())
     {
@@ -30,6 +47,7 @@ public:
       list.push_back(std::move(device));
     }
     list_initialized = true;
+    find_time += std::chrono::steady_clock::now() - start;
     return list;
   }
 
@@ -37,6 +55,23 @@ public:
   {
     if (device) { return device; }
 
+    if (emulated_product)
+    {
+      device = select_handle().get_device();
+      return device;
+    }
+
+    // If we know the serial number, we can skip getting information about
+    // every device, which matters when the program is run many times.
+    if (serial_number_specified && !list_initialized)
+    {
+      auto start = std::chrono::steady_clock::now();
+      device = tic::find_device_by_serial_number(serial_number);
+      find_time += std::chrono::steady_clock::now() - start;
+      if (!device) { throw device_not_found_error(); }
+      return device;
+    }
+
     auto list = list_devices();
     if (list.size() == 0)
     {
@@ -52,6 +87,41 @@ public:
     return device;
   }
 
+  // Opens a handle to the selected device the first time it is called and
+  // returns the same handle after that, so that running several commands only
+  // opens the device once.
+  tic::handle & select_handle()
+  {
+    if (!handle && emulated_product)
+    {
+      handle = tic::handle::open_emulated(emulated_product);
+    }
+    if (!handle)
+    {
+      tic::device device = select_device();
+      auto start = std::chrono::steady_clock::now();
+      handle = tic::handle(device);
+      open_time = std::chrono::steady_clock::now() - start;
+    }
+    return handle;
+  }
+
+  // Returns true if select_handle() has opened a handle.
+  bool handle_open() const
+  {
+    return handle;
+  }
+
+  // The time spent finding devices and opening the handle, for --timing.
+  std::chrono::steady_clock::duration get_find_time() const
+  {
+    return find_time;
+  }
+  std::chrono::steady_clock::duration get_open_time() const
+  {
+    return open_time;
+  }
+
 private:
 
   std::string device_not_found_message() const
@@ -85,8 +155,15 @@ private:
   bool serial_number_specified = false;
   std::string serial_number;
 
+  uint8_t emulated_product = 0;
+
   bool list_initialized = false;
   std::vector<tic::device> list;
 
   tic::device device;
+
+  tic::handle handle;
+
+  std::chrono::steady_clock::duration find_time{};
+  std::chrono::steady_clock::duration open_time{};
 };
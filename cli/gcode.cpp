@@ -0,0 +1,566 @@
+// Runs a small subset of G-code on a set of Tics, one for each axis.
+//
+// The whole file is parsed before anything moves, so a typo on the last line
+// does not leave the machine half way through a job.  Moves are then sent one
+// segment ahead: as soon as every axis in the current segment is close enough
+// to its target that it would start slowing down, we send the targets and
+// speeds of the next segment, and the Tics change course without stopping.
+
+#include "cli.h"
+
+#include <cmath>
+
+// How often we read the positions of the axes while moves are running.
+static const auto gcode_poll_interval = std::chrono::milliseconds(10);
+
+// How often we send a Reset Command Timeout command to every axis while
+// waiting, so the Tics' command timeouts do not stop the motors.
+static const auto gcode_keep_alive_interval = std::chrono::milliseconds(500);
+
+static const uint32_t gcode_poll_fields = TIC_VARIABLES_FIELD_OPERATION_STATE |
+  TIC_VARIABLES_FIELD_MISC_FLAGS | TIC_VARIABLES_FIELD_TARGET_POSITION |
+  TIC_VARIABLES_FIELD_CURRENT_POSITION | TIC_VARIABLES_FIELD_CURRENT_VELOCITY |
+  TIC_VARIABLES_FIELD_MAX_DECEL;
+
+namespace
+{
+  struct gcode_command
+  {
+    enum command_type { MOVE, DWELL, HOME, ENERGIZE, DEENERGIZE };
+
+    command_type type;
+    uint32_t line_number;
+
+    // For MOVE: whether it is a rapid move (G0), and the feed rate in units
+    // per minute for G1.  For MOVE and HOME: which axes were mentioned, and
+    // for MOVE the values, which are relative if the relative flag is set.
+    // For HOME, a positive value means to home that axis forward.
+    bool rapid = false;
+    double feed_rate = 0;
+    bool relative = false;
+    std::vector<bool> axis_used;
+    std::vector<double> value;
+
+    uint32_t dwell_ms = 0;
+  };
+
+  // The state of one axis while the program runs.
+  struct gcode_axis_state
+  {
+    tic::handle handle;
+    tic::variables vars;
+
+    // The speed limit the Tic had when we started, which is used for rapid
+    // moves and as a limit for feed moves.
+    uint32_t max_speed = 0;
+
+    // Where we last told the axis to go, in microsteps.
+    int32_t target = 0;
+
+    // True if the axis has a move in the current segment, which is the last
+    // one we sent.
+    bool in_segment = false;
+  };
+}
+
+static std::string strip_gcode_comments(const std::string & line)
+{
+  std::string result;
+  bool in_paren = false;
+  for (char c : line)
+  {
+    if (in_paren)
+    {
+      if (c == ')') { in_paren = false; }
+    }
+    else if (c == '(') { in_paren = true; }
+    else if (c == ';') { break; }
+    else { result += (char)std::toupper((unsigned char)c); }
+  }
+  return result;
+}
+
+static std::vector<gcode_command> parse_gcode(std::istream & input,
+  const std::vector<gcode_axis> & axes)
+{
+  std::vector<gcode_command> commands;
+  double feed_rate = 0;
+  bool relative = false;
+
+  std::string line;
+  for (uint32_t line_number = 1; std::getline(input, line); line_number++)
+  {
+    auto bad_line = [&](const std::string & what) {
+      return exception_with_exit_code(EXIT_BAD_ARGS,
+        "Line " + std::to_string(line_number) + " of the G-code file: " + what);
+    };
+
+    // Split the line into words: a letter followed by a number.
+    std::string code;
+    gcode_command command;
+    command.line_number = line_number;
+    command.axis_used.assign(axes.size(), false);
+    command.value.assign(axes.size(), 0);
+    bool has_feed_rate = false, has_p = false, has_s = false;
+    double p = 0, s = 0;
+
+    std::istringstream words(strip_gcode_comments(line));
+    char letter;
+    while (words >> letter)
+    {
+      double number;
+      if (!std::isalpha((unsigned char)letter) || !(words >> number))
+      {
+        throw bad_line("Expected a letter followed by a number.");
+      }
+
+      if (letter == 'G' || letter == 'M')
+      {
+        if (!code.empty())
+        {
+          throw bad_line("Only one G or M code per line is supported.");
+        }
+        code = letter + std::to_string((int)number);
+        if (number != (int)number)
+        {
+          throw bad_line("Unsupported code: " + std::string(1, letter) +
+            std::to_string(number) + ".");
+        }
+        continue;
+      }
+
+      if (letter == 'N') { continue; }
+      if (letter == 'F') { has_feed_rate = true; feed_rate = number; continue; }
+      if (letter == 'P') { has_p = true; p = number; continue; }
+      if (letter == 'S') { has_s = true; s = number; continue; }
+
+      bool found = false;
+      for (size_t i = 0; i < axes.size(); i++)
+      {
+        if (axes[i].letter != letter) { continue; }
+        command.axis_used[i] = true;
+        command.value[i] = number;
+        found = true;
+      }
+      if (!found)
+      {
+        throw bad_line("No Tic is assigned to axis " +
+          std::string(1, letter) + ".");
+      }
+    }
+
+    if (has_feed_rate && !(feed_rate > 0))
+    {
+      throw bad_line("The feed rate must be positive.");
+    }
+
+    bool any_axis = std::find(command.axis_used.begin(),
+      command.axis_used.end(), true) != command.axis_used.end();
+
+    if (code.empty() && !any_axis) { continue; }
+
+    if (code == "G0" || code == "G1")
+    {
+      command.type = gcode_command::MOVE;
+      command.rapid = code == "G0";
+      command.feed_rate = feed_rate;
+      command.relative = relative;
+      if (!command.rapid && feed_rate == 0)
+      {
+        throw bad_line("No feed rate was specified for G1.");
+      }
+      if (any_axis) { commands.push_back(command); }
+    }
+    else if (code == "G4")
+    {
+      command.type = gcode_command::DWELL;
+      double ms = has_p ? p : has_s ? s * 1000 : 0;
+      if (ms < 0 || ms > UINT32_MAX)
+      {
+        throw bad_line("Invalid dwell time.");
+      }
+      command.dwell_ms = (uint32_t)ms;
+      commands.push_back(command);
+    }
+    else if (code == "G28")
+    {
+      command.type = gcode_command::HOME;
+      if (!any_axis) { command.axis_used.assign(axes.size(), true); }
+      commands.push_back(command);
+    }
+    else if (code == "G21") { }  // Millimeters: the units are set by --axis.
+    else if (code == "G90") { relative = false; }
+    else if (code == "G91") { relative = true; }
+    else if (code == "M17")
+    {
+      command.type = gcode_command::ENERGIZE;
+      commands.push_back(command);
+    }
+    else if (code == "M18" || code == "M84")
+    {
+      command.type = gcode_command::DEENERGIZE;
+      commands.push_back(command);
+    }
+    else if (code.empty())
+    {
+      throw bad_line("Expected a G or M code.");
+    }
+    else
+    {
+      throw bad_line("Unsupported code: " + code + ".");
+    }
+  }
+
+  return commands;
+}
+
+namespace
+{
+  class gcode_runner
+  {
+  public:
+    gcode_runner(const std::vector<gcode_axis> & axes, uint8_t emulated_product)
+      : axes(axes), states(axes.size())
+    {
+      for (size_t i = 0; i < axes.size(); i++)
+      {
+        gcode_axis_state & state = states[i];
+        if (emulated_product)
+        {
+          state.handle = tic::handle::open_emulated(emulated_product);
+        }
+        else
+        {
+          tic::device device = tic::find_device_by_serial_number(
+            axes[i].serial_number);
+          if (!device)
+          {
+            throw exception_with_exit_code(EXIT_DEVICE_NOT_FOUND,
+              "No device was found with serial number '" +
+              axes[i].serial_number + "' for axis " + axes[i].letter + ".");
+          }
+          state.handle = tic::handle(device);
+        }
+
+        state.vars = state.handle.get_variables();
+        state.max_speed = state.vars.get_max_speed();
+        state.target = state.vars.get_current_position();
+      }
+      last_keep_alive = std::chrono::steady_clock::now();
+    }
+
+    void run(const std::vector<gcode_command> & commands)
+    {
+      for (const gcode_command & command : commands)
+      {
+        try
+        {
+          run_command(command);
+        }
+        catch (const exception_with_exit_code & error)
+        {
+          throw exception_with_exit_code(error.get_code(),
+            line_prefix(command) + error.message());
+        }
+        catch (const std::exception & error)
+        {
+          throw exception_with_exit_code(EXIT_OPERATION_FAILED,
+            line_prefix(command) + error.what());
+        }
+      }
+      wait_until_stopped();
+    }
+
+    tic::handle & get_handle(size_t index)
+    {
+      return states[index].handle;
+    }
+
+  private:
+    static std::string line_prefix(const gcode_command & command)
+    {
+      return "Line " + std::to_string(command.line_number) +
+        " of the G-code file: ";
+    }
+
+    void run_command(const gcode_command & command)
+    {
+      switch (command.type)
+      {
+      case gcode_command::MOVE:
+        start_move(command);
+        break;
+
+      case gcode_command::DWELL:
+        wait_until_stopped();
+        sleep_with_keep_alive(std::chrono::milliseconds(command.dwell_ms));
+        break;
+
+      case gcode_command::HOME:
+        home(command);
+        break;
+
+      case gcode_command::ENERGIZE:
+        wait_until_stopped();
+        for (gcode_axis_state & state : states)
+        {
+          state.handle.energize();
+          state.handle.exit_safe_start();
+        }
+        break;
+
+      case gcode_command::DEENERGIZE:
+        wait_until_stopped();
+        for (gcode_axis_state & state : states)
+        {
+          state.handle.deenergize();
+        }
+        break;
+      }
+    }
+
+    // Works out the targets and speeds for a move, waits until the current
+    // segment is nearly done, and sends them.
+    void start_move(const gcode_command & command)
+    {
+      std::vector<int32_t> targets(axes.size());
+      std::vector<double> distances(axes.size());
+      double length_squared = 0;
+      for (size_t i = 0; i < axes.size(); i++)
+      {
+        targets[i] = states[i].target;
+        if (!command.axis_used[i]) { continue; }
+
+        double target_units = command.value[i];
+        if (command.relative)
+        {
+          target_units += states[i].target / axes[i].steps_per_unit;
+        }
+        double target = std::round(target_units * axes[i].steps_per_unit);
+        if (target > INT32_MAX || target < INT32_MIN)
+        {
+          throw std::runtime_error("Axis " + std::string(1, axes[i].letter) +
+            " target is out of range.");
+        }
+        targets[i] = (int32_t)target;
+        distances[i] = (targets[i] - states[i].target) / axes[i].steps_per_unit;
+        length_squared += distances[i] * distances[i];
+      }
+
+      // Pick the speed of each axis.  For G1, each axis gets its share of the
+      // feed rate so that the tool moves in a straight line, all scaled down
+      // together if that would be too fast for one of the axes.
+      std::vector<double> feed_speeds(axes.size());
+      double length = std::sqrt(length_squared);
+      double scale = 1;
+      for (size_t i = 0; i < axes.size(); i++)
+      {
+        if (command.rapid || length == 0) { break; }
+        feed_speeds[i] = command.feed_rate / 60 * std::fabs(distances[i]) /
+          length * axes[i].steps_per_unit * TIC_SPEED_UNITS_PER_HZ;
+        if (feed_speeds[i] > states[i].max_speed)
+        {
+          scale = std::min(scale, states[i].max_speed / feed_speeds[i]);
+        }
+      }
+
+      std::vector<uint32_t> speeds(axes.size());
+      for (size_t i = 0; i < axes.size(); i++)
+      {
+        if (command.rapid || length == 0)
+        {
+          speeds[i] = states[i].max_speed;
+        }
+        else
+        {
+          speeds[i] = std::max<uint32_t>(1,
+            (uint32_t)std::lround(feed_speeds[i] * scale));
+        }
+      }
+
+      wait_until_ready_for_next_segment();
+
+      for (size_t i = 0; i < axes.size(); i++)
+      {
+        gcode_axis_state & state = states[i];
+        if (targets[i] == state.target) { continue; }
+        state.handle.set_max_speed(speeds[i]);
+        state.handle.set_target_position(targets[i]);
+        state.target = targets[i];
+        state.in_segment = true;
+      }
+    }
+
+    void home(const gcode_command & command)
+    {
+      wait_until_stopped();
+
+      for (size_t i = 0; i < axes.size(); i++)
+      {
+        if (!command.axis_used[i]) { continue; }
+        states[i].handle.set_max_speed(states[i].max_speed);
+        states[i].handle.go_home(command.value[i] > 0 ?
+          TIC_GO_HOME_FORWARD : TIC_GO_HOME_REVERSE);
+      }
+
+      wait_until([&](size_t i) {
+        const tic::variables & vars = states[i].vars;
+        if (!command.axis_used[i]) { return true; }
+        if (vars.get_homing_active()) { return false; }
+        if (vars.get_position_uncertain())
+        {
+          throw std::runtime_error("Homing stopped before it was complete.");
+        }
+        return true;
+      });
+
+      for (size_t i = 0; i < axes.size(); i++)
+      {
+        if (!command.axis_used[i]) { continue; }
+        states[i].target = states[i].vars.get_current_position();
+      }
+    }
+
+    // Returns true if the axis is close enough to the end of its move in the
+    // current segment that it is about to start slowing down, so it is time to
+    // send the next segment.
+    bool near_end_of_segment(size_t i) const
+    {
+      const gcode_axis_state & state = states[i];
+      if (!state.in_segment) { return true; }
+
+      const tic::variables & vars = state.vars;
+      double remaining = std::fabs((double)state.target -
+        vars.get_current_position());
+      double speed = std::fabs((double)vars.get_current_velocity()) /
+        TIC_SPEED_UNITS_PER_HZ;
+      double decel = (double)vars.get_max_decel() / TIC_ACCEL_UNITS_PER_HZ2;
+      double braking = decel > 0 ? speed * speed / (2 * decel) : 0;
+
+      // Allow for the time until we read the position again, plus one more
+      // poll for the time it takes to send the next segment.
+      double look_ahead = speed * 2 *
+        std::chrono::duration<double>(gcode_poll_interval).count();
+
+      return remaining <= braking + look_ahead + 1;
+    }
+
+    bool stopped(size_t i) const
+    {
+      const gcode_axis_state & state = states[i];
+      const tic::variables & vars = state.vars;
+      return vars.get_current_position() == state.target &&
+        vars.get_current_velocity() == 0;
+    }
+
+    void wait_until_ready_for_next_segment()
+    {
+      wait_until([&](size_t i) { return near_end_of_segment(i); });
+      for (gcode_axis_state & state : states) { state.in_segment = false; }
+    }
+
+    void wait_until_stopped()
+    {
+      wait_until([&](size_t i) { return stopped(i); });
+      for (gcode_axis_state & state : states) { state.in_segment = false; }
+    }
+
+    // Reads the variables of every axis until the condition is true for all of
+    // them.
+    void wait_until(std::function<bool (size_t)> done)
+    {
+      while (true)
+      {
+        bool all_done = true;
+        for (size_t i = 0; i < axes.size(); i++)
+        {
+          gcode_axis_state & state = states[i];
+          state.vars.refresh_fields(state.handle, gcode_poll_fields);
+          uint8_t operation_state = state.vars.get_operation_state();
+          if (operation_state != TIC_OPERATION_STATE_NORMAL &&
+            (!stopped(i) || state.vars.get_homing_active()))
+          {
+            throw std::runtime_error("Axis " +
+              std::string(1, axes[i].letter) + " stopped because the Tic is "
+              "not in normal operation (operation state: " +
+              tic_look_up_operation_state_name_ui(operation_state) + ").");
+          }
+          if (!done(i)) { all_done = false; }
+        }
+        if (all_done) { return; }
+
+        keep_alive();
+        std::this_thread::sleep_for(gcode_poll_interval);
+      }
+    }
+
+    void sleep_with_keep_alive(std::chrono::milliseconds time)
+    {
+      auto end = std::chrono::steady_clock::now() + time;
+      while (true)
+      {
+        keep_alive();
+        auto now = std::chrono::steady_clock::now();
+        if (now >= end) { return; }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+          end - now, gcode_keep_alive_interval));
+      }
+    }
+
+    void keep_alive()
+    {
+      auto now = std::chrono::steady_clock::now();
+      if (now - last_keep_alive < gcode_keep_alive_interval) { return; }
+      last_keep_alive = now;
+      for (gcode_axis_state & state : states)
+      {
+        state.handle.reset_command_timeout();
+      }
+    }
+
+    const std::vector<gcode_axis> & axes;
+    std::vector<gcode_axis_state> states;
+    std::chrono::steady_clock::time_point last_keep_alive;
+  };
+}
+
+void run_gcode(const std::string & filename,
+  const std::vector<gcode_axis> & axes, uint8_t emulated_product,
+  bool show_stats)
+{
+  if (axes.empty())
+  {
+    throw exception_with_exit_code(EXIT_BAD_ARGS,
+      "No axes were specified for the G-code.  Use --axis.");
+  }
+
+  for (size_t i = 0; i < axes.size(); i++)
+  {
+    for (size_t j = 0; j < i; j++)
+    {
+      if (axes[i].letter == axes[j].letter)
+      {
+        throw exception_with_exit_code(EXIT_BAD_ARGS,
+          "Axis " + std::string(1, axes[i].letter) + " was specified twice.");
+      }
+    }
+  }
+
+  std::vector<gcode_command> commands;
+  {
+    auto input = open_file_or_pipe_input(filename);
+    commands = parse_gcode(*input, axes);
+  }
+
+  gcode_runner runner(axes, emulated_product);
+  runner.run(commands);
+
+  if (show_stats)
+  {
+    for (size_t i = 0; i < axes.size(); i++)
+    {
+      std::cerr << "Axis " << axes[i].letter << ":" << std::endl;
+      print_handle_stats(runner.get_handle(i).get_stats());
+    }
+  }
+}
@@ -0,0 +1,779 @@
+// Serves the variables of one or more Tics in the OpenMetrics text format, so
+// that a monitoring system such as Prometheus can scrape them.
+//
+// The Tics are only read at the sampling interval.  After each sample, the
+// whole HTTP response is rendered into a buffer that is kept for the life of
+// the server, and a scrape just copies that buffer into the connection's own
+// (also reused) output buffer.  So a scrape never causes any USB I/O, and
+// once the buffers have grown to their working size it does not allocate.
+//
+// The errors occurred bits are cleared every time they are read, so each
+// sample where a bit is set counts as one occurrence of that error.  This
+// means that other programs watching the same Tic will not see those bits.
+
+#include "cli.h"
+
+#ifndef _WIN32
+#include <cstdarg>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+void serve_metrics(const std::string &, uint32_t, device_selector &)
+{
+  throw exception_with_exit_code(EXIT_BAD_ARGS,
+    "The --serve-metrics option is not supported on Windows.");
+}
+
+#else
+
+static const uint32_t metrics_fields = TIC_VARIABLES_FIELD_OPERATION_STATE |
+  TIC_VARIABLES_FIELD_MISC_FLAGS | TIC_VARIABLES_FIELD_ERROR_STATUS |
+  TIC_VARIABLES_FIELD_ERRORS_OCCURRED | TIC_VARIABLES_FIELD_TARGET_POSITION |
+  TIC_VARIABLES_FIELD_CURRENT_POSITION | TIC_VARIABLES_FIELD_CURRENT_VELOCITY |
+  TIC_VARIABLES_FIELD_VIN_VOLTAGE | TIC_VARIABLES_FIELD_UP_TIME;
+
+// The most scrapers we talk to at once.  More connections wait in the
+// listen backlog until a slot is free.
+static const size_t metrics_max_clients = 8;
+
+// The longest request we accept, and how long a scraper has to send it.
+static const size_t metrics_max_request_size = 4096;
+static const auto metrics_client_timeout = std::chrono::seconds(10);
+
+static const char metrics_content_type[] =
+  "application/openmetrics-text; version=1.0.0; charset=utf-8";
+
+// The bits of the error status and errors occurred variables.
+static const uint8_t metrics_error_bits[] = {
+  TIC_ERROR_INTENTIONALLY_DEENERGIZED,
+  TIC_ERROR_MOTOR_DRIVER_ERROR,
+  TIC_ERROR_LOW_VIN,
+  TIC_ERROR_KILL_SWITCH,
+  TIC_ERROR_REQUIRED_INPUT_INVALID,
+  TIC_ERROR_SERIAL_ERROR,
+  TIC_ERROR_COMMAND_TIMEOUT,
+  TIC_ERROR_SAFE_START_VIOLATION,
+  TIC_ERROR_ERR_LINE_HIGH,
+  TIC_ERROR_SERIAL_FRAMING,
+  TIC_ERROR_SERIAL_RX_OVERRUN,
+  TIC_ERROR_SERIAL_FORMAT,
+  TIC_ERROR_SERIAL_CRC,
+  TIC_ERROR_ENCODER_SKIP,
+};
+
+static const size_t metrics_error_bit_count =
+  sizeof(metrics_error_bits) / sizeof(metrics_error_bits[0]);
+
+static volatile sig_atomic_t metrics_stop_requested = 0;
+
+// Sockets are non-blocking so that a scraper that stops reading or writing
+// cannot stall the sampling or the other scrapers.
+static bool metrics_set_non_blocking(int fd)
+{
+  int flags = fcntl(fd, F_GETFL);
+  return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static void metrics_handle_stop_signal(int)
+{
+  metrics_stop_requested = 1;
+}
+
+// Turns an error name like "Low VIN" into a label value like "low_vin".
+static std::string metrics_error_label(uint8_t bit)
+{
+  std::string label;
+  for (const char * p = tic_look_up_error_name_ui(1 << bit); *p; p++)
+  {
+    char c = *p;
+    if (c == ' ' || c == '-') { c = '_'; }
+    label += (char)std::tolower((unsigned char)c);
+  }
+  return label;
+}
+
+static std::string metrics_escape_label(const std::string & value)
+{
+  std::string r;
+  for (char c : value)
+  {
+    if (c == '\\' || c == '"') { r += '\\'; r += c; }
+    else if (c == '\n') { r += "\\n"; }
+    else { r += c; }
+  }
+  return r;
+}
+
+namespace
+{
+  // One Tic that we are reporting on.
+  struct metrics_device
+  {
+    tic::handle * handle;
+
+    // Already escaped, e.g. 'serial_number="00123456"'.
+    std::string labels;
+
+    tic::variables vars;
+    bool vars_valid = false;
+    bool last_sample_ok = false;
+    uint32_t sample_latency_us = 0;
+
+    // How many samples had each bit of errors occurred set, in the order of
+    // metrics_error_bits.
+    uint64_t errors_occurred[metrics_error_bit_count] = {};
+
+    // Totals over every request code, from the handle's statistics.
+    uint64_t transfer_count = 0;
+    uint64_t transfer_error_count = 0;
+    uint64_t transfer_timeout_count = 0;
+    uint64_t transfer_latency_us = 0;
+    uint64_t transfer_histogram[TIC_HANDLE_STATS_HISTOGRAM_SIZE] = {};
+  };
+
+  struct metrics_client
+  {
+    int fd = -1;
+    std::chrono::steady_clock::time_point start;
+
+    // The request we have read so far, and then the response we are sending.
+    // These keep their capacity when the slot is reused.
+    std::string in;
+    std::string out;
+    size_t out_sent = 0;
+    bool responding = false;
+  };
+
+  class metrics_server
+  {
+  public:
+    metrics_server(std::vector<metrics_device> & devices, uint32_t interval_ms)
+      : devices(devices), interval(std::chrono::milliseconds(interval_ms))
+    {
+      for (size_t i = 0; i < metrics_error_bit_count; i++)
+      {
+        error_labels.push_back(metrics_error_label(metrics_error_bits[i]));
+      }
+      clients.resize(metrics_max_clients);
+    }
+
+    ~metrics_server()
+    {
+      for (metrics_client & c : clients)
+      {
+        if (c.fd >= 0) { close(c.fd); }
+      }
+      if (listen_fd >= 0) { close(listen_fd); }
+      if (!unix_path.empty()) { unlink(unix_path.c_str()); }
+    }
+
+    void open_socket(const std::string & address);
+
+    void run();
+
+  private:
+    void sample();
+    void render();
+    void accept_client();
+    bool read_request(metrics_client &);
+    bool write_response(metrics_client &);
+    void drop_client(metrics_client &);
+
+    void family(const char * name, const char * type, const char * unit,
+      const char * help);
+    void line(const char * format, ...)
+      __attribute__((format(printf, 2, 3)));
+
+    std::vector<metrics_device> & devices;
+    std::chrono::steady_clock::duration interval;
+    std::vector<std::string> error_labels;
+
+    int listen_fd = -1;
+    std::string unix_path;
+    std::vector<metrics_client> clients;
+
+    // The body we are rendering, and the full response with its headers that
+    // scrapers get.
+    std::string body;
+    std::string response;
+    std::string not_found_response;
+    std::string not_allowed_response;
+  };
+}
+
+void metrics_server::open_socket(const std::string & address)
+{
+  if (address.compare(0, 5, "unix:") == 0)
+  {
+    std::string path = address.substr(5);
+
+    struct sockaddr_un un;
+    memset(&un, 0, sizeof(un));
+    un.sun_family = AF_UNIX;
+    if (path.empty() || path.size() >= sizeof(un.sun_path))
+    {
+      throw exception_with_exit_code(EXIT_BAD_ARGS,
+        "Invalid socket path for --serve-metrics: '" + path + "'.");
+    }
+    strcpy(un.sun_path, path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+      throw std::runtime_error(std::string("socket: ") + strerror(errno) + ".");
+    }
+
+    // Remove a stale socket left by an earlier run, but do not steal the
+    // socket from a server that is still running.
+    if (connect(listen_fd, (struct sockaddr *)&un, sizeof(un)) == 0)
+    {
+      throw std::runtime_error("Something is already listening on " +
+        path + ".");
+    }
+    close(listen_fd);
+    unlink(path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+      throw std::runtime_error(std::string("socket: ") + strerror(errno) + ".");
+    }
+    if (bind(listen_fd, (struct sockaddr *)&un, sizeof(un)))
+    {
+      throw std::runtime_error(path + ": " + strerror(errno) + ".");
+    }
+    unix_path = path;
+  }
+  else
+  {
+    // HOST:PORT, [HOST]:PORT for IPv6, or just PORT or :PORT, which listen
+    // on the loopback interface only.  To listen on every interface, the
+    // host has to be given explicitly, e.g. 0.0.0.0:9100.
+    std::string host;
+    std::string port = address;
+    size_t colon = address.rfind(':');
+    if (colon != std::string::npos)
+    {
+      host = address.substr(0, colon);
+      port = address.substr(colon + 1);
+      if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+      {
+        host = host.substr(1, host.size() - 2);
+      }
+    }
+    if (host.empty()) { host = "127.0.0.1"; }
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo * info = NULL;
+    int result = getaddrinfo(host.c_str(), port.c_str(), &hints, &info);
+    if (result != 0)
+    {
+      throw exception_with_exit_code(EXIT_BAD_ARGS,
+        "Invalid address for --serve-metrics: '" + address + "': " +
+        gai_strerror(result) + ".");
+    }
+
+    listen_fd = socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+    if (listen_fd < 0)
+    {
+      freeaddrinfo(info);
+      throw std::runtime_error(std::string("socket: ") + strerror(errno) + ".");
+    }
+
+    int yes = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    result = bind(listen_fd, info->ai_addr, info->ai_addrlen);
+    int error_code = errno;
+    freeaddrinfo(info);
+    if (result)
+    {
+      throw std::runtime_error(address + ": " + strerror(error_code) + ".");
+    }
+  }
+
+  if (listen(listen_fd, 16) || !metrics_set_non_blocking(listen_fd))
+  {
+    throw std::runtime_error(std::string("listen: ") + strerror(errno) + ".");
+  }
+}
+
+void metrics_server::sample()
+{
+  for (metrics_device & device : devices)
+  {
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+      device.vars.refresh_fields(*device.handle, metrics_fields, true);
+      device.vars_valid = true;
+      device.last_sample_ok = true;
+    }
+    catch (const tic::error &)
+    {
+      // The failure shows up as tic_up 0 and in the transfer error counts.
+      device.last_sample_ok = false;
+    }
+    device.sample_latency_us = std::chrono::duration_cast<
+      std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+
+    if (device.last_sample_ok)
+    {
+      uint32_t occurred = device.vars.get_errors_occurred();
+      for (size_t i = 0; i < metrics_error_bit_count; i++)
+      {
+        if (occurred >> metrics_error_bits[i] & 1) { device.errors_occurred[i]++; }
+      }
+    }
+
+    tic::handle_stats stats = device.handle->get_stats();
+    device.transfer_count = 0;
+    device.transfer_error_count = 0;
+    device.transfer_timeout_count = 0;
+    device.transfer_latency_us = 0;
+    for (uint64_t & count : device.transfer_histogram) { count = 0; }
+    uint32_t histogram[TIC_HANDLE_STATS_HISTOGRAM_SIZE];
+    for (unsigned int request = 0; request < 256; request++)
+    {
+      const tic_handle_stats * p = stats.get_pointer();
+      if (tic_handle_stats_get_transfer_count(p, request) == 0) { continue; }
+      device.transfer_count += tic_handle_stats_get_transfer_count(p, request);
+      device.transfer_error_count += tic_handle_stats_get_error_count(p, request);
+      device.transfer_timeout_count +=
+        tic_handle_stats_get_timeout_count(p, request);
+      device.transfer_latency_us +=
+        tic_handle_stats_get_total_latency_us(p, request);
+      tic_handle_stats_get_latency_histogram(p, request, histogram);
+      for (size_t i = 0; i < TIC_HANDLE_STATS_HISTOGRAM_SIZE; i++)
+      {
+        device.transfer_histogram[i] += histogram[i];
+      }
+    }
+  }
+}
+
+void metrics_server::line(const char * format, ...)
+{
+  char buffer[256];
+  va_list ap;
+  va_start(ap, format);
+  int length = vsnprintf(buffer, sizeof(buffer), format, ap);
+  va_end(ap);
+  if (length < 0) { return; }
+  if ((size_t)length >= sizeof(buffer)) { length = sizeof(buffer) - 1; }
+  body.append(buffer, length);
+}
+
+void metrics_server::family(const char * name, const char * type,
+  const char * unit, const char * help)
+{
+  line("# TYPE %s %s\n", name, type);
+  if (unit) { line("# UNIT %s %s\n", name, unit); }
+  line("# HELP %s %s\n", name, help);
+}
+
+void metrics_server::render()
+{
+  body.clear();
+
+  family("tic_up", "gauge", NULL,
+    "Whether the last read of the variables succeeded.");
+  for (const metrics_device & d : devices)
+  {
+    line("tic_up{%s} %d\n", d.labels.c_str(), d.last_sample_ok);
+  }
+
+  family("tic_sample_duration_seconds", "gauge", "seconds",
+    "How long the last read of the variables took.");
+  for (const metrics_device & d : devices)
+  {
+    line("tic_sample_duration_seconds{%s} %.6f\n", d.labels.c_str(),
+      d.sample_latency_us / 1e6);
+  }
+
+  // The rest of the variables are only reported once we have read them.
+  family("tic_operation_state", "gauge", NULL,
+    "The operation state (TIC_OPERATION_STATE_*).");
+  for (const metrics_device & d : devices)
+  {
+    if (!d.vars_valid) { continue; }
+    line("tic_operation_state{%s} %u\n", d.labels.c_str(),
+      d.vars.get_operation_state());
+  }
+
+  family("tic_energized", "gauge", NULL,
+    "Whether the motor driver is energized.");
+  for (const metrics_device & d : devices)
+  {
+    if (!d.vars_valid) { continue; }
+    line("tic_energized{%s} %d\n", d.labels.c_str(), d.vars.get_energized());
+  }
+
+  family("tic_current_position", "gauge", NULL,
+    "The current position, in microsteps.");
+  for (const metrics_device & d : devices)
+  {
+    if (!d.vars_valid) { continue; }
+    line("tic_current_position{%s} %d\n", d.labels.c_str(),
+      (int)d.vars.get_current_position());
+  }
+
+  family("tic_target_position", "gauge", NULL,
+    "The target position, in microsteps.  Only meaningful in target position "
+    "mode.");
+  for (const metrics_device & d : devices)
+  {
+    if (!d.vars_valid) { continue; }
+    line("tic_target_position{%s} %d\n", d.labels.c_str(),
+      (int)d.vars.get_target_position());
+  }
+
+  family("tic_current_velocity", "gauge", NULL,
+    "The current velocity, in microsteps per second.");
+  for (const metrics_device & d : devices)
+  {
+    if (!d.vars_valid) { continue; }
+    line("tic_current_velocity{%s} %.4f\n", d.labels.c_str(),
+      d.vars.get_current_velocity() / (double)TIC_SPEED_UNITS_PER_HZ);
+  }
+
+  family("tic_vin_volts", "gauge", "volts",
+    "The voltage on the VIN pin.");
+  for (const metrics_device & d : devices)
+  {
+    if (!d.vars_valid) { continue; }
+    line("tic_vin_volts{%s} %.3f\n", d.labels.c_str(),
+      d.vars.get_vin_voltage() / 1000.0);
+  }
+
+  family("tic_up_time_seconds", "gauge", "seconds",
+    "The time since the Tic was last reset.");
+  for (const metrics_device & d : devices)
+  {
+    if (!d.vars_valid) { continue; }
+    line("tic_up_time_seconds{%s} %.3f\n", d.labels.c_str(),
+      d.vars.get_up_time() / 1000.0);
+  }
+
+  family("tic_error_status", "gauge", NULL,
+    "Whether each error that can stop the motor is currently active.");
+  for (const metrics_device & d : devices)
+  {
+    if (!d.vars_valid) { continue; }
+    uint16_t status = d.vars.get_error_status();
+    for (size_t i = 0; i < metrics_error_bit_count; i++)
+    {
+      if (metrics_error_bits[i] >= 16) { continue; }
+      line("tic_error_status{%s,error=\"%s\"} %d\n", d.labels.c_str(),
+        error_labels[i].c_str(), status >> metrics_error_bits[i] & 1);
+    }
+  }
+
+  family("tic_errors_occurred", "counter", NULL,
+    "The number of samples where the Tic reported that each error had "
+    "happened since the last sample.");
+  for (const metrics_device & d : devices)
+  {
+    for (size_t i = 0; i < metrics_error_bit_count; i++)
+    {
+      line("tic_errors_occurred_total{%s,error=\"%s\"} %llu\n",
+        d.labels.c_str(), error_labels[i].c_str(),
+        (unsigned long long)d.errors_occurred[i]);
+    }
+  }
+
+  family("tic_transfers", "counter", NULL,
+    "The number of commands and requests sent to the Tic.");
+  for (const metrics_device & d : devices)
+  {
+    line("tic_transfers_total{%s} %llu\n", d.labels.c_str(),
+      (unsigned long long)d.transfer_count);
+  }
+
+  family("tic_transfer_errors", "counter", NULL,
+    "The number of commands and requests that failed, including timeouts.");
+  for (const metrics_device & d : devices)
+  {
+    line("tic_transfer_errors_total{%s} %llu\n", d.labels.c_str(),
+      (unsigned long long)d.transfer_error_count);
+  }
+
+  family("tic_transfer_timeouts", "counter", NULL,
+    "The number of commands and requests that timed out.");
+  for (const metrics_device & d : devices)
+  {
+    line("tic_transfer_timeouts_total{%s} %llu\n", d.labels.c_str(),
+      (unsigned long long)d.transfer_timeout_count);
+  }
+
+  // Bucket i of the handle's histogram holds latencies below 2^i us (bucket 0
+  // only holds 0), and the last bucket holds everything above that.
+  family("tic_transfer_latency_seconds", "histogram", "seconds",
+    "How long commands and requests sent to the Tic took.");
+  for (const metrics_device & d : devices)
+  {
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i < TIC_HANDLE_STATS_HISTOGRAM_SIZE - 1; i++)
+    {
+      cumulative += d.transfer_histogram[i];
+      line("tic_transfer_latency_seconds_bucket{%s,le=\"%.7g\"} %llu\n",
+        d.labels.c_str(), ((1ull << i) - 1) / 1e6,
+        (unsigned long long)cumulative);
+    }
+    line("tic_transfer_latency_seconds_bucket{%s,le=\"+Inf\"} %llu\n",
+      d.labels.c_str(), (unsigned long long)d.transfer_count);
+    line("tic_transfer_latency_seconds_count{%s} %llu\n",
+      d.labels.c_str(), (unsigned long long)d.transfer_count);
+    line("tic_transfer_latency_seconds_sum{%s} %.6f\n",
+      d.labels.c_str(), d.transfer_latency_us / 1e6);
+  }
+
+  body += "# EOF\n";
+
+  response.clear();
+  char header[256];
+  snprintf(header, sizeof(header),
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: %s\r\n"
+    "Content-Length: %zu\r\n"
+    "Connection: close\r\n"
+    "\r\n", metrics_content_type, body.size());
+  response += header;
+  response += body;
+}
+
+void metrics_server::accept_client()
+{
+  int fd = accept(listen_fd, NULL, NULL);
+  if (fd < 0) { return; }
+  if (!metrics_set_non_blocking(fd))
+  {
+    close(fd);
+    return;
+  }
+
+  for (metrics_client & c : clients)
+  {
+    if (c.fd >= 0) { continue; }
+    c.fd = fd;
+    c.start = std::chrono::steady_clock::now();
+    c.in.clear();
+    c.out.clear();
+    c.out_sent = 0;
+    c.responding = false;
+    return;
+  }
+
+  // We do not poll the listening socket when every slot is busy, so this
+  // should not happen.
+  close(fd);
+}
+
+void metrics_server::drop_client(metrics_client & c)
+{
+  close(c.fd);
+  c.fd = -1;
+}
+
+// Returns false if the client should be disconnected.
+bool metrics_server::read_request(metrics_client & c)
+{
+  char buffer[1024];
+  ssize_t received = recv(c.fd, buffer, sizeof(buffer), 0);
+  if (received < 0) { return errno == EINTR || errno == EAGAIN; }
+  if (received == 0) { return false; }
+  c.in.append(buffer, received);
+
+  size_t end = c.in.find("\r\n\r\n");
+  if (end == std::string::npos)
+  {
+    return c.in.size() < metrics_max_request_size;
+  }
+
+  // We only care about the request line.  Every path is the metrics page
+  // except for the ones that scrapers and browsers ask for on their own.
+  bool head = c.in.compare(0, 5, "HEAD ") == 0;
+  bool get = c.in.compare(0, 4, "GET ") == 0;
+  size_t path_start = head ? 5 : 4;
+  bool found = c.in.compare(path_start, 12, "/favicon.ico") != 0 &&
+    c.in.compare(path_start, 11, "/robots.txt") != 0;
+
+  const std::string & r = !(get || head) ? not_allowed_response :
+    found ? response : not_found_response;
+  if (head) { c.out.assign(r, 0, r.find("\r\n\r\n") + 4); }
+  else { c.out.assign(r); }
+  c.out_sent = 0;
+  c.responding = true;
+  return true;
+}
+
+// Returns false if the client should be disconnected, which is also what
+// happens after the whole response is sent.  If the socket buffer is full,
+// the rest of the response waits in the client's output buffer until poll()
+// says there is room.
+bool metrics_server::write_response(metrics_client & c)
+{
+  ssize_t sent = send(c.fd, c.out.data() + c.out_sent,
+    c.out.size() - c.out_sent, MSG_NOSIGNAL);
+  if (sent < 0) { return errno == EINTR || errno == EAGAIN; }
+  if (sent == 0) { return false; }
+  c.out_sent += sent;
+  return c.out_sent < c.out.size();
+}
+
+void metrics_server::run()
+{
+  not_found_response =
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 10\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "Not found\n";
+  not_allowed_response =
+    "HTTP/1.1 405 Method Not Allowed\r\n"
+    "Allow: GET, HEAD\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 19\r\n"
+    "Connection: close\r\n"
+    "\r\n"
+    "Method not allowed\n";
+
+  std::vector<struct pollfd> fds;
+  fds.reserve(metrics_max_clients + 1);
+
+  auto next_sample = std::chrono::steady_clock::now();
+  while (!metrics_stop_requested)
+  {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= next_sample)
+    {
+      sample();
+      render();
+
+      // If sampling falls behind, skip the samples we missed instead of
+      // trying to catch up.
+      next_sample += interval;
+      now = std::chrono::steady_clock::now();
+      if (next_sample < now) { next_sample = now + interval; }
+    }
+
+    fds.clear();
+    size_t client_count = 0;
+    for (metrics_client & c : clients)
+    {
+      if (c.fd < 0) { continue; }
+      client_count++;
+      if (now - c.start > metrics_client_timeout)
+      {
+        drop_client(c);
+        continue;
+      }
+      struct pollfd pfd = { c.fd, (short)(c.responding ? POLLOUT : POLLIN), 0 };
+      fds.push_back(pfd);
+    }
+    if (client_count < metrics_max_clients)
+    {
+      struct pollfd pfd = { listen_fd, POLLIN, 0 };
+      fds.push_back(pfd);
+    }
+
+    int timeout_ms = (int)std::chrono::duration_cast<
+      std::chrono::milliseconds>(next_sample - now).count() + 1;
+    int result = poll(fds.data(), fds.size(), timeout_ms);
+    if (result < 0)
+    {
+      if (errno == EINTR) { continue; }
+      throw std::runtime_error(std::string("poll: ") + strerror(errno) + ".");
+    }
+
+    for (const struct pollfd & pfd : fds)
+    {
+      if (pfd.revents == 0) { continue; }
+      if (pfd.fd == listen_fd)
+      {
+        accept_client();
+        continue;
+      }
+
+      for (metrics_client & c : clients)
+      {
+        if (c.fd != pfd.fd) { continue; }
+        bool keep = c.responding ? write_response(c) : read_request(c);
+        if (keep && c.responding && c.out_sent == 0)
+        {
+          // Most responses fit in the socket buffer, so try sending right
+          // away instead of waiting for another trip through poll().
+          keep = write_response(c);
+        }
+        if (!keep) { drop_client(c); }
+        break;
+      }
+    }
+  }
+}
+
+void serve_metrics(const std::string & address, uint32_t interval_ms,
+  device_selector & selector)
+{
+  // If there is only one device to choose from (or -d or --emulate was used),
+  // we use the same handle as the other commands.  Otherwise we serve every
+  // connected Tic.
+  std::vector<tic::handle> extra_handles;
+  std::vector<metrics_device> devices;
+  std::vector<tic::device> list = selector.list_devices();
+  if (list.size() <= 1)
+  {
+    metrics_device device;
+    device.handle = &selector.select_handle();
+    devices.push_back(std::move(device));
+  }
+  else
+  {
+    extra_handles.reserve(list.size());
+    for (const tic::device & d : list)
+    {
+      extra_handles.emplace_back(d);
+      metrics_device device;
+      device.handle = &extra_handles.back();
+      devices.push_back(std::move(device));
+    }
+  }
+
+  for (metrics_device & device : devices)
+  {
+    tic::device d = device.handle->get_device();
+    device.labels = "serial_number=\"" +
+      metrics_escape_label(d.get_serial_number()) + "\"";
+  }
+
+  metrics_server server(devices, interval_ms);
+  server.open_socket(address);
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = metrics_handle_stop_signal;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  std::cerr << "Serving metrics for " << devices.size()
+    << (devices.size() == 1 ? " device" : " devices") << " on "
+    << address << "." << std::endl;
+
+  server.run();
+}
+
+#endif
@@ -109,7 +109,8 @@ void print_status(const tic::variables & vars,
   const std::string & name,
   const std::string & serial_number,
   const std::string & firmware_version,
-  bool full_output)
+  bool full_output,
+  uint32_t missed_errors_occurred)
 {
   // The output here is YAML so that people can more easily write scripts that
   // use it.
@@ -294,7 +295,7 @@ void print_status(const tic::variables & vars,
 
   print_errors(vars.get_error_status(),
     "Errors currently stopping the motor");
-  print_errors(vars.get_errors_occurred(),
+  print_errors(vars.get_errors_occurred() | missed_errors_occurred,
     "Errors that occurred since last check");
   if (product == TIC_PRODUCT_36V4)
   {
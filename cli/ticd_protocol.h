@@ -0,0 +1,443 @@
+// Definitions and encoding helpers for the protocol that ticd uses to talk to
+// its clients over a Unix domain socket.
+//
+// Every message, in either direction, is a 32-bit little-endian length
+// followed by that many bytes of payload.  The first byte of a request payload
+// is one of the TICD_REQUEST_* codes, and the first byte of a response payload
+// is one of the TICD_RESPONSE_* codes.  The rest of the payload is made of
+// little-endian integers and strings, where a string is a 16-bit length
+// followed by that many bytes.  Each request gets exactly one response, and
+// responses are sent in the same order as the requests.
+//
+// This header is private to ticd and ticcmd; it is not installed.
+
+#pragma once
+
+#include <tic.hpp>
+
+#include <cstdint>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// The directory the socket goes in when XDG_RUNTIME_DIR is not set, which is
+// usually the case for a system daemon.  ticd creates it with mode 0700.
+#define TICD_RUNTIME_DIR "/run/ticd"
+
+#define TICD_SOCKET_NAME "ticd.sock"
+
+// Environment variable that overrides the socket path for clients.
+#define TICD_SOCKET_ENV "TICD_SOCKET"
+
+// Returns where the socket is if no other path was given.  This is in the
+// user's runtime directory, which other users cannot write to, so they cannot
+// put their own socket there and pretend to be the daemon.
+inline std::string ticd_default_socket_path()
+{
+  const char * dir = getenv("XDG_RUNTIME_DIR");
+  if (dir != NULL && dir[0] != 0)
+  {
+    return std::string(dir) + "/" TICD_SOCKET_NAME;
+  }
+  return TICD_RUNTIME_DIR "/" TICD_SOCKET_NAME;
+}
+
+// Messages larger than this are treated as a protocol error.
+#define TICD_MAX_MESSAGE_SIZE 0x10000
+
+// Requests.  Most requests start with the serial number of the device they
+// are for, which can be empty if only one device is connected.
+
+// Payload: none.
+// Response: u8 count, then for each device: u8 product,
+// u16 firmware version, str serial number, str name.
+#define TICD_REQUEST_LIST 1
+
+// Payload: str serial number, u8 TIC_CMD_* code, i32 value.
+// For TIC_CMD_SET_AGC_OPTION the value is (option << 4) | option value.
+// For TIC_CMD_SET_CURRENT_LIMIT the value is in milliamps.
+// Response: none.
+#define TICD_REQUEST_COMMAND 2
+
+// Payload: str serial number, u8 clear errors occurred.
+// Response: a ticd_variables record.
+#define TICD_REQUEST_GET_VARIABLES 3
+
+// Payload: str serial number, u8 full output.
+// Response: str status text, formatted the same way as ticcmd --status.
+#define TICD_REQUEST_GET_STATUS 4
+
+// Payload: str serial number.
+// Response: str settings file, str warnings.
+#define TICD_REQUEST_GET_SETTINGS 5
+
+// Payload: str serial number, str settings file.
+// Response: str warnings.
+#define TICD_REQUEST_SET_SETTINGS 6
+
+// Payload: str serial number.
+// Response: none.
+#define TICD_REQUEST_RESTORE_DEFAULTS 7
+
+// Responses.
+
+// The rest of the payload depends on the request.
+#define TICD_RESPONSE_OK 0
+
+// Payload: u8 TICD_ERROR_* code, str message.
+#define TICD_RESPONSE_ERROR 1
+
+// Error codes.
+#define TICD_ERROR_OPERATION_FAILED 1
+#define TICD_ERROR_DEVICE_NOT_FOUND 2
+#define TICD_ERROR_DEVICE_MULTIPLE_FOUND 3
+#define TICD_ERROR_BAD_REQUEST 4
+
+// Builds a message payload.
+class ticd_writer
+{
+public:
+  void u8(uint8_t v)
+  {
+    data.push_back(v);
+  }
+
+  void u16(uint16_t v)
+  {
+    u8(v & 0xFF);
+    u8(v >> 8 & 0xFF);
+  }
+
+  void u32(uint32_t v)
+  {
+    u16(v & 0xFFFF);
+    u16(v >> 16 & 0xFFFF);
+  }
+
+  void i32(int32_t v)
+  {
+    u32((uint32_t)v);
+  }
+
+  void str(const std::string & s)
+  {
+    if (s.size() > 0xFFFF)
+    {
+      throw std::runtime_error("String is too long to send to ticd.");
+    }
+    u16(s.size());
+    data.insert(data.end(), s.begin(), s.end());
+  }
+
+  // Returns the payload with its length prefix.
+  std::vector<uint8_t> framed() const
+  {
+    ticd_writer frame;
+    frame.u32(data.size());
+    frame.data.insert(frame.data.end(), data.begin(), data.end());
+    return frame.data;
+  }
+
+  std::vector<uint8_t> data;
+};
+
+// Reads a message payload.  Throws an exception if the payload is too short.
+class ticd_reader
+{
+public:
+  explicit ticd_reader(const std::vector<uint8_t> & data)
+    : data(data), index(0)
+  {
+  }
+
+  uint8_t u8()
+  {
+    need(1);
+    return data[index++];
+  }
+
+  uint16_t u16()
+  {
+    uint16_t v = u8();
+    return v | u8() << 8;
+  }
+
+  uint32_t u32()
+  {
+    uint32_t v = u16();
+    return v | (uint32_t)u16() << 16;
+  }
+
+  int32_t i32()
+  {
+    return (int32_t)u32();
+  }
+
+  std::string str()
+  {
+    size_t size = u16();
+    need(size);
+    std::string s(data.begin() + index, data.begin() + index + size);
+    index += size;
+    return s;
+  }
+
+private:
+  void need(size_t size)
+  {
+    if (data.size() - index < size)
+    {
+      throw std::runtime_error("Message from ticd is too short.");
+    }
+  }
+
+  const std::vector<uint8_t> & data;
+  size_t index;
+};
+
+// The variables sent in response to TICD_REQUEST_GET_VARIABLES.  This holds
+// the same information as tic::variables except for the pin readings.
+struct ticd_variables
+{
+  uint8_t product = 0;
+  uint8_t operation_state = 0;
+  bool energized = false;
+  bool position_uncertain = false;
+  bool forward_limit_active = false;
+  bool reverse_limit_active = false;
+  bool homing_active = false;
+  uint16_t error_status = 0;
+  uint32_t errors_occurred = 0;
+  uint8_t planning_mode = 0;
+  int32_t target_position = 0;
+  int32_t target_velocity = 0;
+  uint32_t starting_speed = 0;
+  uint32_t max_speed = 0;
+  uint32_t max_decel = 0;
+  uint32_t max_accel = 0;
+  int32_t current_position = 0;
+  int32_t current_velocity = 0;
+  int32_t acting_target_position = 0;
+  uint32_t time_since_last_step = 0;
+  uint8_t device_reset = 0;
+  uint32_t vin_voltage = 0;
+  uint32_t up_time = 0;
+  int32_t encoder_position = 0;
+  uint16_t rc_pulse_width = 0;
+  uint8_t step_mode = 0;
+  uint8_t current_limit_code = 0;
+  uint8_t decay_mode = 0;
+  uint8_t input_state = 0;
+  uint16_t input_after_averaging = 0;
+  uint16_t input_after_hysteresis = 0;
+  int32_t input_after_scaling = 0;
+  uint8_t last_motor_driver_error = 0;
+  uint32_t last_hp_driver_errors = 0;
+
+  ticd_variables()
+  {
+  }
+
+  ticd_variables(const tic::variables & vars, uint8_t product)
+    : product(product),
+      operation_state(vars.get_operation_state()),
+      energized(vars.get_energized()),
+      position_uncertain(vars.get_position_uncertain()),
+      forward_limit_active(vars.get_forward_limit_active()),
+      reverse_limit_active(vars.get_reverse_limit_active()),
+      homing_active(vars.get_homing_active()),
+      error_status(vars.get_error_status()),
+      errors_occurred(vars.get_errors_occurred()),
+      planning_mode(vars.get_planning_mode()),
+      target_position(vars.get_target_position()),
+      target_velocity(vars.get_target_velocity()),
+      starting_speed(vars.get_starting_speed()),
+      max_speed(vars.get_max_speed()),
+      max_decel(vars.get_max_decel()),
+      max_accel(vars.get_max_accel()),
+      current_position(vars.get_current_position()),
+      current_velocity(vars.get_current_velocity()),
+      acting_target_position(vars.get_acting_target_position()),
+      time_since_last_step(vars.get_time_since_last_step()),
+      device_reset(vars.get_device_reset()),
+      vin_voltage(vars.get_vin_voltage()),
+      up_time(vars.get_up_time()),
+      encoder_position(vars.get_encoder_position()),
+      rc_pulse_width(vars.get_rc_pulse_width()),
+      step_mode(vars.get_step_mode()),
+      current_limit_code(vars.get_current_limit_code()),
+      decay_mode(vars.get_decay_mode()),
+      input_state(vars.get_input_state()),
+      input_after_averaging(vars.get_input_after_averaging()),
+      input_after_hysteresis(vars.get_input_after_hysteresis()),
+      input_after_scaling(vars.get_input_after_scaling()),
+      last_motor_driver_error(vars.get_last_motor_driver_error()),
+      last_hp_driver_errors(vars.get_last_hp_driver_errors())
+  {
+  }
+
+  void write(ticd_writer & w) const
+  {
+    w.u8(product);
+    w.u8(operation_state);
+    w.u8(energized | position_uncertain << 1 | forward_limit_active << 2 |
+      reverse_limit_active << 3 | homing_active << 4);
+    w.u16(error_status);
+    w.u32(errors_occurred);
+    w.u8(planning_mode);
+    w.i32(target_position);
+    w.i32(target_velocity);
+    w.u32(starting_speed);
+    w.u32(max_speed);
+    w.u32(max_decel);
+    w.u32(max_accel);
+    w.i32(current_position);
+    w.i32(current_velocity);
+    w.i32(acting_target_position);
+    w.u32(time_since_last_step);
+    w.u8(device_reset);
+    w.u32(vin_voltage);
+    w.u32(up_time);
+    w.i32(encoder_position);
+    w.u16(rc_pulse_width);
+    w.u8(step_mode);
+    w.u8(current_limit_code);
+    w.u8(decay_mode);
+    w.u8(input_state);
+    w.u16(input_after_averaging);
+    w.u16(input_after_hysteresis);
+    w.i32(input_after_scaling);
+    w.u8(last_motor_driver_error);
+    w.u32(last_hp_driver_errors);
+  }
+
+  void read(ticd_reader & r)
+  {
+    product = r.u8();
+    operation_state = r.u8();
+    uint8_t flags = r.u8();
+    energized = flags >> 0 & 1;
+    position_uncertain = flags >> 1 & 1;
+    forward_limit_active = flags >> 2 & 1;
+    reverse_limit_active = flags >> 3 & 1;
+    homing_active = flags >> 4 & 1;
+    error_status = r.u16();
+    errors_occurred = r.u32();
+    planning_mode = r.u8();
+    target_position = r.i32();
+    target_velocity = r.i32();
+    starting_speed = r.u32();
+    max_speed = r.u32();
+    max_decel = r.u32();
+    max_accel = r.u32();
+    current_position = r.i32();
+    current_velocity = r.i32();
+    acting_target_position = r.i32();
+    time_since_last_step = r.u32();
+    device_reset = r.u8();
+    vin_voltage = r.u32();
+    up_time = r.u32();
+    encoder_position = r.i32();
+    rc_pulse_width = r.u16();
+    step_mode = r.u8();
+    current_limit_code = r.u8();
+    decay_mode = r.u8();
+    input_state = r.u8();
+    input_after_averaging = r.u16();
+    input_after_hysteresis = r.u16();
+    input_after_scaling = r.i32();
+    last_motor_driver_error = r.u8();
+    last_hp_driver_errors = r.u32();
+  }
+};
+
+// Sends a command from a TICD_REQUEST_COMMAND request to a Tic.  Returns
+// false if the command or AGC option is not one we know.  ticcmd also uses
+// this when it talks to the device directly, so that both ways of running
+// commands stay the same.
+inline bool ticd_run_command(tic::handle & handle, uint8_t cmd, int32_t value)
+{
+  switch (cmd)
+  {
+  case TIC_CMD_SET_TARGET_POSITION:
+    handle.set_target_position(value);
+    break;
+  case TIC_CMD_SET_TARGET_VELOCITY:
+    handle.set_target_velocity(value);
+    break;
+  case TIC_CMD_HALT_AND_SET_POSITION:
+    handle.halt_and_set_position(value);
+    break;
+  case TIC_CMD_HALT_AND_HOLD:
+    handle.halt_and_hold();
+    break;
+  case TIC_CMD_GO_HOME:
+    handle.go_home(value);
+    break;
+  case TIC_CMD_RESET_COMMAND_TIMEOUT:
+    handle.reset_command_timeout();
+    break;
+  case TIC_CMD_DEENERGIZE:
+    handle.deenergize();
+    break;
+  case TIC_CMD_ENERGIZE:
+    handle.energize();
+    break;
+  case TIC_CMD_EXIT_SAFE_START:
+    handle.exit_safe_start();
+    break;
+  case TIC_CMD_ENTER_SAFE_START:
+    handle.enter_safe_start();
+    break;
+  case TIC_CMD_RESET:
+    handle.reset();
+    break;
+  case TIC_CMD_CLEAR_DRIVER_ERROR:
+    handle.clear_driver_error();
+    break;
+  case TIC_CMD_SET_MAX_SPEED:
+    handle.set_max_speed(value);
+    break;
+  case TIC_CMD_SET_STARTING_SPEED:
+    handle.set_starting_speed(value);
+    break;
+  case TIC_CMD_SET_MAX_ACCEL:
+    handle.set_max_accel(value);
+    break;
+  case TIC_CMD_SET_MAX_DECEL:
+    handle.set_max_decel(value);
+    break;
+  case TIC_CMD_SET_STEP_MODE:
+    handle.set_step_mode(value);
+    break;
+  case TIC_CMD_SET_CURRENT_LIMIT:
+    handle.set_current_limit(value);
+    break;
+  case TIC_CMD_SET_DECAY_MODE:
+    handle.set_decay_mode(value);
+    break;
+  case TIC_CMD_SET_AGC_OPTION:
+    switch (value >> 4 & 7)
+    {
+    case TIC_AGC_OPTION_MODE:
+      handle.set_agc_mode(value & 0xF);
+      break;
+    case TIC_AGC_OPTION_BOTTOM_CURRENT_LIMIT:
+      handle.set_agc_bottom_current_limit(value & 0xF);
+      break;
+    case TIC_AGC_OPTION_CURRENT_BOOST_STEPS:
+      handle.set_agc_current_boost_steps(value & 0xF);
+      break;
+    case TIC_AGC_OPTION_FREQUENCY_LIMIT:
+      handle.set_agc_frequency_limit(value & 0xF);
+      break;
+    default:
+      return false;
+    }
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,874 @@
+// ticd: A daemon that owns the Tics connected to the computer and lets
+// several local programs share them through a Unix domain socket.
+//
+// The daemon is single-threaded.  Commands are sent to the device as soon as
+// they arrive, so commands from different clients are naturally serialized.
+// Requests for variables are held until the next poll period, and then all of
+// the requests waiting for a device are answered with a single read.
+
+#include <tic.hpp>
+#include <string_to_int.h>
+#include "config.h"
+#include "cli.h"
+#include "ticd_protocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const char help[] =
+  DAEMON_NAME ": Pololu Tic Device Daemon\n"
+  "Version " SOFTWARE_VERSION_STRING "\n"
+  "Usage: " DAEMON_NAME " OPTIONS\n"
+  "\n"
+  "Options:\n"
+  "  --socket PATH                Listen on PATH instead of the default,\n"
+  "                               $XDG_RUNTIME_DIR/" TICD_SOCKET_NAME ", or\n"
+  "                               " TICD_RUNTIME_DIR "/" TICD_SOCKET_NAME " if XDG_RUNTIME_DIR\n"
+  "                               is not set.\n"
+  "  --poll-period MS             Minimum time between variable reads from\n"
+  "                               each device (default: 20).\n"
+  "  -h, --help                   Show this help screen.\n"
+  "\n"
+  "Use '" CLI_NAME " --via-daemon' to send commands through the daemon.\n"
+  "\n";
+
+typedef std::chrono::steady_clock clock_type;
+
+// If this many bytes of responses pile up for a client that is not reading
+// them, we disconnect it instead of buffering more.
+static const size_t max_client_output = 1 << 20;
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_stop_signal(int)
+{
+  stop_requested = 1;
+}
+
+class ticd_error : public std::runtime_error
+{
+public:
+  ticd_error(uint8_t code, const std::string & message)
+    : std::runtime_error(message), code(code)
+  {
+  }
+
+  uint8_t code;
+};
+
+struct client
+{
+  explicit client(int fd) : fd(fd)
+  {
+  }
+
+  int fd;
+  std::vector<uint8_t> input;
+  std::vector<uint8_t> output;
+
+  // True if the client is waiting for a response to a variable read.  We
+  // stop reading requests from the client until that response is sent so that
+  // responses always go out in the same order as the requests.
+  bool waiting = false;
+
+  // For each device, the errors occurred bits that were cleared by reads
+  // this client did not ask to clear.  They are added to what the client
+  // sees until it clears them itself, so that a client only loses the bits
+  // it asked to clear.
+  std::map<std::string, uint32_t> missed_errors_occurred;
+};
+
+struct pending_read
+{
+  client * requester;
+  uint8_t request;
+  bool flag;
+};
+
+struct managed_device
+{
+  tic::device device;
+  tic::handle handle;
+  std::vector<pending_read> pending;
+  clock_type::time_point last_read;
+};
+
+class device_broker
+{
+public:
+  device_broker(const std::string & socket_path, uint32_t poll_period_ms)
+    : socket_path(socket_path), poll_period(poll_period_ms)
+  {
+  }
+
+  ~device_broker()
+  {
+    for (client & c : clients) { close(c.fd); }
+    if (listen_fd >= 0)
+    {
+      close(listen_fd);
+      unlink(socket_path.c_str());
+    }
+  }
+
+  void run()
+  {
+    open_socket();
+
+    try
+    {
+      refresh_devices();
+    }
+    catch (const std::exception & error)
+    {
+      std::cerr << "Warning: " << error.what() << std::endl;
+    }
+
+    while (!stop_requested)
+    {
+      std::vector<struct pollfd> fds;
+      fds.push_back({ listen_fd, POLLIN, 0 });
+      for (client & c : clients)
+      {
+        short events = 0;
+        if (!c.waiting) { events |= POLLIN; }
+        if (!c.output.empty()) { events |= POLLOUT; }
+        fds.push_back({ c.fd, events, 0 });
+      }
+      int monitor_fd = monitor ? monitor.get_fd() : -1;
+      if (monitor_fd >= 0) { fds.push_back({ monitor_fd, POLLIN, 0 }); }
+
+      int result = poll(fds.data(), fds.size(), poll_timeout_ms());
+      if (result < 0)
+      {
+        if (errno == EINTR) { continue; }
+        throw std::runtime_error(std::string("poll: ") + strerror(errno) + ".");
+      }
+
+      if (fds[0].revents & POLLIN) { accept_client(); }
+
+      if (monitor_fd >= 0 && fds.back().revents & POLLIN)
+      {
+        handle_hotplug();
+
+        // The monitor waits for a device to settle before it scans, so
+        // check again after that.
+        hotplug_recheck = clock_type::now() + hotplug_settle_time;
+      }
+      else if (hotplug_recheck != clock_type::time_point::max() &&
+        clock_type::now() >= hotplug_recheck)
+      {
+        hotplug_recheck = clock_type::time_point::max();
+        handle_hotplug();
+      }
+
+      size_t i = 1;
+      for (auto it = clients.begin(); it != clients.end(); i++)
+      {
+        client & c = *it;
+        bool ok = true;
+        if (i < fds.size() && fds[i].fd == c.fd)
+        {
+          if (ok && (fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+          {
+            ok = read_from_client(c);
+          }
+          if (ok && (fds[i].revents & POLLOUT))
+          {
+            ok = write_to_client(c);
+          }
+        }
+        if (c.output.size() > max_client_output) { ok = false; }
+
+        if (ok)
+        {
+          ++it;
+        }
+        else
+        {
+          drop_client(c);
+          it = clients.erase(it);
+        }
+      }
+
+      serve_pending_reads();
+      resume_clients();
+    }
+  }
+
+private:
+  // Creates TICD_RUNTIME_DIR if the socket goes there, and makes sure that no
+  // other user can put things in it.
+  void prepare_runtime_dir()
+  {
+    if (socket_path != TICD_RUNTIME_DIR "/" TICD_SOCKET_NAME) { return; }
+
+    if (mkdir(TICD_RUNTIME_DIR, 0700) && errno != EEXIST)
+    {
+      throw std::runtime_error(std::string(TICD_RUNTIME_DIR ": ") +
+        strerror(errno) + ".");
+    }
+
+    struct stat info;
+    if (lstat(TICD_RUNTIME_DIR, &info))
+    {
+      throw std::runtime_error(std::string(TICD_RUNTIME_DIR ": ") +
+        strerror(errno) + ".");
+    }
+    if (!S_ISDIR(info.st_mode) || info.st_uid != geteuid() ||
+      (info.st_mode & 077))
+    {
+      throw std::runtime_error(TICD_RUNTIME_DIR " must be a directory owned "
+        "by the user running " DAEMON_NAME " that only that user can access.");
+    }
+  }
+
+  void open_socket()
+  {
+    prepare_runtime_dir();
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socket_path.size() >= sizeof(address.sun_path))
+    {
+      throw std::runtime_error("The socket path is too long.");
+    }
+    strcpy(address.sun_path, socket_path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+      throw std::runtime_error(std::string("socket: ") + strerror(errno) + ".");
+    }
+
+    // If there is a stale socket left over from a daemon that did not exit
+    // cleanly, remove it, but do not steal the socket from a running daemon.
+    if (connect(listen_fd, (struct sockaddr *)&address, sizeof(address)) == 0)
+    {
+      close(listen_fd);
+      listen_fd = -1;
+      throw std::runtime_error("Another " DAEMON_NAME " is already listening on "
+        + socket_path + ".");
+    }
+    close(listen_fd);
+    unlink(socket_path.c_str());
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+      throw std::runtime_error(std::string("socket: ") + strerror(errno) + ".");
+    }
+
+    // Only the user running the daemon can connect to the socket.  Setting
+    // the mode with the umask means there is no moment when others can.
+    mode_t old_umask = umask(0177);
+    int bind_result = bind(listen_fd, (struct sockaddr *)&address,
+      sizeof(address));
+    umask(old_umask);
+    if (bind_result)
+    {
+      int error_code = errno;
+      close(listen_fd);
+      listen_fd = -1;
+      throw std::runtime_error(socket_path + ": " + strerror(error_code) + ".");
+    }
+
+    if (listen(listen_fd, 16))
+    {
+      throw std::runtime_error(std::string("listen: ") + strerror(errno) + ".");
+    }
+  }
+
+  void accept_client()
+  {
+    int fd = accept(listen_fd, NULL, NULL);
+    if (fd < 0) { return; }
+
+    // Client sockets are non-blocking so that a client that stops reading
+    // cannot stall the other clients and devices.  Responses that do not fit
+    // in the socket buffer wait in the client's output buffer.
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+    {
+      close(fd);
+      return;
+    }
+
+    clients.emplace_back(fd);
+  }
+
+  void drop_client(client & c)
+  {
+    close(c.fd);
+    resumed.erase(std::remove(resumed.begin(), resumed.end(), &c),
+      resumed.end());
+    for (auto & pair : devices)
+    {
+      std::vector<pending_read> & pending = pair.second.pending;
+      for (auto it = pending.begin(); it != pending.end(); )
+      {
+        if (it->requester == &c) { it = pending.erase(it); }
+        else { ++it; }
+      }
+    }
+  }
+
+  // Returns false if the client should be disconnected.
+  bool read_from_client(client & c)
+  {
+    uint8_t buffer[4096];
+    ssize_t received = recv(c.fd, buffer, sizeof(buffer), 0);
+    if (received < 0) { return errno == EINTR || errno == EAGAIN; }
+    if (received == 0) { return false; }
+    c.input.insert(c.input.end(), buffer, buffer + received);
+    return process_input(c);
+  }
+
+  // Returns false if the client should be disconnected.
+  bool process_input(client & c)
+  {
+    while (!c.waiting && c.input.size() >= 4)
+    {
+      uint32_t size = c.input[0] | c.input[1] << 8 |
+        c.input[2] << 16 | (uint32_t)c.input[3] << 24;
+      if (size == 0 || size > TICD_MAX_MESSAGE_SIZE) { return false; }
+      if (c.input.size() < 4 + size) { break; }
+
+      std::vector<uint8_t> payload(c.input.begin() + 4,
+        c.input.begin() + 4 + size);
+      c.input.erase(c.input.begin(), c.input.begin() + 4 + size);
+      handle_request(c, payload);
+    }
+    return true;
+  }
+
+  // Handles the requests that clients sent while they were waiting for a
+  // read.  This is not done as soon as the read finishes because that can
+  // happen in the middle of handling another client's request.
+  void resume_clients()
+  {
+    while (!resumed.empty())
+    {
+      client & c = *resumed.front();
+      resumed.erase(resumed.begin());
+      if (process_input(c)) { continue; }
+
+      for (auto it = clients.begin(); it != clients.end(); ++it)
+      {
+        if (&*it != &c) { continue; }
+        drop_client(c);
+        clients.erase(it);
+        break;
+      }
+    }
+  }
+
+  // Returns false if the client should be disconnected.
+  bool write_to_client(client & c)
+  {
+    ssize_t sent = send(c.fd, c.output.data(), c.output.size(), 0);
+    if (sent < 0) { return errno == EINTR || errno == EAGAIN; }
+    c.output.erase(c.output.begin(), c.output.begin() + sent);
+    return true;
+  }
+
+  void send_response(client & c, const ticd_writer & response)
+  {
+    std::vector<uint8_t> frame = response.framed();
+    c.output.insert(c.output.end(), frame.begin(), frame.end());
+  }
+
+  void send_error(client & c, uint8_t code, const std::string & message)
+  {
+    ticd_writer response;
+    response.u8(TICD_RESPONSE_ERROR);
+    response.u8(code);
+    response.str(message);
+    send_response(c, response);
+  }
+
+  void handle_request(client & c, const std::vector<uint8_t> & payload)
+  {
+    ticd_writer response;
+    response.u8(TICD_RESPONSE_OK);
+
+    try
+    {
+      ticd_reader request(payload);
+      uint8_t code = request.u8();
+      switch (code)
+      {
+      case TICD_REQUEST_LIST:
+        list_devices(response);
+        break;
+
+      case TICD_REQUEST_COMMAND:
+        {
+          managed_device & device = find_device(request.str());
+          uint8_t cmd = request.u8();
+          int32_t value = request.i32();
+          run_command(device, cmd, value);
+          break;
+        }
+
+      case TICD_REQUEST_GET_VARIABLES:
+      case TICD_REQUEST_GET_STATUS:
+        {
+          managed_device & device = find_device(request.str());
+          bool flag = request.u8();
+          device.pending.push_back({ &c, code, flag });
+          c.waiting = true;
+          return;
+        }
+
+      case TICD_REQUEST_GET_SETTINGS:
+        {
+          managed_device & device = find_device(request.str());
+          tic::settings settings = with_device(device, [&]() {
+            return device.handle.get_settings();
+          });
+          std::string warnings;
+          settings.fix(&warnings);
+          response.str(settings.to_string());
+          response.str(warnings);
+          break;
+        }
+
+      case TICD_REQUEST_SET_SETTINGS:
+        {
+          managed_device & device = find_device(request.str());
+          tic::settings settings =
+            tic::settings::read_from_string(request.str());
+          tic_settings_set_product(settings.get_pointer(),
+            device.device.get_product());
+          tic_settings_set_firmware_version(settings.get_pointer(),
+            device.device.get_firmware_version());
+          std::string warnings;
+          settings.fix(&warnings);
+          with_device(device, [&]() {
+            device.handle.set_settings_diff(settings);
+            device.handle.reinitialize();
+            return 0;
+          });
+          response.str(warnings);
+          break;
+        }
+
+      case TICD_REQUEST_RESTORE_DEFAULTS:
+        {
+          managed_device & device = find_device(request.str());
+          with_device(device, [&]() {
+            device.handle.restore_defaults();
+            return 0;
+          });
+          break;
+        }
+
+      default:
+        throw ticd_error(TICD_ERROR_BAD_REQUEST, "Unknown request.");
+      }
+    }
+    catch (const ticd_error & error)
+    {
+      send_error(c, error.code, error.what());
+      return;
+    }
+    catch (const std::exception & error)
+    {
+      send_error(c, TICD_ERROR_OPERATION_FAILED, error.what());
+      return;
+    }
+
+    send_response(c, response);
+  }
+
+  void list_devices(ticd_writer & response)
+  {
+    refresh_devices();
+    response.u8(devices.size());
+    for (auto & pair : devices)
+    {
+      const tic::device & device = pair.second.device;
+      response.u8(device.get_product());
+      response.u16(device.get_firmware_version());
+      response.str(device.get_serial_number());
+      response.str(device.get_name());
+    }
+  }
+
+  void run_command(managed_device & device, uint8_t cmd, int32_t value)
+  {
+    bool known = with_device(device, [&]() {
+      return ticd_run_command(device.handle, cmd, value);
+    });
+    if (!known)
+    {
+      throw ticd_error(TICD_ERROR_BAD_REQUEST, "Unknown command.");
+    }
+  }
+
+  // Runs a function that uses the device.  If the device was disconnected,
+  // we forget about it so that it gets opened again if it comes back.
+  template <typename F>
+  auto with_device(managed_device & device, F f) -> decltype(f())
+  {
+    try
+    {
+      return f();
+    }
+    catch (const tic::error & error)
+    {
+      if (error.has_code(TIC_ERROR_DEVICE_DISCONNECTED))
+      {
+        forget_device(device);
+      }
+      throw;
+    }
+  }
+
+  void forget_device(managed_device & device)
+  {
+    std::string serial_number = device.device.get_serial_number();
+    for (const pending_read & read : device.pending)
+    {
+      read.requester->waiting = false;
+      send_error(*read.requester, TICD_ERROR_OPERATION_FAILED,
+        "The device was disconnected.");
+      resumed.push_back(read.requester);
+    }
+    for (client & c : clients)
+    {
+      c.missed_errors_occurred.erase(serial_number);
+    }
+    devices.erase(serial_number);
+  }
+
+  managed_device & find_device(const std::string & serial_number)
+  {
+    managed_device * device = look_up_device(serial_number);
+    if (device == NULL)
+    {
+      refresh_devices();
+      device = look_up_device(serial_number);
+    }
+
+    if (device == NULL && serial_number.empty() && devices.size() > 1)
+    {
+      throw ticd_error(TICD_ERROR_DEVICE_MULTIPLE_FOUND,
+        "There are multiple qualifying devices connected to this computer.\n"
+        "Use the -d option to specify which device you want to use,\n"
+        "or disconnect the others.");
+    }
+
+    if (device == NULL)
+    {
+      std::string message = "No device was found";
+      if (!serial_number.empty())
+      {
+        message += " with serial number '" + serial_number + "'";
+      }
+      throw ticd_error(TICD_ERROR_DEVICE_NOT_FOUND, message + ".");
+    }
+
+    return *device;
+  }
+
+  managed_device * look_up_device(const std::string & serial_number)
+  {
+    if (serial_number.empty())
+    {
+      if (devices.size() != 1) { return NULL; }
+      return &devices.begin()->second;
+    }
+
+    auto it = devices.find(serial_number);
+    if (it == devices.end()) { return NULL; }
+    return &it->second;
+  }
+
+  void handle_hotplug()
+  {
+    try
+    {
+      refresh_devices();
+    }
+    catch (const std::exception & error)
+    {
+      std::cerr << "Warning: " << error.what() << std::endl;
+    }
+  }
+
+  // Forgets devices that were unplugged and opens any devices we do not
+  // already have open.  The device monitor only scans the USB bus after a
+  // hotplug event, so this is cheap.
+  void refresh_devices()
+  {
+    if (!monitor)
+    {
+      monitor = tic::device_monitor::create();
+    }
+
+    monitor.update();
+    tic::device removed;
+    bool added;
+    while (monitor.take_event(removed, added))
+    {
+      if (added) { continue; }
+      auto it = devices.find(removed.get_serial_number());
+      if (it != devices.end()) { forget_device(it->second); }
+    }
+
+    std::vector<tic::device> list = monitor.get_devices();
+    for (tic::device & device : list)
+    {
+      std::string serial_number = device.get_serial_number();
+      if (devices.count(serial_number)) { continue; }
+
+      try
+      {
+        managed_device & entry = devices[serial_number];
+        entry.handle = tic::handle(device);
+        entry.device = std::move(device);
+      }
+      catch (const std::exception & error)
+      {
+        devices.erase(serial_number);
+        std::cerr << "Warning: Failed to open " << serial_number << ": "
+                  << error.what() << std::endl;
+      }
+    }
+  }
+
+  int poll_timeout_ms()
+  {
+    bool any_pending = false;
+    clock_type::time_point next_read = clock_type::time_point::max();
+    for (auto & pair : devices)
+    {
+      const managed_device & device = pair.second;
+      if (device.pending.empty()) { continue; }
+      any_pending = true;
+      next_read = std::min(next_read, device.last_read + poll_period);
+    }
+    next_read = std::min(next_read, hotplug_recheck);
+    if (!any_pending && hotplug_recheck == clock_type::time_point::max())
+    {
+      return -1;
+    }
+
+    auto wait = next_read - clock_type::now();
+    if (wait <= clock_type::duration::zero()) { return 0; }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(wait).count() + 1;
+  }
+
+  void serve_pending_reads()
+  {
+    clock_type::time_point now = clock_type::now();
+
+    std::vector<std::string> serial_numbers;
+    for (auto & pair : devices)
+    {
+      managed_device & device = pair.second;
+      if (device.pending.empty()) { continue; }
+      if (now < device.last_read + poll_period) { continue; }
+      serial_numbers.push_back(pair.first);
+    }
+
+    for (const std::string & serial_number : serial_numbers)
+    {
+      auto it = devices.find(serial_number);
+      if (it != devices.end()) { serve_pending_reads(it->second, now); }
+    }
+  }
+
+  void serve_pending_reads(managed_device & device, clock_type::time_point now)
+  {
+    // Do one read for everyone.  If anyone asked to clear the errors
+    // occurred bits, we clear them on the device and remember the bits for
+    // every client that did not ask.  A status request always clears them,
+    // like ticcmd --status does.
+    bool clear = false;
+    bool need_settings = false;
+    for (const pending_read & read : device.pending)
+    {
+      if (read.request == TICD_REQUEST_GET_STATUS)
+      {
+        clear = need_settings = true;
+      }
+      else if (read.flag)
+      {
+        clear = true;
+      }
+    }
+
+    std::string serial_number = device.device.get_serial_number();
+    device.last_read = now;
+    tic::variables vars;
+    tic::settings settings;
+    try
+    {
+      with_device(device, [&]() {
+        vars = device.handle.get_variables(clear);
+        if (need_settings) { settings = device.handle.get_settings(); }
+        return 0;
+      });
+    }
+    catch (const std::exception & error)
+    {
+      // If the device was disconnected, with_device already sent the errors
+      // and forgot the device, so we must not touch it again.
+      if (devices.count(serial_number) == 0) { return; }
+      for (const pending_read & read : device.pending)
+      {
+        read.requester->waiting = false;
+        send_error(*read.requester, TICD_ERROR_OPERATION_FAILED, error.what());
+        resumed.push_back(read.requester);
+      }
+      device.pending.clear();
+      return;
+    }
+
+    uint32_t occurred = vars.get_errors_occurred();
+    if (clear && occurred)
+    {
+      for (client & c : clients)
+      {
+        c.missed_errors_occurred[serial_number] |= occurred;
+      }
+    }
+
+    for (const pending_read & read : device.pending)
+    {
+      // The missed bits include the ones we just read if we cleared them.
+      uint32_t & missed =
+        read.requester->missed_errors_occurred[serial_number];
+      bool requester_clears =
+        read.request == TICD_REQUEST_GET_STATUS || read.flag;
+
+      ticd_writer response;
+      response.u8(TICD_RESPONSE_OK);
+      if (read.request == TICD_REQUEST_GET_STATUS)
+      {
+        response.str(render_status(device, vars, settings, read.flag,
+          missed));
+      }
+      else
+      {
+        ticd_variables record(vars, device.device.get_product());
+        record.errors_occurred |= missed;
+        record.write(response);
+      }
+      if (requester_clears) { missed = 0; }
+      send_response(*read.requester, response);
+      read.requester->waiting = false;
+      resumed.push_back(read.requester);
+    }
+    device.pending.clear();
+  }
+
+  std::string render_status(managed_device & device,
+    const tic::variables & vars, const tic::settings & settings, bool full,
+    uint32_t missed_errors_occurred)
+  {
+    std::ostringstream output;
+    std::streambuf * old_buffer = std::cout.rdbuf(output.rdbuf());
+    try
+    {
+      print_status(vars, settings, device.device.get_name(),
+        device.device.get_serial_number(),
+        device.handle.get_firmware_version_string(), full,
+        missed_errors_occurred);
+    }
+    catch (...)
+    {
+      std::cout.rdbuf(old_buffer);
+      throw;
+    }
+    std::cout.rdbuf(old_buffer);
+    return output.str();
+  }
+
+  std::string socket_path;
+  clock_type::duration poll_period;
+  int listen_fd = -1;
+  std::list<client> clients;
+
+  // Clients that stopped waiting for a read and might have more requests in
+  // their input buffers.  See resume_clients().
+  std::vector<client *> resumed;
+  tic::device_monitor monitor;
+  clock_type::time_point hotplug_recheck = clock_type::time_point::max();
+  const std::chrono::milliseconds hotplug_settle_time{600};
+  std::map<std::string, managed_device> devices;
+};
+
+int main(int argc, char ** argv)
+{
+  std::string socket_path = ticd_default_socket_path();
+  uint32_t poll_period_ms = 20;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string arg = argv[i];
+    if (arg == "--socket" && i + 1 < argc)
+    {
+      socket_path = argv[++i];
+    }
+    else if (arg == "--poll-period" && i + 1 < argc)
+    {
+      if (string_to_int(argv[++i], &poll_period_ms))
+      {
+        std::cerr << "Error: The number after '--poll-period' is invalid."
+                  << std::endl;
+        return EXIT_BAD_ARGS;
+      }
+    }
+    else if (arg == "-h" || arg == "--help")
+    {
+      std::cout << help;
+      return 0;
+    }
+    else
+    {
+      std::cerr << "Error: Unknown option: '" << arg << "'." << std::endl;
+      return EXIT_BAD_ARGS;
+    }
+  }
+
+  struct sigaction action;
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = handle_stop_signal;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  signal(SIGPIPE, SIG_IGN);
+
+  try
+  {
+    device_broker broker(socket_path, poll_period_ms);
+    broker.run();
+  }
+  catch (const std::exception & error)
+  {
+    std::cerr << "Error: " << error.what() << std::endl;
+    return EXIT_OPERATION_FAILED;
+  }
+
+  return 0;
+}
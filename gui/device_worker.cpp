@@ -0,0 +1,302 @@
+#include "device_worker.h"
+
+#include <algorithm>
+
+// The most samples we keep for the UI thread, in case it stops taking them.
+static const size_t MAX_SAMPLES = 10000;
+
+device_worker::device_worker()
+  : send_reset_command_timeout(false), clear_errors_occurred(true),
+    record_samples(false)
+{
+  errors_occurred_counts.fill(0);
+}
+
+device_worker::~device_worker()
+{
+  if (!thread.joinable()) { return; }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  job_queued.notify_one();
+  thread.join();
+
+  for (queued_job * j : jobs) { delete j; }
+}
+
+void device_worker::start(uint32_t poll_interval_ms,
+  uint32_t device_list_interval_ms)
+{
+  this->poll_interval_ms = poll_interval_ms;
+  this->device_list_interval_ms = device_list_interval_ms;
+  thread = std::thread(&device_worker::thread_main, this);
+}
+
+void device_worker::set_poll_interval(uint32_t poll_interval_ms)
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  if (this->poll_interval_ms == poll_interval_ms) { return; }
+  this->poll_interval_ms = poll_interval_ms;
+  poll_interval_changed = true;
+  job_queued.notify_one();
+}
+
+void device_worker::run(job function)
+{
+  queued_job j;
+  j.function = function;
+  j.wait = true;
+  j.needs_handle = false;
+  j.done = false;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  jobs.push_back(&j);
+  job_queued.notify_one();
+  job_done.wait(lock, [&] { return j.done; });
+  lock.unlock();
+
+  if (j.exception) { std::rethrow_exception(j.exception); }
+}
+
+void device_worker::post(job function)
+{
+  queued_job * j = new queued_job();
+  j->function = function;
+  j->wait = false;
+  j->needs_handle = true;
+  j->done = false;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  jobs.push_back(j);
+  job_queued.notify_one();
+}
+
+void device_worker::open(tic::device device)
+{
+  queued_job * j = new queued_job();
+  j->function = [device](tic::handle & handle)
+  {
+    handle.close();
+    handle = tic::handle(device);
+  };
+  j->wait = false;
+  j->needs_handle = false;
+  j->done = false;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  jobs.push_back(j);
+  job_queued.notify_one();
+}
+
+std::vector<std::string> device_worker::take_errors()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<std::string> result;
+  result.swap(errors);
+  return result;
+}
+
+std::vector<device_sample> device_worker::take_samples()
+{
+  std::lock_guard<std::mutex> lock(mutex);
+  std::vector<device_sample> result;
+  result.swap(samples);
+  return result;
+}
+
+void device_worker::thread_main()
+{
+  typedef std::chrono::steady_clock clock;
+  clock::time_point last_poll = clock::now();
+  clock::time_point next_poll = last_poll;
+  next_device_list_update = last_poll;
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true)
+  {
+    job_queued.wait_until(lock, next_poll,
+      [&] { return stopping || poll_interval_changed || !jobs.empty(); });
+    if (stopping) { break; }
+
+    clock::duration interval = std::chrono::milliseconds(poll_interval_ms);
+    if (poll_interval_changed)
+    {
+      // Measure the new interval from the last poll, so that switching to a
+      // shorter interval does not have to wait out the rest of the old one.
+      poll_interval_changed = false;
+      next_poll = std::min(next_poll, last_poll + interval);
+    }
+
+    // Run the jobs in order, without holding the lock so the UI thread can
+    // queue more in the meantime.
+    while (!jobs.empty())
+    {
+      queued_job * j = jobs.front();
+      jobs.pop_front();
+      lock.unlock();
+
+      std::exception_ptr exception;
+      try
+      {
+        if (!j->needs_handle || handle) { j->function(handle); }
+      }
+      catch (...)
+      {
+        exception = std::current_exception();
+      }
+
+      if (!j->needs_handle)
+      {
+        handle_sequence++;
+        errors_occurred_counts.fill(0);
+      }
+
+      lock.lock();
+      if (j->wait)
+      {
+        j->exception = exception;
+        j->done = true;
+        job_done.notify_all();
+      }
+      else
+      {
+        if (exception)
+        {
+          try
+          {
+            std::rethrow_exception(exception);
+          }
+          catch (const std::exception & e)
+          {
+            errors.push_back(e.what());
+          }
+          catch (...)
+          {
+            errors.push_back("Unknown error.");
+          }
+        }
+        delete j;
+      }
+    }
+
+    if (clock::now() < next_poll) { continue; }
+
+    lock.unlock();
+    last_poll = clock::now();
+    poll();
+    lock.lock();
+
+    // If we fell behind, skip the polls that we missed instead of running
+    // them back to back.
+    next_poll += interval;
+    clock::time_point now = clock::now();
+    if (next_poll < now) { next_poll = now + interval; }
+  }
+}
+
+void device_worker::poll()
+{
+  // The device monitor only scans for devices after a hotplug event, so
+  // checking it is cheap, but there is no point in doing it on every poll.
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  if (device_list_interval_ms != 0 && now >= next_device_list_update)
+  {
+    next_device_list_update = now +
+      std::chrono::milliseconds(device_list_interval_ms);
+
+    try
+    {
+      bool changed = false;
+      if (!device_monitor)
+      {
+        device_monitor = tic::device_monitor::create();
+        changed = true;
+      }
+      changed = device_monitor.update() || changed || device_list_failed;
+      if (changed)
+      {
+        device_list = device_monitor.get_devices();
+        device_list_failed = false;
+        device_list_sequence++;
+      }
+    }
+    catch (const std::exception & e)
+    {
+      device_list_failed = true;
+      device_list_error = e.what();
+      device_list_sequence++;
+    }
+  }
+
+  // The back buffer might hold a snapshot from a few polls ago, so it only
+  // needs a copy of the device list if the list changed since then.
+  device_snapshot & snapshot = mailbox.back();
+  if (snapshot.device_list_sequence != device_list_sequence)
+  {
+    snapshot.device_list_sequence = device_list_sequence;
+    snapshot.device_list = device_list;
+    snapshot.device_list_failed = device_list_failed;
+    snapshot.device_list_error = device_list_error;
+  }
+  snapshot.os_id.clear();
+  snapshot.handle_sequence = handle_sequence;
+
+  if (handle)
+  {
+    snapshot.os_id = handle.get_device().get_os_id();
+
+    try
+    {
+      // Read into the variables object the back buffer already has so we do
+      // not allocate a new one every poll.
+      snapshot.variables.refresh(handle, clear_errors_occurred);
+      snapshot.variables_update_failed = false;
+
+      if (record_samples)
+      {
+        const tic::variables & vars = snapshot.variables;
+        device_sample sample;
+        sample.time = std::chrono::steady_clock::now();
+        sample.current_position = vars.get_current_position();
+        sample.current_velocity = vars.get_current_velocity();
+        sample.input_after_scaling = vars.get_input_after_scaling();
+        sample.encoder_position = vars.get_encoder_position();
+        sample.vin_voltage = vars.get_vin_voltage();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (samples.size() < MAX_SAMPLES) { samples.push_back(sample); }
+      }
+
+      if (clear_errors_occurred)
+      {
+        uint32_t errors_occurred = snapshot.variables.get_errors_occurred();
+        for (size_t i = 0; i < errors_occurred_counts.size(); i++)
+        {
+          if (errors_occurred >> i & 1) { errors_occurred_counts[i]++; }
+        }
+      }
+
+      if (send_reset_command_timeout)
+      {
+        // Reset command timeout AFTER reloading the variables so we can
+        // indicate an active error if the command timeout interval is shorter
+        // than the interval between polls.
+        handle.reset_command_timeout();
+      }
+    }
+    catch (const std::exception &)
+    {
+      // Ignore the exception.  The snapshot provides other ways to tell that
+      // the variable update failed, and the exact message is probably not
+      // that useful since it is probably just a generic problem with the USB
+      // connection.
+      snapshot.variables_update_failed = true;
+    }
+  }
+
+  snapshot.errors_occurred_counts = errors_occurred_counts;
+
+  mailbox.publish();
+}
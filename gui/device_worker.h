@@ -0,0 +1,187 @@
+#pragma once
+
+#include "snapshot_mailbox.h"
+#include "tic.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The state of the devices as seen by the worker thread at one point in time.
+// The worker publishes a new snapshot after every poll, and the UI thread only
+// reads them.
+struct device_snapshot
+{
+  // Incremented every time the worker gets a new list of devices.
+  uint32_t device_list_sequence = 0;
+
+  // The list of connected devices, and whether the last attempt to get it
+  // failed.
+  std::vector<tic::device> device_list;
+  bool device_list_failed = false;
+  std::string device_list_error;
+
+  // The OS ID of the device that the worker has a handle to, or an empty
+  // string if it has none.  The variables below belong to this device.
+  std::string os_id;
+
+  tic::variables variables;
+  bool variables_update_failed = false;
+
+  // Incremented every time a job run with device_worker::run() or
+  // device_worker::open() finishes, since those jobs can replace the handle.
+  uint32_t handle_sequence = 0;
+
+  // For each error bit, the number of reads of the variables since
+  // handle_sequence changed that found the bit set in the errors occurred
+  // variable.  The worker clears the errors occurred bits every time it reads
+  // them, so these counts let the UI count the errors even if it skips
+  // snapshots.  They stay at zero if the worker does not clear the bits.
+  std::array<uint32_t, 32> errors_occurred_counts{};
+};
+
+// The values of some variables that the worker read from the device at one
+// time, for plotting.  Unlike snapshots, the worker keeps every sample until
+// the UI thread takes it, so the UI can plot every reading even if it is slower
+// than the worker.
+struct device_sample
+{
+  std::chrono::steady_clock::time_point time;
+  int32_t current_position;
+  int32_t current_velocity;
+  int32_t input_after_scaling;
+  int32_t encoder_position;
+  uint32_t vin_voltage;
+};
+
+// Does all of the GUI's communication with devices on a separate thread so
+// that slow USB transfers do not block the UI.
+//
+// The worker owns the handle to the connected device.  Every poll interval it
+// reads the variables from the device (and sends a "Reset command timeout"
+// command if requested), and once every device list interval it gets the list
+// of connected devices; the results are published as a device_snapshot.  Everything else
+// that uses the handle is done by jobs that the UI thread gives to the worker.
+class device_worker
+{
+public:
+  typedef std::function<void(tic::handle &)> job;
+
+  device_worker();
+  ~device_worker();
+
+  // Starts the worker thread.  If device_list_interval_ms is 0, the worker
+  // never gets the list of devices, which is useful if it only watches the
+  // device that it has a handle to.
+  void start(uint32_t poll_interval_ms, uint32_t device_list_interval_ms);
+
+  // Changes the time between polls.  The new interval takes effect right
+  // away: if it is shorter than the old one, the next poll happens sooner.
+  // This can be called from any thread.
+  void set_poll_interval(uint32_t poll_interval_ms);
+
+  // Runs a job on the worker thread and waits for it to finish.  If the job
+  // throws an exception, this function throws it.  This is for operations
+  // that the UI has to wait for anyway, like connecting or applying settings.
+  void run(job);
+
+  // Queues a job on the worker thread without waiting for it.  The job is
+  // skipped if there is no handle when its turn comes.  If the job throws an
+  // exception, its message is returned by take_errors().
+  void post(job);
+
+  // Queues a job that opens a handle to the specified device, replacing the
+  // worker's handle, without waiting for it.  If opening the device fails,
+  // the message is returned by take_errors() and the worker has no handle.
+  void open(tic::device);
+
+  // Returns messages from exceptions thrown by posted jobs and by opening
+  // devices with open(), and clears them.
+  std::vector<std::string> take_errors();
+
+  // Sets whether to send a "Reset command timeout" command after each read of
+  // the variables.  This can be called from any thread.
+  void set_send_reset_command_timeout(bool send)
+  {
+    send_reset_command_timeout = send;
+  }
+
+  // Sets whether to clear the errors occurred bits every time the worker
+  // reads the variables.  The default is true.  Turn this off if something
+  // else is responsible for the device's errors.  This can be called from
+  // any thread.
+  void set_clear_errors_occurred(bool clear)
+  {
+    clear_errors_occurred = clear;
+  }
+
+  // Sets whether to keep a device_sample every time the worker reads the
+  // variables.  This can be called from any thread.
+  void set_record_samples(bool record)
+  {
+    record_samples = record;
+  }
+
+  // Returns the samples recorded since the last call, and clears them.
+  std::vector<device_sample> take_samples();
+
+  // Returns true if the worker published a new snapshot since the last call,
+  // and makes it available from snapshot().  Only call this from the UI
+  // thread.
+  bool take_snapshot() { return mailbox.take(); }
+
+  // Returns the snapshot from the last successful call to take_snapshot().
+  const device_snapshot & snapshot() const { return mailbox.front(); }
+
+private:
+  void thread_main();
+  void poll();
+
+  struct queued_job
+  {
+    job function;
+    bool wait;
+    bool needs_handle;
+    bool done;
+    std::exception_ptr exception;
+  };
+
+  std::thread thread;
+  std::mutex mutex;
+  std::condition_variable job_queued;
+  std::condition_variable job_done;
+  std::deque<queued_job *> jobs;
+  std::vector<std::string> errors;
+  std::vector<device_sample> samples;
+  bool stopping = false;
+
+  std::atomic<bool> send_reset_command_timeout;
+  std::atomic<bool> clear_errors_occurred;
+  std::atomic<bool> record_samples;
+
+  // Protected by the mutex.
+  uint32_t poll_interval_ms = 50;
+  bool poll_interval_changed = false;
+
+  uint32_t device_list_interval_ms = 1000;
+
+  // These are only used on the worker thread.
+  tic::handle handle;
+  tic::device_monitor device_monitor;
+  std::chrono::steady_clock::time_point next_device_list_update;
+  uint32_t device_list_sequence = 0;
+  std::vector<tic::device> device_list;
+  bool device_list_failed = false;
+  std::string device_list_error;
+  uint32_t handle_sequence = 0;
+  std::array<uint32_t, 32> errors_occurred_counts;
+
+  snapshot_mailbox<device_snapshot> mailbox;
+};
@@ -3,13 +3,28 @@
 #include <file_util.h>
 
 #include <cassert>
+#include <chrono>
 #include <cmath>
 
-// This is how often we fetch the variables from the device.
-static const uint32_t UPDATE_INTERVAL_MS = 50;
+// These are the default intervals between reads of the variables from the
+// device.  We read them faster while the motor is doing something so the
+// feedback is smoother, and slower while it is idle to save USB bandwidth and
+// CPU time.  See main_controller::adjust_update_interval().
+static const uint32_t ACTIVE_UPDATE_INTERVAL_MS = 10;
+static const uint32_t NORMAL_UPDATE_INTERVAL_MS = 50;
+static const uint32_t IDLE_UPDATE_INTERVAL_MS = 250;
 
-// Only update the device list once per second to save CPU time.
-static const uint32_t UPDATE_DEVICE_LIST_DIVIDER = 20;
+// How often the worker checks for devices being plugged in or unplugged.
+// The device monitor only scans for devices after a hotplug event, so this
+// can be much shorter than the time it takes to scan.
+static const uint32_t DEVICE_LIST_INTERVAL_MS = 100;
+
+// How long the dashboard waits before trying again to open a device that it
+// could not open, for example because another program was using it.
+static const uint32_t DASHBOARD_RETRY_INTERVAL_MS = 1000;
+
+constexpr uint32_t main_controller::MIN_UPDATE_INTERVAL_MS;
+constexpr uint32_t main_controller::MAX_UPDATE_INTERVAL_MS;
 
 static bool settings_have_limit_switch(const tic::settings & settings)
 {
@@ -34,8 +49,22 @@ void main_controller::start()
 {
   assert(!connected());
 
-  // Start the update timer so that update() will be called regularly.
-  window->set_update_timer_interval(UPDATE_INTERVAL_MS);
+  active_update_interval_ms = ACTIVE_UPDATE_INTERVAL_MS;
+  normal_update_interval_ms = NORMAL_UPDATE_INTERVAL_MS;
+  idle_update_interval_ms = IDLE_UPDATE_INTERVAL_MS;
+  update_interval_ms = idle_update_interval_ms;
+
+  plot_start_time = std::chrono::steady_clock::now();
+  window->set_plot_history(&plot);
+  worker.set_record_samples(true);
+
+  // Start the worker thread, which reads the variables and the device list.
+  worker.start(update_interval_ms, DEVICE_LIST_INTERVAL_MS);
+  widget_update_rate_start = std::chrono::steady_clock::now();
+
+  // Start the update timer so that update() will be called regularly to
+  // pick up the worker's snapshots.
+  window->set_update_timer_interval(update_interval_ms);
   window->start_update_timer();
 
   window->adjust_ui_for_product(TIC_PRODUCT_T825);
@@ -91,46 +120,42 @@ void main_controller::clear_driver_error()
 {
   if (!connected()) { return; }
 
-  try
-  {
-    device_handle.clear_driver_error();
-  }
-  catch (const std::exception & e)
-  {
-    show_exception(e);
-  }
+  worker.post([](tic::handle & handle) { handle.clear_driver_error(); });
 }
 
 void main_controller::go_home(uint8_t direction)
 {
   if (!connected()) { return; }
-  try
-  {
-    device_handle.go_home(direction);
-  }
-  catch (const std::exception & e)
-  {
-    show_exception(e);
-  }
+  worker.post([=](tic::handle & handle) { handle.go_home(direction); });
 }
 
-void main_controller::connect_device(const tic::device & device)
+void main_controller::connect_device(const tic::device & new_device)
 {
-  assert(device);
+  assert(new_device);
+
+  // On some systems, only one handle to a device can be open at a time.
+  release_dashboard_device(new_device);
 
   try
   {
-    // Close the old handle in case one is already open.
-    device_handle.close();
-
+    device = tic::device();
+    unshown_errors_occurred.fill(0);
     connection_error = false;
     disconnected_by_user = false;
-    send_reset_command_timeout = false;
+    worker.set_send_reset_command_timeout(false);
     suppress_high_current_limit_warning = false;
     suppress_potential_high_current_limit_warning = false;
 
-    // Open a handle to the specified device.
-    device_handle = tic::handle(device);
+    worker.run([&](tic::handle & handle)
+    {
+      // Close the old handle in case one is already open.
+      handle.close();
+
+      // Open a handle to the specified device.
+      handle = tic::handle(new_device);
+      firmware_version_string = handle.get_firmware_version_string();
+    });
+    device = new_device;
   }
   catch (const std::exception & e)
   {
@@ -142,7 +167,7 @@ void main_controller::connect_device(const tic::device & device)
 
   try
   {
-    settings = device_handle.get_settings();
+    worker.run([&](tic::handle & handle) { settings = handle.get_settings(); });
     // Note: for future products, consider running settings.fix() here and showing
     // all the warnings, instead of just letting GUI controls silently fix some things.
     handle_settings_applied();
@@ -173,7 +198,8 @@ void main_controller::disconnect_device_by_error(const std::string & error_messa
 
 void main_controller::really_disconnect()
 {
-  device_handle.close();
+  worker.run([](tic::handle & handle) { handle.close(); });
+  device = tic::device();
   settings_modified = false;
 }
 
@@ -196,7 +222,7 @@ void main_controller::reload_settings(bool ask)
 
   try
   {
-    settings = device_handle.get_settings();
+    worker.run([&](tic::handle & handle) { settings = handle.get_settings(); });
     // Note: for future products, consider running settings.fix() here and showing
     // all the warnings, instead of just letting GUI controls silently fix some things.
     handle_settings_applied();
@@ -226,7 +252,7 @@ void main_controller::restore_default_settings()
   bool restore_success = false;
   try
   {
-    device_handle.restore_defaults();
+    worker.run([](tic::handle & handle) { handle.restore_defaults(); });
     restore_success = true;
   }
   catch (const std::exception & e)
@@ -260,7 +286,7 @@ void main_controller::upgrade_firmware()
 
     try
     {
-      device_handle.start_bootloader();
+      worker.run([](tic::handle & handle) { handle.start_bootloader(); });
     }
     catch (const std::exception & e)
     {
@@ -286,24 +312,39 @@ static bool device_list_includes(
 
 void main_controller::update()
 {
-  // This is called regularly by the view when it is time to check for
-  // updates to the state of USB devices.  This runs on the same thread as
-  // everything else, so we should be careful not to do anything too slow
-  // here.  If the user tries to use the UI at all while this function is
-  // running, the UI cannot respond until this function returns.
+  // This is called regularly by the view.  All communication with devices
+  // happens on the worker thread, so this only looks at the latest snapshot
+  // from the worker, and it should not do anything slow.  If the user tries to
+  // use the UI at all while this function is running, the UI cannot respond
+  // until this function returns.
+
+  for (const std::string & message : worker.take_errors())
+  {
+    window->show_error_message(message);
+  }
+
+  report_widget_update_rate();
+  record_plot_samples();
+
+  // The dashboard workers publish snapshots on their own schedule, so check
+  // them even if our main worker has nothing new.
+  update_dashboard();
+
+  if (!worker.take_snapshot()) { return; }
+  const device_snapshot & snapshot = worker.snapshot();
 
   bool successfully_updated_list = false;
-  if (--update_device_list_counter == 0)
+  if (snapshot.device_list_sequence != device_list_sequence)
   {
-    update_device_list_counter = UPDATE_DEVICE_LIST_DIVIDER;
+    device_list_sequence = snapshot.device_list_sequence;
 
-    successfully_updated_list = update_device_list();
+    successfully_updated_list = update_device_list(snapshot);
     if (successfully_updated_list && device_list_changed)
     {
       window->set_device_list_contents(device_list);
       if (connected())
       {
-        window->set_device_list_selected(device_handle.get_device());
+        window->set_device_list_selected(device);
       }
       else
       {
@@ -312,6 +353,12 @@ void main_controller::update()
     }
   }
 
+  // The snapshot might have been taken before we connected to the device we
+  // are connected to now.
+  bool snapshot_is_current = connected() &&
+    snapshot.os_id == device.get_os_id();
+  count_errors_occurred(snapshot, snapshot_is_current);
+
   if (connected())
   {
     // First, see if the device we are connected to is still available.
@@ -319,32 +366,24 @@ void main_controller::update()
     // function that tests if the actual handle we are using is still valid.
     // This would be better for tricky cases like if someone unplugs and
     // plugs the same device in very fast.
-    bool device_still_present = device_list_includes(
-      device_list, device_handle.get_device());
+    bool device_still_present = device_list_includes(device_list, device);
 
     if (device_still_present)
     {
-      // Reload the variables from the device.
-      try
+      if (snapshot_is_current)
       {
-        reload_variables();
-
-        if (send_reset_command_timeout)
+        variables_update_failed = snapshot.variables_update_failed;
+        if (!variables_update_failed)
         {
-          // Reset command timeout AFTER reloading the variables so we can
-          // indicate an active error if the command timeout interval is shorter
-          // than the interval between calls to update().
-          device_handle.reset_command_timeout();
+          variables = snapshot.variables;
+          if (cached_settings)
+          {
+            window->sample_input(
+              variables.get_input_before_scaling(cached_settings));
+          }
         }
+        handle_variables_changed();
       }
-      catch (const std::exception & e)
-      {
-        // Ignore the exception.  The model provides other ways to tell that
-        // the variable update failed, and the exact message is probably
-        // not that useful since it is probably just a generic problem with
-        // the USB connection.
-      }
-      handle_variables_changed();
     }
     else
     {
@@ -377,6 +416,264 @@ void main_controller::update()
       connect_device(device_list.at(0));
     }
   }
+
+  adjust_update_interval();
+}
+
+void main_controller::handle_dashboard_enabled_input(bool enabled)
+{
+  dashboard_enabled = enabled;
+  if (!enabled) { dashboard_devices.clear(); }
+  update_dashboard();
+}
+
+void main_controller::release_dashboard_device(const tic::device & d)
+{
+  for (auto it = dashboard_devices.begin(); it != dashboard_devices.end(); ++it)
+  {
+    if (it->device.get_os_id() == d.get_os_id())
+    {
+      dashboard_devices.erase(it);
+      return;
+    }
+  }
+}
+
+void main_controller::update_dashboard()
+{
+  if (!dashboard_enabled)
+  {
+    window->set_dashboard_rows({});
+    return;
+  }
+
+  // Stop watching devices that are gone or that we are connected to.
+  for (auto it = dashboard_devices.begin(); it != dashboard_devices.end(); )
+  {
+    if (device_list_includes(device_list, it->device) &&
+      !(connected() && it->device.get_os_id() == device.get_os_id()))
+    {
+      ++it;
+    }
+    else
+    {
+      it = dashboard_devices.erase(it);
+    }
+  }
+
+  std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+  std::vector<dashboard_row> rows;
+  for (const tic::device & listed : device_list)
+  {
+    dashboard_row row;
+    row.os_id = listed.get_os_id();
+    row.name = listed.get_short_name();
+    row.serial_number = listed.get_serial_number();
+
+    const tic::variables * vars = NULL;
+
+    if (connected() && listed.get_os_id() == device.get_os_id())
+    {
+      row.connected = true;
+      if (variables && !variables_update_failed) { vars = &variables; }
+    }
+    else
+    {
+      dashboard_device * entry = NULL;
+      for (dashboard_device & candidate : dashboard_devices)
+      {
+        if (candidate.device.get_os_id() == row.os_id) { entry = &candidate; }
+      }
+
+      if (entry == NULL)
+      {
+        // Start watching a new device.  We use the same worker code as for
+        // the connected device, but the worker does not get the device list
+        // since we already do that, and it leaves the errors occurred bits
+        // alone since the dashboard does not show them.  The worker opens
+        // the device so that a slow device does not freeze the UI.
+        dashboard_devices.emplace_back();
+        entry = &dashboard_devices.back();
+        entry->device = listed;
+        entry->worker.reset(new device_worker());
+        entry->worker->set_clear_errors_occurred(false);
+        entry->worker->start(normal_update_interval_ms, 0);
+        entry->worker->open(listed);
+      }
+
+      // The worker only runs jobs to open the device, so any error came from
+      // one of those.  Keep showing it until an attempt to open the device
+      // succeeds.
+      for (const std::string & message : entry->worker->take_errors())
+      {
+        entry->error = message;
+        entry->next_open_attempt = now +
+          std::chrono::milliseconds(DASHBOARD_RETRY_INTERVAL_MS);
+      }
+      if (!entry->error.empty() && now >= entry->next_open_attempt)
+      {
+        entry->next_open_attempt = std::chrono::steady_clock::time_point::max();
+        entry->worker->open(listed);
+      }
+
+      entry->worker->take_snapshot();
+      const device_snapshot & snapshot = entry->worker->snapshot();
+      if (!snapshot.os_id.empty()) { entry->error.clear(); }
+
+      if (!entry->error.empty())
+      {
+        row.error = entry->error;
+      }
+      else if (snapshot.variables_update_failed)
+      {
+        row.error = "Failed to read the variables.";
+      }
+      else if (snapshot.variables)
+      {
+        vars = &snapshot.variables;
+      }
+    }
+
+    if (vars)
+    {
+      row.valid = true;
+      row.current_position = vars->get_current_position();
+      row.current_velocity = vars->get_current_velocity();
+      row.operation_state = tic_look_up_operation_state_name_ui(
+        vars->get_operation_state());
+      row.error_status = vars->get_error_status();
+    }
+
+    rows.push_back(row);
+  }
+
+  window->set_dashboard_rows(rows);
+}
+
+void main_controller::record_plot_samples()
+{
+  std::vector<device_sample> samples = worker.take_samples();
+  if (samples.empty() || plot_paused) { return; }
+
+  std::vector<double> values(PLOT_TRACE_COUNT);
+  for (const device_sample & sample : samples)
+  {
+    double time = std::chrono::duration<double>(
+      sample.time - plot_start_time).count();
+    values[PLOT_CURRENT_POSITION] = sample.current_position;
+    values[PLOT_CURRENT_VELOCITY] =
+      (double)sample.current_velocity / TIC_SPEED_UNITS_PER_HZ;
+    values[PLOT_INPUT_AFTER_SCALING] = sample.input_after_scaling;
+    values[PLOT_ENCODER_POSITION] = sample.encoder_position;
+    values[PLOT_VIN_VOLTAGE] = sample.vin_voltage / 1000.0;
+    plot.add(time, values);
+  }
+  window->update_plot();
+}
+
+void main_controller::handle_plot_paused_input(bool paused)
+{
+  plot_paused = paused;
+  worker.set_record_samples(!paused);
+  adjust_update_interval();
+}
+
+void main_controller::clear_plot()
+{
+  plot.clear();
+  window->update_plot();
+}
+
+void main_controller::export_plot_to_file(std::string filename)
+{
+  // These must be in the same order as the plot_trace enum.
+  static const std::vector<std::string> trace_names = {
+    "current_position",
+    "current_velocity",
+    "input_after_scaling",
+    "encoder_position",
+    "vin_voltage",
+  };
+
+  try
+  {
+    write_string_to_file(filename, plot.to_csv(trace_names));
+  }
+  catch (const std::exception & e)
+  {
+    show_exception(e);
+  }
+}
+
+void main_controller::set_update_intervals(uint32_t active, uint32_t normal,
+  uint32_t idle)
+{
+  active_update_interval_ms = active;
+  normal_update_interval_ms = normal;
+  idle_update_interval_ms = idle;
+  adjust_update_interval();
+}
+
+void main_controller::adjust_update_interval()
+{
+  uint32_t interval = normal_update_interval_ms;
+  if (window->input_wizard_sampling())
+  {
+    interval = active_update_interval_ms;
+  }
+  else if (!connected() || !variables)
+  {
+    interval = idle_update_interval_ms;
+  }
+  else if (variables.get_homing_active() ||
+    variables.get_current_velocity() != 0 || window->plot_active())
+  {
+    interval = active_update_interval_ms;
+  }
+  else if (!variables.get_energized() && !window->input_wizard_open())
+  {
+    // Keep using the normal interval while the input wizard is open so its
+    // display of the input does not lag.
+    interval = idle_update_interval_ms;
+  }
+
+  if (interval == update_interval_ms) { return; }
+  update_interval_ms = interval;
+  worker.set_poll_interval(interval);
+  window->set_update_timer_interval(interval);
+}
+
+void main_controller::report_widget_update_rate()
+{
+  auto now = std::chrono::steady_clock::now();
+  uint64_t elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+    now - widget_update_rate_start).count();
+  if (elapsed_ms < 1000) { return; }
+
+  window->set_widget_update_rate(widget_update_count * 1000 / elapsed_ms);
+  widget_update_count = 0;
+  widget_update_rate_start = now;
+}
+
+void main_controller::count_errors_occurred(const device_snapshot & snapshot,
+  bool count)
+{
+  if (snapshot.handle_sequence != handle_sequence)
+  {
+    // The worker started counting again from zero.
+    handle_sequence = snapshot.handle_sequence;
+    errors_occurred_counts.fill(0);
+  }
+
+  for (size_t i = 0; i < errors_occurred_counts.size(); i++)
+  {
+    if (count)
+    {
+      unshown_errors_occurred[i] +=
+        snapshot.errors_occurred_counts[i] - errors_occurred_counts[i];
+    }
+    errors_occurred_counts[i] = snapshot.errors_occurred_counts[i];
+  }
 }
 
 bool main_controller::exit()
@@ -416,28 +713,26 @@ static bool device_lists_different(
   }
 }
 
-bool main_controller::update_device_list()
+bool main_controller::update_device_list(const device_snapshot & snapshot)
 {
-  try
-  {
-    std::vector<tic::device> new_device_list = tic::list_connected_devices();
-    if (device_lists_different(device_list, new_device_list))
-    {
-      device_list_changed = true;
-    }
-    else
-    {
-      device_list_changed = false;
-    }
-    device_list = new_device_list;
-    return true;
-  }
-  catch (const std::exception & e)
+  if (snapshot.device_list_failed)
   {
     set_connection_error("Failed to get the list of devices.");
-    show_exception(e, "There was an error getting the list of devices.");
+    window->show_error_message("There was an error getting the list of "
+      "devices.  " + snapshot.device_list_error);
     return false;
   }
+
+  if (device_lists_different(device_list, snapshot.device_list))
+  {
+    device_list_changed = true;
+  }
+  else
+  {
+    device_list_changed = false;
+  }
+  device_list = snapshot.device_list;
+  return true;
 }
 
 void main_controller::show_exception(const std::exception & e,
@@ -462,12 +757,13 @@ void main_controller::handle_model_changed()
 
 void main_controller::handle_device_changed()
 {
+  render_all_variables = true;
+
   if (connected())
   {
-    const tic::device & device = device_handle.get_device();
     window->set_device_name(device.get_name(), true);
     window->set_serial_number(device.get_serial_number());
-    window->set_firmware_version(device_handle.get_firmware_version_string());
+    window->set_firmware_version(firmware_version_string);
     window->set_device_reset(
       tic_look_up_device_reset_name_ui(variables.get_device_reset()));
 
@@ -525,47 +821,117 @@ void main_controller::initialize_manual_target()
 
 void main_controller::handle_variables_changed()
 {
-  uint8_t product = device_handle.get_device().get_product();
+  uint8_t product = device.get_product();
+
+  // Compare the variables to the ones we rendered last time, and only update
+  // the widgets whose values changed.  Things other than the variables that
+  // the widgets depend on, like the settings, set render_all_variables when
+  // they change.
+  const tic::variables & old = rendered_variables;
+  bool all = render_all_variables || !rendered_variables;
+  auto changed = [&](bool different)
+  {
+    if (!all && !different) { return false; }
+    widget_update_count++;
+    return true;
+  };
+
+  if (changed(variables.get_up_time() != old.get_up_time()))
+  {
+    window->set_up_time(variables.get_up_time());
+  }
+
+  if (changed(variables.get_encoder_position() != old.get_encoder_position()))
+  {
+    window->set_encoder_position(variables.get_encoder_position());
+  }
+
+  if (changed(variables.get_input_state() != old.get_input_state()))
+  {
+    window->set_input_state(
+      tic_look_up_input_state_name_ui(variables.get_input_state()),
+      variables.get_input_state());
+  }
 
-  window->set_up_time(variables.get_up_time());
+  if (changed(variables.get_input_after_averaging() !=
+      old.get_input_after_averaging()))
+  {
+    window->set_input_after_averaging(variables.get_input_after_averaging());
+  }
+
+  if (changed(variables.get_input_after_hysteresis() !=
+      old.get_input_after_hysteresis()))
+  {
+    window->set_input_after_hysteresis(variables.get_input_after_hysteresis());
+  }
 
-  window->set_encoder_position(variables.get_encoder_position());
-  window->set_input_state(
-    tic_look_up_input_state_name_ui(variables.get_input_state()),
-    variables.get_input_state());
-  window->set_input_after_averaging(variables.get_input_after_averaging());
-  window->set_input_after_hysteresis(variables.get_input_after_hysteresis());
-  if (cached_settings)
+  if (cached_settings && changed(
+      variables.get_input_before_scaling(cached_settings) !=
+      old.get_input_before_scaling(cached_settings)))
   {
     window->set_input_before_scaling(
       variables.get_input_before_scaling(cached_settings),
       tic_settings_get_control_mode(settings.get_pointer()));
   }
-  window->set_input_after_scaling(variables.get_input_after_scaling());
 
-  window->set_vin_voltage(variables.get_vin_voltage());
-  window->set_energized(variables.get_energized());
-  if (settings_have_limit_switch(cached_settings))
+  if (changed(variables.get_input_after_scaling() !=
+      old.get_input_after_scaling()))
   {
-    window->set_limit_active(variables.get_forward_limit_active(),
-      variables.get_reverse_limit_active());
+    window->set_input_after_scaling(variables.get_input_after_scaling());
   }
-  else
+
+  if (changed(variables.get_vin_voltage() != old.get_vin_voltage()))
+  {
+    window->set_vin_voltage(variables.get_vin_voltage());
+  }
+
+  if (changed(variables.get_energized() != old.get_energized()))
   {
-    window->disable_limit_active();
+    window->set_energized(variables.get_energized());
+  }
+
+  if (changed(
+      variables.get_forward_limit_active() != old.get_forward_limit_active() ||
+      variables.get_reverse_limit_active() != old.get_reverse_limit_active()))
+  {
+    if (settings_have_limit_switch(cached_settings))
+    {
+      window->set_limit_active(variables.get_forward_limit_active(),
+        variables.get_reverse_limit_active());
+    }
+    else
+    {
+      window->disable_limit_active();
+    }
+  }
+
+  if (changed(variables.get_homing_active() != old.get_homing_active()))
+  {
+    window->set_homing_active(variables.get_homing_active());
+  }
+
+  if (changed(variables.get_operation_state() != old.get_operation_state()))
+  {
+    window->set_operation_state(
+      tic_look_up_operation_state_name_ui(variables.get_operation_state()));
   }
-  window->set_homing_active(variables.get_homing_active());
-  window->set_operation_state(
-    tic_look_up_operation_state_name_ui(variables.get_operation_state()));
 
   if (product == TIC_PRODUCT_36V4)
   {
-    window->set_last_hp_driver_errors(variables.get_last_hp_driver_errors());
+    if (changed(variables.get_last_hp_driver_errors() !=
+        old.get_last_hp_driver_errors()))
+    {
+      window->set_last_hp_driver_errors(variables.get_last_hp_driver_errors());
+    }
   }
   else
   {
-    window->set_last_motor_driver_error(
-      tic_look_up_motor_driver_error_name_ui(variables.get_last_motor_driver_error()));
+    if (changed(variables.get_last_motor_driver_error() !=
+        old.get_last_motor_driver_error()))
+    {
+      window->set_last_motor_driver_error(
+        tic_look_up_motor_driver_error_name_ui(variables.get_last_motor_driver_error()));
+    }
   }
 
   int32_t target_position = variables.get_target_position();
@@ -573,39 +939,77 @@ void main_controller::handle_variables_changed()
   int32_t current_position = variables.get_current_position();
   int32_t current_velocity = variables.get_current_velocity();
 
+  bool target_changed =
+    variables.get_planning_mode() != old.get_planning_mode() ||
+    target_position != old.get_target_position() ||
+    target_velocity != old.get_target_velocity();
+
   bool target_valid = true;
   if (variables.get_planning_mode() == TIC_PLANNING_MODE_TARGET_POSITION)
   {
-    window->set_target_position(target_position);
+    if (changed(target_changed)) { window->set_target_position(target_position); }
   }
   else if (variables.get_planning_mode() == TIC_PLANNING_MODE_TARGET_VELOCITY)
   {
-    window->set_target_velocity(target_velocity);
+    if (changed(target_changed)) { window->set_target_velocity(target_velocity); }
   }
   else
   {
-    window->set_target_none();
+    if (changed(target_changed)) { window->set_target_none(); }
     target_valid = false;
   }
 
-  window->set_manual_target_ball_position(current_position,
-    target_valid && (current_position == target_position));
-  window->set_manual_target_ball_velocity(current_velocity,
-    target_valid && (current_velocity == target_velocity));
+  if (changed(target_changed || current_position != old.get_current_position()))
+  {
+    window->set_manual_target_ball_position(current_position,
+      target_valid && (current_position == target_position));
+  }
+
+  if (changed(target_changed || current_velocity != old.get_current_velocity()))
+  {
+    window->set_manual_target_ball_velocity(current_velocity,
+      target_valid && (current_velocity == target_velocity));
+  }
+
+  if (changed(current_position != old.get_current_position()))
+  {
+    window->set_current_position(current_position);
+  }
 
-  window->set_current_position(current_position);
-  window->set_position_uncertain(variables.get_position_uncertain());
-  window->set_current_velocity(current_velocity);
+  if (changed(variables.get_position_uncertain() !=
+      old.get_position_uncertain()))
+  {
+    window->set_position_uncertain(variables.get_position_uncertain());
+  }
+
+  if (changed(current_velocity != old.get_current_velocity()))
+  {
+    window->set_current_velocity(current_velocity);
+  }
 
   uint16_t error_status = variables.get_error_status();
 
-  window->set_error_status(error_status);
-  window->increment_errors_occurred(variables.get_errors_occurred());
+  if (changed(error_status != old.get_error_status()))
+  {
+    window->set_error_status(error_status);
+  }
+
+  for (size_t i = 0; i < unshown_errors_occurred.size(); i++)
+  {
+    for (; unshown_errors_occurred[i]; unshown_errors_occurred[i]--)
+    {
+      window->increment_errors_occurred((uint32_t)1 << i);
+      widget_update_count++;
+    }
+  }
 
   // We could enable the de-energize button only when the motor is not
   // intentionally de-energized, but instead we enable it all the time (when
   // connected to a device) so that people aren't nervous to see it disabled.
-  window->set_deenergize_button_enabled(connected());
+  if (changed(false))
+  {
+    window->set_deenergize_button_enabled(connected());
+  }
 
   uint16_t resumable_errors = 1 << TIC_ERROR_INTENTIONALLY_DEENERGIZED;
   bool resume_button_enabled, prompt_to_resume;
@@ -634,15 +1038,28 @@ void main_controller::handle_variables_changed()
     prompt_to_resume = connected() && error_status &&
       !(error_status & ~resumable_errors);
   }
-  window->set_resume_button_enabled(resume_button_enabled);
+  if (changed(error_status != old.get_error_status()))
+  {
+    window->set_resume_button_enabled(resume_button_enabled);
+  }
   update_motor_status_message(prompt_to_resume);
+
+  if (variables)
+  {
+    rendered_variables = variables;
+  }
+  else
+  {
+    rendered_variables = tic::variables();
+  }
+  render_all_variables = false;
 }
 
 void main_controller::update_motor_status_message(bool prompt_to_resume)
 {
   std::string msg;
   bool stopped = true;
-  uint8_t product = device_handle.get_device().get_product();
+  uint8_t product = device.get_product();
   uint16_t error_status = variables.get_error_status();
   uint32_t vin_voltage = variables.get_vin_voltage();
 
@@ -770,11 +1187,20 @@ void main_controller::update_motor_status_message(bool prompt_to_resume)
     msg += "  Press Resume to start.";
   }
 
-  window->set_motor_status_message(msg, stopped);
+  if (render_all_variables || msg != rendered_motor_status_message ||
+    stopped != rendered_motor_stopped)
+  {
+    window->set_motor_status_message(msg, stopped);
+    rendered_motor_status_message = msg;
+    rendered_motor_stopped = stopped;
+    widget_update_count++;
+  }
 }
 
 void main_controller::handle_settings_changed()
 {
+  render_all_variables = true;
+
   // [all-settings]
 
   tic_settings * s = settings.get_pointer();
@@ -1403,88 +1829,58 @@ void main_controller::set_target_position(int32_t position)
 {
   if (!connected()) { return; }
 
-  try
-  {
-    device_handle.set_target_position(position);
-    send_reset_command_timeout = true;
-  }
-  catch (const std::exception & e)
+  worker.post([=](tic::handle & handle)
   {
-    show_exception(e);
-  }
+    handle.set_target_position(position);
+    worker.set_send_reset_command_timeout(true);
+  });
 }
 
 void main_controller::set_target_velocity(int32_t velocity)
 {
   if (!connected()) { return; }
 
-  try
-  {
-    device_handle.set_target_velocity(velocity);
-    send_reset_command_timeout = true;
-  }
-  catch (const std::exception & e)
+  worker.post([=](tic::handle & handle)
   {
-    show_exception(e);
-  }
+    handle.set_target_velocity(velocity);
+    worker.set_send_reset_command_timeout(true);
+  });
 }
 
 void main_controller::halt_and_set_position(int32_t position)
 {
   if (!connected()) { return; }
 
-  try
+  worker.post([=](tic::handle & handle)
   {
-    device_handle.halt_and_set_position(position);
-  }
-  catch (const std::exception & e)
-  {
-    show_exception(e);
-  }
+    handle.halt_and_set_position(position);
+  });
 }
 
 void main_controller::halt_and_hold()
 {
   if (!connected()) { return; }
 
-  try
-  {
-    device_handle.halt_and_hold();
-  }
-  catch (const std::exception & e)
-  {
-    show_exception(e);
-  }
+  worker.post([](tic::handle & handle) { handle.halt_and_hold(); });
 }
 
 void main_controller::deenergize()
 {
   if (!connected()) { return; }
 
-  try
-  {
-    device_handle.deenergize();
-  }
-  catch (const std::exception & e)
-  {
-    show_exception(e);
-  }
+  worker.post([](tic::handle & handle) { handle.deenergize(); });
 }
 
 void main_controller::resume()
 {
   if (!connected()) { return; }
 
-  try
+  worker.post([=](tic::handle & handle)
   {
-    device_handle.energize();
-    device_handle.exit_safe_start();
-    send_reset_command_timeout = true;
-  }
-  catch (const std::exception & e)
-  {
-    show_exception(e);
-  }
+    handle.energize();
+    handle.exit_safe_start();
+    worker.set_send_reset_command_timeout(true);
+  });
 }
 
 void main_controller::start_input_setup()
@@ -1593,8 +1989,11 @@ void main_controller::apply_settings()
       window->confirm(warnings + "\nAccept these changes and apply settings?"))
     {
       settings = fixed_settings;
-      device_handle.set_settings(settings);
-      device_handle.reinitialize();
+      worker.run([&](tic::handle & handle)
+      {
+        handle.set_settings_diff(settings);
+        handle.reinitialize();
+      });
       handle_settings_applied();
       settings_modified = false;  // this must be last in case exceptions are thrown
     }
@@ -1616,7 +2015,6 @@ void main_controller::open_settings_from_file(std::string filename)
     std::string settings_string = read_string_from_file(filename);
     tic::settings fixed_settings = tic::settings::read_from_string(settings_string);
 
-    tic::device device = device_handle.get_device();
     tic_settings_set_product(fixed_settings.get_pointer(),
       device.get_product());
     tic_settings_set_firmware_version(fixed_settings.get_pointer(),
@@ -1684,8 +2082,17 @@ void main_controller::reload_variables()
 
   try
   {
-    variables = device_handle.get_variables(true);
+    worker.run([&](tic::handle & handle)
+    {
+      variables = handle.get_variables(true);
+    });
     variables_update_failed = false;
+
+    uint32_t errors_occurred = variables.get_errors_occurred();
+    for (size_t i = 0; i < unshown_errors_occurred.size(); i++)
+    {
+      if (errors_occurred >> i & 1) { unshown_errors_occurred[i]++; }
+    }
   }
   catch (...)
   {
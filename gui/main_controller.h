@@ -1,9 +1,26 @@
 #pragma once
 
+#include "device_worker.h"
+#include "plot_history.h"
 #include "tic.hpp"
 
+#include <array>
+#include <chrono>
+#include <memory>
+
 class main_window;
 
+// The traces in the plot on the plot tab.
+enum plot_trace
+{
+  PLOT_CURRENT_POSITION,
+  PLOT_CURRENT_VELOCITY,
+  PLOT_INPUT_AFTER_SCALING,
+  PLOT_ENCODER_POSITION,
+  PLOT_VIN_VOLTAGE,
+  PLOT_TRACE_COUNT
+};
+
 class main_controller
 {
 public:
@@ -57,13 +74,22 @@ private:
   void really_disconnect();
   void set_connection_error(const std::string & error_message);
 
-  // Returns true for success, false for failure.
-  bool update_device_list();
+  // Copies the device list from a snapshot.  Returns true for success, false
+  // if the worker failed to get the list.
+  bool update_device_list(const device_snapshot &);
 
   // True if device_list changed the last time update_device_list() was
   // called.
   bool device_list_changed;
 
+  // Tells the window how many widget updates per second we have been doing,
+  // about once per second.
+  void report_widget_update_rate();
+
+  // Adds the errors that the worker counted since the last snapshot we took
+  // to unshown_errors_occurred.  If count is false, just remembers the counts.
+  void count_errors_occurred(const device_snapshot &, bool count);
+
   void show_exception(const std::exception & e, const std::string & context = "");
 
 public:
@@ -157,8 +183,32 @@ public:
 
   void handle_upload_complete();
 
+  // This is called when the user turns the dashboard on or off.  While it is
+  // on, we connect to every device in the device list, not just the one
+  // shown in the other tabs, and show a summary of each one.
+  void handle_dashboard_enabled_input(bool enabled);
+
+  // These are called when the user uses the controls on the plot tab.
+  void handle_plot_paused_input(bool paused);
+  void clear_plot();
+  void export_plot_to_file(std::string filename);
+
   uint8_t get_product() { return settings.get_product(); }
 
+  // The limits for the update intervals that the user can choose.
+  static constexpr uint32_t MIN_UPDATE_INTERVAL_MS = 5;
+  static constexpr uint32_t MAX_UPDATE_INTERVAL_MS = 5000;
+
+  // How often we read the variables from the device, in milliseconds.  We
+  // use the active interval while the motor is moving or homing, the input
+  // wizard is sampling, or the plot is shown; the idle interval while the
+  // motor is deenergized or we are not connected; and the normal interval
+  // otherwise.
+  uint32_t get_active_update_interval() const { return active_update_interval_ms; }
+  uint32_t get_normal_update_interval() const { return normal_update_interval_ms; }
+  uint32_t get_idle_update_interval() const { return idle_update_interval_ms; }
+  void set_update_intervals(uint32_t active, uint32_t normal, uint32_t idle);
+
 private:
   // This is called whenever it is possible that we have connected to a
   // different device.
@@ -169,13 +219,48 @@ private:
   void update_menu_enables();
 
   void initialize_manual_target();
+
+  // Adds the samples that the worker recorded since the last call to the
+  // plot.
+  void record_plot_samples();
+
+  // Makes sure there is a dashboard worker for each device in the device list
+  // other than the connected one, and passes the latest status of each device
+  // to the window.
+  void update_dashboard();
+
+  // Closes the dashboard's handle to the specified device, if it has one.
+  void release_dashboard_device(const tic::device &);
+
+  // Chooses the update interval that suits what the device is doing, and
+  // passes it on to the worker and the window's update timer if it changed.
+  void adjust_update_interval();
   void update_motor_status_message(bool prompt_to_resume);
 
   // Holds a list of the relevant devices that are connected to the computer.
   std::vector<tic::device> device_list;
 
-  // Holds an open handle to a device or a null handle if we are not connected.
-  tic::handle device_handle;
+  // Does all communication with devices, and holds the handle to the device
+  // we are connected to.
+  device_worker worker;
+
+  // Holds the device we are connected to or a null device if we are not
+  // connected.
+  tic::device device;
+
+  // The firmware version string of the connected device, which is read when
+  // we connect.
+  std::string firmware_version_string;
+
+  // The device_list_sequence and handle_sequence of the last snapshot we took
+  // from the worker, and its errors occurred counts.
+  uint32_t device_list_sequence = 0;
+  uint32_t handle_sequence = 0;
+  std::array<uint32_t, 32> errors_occurred_counts{};
+
+  // For each error bit, the number of times the device reported that error as
+  // occurring that have not been passed on to the window yet.
+  std::array<uint32_t, 32> unshown_errors_occurred{};
 
   // True if the last connection or connection attempt resulted in an error.  If
   // true, connection_error_essage provides some information about the error.
@@ -201,25 +286,61 @@ private:
   // Holds the variables/status of the device.
   tic::variables variables;
 
+  // Holds the variables that were last shown in the window, so we only update
+  // the widgets for variables that changed.  If render_all_variables is true,
+  // something else that the widgets depend on changed, so we update all of
+  // them.
+  tic::variables rendered_variables;
+  bool render_all_variables = true;
+  std::string rendered_motor_status_message;
+  bool rendered_motor_stopped = false;
+
+  // A device shown on the dashboard.  Each one has its own worker, so the
+  // devices are all polled at the same time and a slow device does not hold
+  // up the others.  The dashboard does not have a worker for the connected
+  // device; it uses the variables from our main worker for that one.
+  struct dashboard_device
+  {
+    tic::device device;
+    std::unique_ptr<device_worker> worker;
+
+    // The error that happened the last time we tried to connect, if any,
+    // and when to try again.
+    std::string error;
+    std::chrono::steady_clock::time_point next_open_attempt;
+  };
+  std::vector<dashboard_device> dashboard_devices;
+  bool dashboard_enabled = false;
+
+  // The history shown on the plot tab, and the time that its time axis is
+  // measured from.
+  plot_history plot{PLOT_TRACE_COUNT};
+  std::chrono::steady_clock::time_point plot_start_time;
+  bool plot_paused = false;
+
+  uint32_t active_update_interval_ms = 0;
+  uint32_t normal_update_interval_ms = 0;
+  uint32_t idle_update_interval_ms = 0;
+
+  // The update interval that the worker is using now.
+  uint32_t update_interval_ms = 0;
+
+  // The number of times we called a function of the window to update a widget
+  // for the variables since widget_update_rate_start.
+  uint32_t widget_update_count = 0;
+  std::chrono::steady_clock::time_point widget_update_rate_start;
+
   // True if the last attempt to update the variables failed (typically due
   // to a USB error).
   bool variables_update_failed = false;
 
-  // The number of updates to wait for before updating the
-  // device list again (saves CPU time).
-  uint32_t update_device_list_counter = 1;
-
-  // True if we want to regularly send the "Reset command timeout" command to
-  // this device.
-  bool send_reset_command_timeout = false;
-
   bool suppress_high_current_limit_warning = false;
   bool suppress_potential_high_current_limit_warning = false;
 
   void reload_variables();
 
   // Returns true if we are currently connected to a device.
-  bool connected() const { return device_handle; }
+  bool connected() const { return device; }
 
   static bool control_mode_is_serial(const tic::settings & s);
   static bool uses_pin_func(const tic::settings & s, uint8_t func);
@@ -0,0 +1,108 @@
+#include "plot_history.h"
+
+#include <algorithm>
+#include <cassert>
+#include <sstream>
+
+plot_history::plot_history(size_t trace_count, size_t capacity)
+  : traces(trace_count), capacity(capacity)
+{
+  assert(capacity >= 2 && capacity % 2 == 0);
+  time_first.reserve(capacity);
+  time_last.reserve(capacity);
+  mins.reserve(capacity * traces);
+  maxes.reserve(capacity * traces);
+}
+
+void plot_history::add(double time, const std::vector<double> & values)
+{
+  assert(values.size() == traces);
+
+  if (!empty() && last_count < span)
+  {
+    // Add the sample to the last point.
+    double * min = &mins[(size() - 1) * traces];
+    double * max = &maxes[(size() - 1) * traces];
+    for (size_t i = 0; i < traces; i++)
+    {
+      min[i] = std::min(min[i], values[i]);
+      max[i] = std::max(max[i], values[i]);
+    }
+    time_last.back() = time;
+    last_count++;
+    return;
+  }
+
+  if (size() == capacity) { merge_pairs(); }
+
+  time_first.push_back(time);
+  time_last.push_back(time);
+  mins.insert(mins.end(), values.begin(), values.end());
+  maxes.insert(maxes.end(), values.begin(), values.end());
+  last_count = 1;
+}
+
+void plot_history::merge_pairs()
+{
+  // All the points are full, so after merging they are still full.
+  size_t new_size = size() / 2;
+  for (size_t p = 0; p < new_size; p++)
+  {
+    size_t a = 2 * p, b = 2 * p + 1;
+    time_first[p] = time_first[a];
+    time_last[p] = time_last[b];
+    for (size_t i = 0; i < traces; i++)
+    {
+      mins[p * traces + i] = std::min(mins[a * traces + i], mins[b * traces + i]);
+      maxes[p * traces + i] = std::max(maxes[a * traces + i], maxes[b * traces + i]);
+    }
+  }
+  time_first.resize(new_size);
+  time_last.resize(new_size);
+  mins.resize(new_size * traces);
+  maxes.resize(new_size * traces);
+  span *= 2;
+  last_count = span;
+}
+
+void plot_history::clear()
+{
+  time_first.clear();
+  time_last.clear();
+  mins.clear();
+  maxes.clear();
+  span = 1;
+  last_count = 0;
+}
+
+size_t plot_history::find_point(double time) const
+{
+  return std::lower_bound(time_last.begin(), time_last.end(), time) -
+    time_last.begin();
+}
+
+std::string plot_history::to_csv(
+  const std::vector<std::string> & trace_names) const
+{
+  assert(trace_names.size() == traces);
+
+  std::ostringstream csv;
+  csv.precision(10);
+  csv << "time_first,time_last";
+  for (const std::string & name : trace_names)
+  {
+    csv << "," << name << "_min," << name << "_max";
+  }
+  csv << "\n";
+
+  for (size_t p = 0; p < size(); p++)
+  {
+    csv << time_first[p] << "," << time_last[p];
+    for (size_t i = 0; i < traces; i++)
+    {
+      csv << "," << get_min(i, p) << "," << get_max(i, p);
+    }
+    csv << "\n";
+  }
+  return csv.str();
+}
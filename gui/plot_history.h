@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Holds the history of several traces that are sampled at the same times, for
+// plotting.
+//
+// The history never holds more than a fixed number of points.  Each point
+// covers one or more consecutive samples and records the minimum and maximum
+// value of each trace over those samples.  When the history is full, it merges
+// each pair of adjacent points into one, so it can hold twice as many samples
+// in the same space.  This way the memory used and the time it takes to draw
+// the plot stay the same no matter how long we have been sampling, and short
+// spikes still show up.
+class plot_history
+{
+public:
+  // The capacity is the maximum number of points, and should be even.
+  plot_history(size_t trace_count, size_t capacity = 2000);
+
+  size_t trace_count() const { return traces; }
+
+  // Adds a sample.  The values must have one entry per trace, and the time
+  // must not be earlier than the time of the previous sample.
+  void add(double time, const std::vector<double> & values);
+
+  // Removes all the samples.
+  void clear();
+
+  // The number of points in the history.
+  size_t size() const { return time_first.size(); }
+  bool empty() const { return time_first.empty(); }
+
+  // The number of samples covered by each point, except the last one, which
+  // might cover fewer.
+  uint32_t samples_per_point() const { return span; }
+
+  // The times of the first and last samples covered by a point.
+  double get_time_first(size_t point) const { return time_first[point]; }
+  double get_time_last(size_t point) const { return time_last[point]; }
+
+  // The minimum and maximum value of a trace over the samples covered by a
+  // point.
+  double get_min(size_t trace, size_t point) const
+  {
+    return mins[point * traces + trace];
+  }
+  double get_max(size_t trace, size_t point) const
+  {
+    return maxes[point * traces + trace];
+  }
+
+  // Returns the index of the first point whose last sample is at or after the
+  // specified time, or size() if there is none.
+  size_t find_point(double time) const;
+
+  // Returns the history as comma-separated values, with a header row that
+  // uses the specified trace names.  Each row has the time range of a point
+  // followed by the minimum and maximum of each trace.
+  std::string to_csv(const std::vector<std::string> & trace_names) const;
+
+private:
+  void merge_pairs();
+
+  size_t traces;
+  size_t capacity;
+  uint32_t span = 1;
+
+  // The number of samples in the last point.
+  uint32_t last_count = 0;
+
+  std::vector<double> time_first;
+  std::vector<double> time_last;
+  std::vector<double> mins;
+  std::vector<double> maxes;
+};
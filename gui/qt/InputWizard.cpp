@@ -18,8 +18,10 @@
 #define FINISH_BUTTON_TEXT tr("Finish")
 #endif
 
-// Take 20 samples, one sample every 50 ms. Total time is 1 s.
-static uint32_t const SAMPLE_COUNT = 20;
+// Sample the input for 1 s.  The number of samples we get depends on how
+// often the controller reads the variables, which it does faster while we are
+// sampling.
+static uint32_t const SAMPLE_TIME_MS = 1000;
 
 InputWizard::InputWizard(main_window * parent)
   : QWizard(parent)
@@ -257,7 +259,7 @@ LearnPage::LearnPage(InputWizard * parent)
   layout->addWidget(sampling_label);
 
   sampling_progress = new QProgressBar();
-  sampling_progress->setMaximum(SAMPLE_COUNT);
+  sampling_progress->setMaximum(SAMPLE_TIME_MS);
   sampling_progress->setTextVisible(false);
   layout->addWidget(sampling_progress);
 
@@ -371,6 +373,7 @@ bool LearnPage::handle_next()
   {
     sampling = true;
     samples.clear();
+    sampling_timer.start();
     sampling_progress->setValue(0);
     set_progress_visible(true);
     set_next_button_enabled(false);
@@ -393,9 +396,10 @@ void LearnPage::sample(uint16_t input)
   }
 
   samples.push_back(input);
-  sampling_progress->setValue(sampling_progress->value() + 1);
+  qint64 elapsed = sampling_timer.elapsed();
+  sampling_progress->setValue(std::min<qint64>(elapsed, SAMPLE_TIME_MS));
 
-  if (sampling_progress->value() == SAMPLE_COUNT)
+  if (elapsed >= SAMPLE_TIME_MS)
   {
     sampling = false;
     set_progress_visible(false);
@@ -2,6 +2,7 @@
 
 #include <array>
 
+#include <QElapsedTimer>
 #include <QWizard>
 
 class InputWizard;
@@ -72,6 +73,7 @@ private:
   bool enable_next_button = true;
 
   bool sampling = false;
+  QElapsedTimer sampling_timer;
   std::vector<uint16_t> samples;
   std::array<input_range, 3> learned_ranges;
 
@@ -108,6 +110,9 @@ public:
 
   void handle_input(uint16_t input);
 
+  // True if the wizard is in the middle of sampling the input.
+  bool sampling() const { return learn_page->sampling; }
+
   bool learned_input_invert() const           { return learn_page->input_invert; }
   uint16_t learned_input_min() const          { return learn_page->input_min; }
   uint16_t learned_input_neutral_min() const  { return learn_page->input_neutral_min; }
@@ -5,6 +5,8 @@
 
 #include "BallScrollBar.h"
 #include "current_spin_box.h"
+#include "plot_history.h"
+#include "plot_widget.h"
 #include "time_spin_box.h"
 
 #include <QApplication>
@@ -14,11 +16,14 @@
 #include <QComboBox>
 #include <QDesktopServices>
 #include <QDesktopWidget>
+#include <QDialog>
+#include <QDialogButtonBox>
 #include <QDoubleSpinBox>
 #include <QFileDialog>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QHBoxLayout>
+#include <QHeaderView>
 #include <QLabel>
 #include <QMenuBar>
 #include <QMessageBox>
@@ -27,6 +32,8 @@
 #include <QRadioButton>
 #include <QShortcut>
 #include <QSpinBox>
+#include <QStatusBar>
+#include <QTableWidget>
 #include <QTabWidget>
 #include <QTimer>
 #include <QUrl>
@@ -383,6 +390,8 @@ void main_window::set_tab_pages_enabled(bool enabled)
 {
   for (int i = 0; i < tab_widget->count(); i++)
   {
+    // The dashboard shows all the devices, so it works without a connection.
+    if (tab_widget->widget(i) == dashboard_page_widget) { continue; }
     tab_widget->widget(i)->setEnabled(enabled);
   }
 }
@@ -515,8 +524,6 @@ void main_window::set_input_before_scaling(uint16_t input_before_scaling, uint8_
   input_before_scaling_label->setEnabled(input_not_null);
   input_before_scaling_value->setEnabled(input_not_null);
   input_before_scaling_pretty->setEnabled(input_not_null);
-
-  if (input_wizard->isVisible()) { input_wizard->handle_input(input_before_scaling); }
 }
 
 void main_window::set_input_state(const std::string & input_state, uint8_t input_state_raw)
@@ -793,6 +800,8 @@ void main_window::set_displayed_manual_target(int32_t target)
 
 void main_window::set_manual_target_ball_position(int32_t current_position, bool on_target)
 {
+  cached_ball_position = current_position;
+  cached_ball_position_on_target = on_target;
   if (manual_target_position_mode_radio->isChecked())
   {
     manual_target_scroll_bar->setBallValue(current_position);
@@ -802,6 +811,8 @@ void main_window::set_manual_target_ball_position(int32_t current_position, bool
 
 void main_window::set_manual_target_ball_velocity(int32_t current_velocity, bool on_target)
 {
+  cached_ball_velocity = current_velocity;
+  cached_ball_velocity_on_target = on_target;
   if (manual_target_velocity_mode_radio->isChecked())
   {
     manual_target_scroll_bar->setBallValue(current_velocity);
@@ -988,6 +999,21 @@ void main_window::run_input_wizard(uint8_t control_mode)
   }
 }
 
+void main_window::sample_input(uint16_t input_before_scaling)
+{
+  if (input_wizard->isVisible()) { input_wizard->handle_input(input_before_scaling); }
+}
+
+bool main_window::input_wizard_open() const
+{
+  return input_wizard->isVisible();
+}
+
+bool main_window::input_wizard_sampling() const
+{
+  return input_wizard->isVisible() && input_wizard->sampling();
+}
+
 void main_window::set_invert_motor_direction(bool invert_motor_direction)
 {
   set_check_box(invert_motor_direction_check, invert_motor_direction);
@@ -1250,6 +1276,83 @@ void main_window::set_motor_status_message(const std::string & message, bool sto
   motor_status_value->setText(QString::fromStdString(message));
 }
 
+void main_window::set_dashboard_rows(const std::vector<dashboard_row> & rows)
+{
+  dashboard_table->setRowCount(rows.size());
+  dashboard_rows = rows;
+
+  for (size_t r = 0; r < rows.size(); r++)
+  {
+    const dashboard_row & row = rows[r];
+
+    QString errors;
+    if (row.valid)
+    {
+      for (uint32_t i = 0; i < 32; i++)
+      {
+        uint32_t bit = (uint32_t)1 << i;
+        if (!(row.error_status & bit)) { continue; }
+        if (!errors.isEmpty()) { errors += ", "; }
+        errors += tic_look_up_error_name_ui(bit);
+      }
+      if (errors.isEmpty()) { errors = tr("None"); }
+    }
+
+    QString cells[] = {
+      QString::fromStdString(row.name),
+      QString::fromStdString(row.serial_number),
+      row.valid ? QString::number(row.current_position) : "",
+      row.valid ? QString::fromStdString(
+        convert_speed_to_pps_string(row.current_velocity)) : "",
+      row.valid ? QString::fromStdString(row.operation_state) :
+        QString::fromStdString(row.error),
+      errors,
+    };
+
+    for (int c = 0; c < (int)(sizeof(cells) / sizeof(cells[0])); c++)
+    {
+      QTableWidgetItem * item = dashboard_table->item(r, c);
+      if (item == NULL)
+      {
+        item = new QTableWidgetItem();
+        item->setFlags(Qt::ItemIsEnabled | Qt::ItemIsSelectable);
+        dashboard_table->setItem(r, c, item);
+      }
+
+      // Setting the text or font of an item causes a repaint, so only do it
+      // if something actually changed.
+      if (item->text() != cells[c]) { item->setText(cells[c]); }
+      if (item->font().bold() != row.connected)
+      {
+        QFont font = item->font();
+        font.setBold(row.connected);
+        item->setFont(font);
+      }
+    }
+  }
+}
+
+void main_window::set_plot_history(const plot_history * history)
+{
+  plot->set_history(history);
+}
+
+void main_window::update_plot()
+{
+  if (plot->isVisible()) { plot->update(); }
+}
+
+bool main_window::plot_active() const
+{
+  return plot->isVisible() && !plot_pause_button->isChecked();
+}
+
+void main_window::set_widget_update_rate(uint32_t updates_per_second)
+{
+  update_stats_label->setText(
+    tr("Widget updates: %1/s").arg(updates_per_second));
+}
+
 void main_window::set_combo_items(QComboBox * combo,
   std::vector<std::pair<const char *, uint32_t>> items)
 {
@@ -1321,6 +1424,10 @@ void main_window::update_manual_target_controls()
     {
       set_displayed_manual_target(0);
     }
+
+    // The controller only updates the ball when its value changes.
+    set_manual_target_ball_position(cached_ball_position,
+      cached_ball_position_on_target);
   }
   else
   {
@@ -1339,6 +1446,9 @@ void main_window::update_manual_target_controls()
     {
       set_displayed_manual_target(0);
     }
+
+    set_manual_target_ball_velocity(cached_ball_velocity,
+      cached_ball_velocity_on_target);
   }
 }
 
@@ -1446,12 +1556,66 @@ void main_window::on_restore_defaults_action_triggered()
   controller->restore_default_settings();
 }
 
+void main_window::on_update_intervals_action_triggered()
+{
+  QDialog dialog(this);
+  dialog.setWindowTitle(tr("Polling intervals"));
+
+  QLabel * info_label = new QLabel(tr(
+    "These settings control how often this program reads the status of the "
+    "device.  Shorter intervals give smoother feedback but use more USB "
+    "bandwidth and CPU time."));
+  info_label->setWordWrap(true);
+
+  auto make_spin_box = [&](uint32_t value)
+  {
+    QSpinBox * box = new QSpinBox();
+    box->setRange(main_controller::MIN_UPDATE_INTERVAL_MS,
+      main_controller::MAX_UPDATE_INTERVAL_MS);
+    box->setSuffix(" ms");
+    box->setValue(value);
+    return box;
+  };
+  QSpinBox * active_box = make_spin_box(controller->get_active_update_interval());
+  QSpinBox * normal_box = make_spin_box(controller->get_normal_update_interval());
+  QSpinBox * idle_box = make_spin_box(controller->get_idle_update_interval());
+
+  QGridLayout * grid = new QGridLayout();
+  grid->addWidget(new QLabel(tr("While moving, homing, or sampling:")), 0, 0);
+  grid->addWidget(active_box, 0, 1);
+  grid->addWidget(new QLabel(tr("While energized and stopped:")), 1, 0);
+  grid->addWidget(normal_box, 1, 1);
+  grid->addWidget(new QLabel(tr("While deenergized or disconnected:")), 2, 0);
+  grid->addWidget(idle_box, 2, 1);
+
+  QDialogButtonBox * buttons = new QDialogButtonBox(
+    QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+  connect(buttons, SIGNAL(accepted()), &dialog, SLOT(accept()));
+  connect(buttons, SIGNAL(rejected()), &dialog, SLOT(reject()));
+
+  QVBoxLayout * layout = new QVBoxLayout();
+  layout->addWidget(info_label);
+  layout->addLayout(grid);
+  layout->addWidget(buttons);
+  dialog.setLayout(layout);
+
+  if (dialog.exec() != QDialog::Accepted) { return; }
+
+  controller->set_update_intervals(active_box->value(), normal_box->value(),
+    idle_box->value());
+}
+
 void main_window::on_update_timer_timeout()
 {
   controller->update();
   animate_apply_settings_button();
 }
 
+void main_window::on_show_update_stats_action_toggled(bool checked)
+{
+  statusBar()->setVisible(checked);
+}
+
 void main_window::on_device_name_value_linkActivated()
 {
   on_documentation_action_triggered();
@@ -1508,6 +1672,59 @@ void main_window::on_errors_reset_counts_button_clicked()
   reset_error_counts();
 }
 
+void main_window::on_dashboard_enabled_check_toggled(bool checked)
+{
+  if (suppress_events) { return; }
+  controller->handle_dashboard_enabled_input(checked);
+}
+
+void main_window::on_dashboard_table_cellClicked(int row, int column)
+{
+  (void)column;
+  if (row < 0 || (size_t)row >= dashboard_rows.size()) { return; }
+
+  // Copy the ID since the rows can change while we connect.
+  const std::string os_id = dashboard_rows[row].os_id;
+
+  if (!dashboard_rows[row].connected)
+  {
+    if (!controller->disconnect_device())
+    {
+      // User canceled disconnect when prompted about settings that have not
+      // been applied.
+      return;
+    }
+    controller->connect_device_with_os_id(os_id);
+  }
+
+  // Show the full status of the device.
+  tab_widget->setCurrentIndex(0);
+}
+
+void main_window::on_plot_pause_button_toggled(bool checked)
+{
+  controller->handle_plot_paused_input(checked);
+}
+
+void main_window::on_plot_clear_button_clicked()
+{
+  controller->clear_plot();
+  plot->reset_zoom();
+}
+
+void main_window::on_plot_export_button_clicked()
+{
+  QString filename = QFileDialog::getSaveFileName(this,
+    tr("Export Plot"), directory_hint + "/tic_plot.csv",
+    tr("CSV files (*.csv)"));
+
+  if (!filename.isNull())
+  {
+    directory_hint = QFileInfo(filename).canonicalPath();
+    controller->export_plot_to_file(filename.toStdString());
+  }
+}
+
 void main_window::on_manual_target_position_mode_radio_toggled(bool checked)
 {
   if (suppress_events) { return; }
@@ -2319,6 +2536,10 @@ void main_window::setup_window()
   central_widget->setLayout(layout);
   setCentralWidget(central_widget);
 
+  update_stats_label = new QLabel();
+  statusBar()->addPermanentWidget(update_stats_label);
+  statusBar()->hide();
+
   retranslate();
 
   adjust_sizes();
@@ -2402,6 +2623,12 @@ void main_window::setup_menu_bar()
   upgrade_firmware_action->setObjectName("upgrade_firmware_action");
   device_menu->addAction(upgrade_firmware_action);
 
+  device_menu->addSeparator();
+
+  update_intervals_action = new QAction(this);
+  update_intervals_action->setObjectName("update_intervals_action");
+  device_menu->addAction(update_intervals_action);
+
   help_menu = menu_bar->addMenu("");
 
   documentation_action = new QAction(this);
@@ -2414,6 +2641,13 @@ void main_window::setup_menu_bar()
   about_action->setShortcut(QKeySequence::WhatsThis);
   help_menu->addAction(about_action);
 
+  help_menu->addSeparator();
+
+  show_update_stats_action = new QAction(this);
+  show_update_stats_action->setObjectName("show_update_stats_action");
+  show_update_stats_action->setCheckable(true);
+  help_menu->addAction(show_update_stats_action);
+
   setMenuBar(menu_bar);
 }
 
@@ -2470,12 +2704,16 @@ QWidget * main_window::setup_tab_widget()
     add_tab(setup_motor_settings_widget(), tr("Motor"));
     add_tab(setup_homing_settings_widget(), tr("Homing"));
     add_tab(setup_advanced_settings_page_widget(), tr("Advanced"));
+    add_tab(setup_dashboard_widget(), tr("Dashboard"));
+    add_tab(setup_plot_widget(), tr("Plot"));
   }
   else
   {
     add_tab(setup_status_page_widget(), tr("Status"));
     add_tab(setup_input_motor_settings_page_widget(), tr("Input and motor settings"));
     add_tab(setup_advanced_settings_page_widget(), tr("Advanced settings"));
+    add_tab(setup_dashboard_widget(), tr("Dashboard"));
+    add_tab(setup_plot_widget(), tr("Plot"));
   }
   update_shown_tabs();
 
@@ -2912,6 +3150,95 @@ QLayout * main_window::setup_error_table_layout()
   return layout;
 }
 
+QWidget * main_window::setup_dashboard_widget()
+{
+  dashboard_page_widget = new QWidget();
+  QVBoxLayout * layout = new QVBoxLayout();
+
+  dashboard_enabled_check = new QCheckBox();
+  dashboard_enabled_check->setObjectName("dashboard_enabled_check");
+  layout->addWidget(dashboard_enabled_check);
+
+  dashboard_table = new QTableWidget(0, 6);
+  dashboard_table->setObjectName("dashboard_table");
+  dashboard_table->setSelectionMode(QAbstractItemView::NoSelection);
+  dashboard_table->verticalHeader()->setVisible(false);
+  dashboard_table->horizontalHeader()->setStretchLastSection(true);
+  layout->addWidget(dashboard_table, 1);
+
+  dashboard_note_label = new QLabel();
+  dashboard_note_label->setWordWrap(true);
+  layout->addWidget(dashboard_note_label);
+
+  dashboard_page_widget->setLayout(layout);
+  return dashboard_page_widget;
+}
+
+QWidget * main_window::setup_plot_widget()
+{
+  plot_page_widget = new QWidget();
+  QVBoxLayout * layout = new QVBoxLayout();
+
+  {
+    QHBoxLayout * buttons = new QHBoxLayout();
+
+    plot_pause_button = new QPushButton();
+    plot_pause_button->setObjectName("plot_pause_button");
+    plot_pause_button->setCheckable(true);
+    buttons->addWidget(plot_pause_button);
+
+    plot_clear_button = new QPushButton();
+    plot_clear_button->setObjectName("plot_clear_button");
+    buttons->addWidget(plot_clear_button);
+
+    buttons->addSpacing(fontMetrics().height());
+
+    plot_zoom_in_button = new QPushButton();
+    buttons->addWidget(plot_zoom_in_button);
+
+    plot_zoom_out_button = new QPushButton();
+    buttons->addWidget(plot_zoom_out_button);
+
+    plot_reset_zoom_button = new QPushButton();
+    buttons->addWidget(plot_reset_zoom_button);
+
+    buttons->addStretch(1);
+
+    plot_export_button = new QPushButton();
+    plot_export_button->setObjectName("plot_export_button");
+    buttons->addWidget(plot_export_button);
+
+    layout->addLayout(buttons);
+  }
+
+  plot = new plot_widget();
+  connect(plot_zoom_in_button, SIGNAL(clicked()), plot, SLOT(zoom_in()));
+  connect(plot_zoom_out_button, SIGNAL(clicked()), plot, SLOT(zoom_out()));
+  connect(plot_reset_zoom_button, SIGNAL(clicked()), plot, SLOT(reset_zoom()));
+
+  {
+    QHBoxLayout * checks = new QHBoxLayout();
+    for (size_t i = 0; i < PLOT_TRACE_COUNT; i++)
+    {
+      QCheckBox * check = new QCheckBox();
+      check->setChecked(i != PLOT_ENCODER_POSITION && i != PLOT_VIN_VOLTAGE);
+      connect(check, &QCheckBox::toggled, [=](bool checked) {
+        plot->set_trace_visible(i, checked);
+      });
+      plot->set_trace_visible(i, check->isChecked());
+      plot_trace_checks.push_back(check);
+      checks->addWidget(check);
+    }
+    checks->addStretch(1);
+    layout->addLayout(checks);
+  }
+
+  layout->addWidget(plot, 1);
+
+  plot_page_widget->setLayout(layout);
+  return plot_page_widget;
+}
+
 // [all-settings]
 
 //// input and motor settings page
@@ -3871,9 +4198,11 @@ void main_window::retranslate()
   restore_defaults_action->setText(tr("&Restore default settings"));
   apply_settings_action->setText(tr("&Apply settings"));
   upgrade_firmware_action->setText(tr("&Upgrade firmware..."));
+  update_intervals_action->setText(tr("&Polling intervals..."));
   help_menu->setTitle(tr("&Help"));
   documentation_action->setText(tr("&Online documentation..."));
   about_action->setText(tr("&About..."));
+  show_update_stats_action->setText(tr("Show &update statistics"));
 
   device_list_label->setText(tr("Connected to:"));
 
@@ -3942,6 +4271,41 @@ void main_window::retranslate()
   halt_button->setText(tr("Ha&lt motor"));
   decelerate_button->setText(tr("D&ecelerate motor"));
 
+  //// dashboard page
+
+  dashboard_enabled_check->setText(tr("&Connect to all devices"));
+  dashboard_table->setHorizontalHeaderLabels({
+    tr("Device"), tr("Serial number"), tr("Current position"),
+    tr("Current velocity"), tr("Operation state"), tr("Errors") });
+  dashboard_note_label->setText(tr(
+    "The dashboard connects to every Tic in the device list and shows the "
+    "status of each one.  The device shown in the other tabs is bold.  Click "
+    "on a device to show it in the other tabs."));
+
+  //// plot page
+
+  plot_pause_button->setText(tr("&Pause"));
+  plot_clear_button->setText(tr("Clea&r"));
+  plot_zoom_in_button->setText(tr("Zoom &in"));
+  plot_zoom_out_button->setText(tr("Zoom &out"));
+  plot_reset_zoom_button->setText(tr("&Show all"));
+  plot_export_button->setText(tr("E&xport CSV..."));
+  {
+    struct { QString name; QString unit; QColor color; } traces[PLOT_TRACE_COUNT];
+    traces[PLOT_CURRENT_POSITION] = { tr("Current position"), tr("steps"), QColor(0, 90, 200) };
+    traces[PLOT_CURRENT_VELOCITY] = { tr("Current velocity"), tr("pulses/s"), QColor(200, 60, 0) };
+    traces[PLOT_INPUT_AFTER_SCALING] = { tr("Input after scaling"), "", QColor(0, 150, 60) };
+    traces[PLOT_ENCODER_POSITION] = { tr("Encoder position"), tr("counts"), QColor(150, 0, 150) };
+    traces[PLOT_VIN_VOLTAGE] = { tr("VIN voltage"), tr("V"), QColor(120, 120, 0) };
+    for (size_t i = 0; i < PLOT_TRACE_COUNT; i++)
+    {
+      plot_trace_checks[i]->setText(traces[i].name);
+      plot_trace_checks[i]->setStyleSheet(
+        QString("color: %1;").arg(traces[i].color.name()));
+      plot->set_trace(i, traces[i].name, traces[i].unit, traces[i].color);
+    }
+  }
+
   //// settings page
   // [all-settings]
 
@@ -24,12 +24,15 @@ class QPushButton;
 class QRadioButton;
 class QShortcut;
 class QSpinBox;
+class QTableWidget;
 class QTabWidget;
 class QVBoxLayout;
 
 class current_spin_box;
 class time_spin_box;
 class main_controller;
+class plot_history;
+class plot_widget;
 
 struct tab_spec {
   QWidget * tab = NULL;
@@ -88,6 +91,27 @@ private:
   friend class main_window;
 };
 
+// The status of one device, for the dashboard.
+struct dashboard_row
+{
+  std::string os_id;
+  std::string name;
+  std::string serial_number;
+
+  // True if this is the device shown in the other tabs.
+  bool connected = false;
+
+  // If there was a problem getting the status, this describes it.
+  std::string error;
+
+  // True if the values below are valid.
+  bool valid = false;
+  int32_t current_position = 0;
+  int32_t current_velocity = 0;
+  std::string operation_state;
+  uint32_t error_status = 0;
+};
+
 class main_window : public QMainWindow
 {
   Q_OBJECT
@@ -239,6 +263,15 @@ public:
 
   void run_input_wizard(uint8_t control_mode);
 
+  // Passes a new reading of the input to the input wizard if it is open.
+  // This should be called for every reading, even if the input did not
+  // change, because the wizard samples the input over time.
+  void sample_input(uint16_t input_before_scaling);
+
+  // True if the input wizard is open, and true if it is sampling the input.
+  bool input_wizard_open() const;
+  bool input_wizard_sampling() const;
+
   void set_invert_motor_direction(bool invert_motor_direction);
   void set_speed_max(uint32_t speed_max);
   void set_starting_speed(uint32_t starting_speed);
@@ -280,6 +313,22 @@ public:
 
   void set_motor_status_message(const std::string & message, bool stopped = true);
 
+  // Shows the status of each device on the dashboard tab.
+  void set_dashboard_rows(const std::vector<dashboard_row> & rows);
+
+  // Sets the history that the plot tab shows.
+  void set_plot_history(const plot_history * history);
+
+  // Redraws the plot after samples were added to its history.
+  void update_plot();
+
+  // True if the plot tab is the current tab and it is not paused.
+  bool plot_active() const;
+
+  // Shows the number of widget updates per second in the status bar, which
+  // is only visible if the user chose to show update statistics.
+  void set_widget_update_rate(uint32_t updates_per_second);
+
 private:
 
   void set_combo_items(QComboBox * combo,
@@ -315,16 +364,23 @@ private slots:
   void on_go_home_forward_action_triggered();
   void on_reload_settings_action_triggered();
   void on_restore_defaults_action_triggered();
+  void on_update_intervals_action_triggered();
   void on_update_timer_timeout();
   void on_device_name_value_linkActivated();
   void on_documentation_action_triggered();
   void on_about_action_triggered();
+  void on_show_update_stats_action_toggled(bool checked);
 
   void on_device_list_value_currentIndexChanged(int index);
   void on_deenergize_button_clicked();
   void on_resume_button_clicked();
 
   void on_errors_reset_counts_button_clicked();
+  void on_dashboard_enabled_check_toggled(bool checked);
+  void on_dashboard_table_cellClicked(int row, int column);
+  void on_plot_pause_button_toggled(bool checked);
+  void on_plot_clear_button_clicked();
+  void on_plot_export_button_clicked();
   void on_manual_target_position_mode_radio_toggled(bool checked);
   void on_manual_target_scroll_bar_valueChanged(int value);
   void on_manual_target_scroll_bar_scrollingFinished();
@@ -444,6 +500,8 @@ private:
   QWidget * setup_errors_box();
   QWidget * setup_errors_widget();
   QLayout * setup_error_table_layout();
+  QWidget * setup_dashboard_widget();
+  QWidget * setup_plot_widget();
 
   QWidget * setup_input_motor_settings_page_widget();
   QWidget * setup_control_mode_widget();
@@ -487,9 +545,13 @@ private:
   QAction * restore_defaults_action;
   QAction * apply_settings_action;
   QAction * upgrade_firmware_action;
+  QAction * update_intervals_action;
   QMenu * help_menu;
   QAction * documentation_action;
   QAction * about_action;
+  QAction * show_update_stats_action;
+
+  QLabel * update_stats_label;
 
   // True if we are using the compact layout.
   bool compact = false;
@@ -571,6 +633,13 @@ private:
   uint8_t cached_input_state = 0;
   int32_t cached_input_after_scaling;
 
+  // The manual target ball values from the controller, so we can show the
+  // right one when the manual target mode changes.
+  int32_t cached_ball_position = 0;
+  bool cached_ball_position_on_target = false;
+  int32_t cached_ball_velocity = 0;
+  bool cached_ball_velocity_on_target = false;
+
   QGroupBox * manual_target_box = NULL;
   QWidget * manual_target_widget;
   QVBoxLayout * manual_target_mode_layout;
@@ -603,6 +672,22 @@ private:
   QLabel * errors_stopping_header_label;
   QLabel * errors_count_header_label;
   std::array<error_row, 32> error_rows;
+
+  QWidget * dashboard_page_widget;
+  QCheckBox * dashboard_enabled_check;
+  QLabel * dashboard_note_label;
+  QTableWidget * dashboard_table;
+  std::vector<dashboard_row> dashboard_rows;
+
+  QWidget * plot_page_widget;
+  QPushButton * plot_pause_button;
+  QPushButton * plot_clear_button;
+  QPushButton * plot_zoom_in_button;
+  QPushButton * plot_zoom_out_button;
+  QPushButton * plot_reset_zoom_button;
+  QPushButton * plot_export_button;
+  std::vector<QCheckBox *> plot_trace_checks;
+  plot_widget * plot;
   QPushButton * errors_reset_counts_button;
 
   // [all-settings]
@@ -0,0 +1,339 @@
+#include "plot_widget.h"
+#include "plot_history.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPolygonF>
+#include <QWheelEvent>
+
+#include <algorithm>
+#include <cmath>
+
+// The shortest length of time we let the user zoom in to, in seconds.
+static const double MIN_VIEW_SPAN = 0.01;
+
+// How much one step of the mouse wheel or one click of a zoom button zooms.
+static const double ZOOM_FACTOR = 0.8;
+
+plot_widget::plot_widget(QWidget * parent)
+  : QWidget(parent)
+{
+  setMinimumHeight(200);
+  setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
+}
+
+void plot_widget::set_history(const plot_history * history)
+{
+  this->history = history;
+  if (history && traces.size() < history->trace_count())
+  {
+    traces.resize(history->trace_count());
+  }
+  update();
+}
+
+void plot_widget::set_trace(size_t trace, const QString & name,
+  const QString & unit, const QColor & color)
+{
+  if (trace >= traces.size()) { traces.resize(trace + 1); }
+  trace_info & info = traces[trace];
+  info.name = name;
+  info.unit = unit;
+  info.color = color;
+  update();
+}
+
+void plot_widget::set_trace_visible(size_t trace, bool visible)
+{
+  if (trace >= traces.size()) { traces.resize(trace + 1); }
+  traces[trace].visible = visible;
+  update();
+}
+
+QSize plot_widget::sizeHint() const
+{
+  return QSize(400, 300);
+}
+
+void plot_widget::zoom_in()
+{
+  double start, end;
+  get_time_range(start, end);
+  zoom_around((start + end) / 2, ZOOM_FACTOR);
+}
+
+void plot_widget::zoom_out()
+{
+  double start, end;
+  get_time_range(start, end);
+  zoom_around((start + end) / 2, 1 / ZOOM_FACTOR);
+}
+
+void plot_widget::reset_zoom()
+{
+  view_span = 0;
+  view_follow = true;
+  update();
+}
+
+QRect plot_widget::plot_area() const
+{
+  int axis_height = fontMetrics().height() + 6;
+  return rect().adjusted(0, 0, -1, -axis_height);
+}
+
+void plot_widget::get_time_range(double & start, double & end) const
+{
+  start = end = 0;
+  if (!history || history->empty()) { return; }
+
+  double first = history->get_time_first(0);
+  double latest = history->get_time_last(history->size() - 1);
+
+  if (view_span == 0)
+  {
+    start = first;
+    end = latest;
+  }
+  else
+  {
+    end = view_follow ? latest : view_end;
+    start = end - view_span;
+  }
+
+  if (end - start < MIN_VIEW_SPAN) { end = start + MIN_VIEW_SPAN; }
+}
+
+void plot_widget::zoom_around(double time, double factor)
+{
+  if (!history || history->empty()) { return; }
+
+  double start, end;
+  get_time_range(start, end);
+
+  double new_start = time - (time - start) * factor;
+  double new_end = time + (end - time) * factor;
+  if (new_end - new_start < MIN_VIEW_SPAN)
+  {
+    new_start = time - MIN_VIEW_SPAN / 2;
+    new_end = time + MIN_VIEW_SPAN / 2;
+  }
+
+  double latest = history->get_time_last(history->size() - 1);
+  view_span = new_end - new_start;
+  view_end = new_end;
+  view_follow = new_end >= latest;
+  update();
+}
+
+void plot_widget::wheelEvent(QWheelEvent * event)
+{
+  int delta = event->angleDelta().y();
+  if (delta == 0 || !history || history->empty())
+  {
+    event->ignore();
+    return;
+  }
+
+  QRect area = plot_area();
+  double start, end;
+  get_time_range(start, end);
+  double time = start + (end - start) *
+    (event->pos().x() - area.left()) / std::max(1, area.width());
+
+  zoom_around(time, std::pow(ZOOM_FACTOR, delta / 120.0));
+  event->accept();
+}
+
+void plot_widget::mousePressEvent(QMouseEvent * event)
+{
+  if (event->button() != Qt::LeftButton || !history || history->empty())
+  {
+    QWidget::mousePressEvent(event);
+    return;
+  }
+
+  double start, end;
+  get_time_range(start, end);
+  view_span = end - start;
+  view_end = end;
+  view_follow = false;
+
+  dragging = true;
+  drag_start_x = event->pos().x();
+  drag_start_view_end = view_end;
+  setCursor(Qt::ClosedHandCursor);
+}
+
+void plot_widget::mouseMoveEvent(QMouseEvent * event)
+{
+  if (!dragging) { return; }
+
+  int dx = event->pos().x() - drag_start_x;
+  view_end = drag_start_view_end -
+    view_span * dx / std::max(1, plot_area().width());
+  update();
+}
+
+void plot_widget::mouseReleaseEvent(QMouseEvent * event)
+{
+  if (!dragging)
+  {
+    QWidget::mouseReleaseEvent(event);
+    return;
+  }
+
+  dragging = false;
+  unsetCursor();
+
+  // Start following new samples again if the user dragged the plot all the
+  // way to the latest one.
+  if (history && !history->empty() &&
+    view_end >= history->get_time_last(history->size() - 1))
+  {
+    view_follow = true;
+  }
+  update();
+}
+
+void plot_widget::mouseDoubleClickEvent(QMouseEvent *)
+{
+  reset_zoom();
+}
+
+void plot_widget::paintEvent(QPaintEvent *)
+{
+  QPainter painter(this);
+  painter.fillRect(rect(), palette().base());
+
+  QRect area = plot_area();
+
+  std::vector<size_t> shown;
+  size_t trace_count = history ? history->trace_count() : 0;
+  for (size_t i = 0; i < trace_count && i < traces.size(); i++)
+  {
+    if (traces[i].visible) { shown.push_back(i); }
+  }
+
+  if (!history || history->empty() || shown.empty())
+  {
+    painter.setPen(palette().color(QPalette::Disabled, QPalette::Text));
+    painter.drawText(area, Qt::AlignCenter,
+      (!history || history->empty()) ? tr("No data.") :
+      tr("No traces selected."));
+    return;
+  }
+
+  double start, end;
+  get_time_range(start, end);
+  draw_time_axis(painter, area, start, end);
+
+  for (size_t i = 0; i < shown.size(); i++)
+  {
+    int top = area.top() + area.height() * i / shown.size();
+    int bottom = area.top() + area.height() * (i + 1) / shown.size();
+    QRect lane(area.left(), top, area.width(), bottom - top);
+    draw_lane(painter, lane, shown[i], start, end);
+  }
+}
+
+void plot_widget::draw_time_axis(QPainter & painter, const QRect & area,
+  double start, double end)
+{
+  // Pick a tick spacing of 1, 2, or 5 times a power of 10 that gives us about
+  // 6 ticks.
+  double raw_step = (end - start) / 6;
+  double magnitude = std::pow(10, std::floor(std::log10(raw_step)));
+  double step = magnitude;
+  if (raw_step > 5 * magnitude) { step = 10 * magnitude; }
+  else if (raw_step > 2 * magnitude) { step = 5 * magnitude; }
+  else if (raw_step > magnitude) { step = 2 * magnitude; }
+
+  QPen grid_pen(palette().color(QPalette::Midlight));
+  QPen text_pen(palette().color(QPalette::Text));
+  int text_top = area.bottom() + 3;
+  int text_height = height() - text_top;
+
+  for (double t = std::ceil(start / step) * step; t <= end; t += step)
+  {
+    int x = area.left() + std::lround((t - start) / (end - start) * area.width());
+
+    painter.setPen(grid_pen);
+    painter.drawLine(x, area.top(), x, area.bottom());
+
+    painter.setPen(text_pen);
+    painter.drawText(x - 50, text_top, 100, text_height,
+      Qt::AlignHCenter | Qt::AlignTop,
+      tr("%1 s").arg(std::fabs(t) < step / 2 ? 0 : t, 0, 'g', 6));
+  }
+}
+
+void plot_widget::draw_lane(QPainter & painter, const QRect & lane,
+  size_t trace, double start, double end)
+{
+  const trace_info & info = traces[trace];
+
+  // Include one point on each side of the visible range so the lines reach
+  // the edges of the plot.
+  size_t first = history->find_point(start);
+  if (first > 0) { first--; }
+  size_t last = std::min(history->find_point(end) + 1, history->size());
+
+  double min = history->get_min(trace, first);
+  double max = history->get_max(trace, first);
+  for (size_t p = first; p < last; p++)
+  {
+    min = std::min(min, history->get_min(trace, p));
+    max = std::max(max, history->get_max(trace, p));
+  }
+
+  double range_min = min, range_max = max;
+  if (range_max == range_min)
+  {
+    range_min -= 1;
+    range_max += 1;
+  }
+  double margin = (range_max - range_min) * 0.05;
+  range_min -= margin;
+  range_max += margin;
+
+  auto x_of = [&](double t)
+  {
+    return lane.left() + (t - start) / (end - start) * lane.width();
+  };
+  auto y_of = [&](double v)
+  {
+    return lane.bottom() - (v - range_min) / (range_max - range_min) * lane.height();
+  };
+
+  // Draw each point as a vertical line from its minimum to its maximum, joined
+  // to its neighbors, so the plot shows the whole range of values that the
+  // point covers.
+  QPolygonF line;
+  for (size_t p = first; p < last; p++)
+  {
+    double x = x_of((history->get_time_first(p) + history->get_time_last(p)) / 2);
+    double pmin = history->get_min(trace, p);
+    double pmax = history->get_max(trace, p);
+    line << QPointF(x, y_of(pmin));
+    if (pmax != pmin) { line << QPointF(x, y_of(pmax)); }
+  }
+
+  painter.save();
+  painter.setClipRect(lane);
+
+  painter.setPen(palette().color(QPalette::Mid));
+  painter.drawLine(lane.topLeft(), lane.topRight());
+
+  painter.setRenderHint(QPainter::Antialiasing);
+  painter.setPen(QPen(info.color, 1.5));
+  painter.drawPolyline(line);
+
+  QString label = tr("%1: %2 to %3 %4").arg(info.name)
+    .arg(min, 0, 'g', 7).arg(max, 0, 'g', 7).arg(info.unit);
+  painter.setPen(palette().color(QPalette::Text));
+  painter.drawText(lane.adjusted(4, 2, -4, -2), Qt::AlignLeft | Qt::AlignTop,
+    label);
+
+  painter.restore();
+}
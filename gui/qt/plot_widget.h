@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QColor>
+#include <QString>
+#include <QWidget>
+
+#include <vector>
+
+class QPainter;
+class plot_history;
+
+// Draws the traces of a plot_history, each in its own lane with its own
+// vertical scale, against a shared time axis.
+//
+// By default the widget shows the whole history and follows new samples as
+// they are added.  The mouse wheel zooms the time axis around the pointer,
+// dragging pans it, and double-clicking goes back to showing everything.
+class plot_widget : public QWidget
+{
+  Q_OBJECT
+
+public:
+  plot_widget(QWidget * parent = NULL);
+
+  // Sets the history to draw.  The widget does not copy or own it, so it must
+  // stay valid while the widget exists.
+  void set_history(const plot_history * history);
+
+  // Sets how a trace is labeled and drawn.  These can be called before
+  // set_history().
+  void set_trace(size_t trace, const QString & name, const QString & unit,
+    const QColor & color);
+
+  void set_trace_visible(size_t trace, bool visible);
+
+  QSize sizeHint() const override;
+
+public slots:
+  void zoom_in();
+  void zoom_out();
+  void reset_zoom();
+
+protected:
+  void paintEvent(QPaintEvent *) override;
+  void wheelEvent(QWheelEvent *) override;
+  void mousePressEvent(QMouseEvent *) override;
+  void mouseMoveEvent(QMouseEvent *) override;
+  void mouseReleaseEvent(QMouseEvent *) override;
+  void mouseDoubleClickEvent(QMouseEvent *) override;
+
+private:
+  struct trace_info
+  {
+    QString name;
+    QString unit;
+    QColor color;
+    bool visible = true;
+  };
+
+  QRect plot_area() const;
+  void get_time_range(double & start, double & end) const;
+  void zoom_around(double time, double factor);
+  void draw_time_axis(QPainter &, const QRect & area, double start, double end);
+  void draw_lane(QPainter &, const QRect & lane, size_t trace,
+    double start, double end);
+
+  const plot_history * history = NULL;
+  std::vector<trace_info> traces;
+
+  // The length of time that is shown, or 0 to show the whole history.
+  double view_span = 0;
+
+  // The time at the right edge of the plot, unless view_follow is true, in
+  // which case the right edge is the latest sample.
+  double view_end = 0;
+  bool view_follow = true;
+
+  bool dragging = false;
+  int drag_start_x = 0;
+  double drag_start_view_end = 0;
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Passes the latest value of type T from one writer thread to one reader thread
+// without locks, using three buffers.  The writer fills the back buffer and
+// swaps it with the middle buffer; the reader swaps the middle buffer with the
+// front buffer when there is something new in it.  The reader can skip values
+// if the writer is faster, but it never sees a value that is partly written,
+// and neither thread ever waits for the other.
+template <class T>
+class snapshot_mailbox
+{
+public:
+  // Returns the buffer that the writer should fill.  Only call this from the
+  // writer thread.
+  T & back() { return buffers[back_index]; }
+
+  // Makes the back buffer available to the reader.  Only call this from the
+  // writer thread.
+  void publish()
+  {
+    uint8_t old_middle = middle.exchange(back_index | FRESH,
+      std::memory_order_acq_rel);
+    back_index = old_middle & INDEX_MASK;
+  }
+
+  // If the writer published something since the last call, makes it the
+  // front buffer and returns true.  Only call this from the reader thread.
+  bool take()
+  {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH)) { return false; }
+    uint8_t old_middle = middle.exchange(front_index,
+      std::memory_order_acq_rel);
+    front_index = old_middle & INDEX_MASK;
+    return true;
+  }
+
+  // Returns the value from the last successful call to take().  Only call this
+  // from the reader thread.
+  const T & front() const { return buffers[front_index]; }
+
+private:
+  static const uint8_t INDEX_MASK = 3;
+  static const uint8_t FRESH = 4;
+
+  T buffers[3];
+  uint8_t back_index = 0;
+  uint8_t front_index = 1;
+  std::atomic<uint8_t> middle{2};
+};
@@ -153,6 +153,14 @@ const char * tic_look_up_device_reset_name_ui(uint8_t device_reset);
 TIC_API
 const char * tic_look_up_operation_state_name_ui(uint8_t operation_state);
 
+/// Looks up a user-friendly string corresponding to the specified request
+/// code, e.g. "Set target position".  The request argument should be one of
+/// the TIC_CMD_* macros, but if it is not, this function returns
+/// "(Unknown)".  The returned string will be valid indefinitely and should not
+/// be freed.
+TIC_API
+const char * tic_look_up_command_name_ui(uint8_t request);
+
 /// Looks up a user-friendly string corresponding to the specified step mode,
 /// e.g. "Full step" or "1/2 step".  The step_mode argument should be one of the
 /// TIC_STEP_MODE_* macros, but if it is not, this functions returns
@@ -1287,6 +1295,53 @@ uint8_t tic_settings_get_hp_decmod(const tic_settings *);
 /// Variables command.
 typedef struct tic_variables tic_variables;
 
+// Bits used with tic_get_variables_fields() to select which variables to read
+// from the device.
+//
+// TIC_VARIABLES_FIELD_MISC_FLAGS covers the energized, position uncertain,
+// limit switch, and homing active flags.  TIC_VARIABLES_FIELD_PIN_INFO covers
+// the analog readings, digital readings, and pin states.
+// TIC_VARIABLES_FIELD_AGC covers all four AGC variables.
+#define TIC_VARIABLES_FIELD_OPERATION_STATE (UINT32_C(1) << 0)
+#define TIC_VARIABLES_FIELD_MISC_FLAGS (UINT32_C(1) << 1)
+#define TIC_VARIABLES_FIELD_ERROR_STATUS (UINT32_C(1) << 2)
+#define TIC_VARIABLES_FIELD_ERRORS_OCCURRED (UINT32_C(1) << 3)
+#define TIC_VARIABLES_FIELD_PLANNING_MODE (UINT32_C(1) << 4)
+#define TIC_VARIABLES_FIELD_TARGET_POSITION (UINT32_C(1) << 5)
+#define TIC_VARIABLES_FIELD_TARGET_VELOCITY (UINT32_C(1) << 6)
+#define TIC_VARIABLES_FIELD_STARTING_SPEED (UINT32_C(1) << 7)
+#define TIC_VARIABLES_FIELD_MAX_SPEED (UINT32_C(1) << 8)
+#define TIC_VARIABLES_FIELD_MAX_DECEL (UINT32_C(1) << 9)
+#define TIC_VARIABLES_FIELD_MAX_ACCEL (UINT32_C(1) << 10)
+#define TIC_VARIABLES_FIELD_CURRENT_POSITION (UINT32_C(1) << 11)
+#define TIC_VARIABLES_FIELD_CURRENT_VELOCITY (UINT32_C(1) << 12)
+#define TIC_VARIABLES_FIELD_ACTING_TARGET_POSITION (UINT32_C(1) << 13)
+#define TIC_VARIABLES_FIELD_TIME_SINCE_LAST_STEP (UINT32_C(1) << 14)
+#define TIC_VARIABLES_FIELD_DEVICE_RESET (UINT32_C(1) << 15)
+#define TIC_VARIABLES_FIELD_VIN_VOLTAGE (UINT32_C(1) << 16)
+#define TIC_VARIABLES_FIELD_UP_TIME (UINT32_C(1) << 17)
+#define TIC_VARIABLES_FIELD_ENCODER_POSITION (UINT32_C(1) << 18)
+#define TIC_VARIABLES_FIELD_RC_PULSE_WIDTH (UINT32_C(1) << 19)
+#define TIC_VARIABLES_FIELD_PIN_INFO (UINT32_C(1) << 20)
+#define TIC_VARIABLES_FIELD_STEP_MODE (UINT32_C(1) << 21)
+#define TIC_VARIABLES_FIELD_CURRENT_LIMIT (UINT32_C(1) << 22)
+#define TIC_VARIABLES_FIELD_DECAY_MODE (UINT32_C(1) << 23)
+#define TIC_VARIABLES_FIELD_INPUT_STATE (UINT32_C(1) << 24)
+#define TIC_VARIABLES_FIELD_INPUT_AFTER_AVERAGING (UINT32_C(1) << 25)
+#define TIC_VARIABLES_FIELD_INPUT_AFTER_HYSTERESIS (UINT32_C(1) << 26)
+#define TIC_VARIABLES_FIELD_INPUT_AFTER_SCALING (UINT32_C(1) << 27)
+#define TIC_VARIABLES_FIELD_LAST_MOTOR_DRIVER_ERROR (UINT32_C(1) << 28)
+#define TIC_VARIABLES_FIELD_AGC (UINT32_C(1) << 29)
+#define TIC_VARIABLES_FIELD_LAST_HP_DRIVER_ERRORS (UINT32_C(1) << 30)
+#define TIC_VARIABLES_FIELD_ALL (UINT32_C(0x7FFFFFFF))
+
+/// Creates a new tic_variables object with all fields set to zero.  This is
+/// only needed if you want to use tic_get_variables_into().  If this function
+/// is successful, the caller must free the variables later by calling
+/// tic_variables_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_variables_create(tic_variables ** variables);
+
 /// Copies a tic_variables object.  If this function is successful, the caller must
 /// free the settings later by calling tic_settings_free().
 TIC_API TIC_WARN_UNUSED
@@ -1663,11 +1718,39 @@ tic_error * tic_list_connected_devices(
   tic_device *** device_list,
   size_t * device_count);
 
+/// Finds the Tic with the specified serial number that is connected to the
+/// computer via USB.
+///
+/// This is faster than calling tic_list_connected_devices() and looking
+/// through the list, because it only does the slow work of getting a generic
+/// interface for the device it finds, and it stops looking once it finds it.
+///
+/// If no such device is connected, this function returns success and sets
+/// *device to NULL.  Otherwise, you must later free the device by calling
+/// tic_device_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_find_device_by_serial_number(const char * serial_number,
+  tic_device ** device);
+
 /// Frees a device list returned by ::tic_list_connected_devices.  It is OK to
 /// pass NULL to this function.
 TIC_API
 void tic_list_free(tic_device ** list);
 
+/// tic_list_connected_devices() keeps a cache of the devices it found, keyed
+/// by OS ID, and only does the slow work of getting a generic interface and
+/// serial number for devices that were not in the cache.  This function gets
+/// the number of devices that were found in the cache (@a hits) and the
+/// number that were not (@a misses) since the program started or the cache
+/// was cleared.  Either pointer can be NULL.
+TIC_API
+void tic_device_cache_get_stats(uint32_t * hits, uint32_t * misses);
+
+/// Empties the cache used by tic_list_connected_devices() and resets its
+/// statistics, so the next call will get fresh information about every device.
+TIC_API
+void tic_device_cache_clear(void);
+
 /// Makes a copy of a device object.  If this function is successful, you will
 /// need to free the copy by calling tic_device_free() at some point.
 TIC_API TIC_WARN_UNUSED
@@ -1718,6 +1801,81 @@ TIC_API TIC_WARN_UNUSED
 uint16_t tic_device_get_firmware_version(const tic_device *);
 
 
+// tic_device_monitor ///////////////////////////////////////////////////////////
+
+/// Keeps a list of the Tics connected to the computer over USB, so programs
+/// that need to know when devices are plugged in or unplugged do not have to
+/// call tic_list_connected_devices() over and over.  Scanning for devices looks
+/// at every USB device on the system and reads the serial number of every Tic,
+/// so it is slow and puts traffic on the bus.
+///
+/// On Linux, the monitor listens for USB hotplug events from the kernel and
+/// udev, and only scans after an event about a Pololu device.  On other
+/// systems, or if it cannot listen for hotplug events, it scans at most once
+/// per second.
+///
+/// A device monitor is not thread-safe.
+typedef struct tic_device_monitor tic_device_monitor;
+
+/// Creates a device monitor and scans for devices.
+///
+/// The monitor must later be freed with tic_device_monitor_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_device_monitor_create(tic_device_monitor ** monitor);
+
+/// Frees a device monitor.  It is OK to pass NULL to this function.
+TIC_API
+void tic_device_monitor_free(tic_device_monitor *);
+
+/// Processes hotplug events and scans for devices if needed.  This does not
+/// block, and if nothing happened it does no USB I/O, so it is fine to call it
+/// often, or whenever the file descriptor from tic_device_monitor_get_fd()
+/// becomes readable.  The optional @a changed parameter is set to true if a
+/// device was added or removed.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_device_monitor_update(tic_device_monitor *, bool * changed);
+
+/// Returns a file descriptor that becomes readable when there are hotplug
+/// events for tic_device_monitor_update() to process, or -1 if the monitor is
+/// not getting hotplug events.  Do not read from it or close it.
+TIC_API TIC_WARN_UNUSED
+int tic_device_monitor_get_fd(const tic_device_monitor *);
+
+/// Gets a copy of the list of connected devices as of the last scan.  The
+/// list is the same as one from tic_list_connected_devices() and must be freed
+/// the same way.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_device_monitor_get_devices(const tic_device_monitor *,
+  tic_device *** device_list, size_t * device_count);
+
+/// Gets the number of devices in the list as of the last scan.
+TIC_API TIC_WARN_UNUSED
+size_t tic_device_monitor_get_device_count(const tic_device_monitor *);
+
+/// Takes the oldest notification about a device being added or removed that
+/// has not been taken yet.  If there is none, sets *device to NULL.
+/// Otherwise, sets *device to a device object that you must free with
+/// tic_device_free(), and sets *added to true if the device was added or false
+/// if it was removed.  A removed device can not be opened, but its serial
+/// number and OS ID are still available.
+///
+/// The monitor keeps the last 64 notifications, so if you do not need them,
+/// you can ignore them.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_device_monitor_take_event(tic_device_monitor *,
+  tic_device ** device, bool * added);
+
+/// Gets the number of times the monitor scanned for devices.
+TIC_API TIC_WARN_UNUSED
+uint32_t tic_device_monitor_get_scan_count(const tic_device_monitor *);
+
+/// Gets the number of hotplug events about Pololu devices that the monitor
+/// has received.
+TIC_API TIC_WARN_UNUSED
+uint32_t tic_device_monitor_get_hotplug_event_count(
+  const tic_device_monitor *);
+
+
 // tic_handle ///////////////////////////////////////////////////////////////////
 
 /// Represents an open handle that can be used to read and write data from a
@@ -1733,6 +1891,56 @@ typedef struct tic_handle tic_handle;
 TIC_API TIC_WARN_UNUSED
 tic_error * tic_handle_open(const tic_device *, tic_handle **);
 
+/// Opens a handle to an emulated Tic that runs inside this process, for
+/// testing software without hardware.  The product argument should be one of
+/// the TIC_PRODUCT_* macros.  The handle must later be closed with
+/// tic_handle_close().
+///
+/// The emulated Tic answers the same requests as a real one.  It has its own
+/// settings, which start out as the defaults and are lost when the handle is
+/// closed, and it runs a basic acceleration-limited motion planner as time
+/// passes.  It only emulates serial control mode and does not have any
+/// inputs or limit switches.  Homing is done with a virtual limit switch at
+/// the position the motor had when the handle was opened.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_handle_open_emulated(uint8_t product, tic_handle **);
+
+// Flags for tic_handle_open_serial().  These should match the serial settings
+// of the Tic.
+
+// Use the compact protocol instead of the Pololu protocol.  The device number
+// is ignored.
+#define TIC_SERIAL_FLAG_COMPACT_PROTOCOL (1 << 0)
+
+// Send 14-bit device numbers in the Pololu protocol.
+#define TIC_SERIAL_FLAG_14BIT_DEVICE_NUMBER (1 << 1)
+
+// Add CRC7 bytes to commands.
+#define TIC_SERIAL_FLAG_CRC_FOR_COMMANDS (1 << 2)
+
+// Expect CRC7 bytes on responses.
+#define TIC_SERIAL_FLAG_CRC_FOR_RESPONSES (1 << 3)
+
+// Expect 7-bit responses.
+#define TIC_SERIAL_FLAG_7BIT_RESPONSES (1 << 4)
+
+/// Opens a handle to a Tic that is connected to a TTL serial port, such as
+/// "/dev/ttyS0".  The baud rate must be one of the standard rates from 1200 to
+/// 115200.  The product argument should be one of the TIC_PRODUCT_* macros,
+/// because there is no way to read it from the device.  The flags argument is
+/// a combination of the TIC_SERIAL_FLAG_* macros.  The handle must later be
+/// closed with tic_handle_close().
+///
+/// Most functions work the same way as they do over USB, but functions that
+/// change settings, like tic_set_settings() and tic_restore_defaults(), are
+/// not available.  The device object of the handle has an empty serial number,
+/// the port name as its OS ID, and a firmware version of 0 (unknown).
+///
+/// This function is not supported on Windows.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_handle_open_serial(const char * port_name, uint32_t baud_rate,
+  uint8_t product, uint16_t device_number, uint32_t flags, tic_handle **);
+
 /// Closes and frees the specified handle.  It is OK to pass NULL to this
 /// function.  Do not close the same non-NULL handle twice.
 TIC_API
@@ -1751,6 +1959,90 @@ const tic_device * tic_handle_get_device(const tic_handle *);
 TIC_API TIC_WARN_UNUSED
 const char * tic_get_firmware_version_string(tic_handle *);
 
+/// Statistics about the USB control transfers (or the equivalent serial
+/// commands) that a handle has sent, grouped by request code.  For Tic
+/// commands, the request code is the command code, one of the TIC_CMD_*
+/// macros.  Transfers that fail because of a timeout count as errors and also
+/// as timeouts.
+typedef struct tic_handle_stats tic_handle_stats;
+
+/// The number of buckets in the histogram from
+/// tic_handle_stats_get_latency_histogram().  The buckets are the same as the
+/// ones described for ::TIC_STREAMER_HISTOGRAM_SIZE.
+#define TIC_HANDLE_STATS_HISTOGRAM_SIZE 24
+
+/// Makes a copy of the handle's statistics.  The handle keeps counting while
+/// the copy stays the same, so this can be called from another thread while
+/// the handle is in use (for example, by a ::tic_monitor).
+///
+/// The statistics must later be freed with tic_handle_stats_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_handle_get_stats(const tic_handle *, tic_handle_stats **);
+
+/// Sets all of the handle's statistics back to zero, except for the time
+/// taken by the first transfer.
+TIC_API
+void tic_handle_reset_stats(tic_handle *);
+
+/// Copies statistics.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_handle_stats_copy(const tic_handle_stats * source,
+  tic_handle_stats ** dest);
+
+/// Frees statistics.  It is OK to pass NULL to this function.
+TIC_API
+void tic_handle_stats_free(tic_handle_stats *);
+
+/// Returns the number of transfers with the specified request code.
+TIC_API
+uint32_t tic_handle_stats_get_transfer_count(const tic_handle_stats *,
+  uint8_t request);
+
+/// Returns the number of bytes in the data stages of the transfers with the
+/// specified request code.
+TIC_API
+uint64_t tic_handle_stats_get_byte_count(const tic_handle_stats *,
+  uint8_t request);
+
+/// Returns the number of transfers with the specified request code that
+/// failed.
+TIC_API
+uint32_t tic_handle_stats_get_error_count(const tic_handle_stats *,
+  uint8_t request);
+
+/// Returns the number of transfers with the specified request code that
+/// failed because the device took too long to respond.
+TIC_API
+uint32_t tic_handle_stats_get_timeout_count(const tic_handle_stats *,
+  uint8_t request);
+
+/// Returns the total time taken by the transfers with the specified request
+/// code, in microseconds.
+TIC_API
+uint64_t tic_handle_stats_get_total_latency_us(const tic_handle_stats *,
+  uint8_t request);
+
+/// Returns the time taken by the slowest transfer with the specified request
+/// code, in microseconds.
+TIC_API
+uint32_t tic_handle_stats_get_max_latency_us(const tic_handle_stats *,
+  uint8_t request);
+
+/// Copies the histogram of the times taken by the transfers with the
+/// specified request code into counts, which must have room for
+/// ::TIC_HANDLE_STATS_HISTOGRAM_SIZE entries.
+TIC_API
+void tic_handle_stats_get_latency_histogram(const tic_handle_stats *,
+  uint8_t request, uint32_t * counts);
+
+/// Returns the time taken by the first transfer the handle sent, in
+/// microseconds, or 0 if it has not sent any.  This is often longer than the
+/// others because the operating system or device does some work when a
+/// handle is first used.
+TIC_API
+uint64_t tic_handle_stats_get_first_transfer_latency_us(
+  const tic_handle_stats *);
+
 /// Sets the target position of the Tic, in microsteps.
 ///
 /// This function sends a set target position to the Tic.  If the Control mode
@@ -2067,6 +2359,97 @@ TIC_API TIC_WARN_UNUSED
 tic_error * tic_get_variables(tic_handle *, tic_variables ** variables,
   bool clear_errors_occurred);
 
+/// Reads all of the Tic's status variables into an existing variables object.
+///
+/// This is like tic_get_variables(), but instead of allocating a new object
+/// every time, it overwrites the object you pass in, which you can create once
+/// with tic_variables_create().  This is useful if you are polling the Tic at
+/// a high rate.  If this function fails, the variables object is not modified.
+///
+/// If the device has been disconnected, this function returns an error with
+/// code ::TIC_ERROR_DEVICE_DISCONNECTED that was not allocated on the heap,
+/// so a polling loop can handle that case without allocating memory.  You
+/// should still pass the error to tic_error_free() as usual.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_get_variables_into(tic_handle *, tic_variables * variables,
+  bool clear_errors_occurred);
+
+/// Reads only some of the Tic's status variables into an existing variables
+/// object.
+///
+/// The fields argument is a bitmask of TIC_VARIABLES_FIELD_* macros that
+/// specifies which variables to read.  This function works out which bytes of
+/// the device's variables those fields occupy and reads them with as few Get
+/// Variables commands as possible, so for example reading the current
+/// position and velocity of a Tic 36v4 only takes one small transfer.  Fields
+/// that do not apply to the Tic you are connected to are ignored.
+///
+/// Variables that were not requested are left unchanged in the variables
+/// object.  If this function fails, the variables object is not modified.
+///
+/// If clear_errors_occurred is true, TIC_VARIABLES_FIELD_ERRORS_OCCURRED is
+/// read even if it was not requested, so that the bits being cleared are not
+/// lost.
+///
+/// Errors are reported the same way as tic_get_variables_into().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_get_variables_fields(tic_handle *, tic_variables * variables,
+  uint32_t fields, bool clear_errors_occurred);
+
+/// Waits until the Tic's current position equals its target position and the
+/// motor has stopped.  Call this after tic_set_target_position().
+///
+/// While waiting, this function only reads the few variables it needs, and it
+/// reads them less often when the motor is far from the target.
+/// It also sends a Reset Command Timeout command every half second so that
+/// the Tic's command timeout does not stop the motor while we are waiting.
+///
+/// Returns an error with code ::TIC_ERROR_TIMEOUT if the position is not
+/// reached within timeout_ms milliseconds.  Also returns an error if the Tic
+/// leaves normal operation (for example, because of a motor driver error) or
+/// stops moving to a target position, since then the position would never be
+/// reached.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_wait_for_position_reached(tic_handle *, uint32_t timeout_ms);
+
+/// Waits until the Tic finishes homing.  Call this after tic_go_home().
+/// Like tic_wait_for_position_reached(), this sends Reset Command Timeout
+/// commands while waiting.
+///
+/// Returns an error with code ::TIC_ERROR_TIMEOUT if homing does not finish
+/// within timeout_ms milliseconds.  Also returns an error if the Tic leaves
+/// normal operation or homing stops while the position is still uncertain.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_wait_for_homing_complete(tic_handle *, uint32_t timeout_ms);
+
+/// The shortest and longest times tic_wait_for_position_reached() waits
+/// between reads of the variables, in microseconds.
+#define TIC_WAIT_MIN_INTERVAL_US 2000
+#define TIC_WAIT_MAX_INTERVAL_US 100000
+
+/// How often tic_wait_for_homing_complete() reads the variables, in
+/// microseconds.  The Tic does not tell us how far away the limit switch is,
+/// so we cannot do anything smarter.
+#define TIC_WAIT_HOMING_INTERVAL_US 20000
+
+/// How often the wait functions send a Reset Command Timeout command, in
+/// microseconds.  This has to be shorter than the shortest useful command
+/// timeout.
+#define TIC_WAIT_KEEP_ALIVE_US 500000
+
+/// Returns how long tic_wait_for_position_reached() waits before reading the
+/// variables again, in microseconds, given the target position, current
+/// position, and current velocity it just read.  This is half of the time the
+/// motor would take to reach the target at its current speed, so the waits
+/// get shorter as the motor gets closer, limited to the range from
+/// ::TIC_WAIT_MIN_INTERVAL_US to ::TIC_WAIT_MAX_INTERVAL_US.
+///
+/// This is useful if you wait for a move some other way, for example by
+/// getting the variables from ticd.
+TIC_API TIC_WARN_UNUSED
+uint32_t tic_wait_get_position_interval_us(int32_t target_position,
+  int32_t current_position, int32_t current_velocity);
+
 /// Reads all of the Tic's non-volatile settings and returns them as an object.
 ///
 /// The settings parameter should be a non-null pointer to a tic_settings
@@ -2093,6 +2476,25 @@ tic_error * tic_get_settings(tic_handle *, tic_settings ** settings);
 TIC_API TIC_WARN_UNUSED
 tic_error * tic_set_settings(tic_handle *, const tic_settings *);
 
+/// Writes the Tic's non-volatile settings like tic_set_settings(), but only
+/// sends the bytes that are different from what is already stored on the
+/// device.
+///
+/// Each call reads the settings from the device to see what is there, so it
+/// is correct even if something else changed them since your last read.
+/// Applying a small change costs only a few USB transfers, and this also
+/// avoids wearing out the Tic's EEPROM by rewriting bytes that did not
+/// change.
+///
+/// If the bytes_written pointer is not NULL, this function stores the number of
+/// settings bytes that were actually written to it.
+///
+/// After calling this function, to make the settings actually take effect, you
+/// should call tic_reinitialize().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_set_settings_diff(tic_handle *, const tic_settings *,
+  size_t * bytes_written);
+
 /// Resets the Tic's settings to their factory default values.
 TIC_API TIC_WARN_UNUSED
 tic_error * tic_restore_defaults(tic_handle * handle);
@@ -2113,6 +2515,636 @@ tic_error * tic_get_debug_data(tic_handle *, uint8_t * data, size_t * size);
 /// \endcond
 
 
+// tic_monitor //////////////////////////////////////////////////////////////////
+
+/// Samples a Tic's variables at a fixed rate on a background thread and queues
+/// the samples for another thread to read.
+///
+/// While a monitor is running, it is the only thing that may use its handle.
+/// Stop the monitor with tic_monitor_stop() before using the handle for
+/// anything else, and before closing the handle.
+typedef struct tic_monitor tic_monitor;
+
+/// Creates a monitor for the specified handle, but does not start it.
+///
+/// The interval_us argument is the time between samples, in microseconds.
+/// The sampler keeps to a schedule based on its start time, so the time taken
+/// by each USB transfer does not cause the samples to drift.  If it falls
+/// more than a whole interval behind, it skips the samples it missed (see
+/// tic_monitor_get_missed_deadline_count()).
+///
+/// The capacity argument is the number of samples that can be queued.  If the
+/// queue is full when a sample is taken, the sample is discarded (see
+/// tic_monitor_get_dropped_count()).
+///
+/// The fields argument is a bitwise or of TIC_VARIABLES_FIELD_* values,
+/// which is passed to tic_get_variables_fields().  The up time is always read
+/// so that each sample has a timestamp from the device.
+///
+/// The monitor must later be freed with tic_monitor_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_monitor_create(tic_handle *, uint32_t interval_us,
+  size_t capacity, uint32_t fields, tic_monitor ** monitor);
+
+/// Stops and frees the specified monitor.  It is OK to pass NULL to this
+/// function.
+TIC_API
+void tic_monitor_free(tic_monitor *);
+
+/// Starts the monitor's sampling thread.
+///
+/// Returns an error if the thread is already running.  A monitor that was
+/// stopped, or whose thread stopped because of an error, can be started
+/// again.  Restarting it discards any samples that are still queued, frees
+/// the error from tic_monitor_get_error(), and resets the dropped and missed
+/// deadline counts.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_monitor_start(tic_monitor *);
+
+/// Stops the monitor's sampling thread and waits for it to finish.  Samples
+/// that were already queued can still be read.  It is OK to call this on a
+/// monitor that is not running.
+TIC_API
+void tic_monitor_stop(tic_monitor *);
+
+/// Removes the oldest queued sample and copies it into the specified variables
+/// object, which should have been created with tic_variables_create().  Fields
+/// that the monitor was not asked to read are left unspecified.
+///
+/// If host_time_us is not NULL, it receives the time the sample was taken
+/// according to the computer's monotonic clock, in microseconds.
+///
+/// Returns false if there were no samples queued.  This function does not
+/// block, and it must only be called from one thread at a time.
+TIC_API
+bool tic_monitor_read_sample(tic_monitor *, tic_variables * variables,
+  uint64_t * host_time_us);
+
+/// Removes up to capacity of the oldest queued samples and copies them into
+/// the specified array of variables objects, in the order they were taken.
+/// The number of samples copied is written to count, which is 0 if there
+/// were no samples queued.
+///
+/// This is cheaper than calling tic_monitor_read_sample() in a loop because
+/// it only synchronizes with the sampling thread once.  It does not return
+/// the host times; use the up time in each sample instead.  The same
+/// threading rules as tic_monitor_read_sample() apply.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_monitor_read_samples(tic_monitor *,
+  tic_variables * const * samples, size_t capacity, size_t * count);
+
+/// Returns the number of samples currently queued.
+TIC_API
+size_t tic_monitor_get_sample_count(const tic_monitor *);
+
+/// Returns true if the sampling thread is running.  The thread stops when
+/// tic_monitor_stop() is called or when there is an error communicating with
+/// the device.
+TIC_API
+bool tic_monitor_is_running(const tic_monitor *);
+
+/// If the sampling thread stopped because of an error, returns that error.
+/// Otherwise, returns NULL.  The error is owned by the monitor.
+TIC_API
+const tic_error * tic_monitor_get_error(const tic_monitor *);
+
+/// Returns the number of samples that were discarded because the queue was
+/// full.
+TIC_API
+uint32_t tic_monitor_get_dropped_count(const tic_monitor *);
+
+/// Returns the number of scheduled samples that were skipped because the
+/// sampling thread fell behind.
+TIC_API
+uint32_t tic_monitor_get_missed_deadline_count(const tic_monitor *);
+
+
+// tic_fleet ////////////////////////////////////////////////////////////////////
+
+/// Polls the variables of several Tics in parallel using a pool of worker
+/// threads.  Each call to tic_fleet_poll() is one cycle, and at the end of
+/// each cycle the fleet publishes a snapshot containing the latest variables,
+/// status, and latency of every device.
+///
+/// While a fleet exists, it is the only thing that may use its handles.
+/// Free the fleet with tic_fleet_free() before using the handles for
+/// anything else, and before closing them.
+typedef struct tic_fleet tic_fleet;
+
+// Statuses returned by tic_fleet_get_status().
+
+// No read from the device has finished yet.
+#define TIC_FLEET_STATUS_NO_DATA 0
+
+// The device was read successfully during the last cycle.
+#define TIC_FLEET_STATUS_OK 1
+
+// A read from the device did not finish before the end of the last cycle.
+// The variables in the snapshot are from an earlier cycle.  The device will
+// not be read again until the read that is in progress finishes, which could
+// take as long as the USB control transfer timeout (1600 ms).
+#define TIC_FLEET_STATUS_STALLED 2
+
+// The last read from the device failed.  See tic_fleet_get_error().
+#define TIC_FLEET_STATUS_ERROR 3
+
+/// Creates a fleet for the specified handles and starts its worker threads.
+///
+/// The worker_count argument is the number of worker threads to use.  If it
+/// is zero or larger than handle_count, one worker is used for each handle.
+/// A stalled device ties up one worker, so to keep stalled devices from
+/// delaying the others you should have more workers than devices you expect
+/// to stall at the same time.
+///
+/// The fields argument is a bitwise or of TIC_VARIABLES_FIELD_* values,
+/// which is passed to tic_get_variables_fields().
+///
+/// The fleet must later be freed with tic_fleet_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_fleet_create(tic_handle * const * handles, size_t handle_count,
+  size_t worker_count, uint32_t fields, tic_fleet ** fleet);
+
+/// Stops the worker threads and frees the fleet.  If a device is stalled,
+/// this waits for its read to time out.  It is OK to pass NULL to this
+/// function.
+TIC_API
+void tic_fleet_free(tic_fleet *);
+
+/// Runs one polling cycle.  This starts a read from every device that is not
+/// already busy with a read from an earlier cycle, waits until all of the
+/// reads finish or timeout_ms milliseconds pass, and then publishes a new
+/// snapshot.
+///
+/// Errors communicating with individual devices do not cause this function
+/// to fail; they are reported by tic_fleet_get_status() and
+/// tic_fleet_get_error().
+///
+/// This function and the tic_fleet_get_* functions must only be called from
+/// one thread at a time.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_fleet_poll(tic_fleet *, uint32_t timeout_ms);
+
+/// Returns the number of devices in the fleet.
+TIC_API
+size_t tic_fleet_get_device_count(const tic_fleet *);
+
+/// Returns the number of times tic_fleet_poll() has succeeded.
+TIC_API
+uint32_t tic_fleet_get_cycle_count(const tic_fleet *);
+
+/// Returns the time the last call to tic_fleet_poll() took, in microseconds.
+TIC_API
+uint32_t tic_fleet_get_cycle_time_us(const tic_fleet *);
+
+/// Returns the status of the specified device in the latest snapshot.  This
+/// is one of the TIC_FLEET_STATUS_* macros.
+TIC_API
+uint8_t tic_fleet_get_status(const tic_fleet *, size_t index);
+
+/// Returns the variables of the specified device in the latest snapshot.
+/// Only the fields selected when the fleet was created are valid.  The
+/// returned object is owned by the fleet and is valid until the next call to
+/// tic_fleet_poll().
+TIC_API
+const tic_variables * tic_fleet_get_variables(const tic_fleet *, size_t index);
+
+/// Returns the error from the last read of the specified device, or NULL if
+/// it succeeded.  The returned error is owned by the fleet and is valid until
+/// the next call to tic_fleet_poll().
+TIC_API
+const tic_error * tic_fleet_get_error(const tic_fleet *, size_t index);
+
+/// Returns the time the last finished read of the specified device took, in
+/// microseconds.
+TIC_API
+uint32_t tic_fleet_get_latency_us(const tic_fleet *, size_t index);
+
+/// Returns the time when the last finished read of the specified device
+/// completed, in microseconds, from the same monotonic clock used by
+/// tic_monitor_read_sample().
+TIC_API
+uint64_t tic_fleet_get_sample_time_us(const tic_fleet *, size_t index);
+
+
+// tic_sync_move ////////////////////////////////////////////////////////////////
+
+/// Moves several Tics (axes) to new target positions so that they all arrive
+/// at the same time, for example to move an XY stage in a straight line.
+///
+/// Each call to tic_sync_move_start() reads the current position and limits
+/// of every axis, picks a speed profile that all the axes can follow, and
+/// sets the starting speed, max speed, max acceleration, and max deceleration
+/// of each axis to that profile scaled by the distance the axis has to move.
+/// Then it sends the Set Target Position commands to all the axes at once
+/// from one thread per axis, and measures how closely the axes started.
+///
+/// The limits of each axis are read during the first call to
+/// tic_sync_move_start() and used to plan every move after that, since the
+/// limits that the Tic reports afterwards are the ones set for the move.  The
+/// limits stay set after the moves, like other temporary settings; use
+/// tic_reinitialize() to go back to the limits in the Tic's settings.
+///
+/// While tic_sync_move_start() runs, it is the only thing that may use the
+/// handles.
+typedef struct tic_sync_move tic_sync_move;
+
+/// Creates a sync move for the specified handles.  The handles must stay
+/// open until the sync move is freed.
+///
+/// The sync move must later be freed with tic_sync_move_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_sync_move_create(tic_handle * const * handles,
+  size_t handle_count, tic_sync_move ** move);
+
+/// Frees the specified sync move.  It is OK to pass NULL to this function.
+TIC_API
+void tic_sync_move_free(tic_sync_move *);
+
+/// Starts a move.  targets is a list of target positions, one for each
+/// handle, and target_count is the number of targets in it.  Axes that are
+/// already at their targets are left alone.  Every axis must be stopped (its
+/// current velocity must be 0).
+///
+/// This returns after all the axes have started moving; use
+/// tic_wait_for_position_reached() to wait for them to arrive.
+///
+/// The Tic cannot accelerate more slowly than ::TIC_MIN_ALLOWED_ACCEL, so an
+/// axis whose move is much shorter than another axis's might not be able to
+/// follow the scaled profile.  With an acceleration limit of 40000, for
+/// example, that happens when one move is more than 400 times as long as
+/// another.  In that case this function returns an error that names the
+/// axis instead of letting it arrive early, and nothing moves.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_sync_move_start(tic_sync_move *, const int32_t * targets,
+  size_t target_count);
+
+/// Returns the number of axes.
+TIC_API
+size_t tic_sync_move_get_axis_count(const tic_sync_move *);
+
+/// Returns how long the last move should take, in microseconds.
+TIC_API
+uint32_t tic_sync_move_get_duration_us(const tic_sync_move *);
+
+/// Returns the max speed used for the specified axis in the last move, or 0
+/// if it did not move.
+TIC_API
+uint32_t tic_sync_move_get_max_speed(const tic_sync_move *, size_t index);
+
+/// Returns the max acceleration and deceleration used for the specified axis
+/// in the last move, or 0 if it did not move.
+TIC_API
+uint32_t tic_sync_move_get_max_accel(const tic_sync_move *, size_t index);
+
+/// Returns the starting speed used for the specified axis in the last move.
+TIC_API
+uint32_t tic_sync_move_get_starting_speed(const tic_sync_move *, size_t index);
+
+/// Returns the time between when the first and last Set Target Position
+/// commands of the last move finished, in microseconds.
+TIC_API
+uint32_t tic_sync_move_get_send_skew_us(const tic_sync_move *);
+
+/// Returns the time between when the first and last axes started moving in
+/// the last move, in microseconds.
+///
+/// The Tic's up time only has a resolution of 1 ms, so this is measured
+/// instead by reading the velocity of each axis right after sending its
+/// target: the speed it has gained divided by its acceleration tells us how
+/// long ago it started.  This works as long as the axes are still speeding
+/// up when they are read, which is true except for very short moves.
+TIC_API
+uint32_t tic_sync_move_get_start_skew_us(const tic_sync_move *);
+
+/// Returns how long after the first axis the specified axis started moving
+/// in the last move, in microseconds.
+TIC_API
+uint32_t tic_sync_move_get_start_offset_us(const tic_sync_move *,
+  size_t index);
+
+
+// tic_estimator ////////////////////////////////////////////////////////////////
+
+/// Predicts the Tic's position and velocity between reads of its variables.
+///
+/// Each time you read the variables, pass them to tic_estimator_update()
+/// along with the time they were read.  Then tic_estimator_predict() can tell
+/// you where the motor probably is at any later time, by running a model of
+/// the Tic's motion planner forward from the last snapshot using its target,
+/// speed limits, and acceleration limits.  This lets you read the variables
+/// much less often and still have a good idea of the position.
+///
+/// The model assumes that nothing changes the Tic's targets or limits between
+/// snapshots, and it cannot predict when homing will reach the limit switch or
+/// exactly how a soft error will be handled.  The prediction error, which
+/// is measured each time you call tic_estimator_update(), tells you how well
+/// it is working.
+///
+/// The model runs in 1 ms ticks.  For moves from a snapshot to a target, its
+/// predictions stay within about one microstep of an ideal trapezoidal or
+/// triangular speed profile with the same limits.  It has not been checked
+/// against the firmware of a real Tic, whose planner works in whole
+/// microsteps and can differ from the ideal profile, so measure the
+/// prediction error on your own hardware before relying on it.
+///
+/// Times are in microseconds from the same monotonic clock as
+/// tic_get_time_us().  An estimator is not thread-safe.
+typedef struct tic_estimator tic_estimator;
+
+/// The variables that the estimator needs.  Pass this to
+/// tic_get_variables_fields() to read only those variables.
+#define TIC_ESTIMATOR_FIELDS (TIC_VARIABLES_FIELD_OPERATION_STATE | \
+  TIC_VARIABLES_FIELD_MISC_FLAGS | TIC_VARIABLES_FIELD_PLANNING_MODE | \
+  TIC_VARIABLES_FIELD_TARGET_POSITION | TIC_VARIABLES_FIELD_TARGET_VELOCITY | \
+  TIC_VARIABLES_FIELD_STARTING_SPEED | TIC_VARIABLES_FIELD_MAX_SPEED | \
+  TIC_VARIABLES_FIELD_MAX_DECEL | TIC_VARIABLES_FIELD_MAX_ACCEL | \
+  TIC_VARIABLES_FIELD_CURRENT_POSITION | TIC_VARIABLES_FIELD_CURRENT_VELOCITY)
+
+/// Returns the current time from the monotonic clock used by the estimator,
+/// tic_monitor_read_sample(), and tic_fleet_get_sample_time_us(), in
+/// microseconds.
+TIC_API TIC_WARN_UNUSED
+uint64_t tic_get_time_us(void);
+
+/// Creates an estimator with no snapshot.
+///
+/// The estimator must later be freed with tic_estimator_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_estimator_create(tic_estimator ** estimator);
+
+/// Frees the specified estimator.  It is OK to pass NULL to this function.
+TIC_API
+void tic_estimator_free(tic_estimator *);
+
+/// Gives the estimator a new snapshot of the variables, which should include
+/// the ones in ::TIC_ESTIMATOR_FIELDS.  host_time_us is the time when the
+/// variables were read; if you only know when the read started and ended, the
+/// middle is a good choice.
+///
+/// If there was an earlier snapshot, this first predicts the position at
+/// host_time_us from it and records how far off the prediction was (see
+/// tic_estimator_get_last_error()).
+TIC_API
+void tic_estimator_update(tic_estimator *, const tic_variables * variables,
+  uint64_t host_time_us);
+
+/// Predicts the position (in microsteps) and velocity (in microsteps per
+/// 10000 seconds, like tic_variables_get_current_velocity()) at the specified
+/// time.  Times before the last snapshot give the values from the snapshot.
+/// Either output pointer can be NULL.
+///
+/// Returns false, and predicts 0, if there is no snapshot yet.
+TIC_API
+bool tic_estimator_predict(const tic_estimator *, uint64_t host_time_us,
+  double * position, double * velocity);
+
+/// Gets the number of predictions that have been checked against a new
+/// snapshot.
+TIC_API TIC_WARN_UNUSED
+uint32_t tic_estimator_get_update_count(const tic_estimator *);
+
+/// Gets how far off the last checked prediction was, in microsteps: the actual
+/// position minus the predicted position.
+TIC_API TIC_WARN_UNUSED
+double tic_estimator_get_last_error(const tic_estimator *);
+
+/// Gets the largest absolute prediction error so far, in microsteps.
+TIC_API TIC_WARN_UNUSED
+double tic_estimator_get_max_error(const tic_estimator *);
+
+/// Resets the update count and the prediction errors to 0.
+TIC_API
+void tic_estimator_clear_stats(tic_estimator *);
+
+
+// tic_streamer /////////////////////////////////////////////////////////////////
+
+/// Sends a timed sequence of target positions and target velocities to a Tic
+/// from a background thread, with each one sent as close as possible to its
+/// scheduled time.
+///
+/// While a streamer is running, it is the only thing that may use its handle.
+/// Wait for it with tic_streamer_wait() or stop it with tic_streamer_stop()
+/// before using the handle for anything else, and before closing the handle.
+typedef struct tic_streamer tic_streamer;
+
+// Commands used with tic_streamer_add_point().
+#define TIC_STREAM_TARGET_POSITION 1
+#define TIC_STREAM_TARGET_VELOCITY 2
+
+/// The number of buckets in the histograms from
+/// tic_streamer_get_jitter_histogram() and
+/// tic_streamer_get_latency_histogram().  Bucket 0 counts times less than
+/// 1 us, bucket i counts times from 2^(i-1) us up to 2^i us, and the last
+/// bucket also counts all longer times.
+#define TIC_STREAMER_HISTOGRAM_SIZE 24
+
+/// Creates a streamer with no points for the specified handle.
+///
+/// If the streaming thread falls behind, it handles late points in two
+/// ways.  If the next point is also due and is the same kind of command, the
+/// late point is skipped, since the next one would replace it right away
+/// (see tic_streamer_get_merged_count()).  Otherwise, if max_lateness_us is
+/// not 0 and the point is more than that late, it is dropped (see
+/// tic_streamer_get_dropped_count()).  The last point is never dropped.
+///
+/// The streamer must later be freed with tic_streamer_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_streamer_create(tic_handle *, uint32_t max_lateness_us,
+  tic_streamer ** streamer);
+
+/// Stops and frees the specified streamer.  It is OK to pass NULL to this
+/// function.
+TIC_API
+void tic_streamer_free(tic_streamer *);
+
+/// Adds a point to the end of the sequence.  time_us is when to send it, in
+/// microseconds after the streamer starts, and must not be earlier than the
+/// time of the previous point.  command is ::TIC_STREAM_TARGET_POSITION or
+/// ::TIC_STREAM_TARGET_VELOCITY, and value is the target in the units used by
+/// tic_set_target_position() or tic_set_target_velocity().
+///
+/// Points can only be added before the streamer is started.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_streamer_add_point(tic_streamer *, uint64_t time_us,
+  uint8_t command, int32_t value);
+
+/// Returns the number of points in the sequence.
+TIC_API
+size_t tic_streamer_get_point_count(const tic_streamer *);
+
+/// Starts the streaming thread.  Time 0 of the sequence is now.  A streamer
+/// can only be started once, even after it finishes or is stopped, so that
+/// its statistics and error always describe a single run; create a new
+/// streamer to send the sequence again.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_streamer_start(tic_streamer *);
+
+/// Waits for the streaming thread to finish the sequence.  It is OK to call
+/// this on a streamer that is not running.
+TIC_API
+void tic_streamer_wait(tic_streamer *);
+
+/// Stops the streaming thread without sending the rest of the sequence and
+/// waits for it to finish.  It is OK to call this on a streamer that is not
+/// running.
+TIC_API
+void tic_streamer_stop(tic_streamer *);
+
+/// Returns true if the streaming thread is running.  The thread stops when it
+/// finishes the sequence, when tic_streamer_stop() is called, or when there is
+/// an error communicating with the device.
+TIC_API
+bool tic_streamer_is_running(const tic_streamer *);
+
+/// If the streaming thread stopped because of an error, returns that error.
+/// Otherwise, returns NULL.  The error is owned by the streamer.
+TIC_API
+const tic_error * tic_streamer_get_error(const tic_streamer *);
+
+/// Returns the number of points that were sent.
+TIC_API
+uint32_t tic_streamer_get_sent_count(const tic_streamer *);
+
+/// Returns the number of late points that were skipped because the next point
+/// replaced them.
+TIC_API
+uint32_t tic_streamer_get_merged_count(const tic_streamer *);
+
+/// Returns the number of points that were dropped for being too late.
+TIC_API
+uint32_t tic_streamer_get_dropped_count(const tic_streamer *);
+
+/// Returns the largest jitter of a sent point: the time between when it was
+/// scheduled and when we started sending it, in microseconds.
+TIC_API
+uint32_t tic_streamer_get_max_jitter_us(const tic_streamer *);
+
+/// Returns the largest latency of a sent point: the time that sending it
+/// took, in microseconds.
+TIC_API
+uint32_t tic_streamer_get_max_latency_us(const tic_streamer *);
+
+/// Copies the histogram of the jitter of sent points into counts, which must
+/// have room for ::TIC_STREAMER_HISTOGRAM_SIZE entries.
+TIC_API
+void tic_streamer_get_jitter_histogram(const tic_streamer *, uint32_t * counts);
+
+/// Copies the histogram of the latency of sent points into counts, which must
+/// have room for ::TIC_STREAMER_HISTOGRAM_SIZE entries.
+TIC_API
+void tic_streamer_get_latency_histogram(const tic_streamer *,
+  uint32_t * counts);
+
+
+// tic_serial_bus ///////////////////////////////////////////////////////////////
+
+/// Talks to several Tics that share one TTL serial line, where the bandwidth
+/// of the line is usually the bottleneck.  Commands for any of the devices are
+/// queued with tic_serial_bus_queue_command() and sent back to back in a single
+/// write by tic_serial_bus_flush().  Each command uses the shortest framing
+/// that its device accepts: the compact protocol when there is only one device
+/// on the bus, 14-bit device numbers and CRC bytes only for devices that
+/// require them.
+///
+/// tic_serial_bus_get_variables() reads variables from every device and
+/// pipelines the reads: the request for the next read is sent while the
+/// response to the current one is still arriving, timed so that the next
+/// response, which starts after the device's serial response delay, does not
+/// collide with the current one.
+///
+/// A bus is not thread-safe.  It is not supported on Windows.
+typedef struct tic_serial_bus tic_serial_bus;
+
+/// Opens a serial port for a bus.  The port name and baud rate are the same
+/// as for tic_handle_open_serial().  The bus must later be freed with
+/// tic_serial_bus_free().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_serial_bus_create(const char * port_name, uint32_t baud_rate,
+  tic_serial_bus ** bus);
+
+/// Closes the serial port and frees the bus.  It is OK to pass NULL to this
+/// function.
+TIC_API
+void tic_serial_bus_free(tic_serial_bus *);
+
+/// Adds a device to the bus.  The settings should be the settings of the
+/// device, from tic_get_settings() for example.  They determine its product,
+/// its device number, and its serial format: 14-bit device numbers, CRC for
+/// commands and responses, 7-bit responses, and the response delay.  If
+/// use_alt_device_number is true, the device is addressed using its
+/// alternative device number, which must be enabled in the settings.
+///
+/// The baud rate in the settings must match the baud rate of the bus, and
+/// the device number must not already be used by another device on the bus.
+/// Devices are numbered in the order they were added, starting at 0.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_serial_bus_add_device(tic_serial_bus *,
+  const tic_settings * settings, bool use_alt_device_number);
+
+/// Returns the number of devices on the bus.
+TIC_API
+size_t tic_serial_bus_get_device_count(const tic_serial_bus *);
+
+/// Queues a command for the specified device.  The command is one of the
+/// TIC_CMD_* macros that is available over serial, like
+/// TIC_CMD_SET_TARGET_POSITION, and value is its argument, which is ignored
+/// for commands that do not take one.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_serial_bus_queue_command(tic_serial_bus *, size_t index,
+  uint8_t command, int32_t value);
+
+/// Sends all of the queued commands in one write and empties the queue.
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_serial_bus_flush(tic_serial_bus *);
+
+/// Flushes any queued commands, then reads the specified fields of the
+/// variables of every device on the bus.  variables must point to an array
+/// with one variables object for each device; see tic_variables_create().
+/// The fields argument works like it does for tic_get_variables_fields().
+TIC_API TIC_WARN_UNUSED
+tic_error * tic_serial_bus_get_variables(tic_serial_bus *,
+  tic_variables * const * variables, uint32_t fields,
+  bool clear_errors_occurred);
+
+/// Returns the number of serial commands sent on the bus, including the
+/// commands that request data, since it was created or the statistics were
+/// reset.
+TIC_API
+uint64_t tic_serial_bus_get_command_count(const tic_serial_bus *);
+
+/// Returns the number of bytes sent on the bus.
+TIC_API
+uint64_t tic_serial_bus_get_bytes_sent(const tic_serial_bus *);
+
+/// Returns the number of bytes received on the bus.
+TIC_API
+uint64_t tic_serial_bus_get_bytes_received(const tic_serial_bus *);
+
+/// Returns the time spent in tic_serial_bus_flush() and
+/// tic_serial_bus_get_variables(), in microseconds.
+TIC_API
+uint64_t tic_serial_bus_get_busy_time_us(const tic_serial_bus *);
+
+/// Returns the number of commands per second that the bus achieved while it
+/// was busy.
+TIC_API
+uint32_t tic_serial_bus_get_commands_per_second(const tic_serial_bus *);
+
+/// Returns the number of commands per second that would be possible if the
+/// line were never idle, given the average size of the commands and responses
+/// sent so far and the actual baud rate of the devices, which can differ
+/// slightly from the requested baud rate (see
+/// tic_settings_get_serial_baud_rate()).  Each byte takes 10 bits.
+TIC_API
+uint32_t tic_serial_bus_get_theoretical_commands_per_second(
+  const tic_serial_bus *);
+
+/// Resets the statistics of the bus to zero.
+TIC_API
+void tic_serial_bus_reset_stats(tic_serial_bus *);
+
+
 //// Current limits
 
 /// Gets the maximum allowed current limit setting for the specified Tic
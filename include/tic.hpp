@@ -70,6 +70,20 @@ namespace tic
     return copy;
   }
 
+  /// Wrapper for tic_handle_stats_free().
+  inline void pointer_free(tic_handle_stats * p) noexcept
+  {
+    tic_handle_stats_free(p);
+  }
+
+  /// Wrapper for tic_handle_stats_copy().
+  inline tic_handle_stats * pointer_copy(const tic_handle_stats * p)
+  {
+    tic_handle_stats * copy;
+    throw_if_needed(tic_handle_stats_copy(p, &copy));
+    return copy;
+  }
+
   /// Wrapper for tic_device_free().
   inline void pointer_free(tic_device * p) noexcept
   {
@@ -84,12 +98,54 @@ namespace tic
     return copy;
   }
 
+  /// Wrapper for tic_device_monitor_free().
+  inline void pointer_free(tic_device_monitor * p) noexcept
+  {
+    tic_device_monitor_free(p);
+  }
+
   /// Wrapper for tic_handle_close().
   inline void pointer_free(tic_handle * p) noexcept
   {
     tic_handle_close(p);
   }
 
+  /// Wrapper for tic_monitor_free().
+  inline void pointer_free(tic_monitor * p) noexcept
+  {
+    tic_monitor_free(p);
+  }
+
+  /// Wrapper for tic_fleet_free().
+  inline void pointer_free(tic_fleet * p) noexcept
+  {
+    tic_fleet_free(p);
+  }
+
+  /// Wrapper for tic_sync_move_free().
+  inline void pointer_free(tic_sync_move * p) noexcept
+  {
+    tic_sync_move_free(p);
+  }
+
+  /// Wrapper for tic_estimator_free().
+  inline void pointer_free(tic_estimator * p) noexcept
+  {
+    tic_estimator_free(p);
+  }
+
+  /// Wrapper for tic_streamer_free().
+  inline void pointer_free(tic_streamer * p) noexcept
+  {
+    tic_streamer_free(p);
+  }
+
+  /// Wrapper for tic_serial_bus_free().
+  inline void pointer_free(tic_serial_bus * p) noexcept
+  {
+    tic_serial_bus_free(p);
+  }
+
   /// This class is not part of the public API of the library and you should
   /// not use it directly, but you can use the public methods it provides to
   /// the classes that inherit from it.
@@ -327,6 +383,8 @@ namespace tic
     }
   };
 
+  class handle;
+
   /// Represents the variables read from a Tic.  This object just stores plain
   /// old data; it does not have any pointer or handles for other resources.
   class variables : public unique_pointer_wrapper_with_copy<tic_variables>
@@ -338,6 +396,26 @@ namespace tic
     {
     }
 
+    /// Wrapper for tic_variables_create().
+    static variables create()
+    {
+      tic_variables * p;
+      throw_if_needed(tic_variables_create(&p));
+      return variables(p);
+    }
+
+    /// Reads the variables from the device into this object using
+    /// tic_get_variables_into(), so no memory is allocated after the first
+    /// call.  If this object is null, a new variables object is created first.
+    inline void refresh(handle & handle, bool clear_errors_occurred = false);
+
+    /// Reads some of the variables from the device into this object using
+    /// tic_get_variables_fields().  The fields argument is a bitmask of
+    /// TIC_VARIABLES_FIELD_* macros.  If this object is null, a new variables
+    /// object is created first.
+    inline void refresh_fields(handle & handle, uint32_t fields,
+      bool clear_errors_occurred = false);
+
     /// Wrapper for tic_variables_get_operation_state().
     uint8_t get_operation_state() const noexcept
     {
@@ -663,6 +741,180 @@ namespace tic
     return vector;
   }
 
+  /// Wrapper for tic_find_device_by_serial_number().  Returns a null device
+  /// if no device with that serial number is connected.
+  inline tic::device find_device_by_serial_number(
+    const std::string & serial_number)
+  {
+    tic_device * p;
+    throw_if_needed(tic_find_device_by_serial_number(
+        serial_number.c_str(), &p));
+    return device(p);
+  }
+
+  /// Wrapper for tic_device_cache_get_stats().
+  inline void device_cache_get_stats(uint32_t & hits, uint32_t & misses) noexcept
+  {
+    tic_device_cache_get_stats(&hits, &misses);
+  }
+
+  /// Wrapper for tic_device_cache_clear().
+  inline void device_cache_clear() noexcept
+  {
+    tic_device_cache_clear();
+  }
+
+  /// Wrapper for tic_wait_get_position_interval_us().
+  inline uint32_t wait_get_position_interval_us(int32_t target_position,
+    int32_t current_position, int32_t current_velocity) noexcept
+  {
+    return tic_wait_get_position_interval_us(target_position,
+      current_position, current_velocity);
+  }
+
+  /// Keeps a list of the connected Tics up to date using hotplug events.  See
+  /// tic_device_monitor_create() for details.
+  class device_monitor : public unique_pointer_wrapper<tic_device_monitor>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.  This object will free
+    /// the pointer when it is destroyed.
+    explicit device_monitor(tic_device_monitor * p = NULL) noexcept
+      : unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for tic_device_monitor_create().
+    static device_monitor create()
+    {
+      tic_device_monitor * p;
+      throw_if_needed(tic_device_monitor_create(&p));
+      return device_monitor(p);
+    }
+
+    /// Wrapper for tic_device_monitor_update().  Returns true if a device was
+    /// added or removed.
+    bool update()
+    {
+      bool changed;
+      throw_if_needed(tic_device_monitor_update(pointer, &changed));
+      return changed;
+    }
+
+    /// Wrapper for tic_device_monitor_get_fd().
+    int get_fd() const noexcept
+    {
+      return tic_device_monitor_get_fd(pointer);
+    }
+
+    /// Wrapper for tic_device_monitor_get_devices().
+    std::vector<tic::device> get_devices() const
+    {
+      tic_device ** device_list;
+      size_t size;
+      throw_if_needed(tic_device_monitor_get_devices(pointer,
+          &device_list, &size));
+      std::vector<device> vector;
+      for (size_t i = 0; i < size; i++)
+      {
+        vector.push_back(device(device_list[i]));
+      }
+      tic_list_free(device_list);
+      return vector;
+    }
+
+    /// Wrapper for tic_device_monitor_get_device_count().
+    size_t get_device_count() const noexcept
+    {
+      return tic_device_monitor_get_device_count(pointer);
+    }
+
+    /// Wrapper for tic_device_monitor_take_event().  Returns false if there
+    /// was no event to take.
+    bool take_event(tic::device & device, bool & added)
+    {
+      tic_device * p;
+      throw_if_needed(tic_device_monitor_take_event(pointer, &p, &added));
+      if (p == NULL) { return false; }
+      device = tic::device(p);
+      return true;
+    }
+
+    /// Wrapper for tic_device_monitor_get_scan_count().
+    uint32_t get_scan_count() const noexcept
+    {
+      return tic_device_monitor_get_scan_count(pointer);
+    }
+
+    /// Wrapper for tic_device_monitor_get_hotplug_event_count().
+    uint32_t get_hotplug_event_count() const noexcept
+    {
+      return tic_device_monitor_get_hotplug_event_count(pointer);
+    }
+  };
+
+  /// Statistics about the transfers a handle has sent.  See
+  /// ::tic_handle_stats for details.
+  class handle_stats : public unique_pointer_wrapper_with_copy<tic_handle_stats>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.
+    explicit handle_stats(tic_handle_stats * p = NULL) noexcept :
+      unique_pointer_wrapper_with_copy(p)
+    {
+    }
+
+    /// Wrapper for tic_handle_stats_get_transfer_count().
+    uint32_t get_transfer_count(uint8_t request) const noexcept
+    {
+      return tic_handle_stats_get_transfer_count(pointer, request);
+    }
+
+    /// Wrapper for tic_handle_stats_get_byte_count().
+    uint64_t get_byte_count(uint8_t request) const noexcept
+    {
+      return tic_handle_stats_get_byte_count(pointer, request);
+    }
+
+    /// Wrapper for tic_handle_stats_get_error_count().
+    uint32_t get_error_count(uint8_t request) const noexcept
+    {
+      return tic_handle_stats_get_error_count(pointer, request);
+    }
+
+    /// Wrapper for tic_handle_stats_get_timeout_count().
+    uint32_t get_timeout_count(uint8_t request) const noexcept
+    {
+      return tic_handle_stats_get_timeout_count(pointer, request);
+    }
+
+    /// Wrapper for tic_handle_stats_get_total_latency_us().
+    uint64_t get_total_latency_us(uint8_t request) const noexcept
+    {
+      return tic_handle_stats_get_total_latency_us(pointer, request);
+    }
+
+    /// Wrapper for tic_handle_stats_get_max_latency_us().
+    uint32_t get_max_latency_us(uint8_t request) const noexcept
+    {
+      return tic_handle_stats_get_max_latency_us(pointer, request);
+    }
+
+    /// Wrapper for tic_handle_stats_get_latency_histogram().
+    std::vector<uint32_t> get_latency_histogram(uint8_t request) const
+    {
+      std::vector<uint32_t> counts(TIC_HANDLE_STATS_HISTOGRAM_SIZE);
+      tic_handle_stats_get_latency_histogram(pointer, request, counts.data());
+      return counts;
+    }
+
+    /// Wrapper for tic_handle_stats_get_first_transfer_latency_us().
+    uint64_t get_first_transfer_latency_us() const noexcept
+    {
+      return tic_handle_stats_get_first_transfer_latency_us(pointer);
+    }
+  };
+
   /// Represents an open handle that can be used to read and write data from a
   /// device.  Can also be in a null state where it does not represent a device.
   class handle : public unique_pointer_wrapper<tic_handle>
@@ -681,6 +933,25 @@ namespace tic
       throw_if_needed(tic_handle_open(device.get_pointer(), &pointer));
     }
 
+    /// Wrapper for tic_handle_open_serial().
+    static handle open_serial(const std::string & port_name,
+      uint32_t baud_rate, uint8_t product, uint16_t device_number,
+      uint32_t flags = 0)
+    {
+      tic_handle * p;
+      throw_if_needed(tic_handle_open_serial(port_name.c_str(), baud_rate,
+        product, device_number, flags, &p));
+      return handle(p);
+    }
+
+    /// Wrapper for tic_handle_open_emulated().
+    static handle open_emulated(uint8_t product)
+    {
+      tic_handle * p;
+      throw_if_needed(tic_handle_open_emulated(product, &p));
+      return handle(p);
+    }
+
     /// Closes the handle and puts this object into the null state.
     void close() noexcept
     {
@@ -843,6 +1114,20 @@ namespace tic
       throw_if_needed(tic_set_agc_frequency_limit(pointer, limit));
     }
 
+    /// Wrapper for tic_handle_get_stats().
+    handle_stats get_stats() const
+    {
+      tic_handle_stats * s;
+      throw_if_needed(tic_handle_get_stats(pointer, &s));
+      return handle_stats(s);
+    }
+
+    /// Wrapper for tic_handle_reset_stats().
+    void reset_stats() noexcept
+    {
+      tic_handle_reset_stats(pointer);
+    }
+
     /// Wrapper for tic_get_variables().
     variables get_variables(bool clear_errors_occurred = false)
     {
@@ -851,6 +1136,18 @@ namespace tic
       return variables(v);
     }
 
+    /// Wrapper for tic_wait_for_position_reached().
+    void wait_for_position_reached(uint32_t timeout_ms)
+    {
+      throw_if_needed(tic_wait_for_position_reached(pointer, timeout_ms));
+    }
+
+    /// Wrapper for tic_wait_for_homing_complete().
+    void wait_for_homing_complete(uint32_t timeout_ms)
+    {
+      throw_if_needed(tic_wait_for_homing_complete(pointer, timeout_ms));
+    }
+
     /// Wrapper for tic_get_settings().
     settings get_settings()
     {
@@ -865,6 +1162,16 @@ namespace tic
       throw_if_needed(tic_set_settings(pointer, settings.get_pointer()));
     }
 
+    /// Wrapper for tic_set_settings_diff().  Returns the number of bytes that
+    /// were written.
+    size_t set_settings_diff(const settings & settings)
+    {
+      size_t bytes_written;
+      throw_if_needed(tic_set_settings_diff(pointer, settings.get_pointer(),
+          &bytes_written));
+      return bytes_written;
+    }
+
     /// Wrapper for tic_restore_defaults().
     void restore_defaults()
     {
@@ -894,6 +1201,555 @@ namespace tic
 
   };
 
+  inline void variables::refresh(handle & handle, bool clear_errors_occurred)
+  {
+    if (pointer == NULL)
+    {
+      throw_if_needed(tic_variables_create(&pointer));
+    }
+    throw_if_needed(tic_get_variables_into(handle.get_pointer(), pointer,
+        clear_errors_occurred));
+  }
+
+  inline void variables::refresh_fields(handle & handle, uint32_t fields,
+    bool clear_errors_occurred)
+  {
+    if (pointer == NULL)
+    {
+      throw_if_needed(tic_variables_create(&pointer));
+    }
+    throw_if_needed(tic_get_variables_fields(handle.get_pointer(), pointer,
+        fields, clear_errors_occurred));
+  }
+
+  /// Samples a Tic's variables at a fixed rate on a background thread.  See
+  /// tic_monitor_create() for details.  The handle must outlive this object
+  /// and must not be used while the monitor is running.
+  class monitor : public unique_pointer_wrapper<tic_monitor>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.  This object will free
+    /// the pointer when it is destroyed.
+    explicit monitor(tic_monitor * p = NULL) noexcept
+      : unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for tic_monitor_create().
+    monitor(handle & handle, uint32_t interval_us, size_t capacity,
+      uint32_t fields)
+    {
+      throw_if_needed(tic_monitor_create(handle.get_pointer(),
+          interval_us, capacity, fields, &pointer));
+    }
+
+    /// Wrapper for tic_monitor_start().
+    void start()
+    {
+      throw_if_needed(tic_monitor_start(pointer));
+    }
+
+    /// Wrapper for tic_monitor_stop().
+    void stop() noexcept
+    {
+      tic_monitor_stop(pointer);
+    }
+
+    /// Wrapper for tic_monitor_read_sample().  If the variables object is
+    /// null, a new variables object is created first.
+    bool read_sample(variables & vars, uint64_t * host_time_us = NULL)
+    {
+      if (!vars) { vars = variables::create(); }
+      return tic_monitor_read_sample(pointer, vars.get_pointer(),
+        host_time_us);
+    }
+
+    /// Wrapper for tic_monitor_read_samples().  Reads up to samples.size()
+    /// samples and returns how many were read.  Any null variables objects in
+    /// the vector are created first.
+    size_t read_samples(std::vector<variables> & samples)
+    {
+      std::vector<tic_variables *> pointers;
+      for (variables & vars : samples)
+      {
+        if (!vars) { vars = variables::create(); }
+        pointers.push_back(vars.get_pointer());
+      }
+      size_t count;
+      throw_if_needed(tic_monitor_read_samples(pointer, pointers.data(),
+          pointers.size(), &count));
+      return count;
+    }
+
+    /// Wrapper for tic_monitor_get_sample_count().
+    size_t get_sample_count() const noexcept
+    {
+      return tic_monitor_get_sample_count(pointer);
+    }
+
+    /// Wrapper for tic_monitor_is_running().
+    bool is_running() const noexcept
+    {
+      return tic_monitor_is_running(pointer);
+    }
+
+    /// Throws the error that stopped the sampling thread, if there was one.
+    void throw_if_failed() const
+    {
+      const tic_error * err = tic_monitor_get_error(pointer);
+      if (err != NULL) { throw error(pointer_copy(err)); }
+    }
+
+    /// Wrapper for tic_monitor_get_dropped_count().
+    uint32_t get_dropped_count() const noexcept
+    {
+      return tic_monitor_get_dropped_count(pointer);
+    }
+
+    /// Wrapper for tic_monitor_get_missed_deadline_count().
+    uint32_t get_missed_deadline_count() const noexcept
+    {
+      return tic_monitor_get_missed_deadline_count(pointer);
+    }
+  };
+
+  /// Polls several Tics in parallel.  See tic_fleet_create() for details.  The
+  /// handles must outlive this object and must not be used while it exists.
+  class fleet : public unique_pointer_wrapper<tic_fleet>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.  This object will free
+    /// the pointer when it is destroyed.
+    explicit fleet(tic_fleet * p = NULL) noexcept
+      : unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for tic_fleet_create().
+    fleet(std::vector<handle> & handles, size_t worker_count, uint32_t fields)
+    {
+      std::vector<tic_handle *> pointers;
+      for (handle & h : handles) { pointers.push_back(h.get_pointer()); }
+      throw_if_needed(tic_fleet_create(pointers.data(), pointers.size(),
+          worker_count, fields, &pointer));
+    }
+
+    /// Wrapper for tic_fleet_poll().
+    void poll(uint32_t timeout_ms)
+    {
+      throw_if_needed(tic_fleet_poll(pointer, timeout_ms));
+    }
+
+    /// Wrapper for tic_fleet_get_device_count().
+    size_t get_device_count() const noexcept
+    {
+      return tic_fleet_get_device_count(pointer);
+    }
+
+    /// Wrapper for tic_fleet_get_cycle_count().
+    uint32_t get_cycle_count() const noexcept
+    {
+      return tic_fleet_get_cycle_count(pointer);
+    }
+
+    /// Wrapper for tic_fleet_get_cycle_time_us().
+    uint32_t get_cycle_time_us() const noexcept
+    {
+      return tic_fleet_get_cycle_time_us(pointer);
+    }
+
+    /// Wrapper for tic_fleet_get_status().
+    uint8_t get_status(size_t index) const noexcept
+    {
+      return tic_fleet_get_status(pointer, index);
+    }
+
+    /// Returns a copy of the variables from tic_fleet_get_variables().
+    variables get_variables(size_t index) const
+    {
+      return variables(pointer_copy(tic_fleet_get_variables(pointer, index)));
+    }
+
+    /// Returns a copy of the error from tic_fleet_get_error(), which will be
+    /// null if there was no error.
+    error get_error(size_t index) const
+    {
+      const tic_error * err = tic_fleet_get_error(pointer, index);
+      return error(err == NULL ? NULL : pointer_copy(err));
+    }
+
+    /// Wrapper for tic_fleet_get_latency_us().
+    uint32_t get_latency_us(size_t index) const noexcept
+    {
+      return tic_fleet_get_latency_us(pointer, index);
+    }
+
+    /// Wrapper for tic_fleet_get_sample_time_us().
+    uint64_t get_sample_time_us(size_t index) const noexcept
+    {
+      return tic_fleet_get_sample_time_us(pointer, index);
+    }
+  };
+
+  /// Wrapper for tic_get_time_us().
+  inline uint64_t get_time_us() noexcept
+  {
+    return tic_get_time_us();
+  }
+
+  /// Moves several Tics so that they all arrive at the same time.  See
+  /// tic_sync_move_create() for details.
+  class sync_move : public unique_pointer_wrapper<tic_sync_move>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.  This object will free
+    /// the pointer when it is destroyed.
+    explicit sync_move(tic_sync_move * p = NULL) noexcept
+      : unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for tic_sync_move_create().
+    sync_move(std::vector<handle> & handles)
+    {
+      std::vector<tic_handle *> pointers;
+      for (handle & h : handles) { pointers.push_back(h.get_pointer()); }
+      throw_if_needed(tic_sync_move_create(pointers.data(), pointers.size(),
+          &pointer));
+    }
+
+    /// Wrapper for tic_sync_move_start().
+    void start(const std::vector<int32_t> & targets)
+    {
+      throw_if_needed(tic_sync_move_start(pointer, targets.data(),
+          targets.size()));
+    }
+
+    /// Wrapper for tic_sync_move_get_axis_count().
+    size_t get_axis_count() const noexcept
+    {
+      return tic_sync_move_get_axis_count(pointer);
+    }
+
+    /// Wrapper for tic_sync_move_get_duration_us().
+    uint32_t get_duration_us() const noexcept
+    {
+      return tic_sync_move_get_duration_us(pointer);
+    }
+
+    /// Wrapper for tic_sync_move_get_max_speed().
+    uint32_t get_max_speed(size_t index) const noexcept
+    {
+      return tic_sync_move_get_max_speed(pointer, index);
+    }
+
+    /// Wrapper for tic_sync_move_get_max_accel().
+    uint32_t get_max_accel(size_t index) const noexcept
+    {
+      return tic_sync_move_get_max_accel(pointer, index);
+    }
+
+    /// Wrapper for tic_sync_move_get_starting_speed().
+    uint32_t get_starting_speed(size_t index) const noexcept
+    {
+      return tic_sync_move_get_starting_speed(pointer, index);
+    }
+
+    /// Wrapper for tic_sync_move_get_send_skew_us().
+    uint32_t get_send_skew_us() const noexcept
+    {
+      return tic_sync_move_get_send_skew_us(pointer);
+    }
+
+    /// Wrapper for tic_sync_move_get_start_skew_us().
+    uint32_t get_start_skew_us() const noexcept
+    {
+      return tic_sync_move_get_start_skew_us(pointer);
+    }
+
+    /// Wrapper for tic_sync_move_get_start_offset_us().
+    uint32_t get_start_offset_us(size_t index) const noexcept
+    {
+      return tic_sync_move_get_start_offset_us(pointer, index);
+    }
+  };
+
+  /// Predicts the Tic's position between reads of its variables.  See
+  /// tic_estimator_create() for details.
+  class estimator : public unique_pointer_wrapper<tic_estimator>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.  This object will free
+    /// the pointer when it is destroyed.
+    explicit estimator(tic_estimator * p = NULL) noexcept
+      : unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for tic_estimator_create().
+    static estimator create()
+    {
+      tic_estimator * p;
+      throw_if_needed(tic_estimator_create(&p));
+      return estimator(p);
+    }
+
+    /// Wrapper for tic_estimator_update().
+    void update(const variables & vars, uint64_t host_time_us) noexcept
+    {
+      tic_estimator_update(pointer, vars.get_pointer(), host_time_us);
+    }
+
+    /// Wrapper for tic_estimator_predict().
+    bool predict(uint64_t host_time_us, double & position,
+      double & velocity) const noexcept
+    {
+      return tic_estimator_predict(pointer, host_time_us, &position, &velocity);
+    }
+
+    /// Wrapper for tic_estimator_get_update_count().
+    uint32_t get_update_count() const noexcept
+    {
+      return tic_estimator_get_update_count(pointer);
+    }
+
+    /// Wrapper for tic_estimator_get_last_error().
+    double get_last_error() const noexcept
+    {
+      return tic_estimator_get_last_error(pointer);
+    }
+
+    /// Wrapper for tic_estimator_get_max_error().
+    double get_max_error() const noexcept
+    {
+      return tic_estimator_get_max_error(pointer);
+    }
+
+    /// Wrapper for tic_estimator_clear_stats().
+    void clear_stats() noexcept
+    {
+      tic_estimator_clear_stats(pointer);
+    }
+  };
+
+  /// Sends a timed sequence of targets to a Tic from a background thread.  See
+  /// tic_streamer_create() for details.
+  class streamer : public unique_pointer_wrapper<tic_streamer>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.  This object will free
+    /// the pointer when it is destroyed.
+    explicit streamer(tic_streamer * p = NULL) noexcept
+      : unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for tic_streamer_create().
+    streamer(const handle & handle, uint32_t max_lateness_us = 0)
+    {
+      throw_if_needed(tic_streamer_create(handle.get_pointer(),
+          max_lateness_us, &pointer));
+    }
+
+    /// Wrapper for tic_streamer_add_point().
+    void add_point(uint64_t time_us, uint8_t command, int32_t value)
+    {
+      throw_if_needed(tic_streamer_add_point(pointer, time_us, command, value));
+    }
+
+    /// Wrapper for tic_streamer_get_point_count().
+    size_t get_point_count() const noexcept
+    {
+      return tic_streamer_get_point_count(pointer);
+    }
+
+    /// Wrapper for tic_streamer_start().
+    void start()
+    {
+      throw_if_needed(tic_streamer_start(pointer));
+    }
+
+    /// Wrapper for tic_streamer_wait().
+    void wait() noexcept
+    {
+      tic_streamer_wait(pointer);
+    }
+
+    /// Wrapper for tic_streamer_stop().
+    void stop() noexcept
+    {
+      tic_streamer_stop(pointer);
+    }
+
+    /// Wrapper for tic_streamer_is_running().
+    bool is_running() const noexcept
+    {
+      return tic_streamer_is_running(pointer);
+    }
+
+    /// Throws the error that stopped the streaming thread, if there was one.
+    void throw_if_failed() const
+    {
+      const tic_error * err = tic_streamer_get_error(pointer);
+      if (err != NULL) { throw error(pointer_copy(err)); }
+    }
+
+    /// Wrapper for tic_streamer_get_sent_count().
+    uint32_t get_sent_count() const noexcept
+    {
+      return tic_streamer_get_sent_count(pointer);
+    }
+
+    /// Wrapper for tic_streamer_get_merged_count().
+    uint32_t get_merged_count() const noexcept
+    {
+      return tic_streamer_get_merged_count(pointer);
+    }
+
+    /// Wrapper for tic_streamer_get_dropped_count().
+    uint32_t get_dropped_count() const noexcept
+    {
+      return tic_streamer_get_dropped_count(pointer);
+    }
+
+    /// Wrapper for tic_streamer_get_max_jitter_us().
+    uint32_t get_max_jitter_us() const noexcept
+    {
+      return tic_streamer_get_max_jitter_us(pointer);
+    }
+
+    /// Wrapper for tic_streamer_get_max_latency_us().
+    uint32_t get_max_latency_us() const noexcept
+    {
+      return tic_streamer_get_max_latency_us(pointer);
+    }
+
+    /// Wrapper for tic_streamer_get_jitter_histogram().
+    std::vector<uint32_t> get_jitter_histogram() const
+    {
+      std::vector<uint32_t> counts(TIC_STREAMER_HISTOGRAM_SIZE);
+      tic_streamer_get_jitter_histogram(pointer, counts.data());
+      return counts;
+    }
+
+    /// Wrapper for tic_streamer_get_latency_histogram().
+    std::vector<uint32_t> get_latency_histogram() const
+    {
+      std::vector<uint32_t> counts(TIC_STREAMER_HISTOGRAM_SIZE);
+      tic_streamer_get_latency_histogram(pointer, counts.data());
+      return counts;
+    }
+  };
+
+  /// Talks to several Tics that share one serial line.  See
+  /// tic_serial_bus_create() for details.
+  class serial_bus : public unique_pointer_wrapper<tic_serial_bus>
+  {
+  public:
+    /// Constructor that takes a pointer from the C API.  This object will free
+    /// the pointer when it is destroyed.
+    explicit serial_bus(tic_serial_bus * p = NULL) noexcept
+      : unique_pointer_wrapper(p)
+    {
+    }
+
+    /// Wrapper for tic_serial_bus_create().
+    serial_bus(const std::string & port_name, uint32_t baud_rate)
+    {
+      throw_if_needed(tic_serial_bus_create(port_name.c_str(), baud_rate,
+          &pointer));
+    }
+
+    /// Wrapper for tic_serial_bus_add_device().
+    void add_device(const settings & settings,
+      bool use_alt_device_number = false)
+    {
+      throw_if_needed(tic_serial_bus_add_device(pointer,
+          settings.get_pointer(), use_alt_device_number));
+    }
+
+    /// Wrapper for tic_serial_bus_get_device_count().
+    size_t get_device_count() const noexcept
+    {
+      return tic_serial_bus_get_device_count(pointer);
+    }
+
+    /// Wrapper for tic_serial_bus_queue_command().
+    void queue_command(size_t index, uint8_t command, int32_t value = 0)
+    {
+      throw_if_needed(tic_serial_bus_queue_command(pointer, index,
+          command, value));
+    }
+
+    /// Wrapper for tic_serial_bus_flush().
+    void flush()
+    {
+      throw_if_needed(tic_serial_bus_flush(pointer));
+    }
+
+    /// Wrapper for tic_serial_bus_get_variables().  Returns one variables
+    /// object for each device on the bus.
+    std::vector<variables> get_variables(
+      uint32_t fields = TIC_VARIABLES_FIELD_ALL,
+      bool clear_errors_occurred = false)
+    {
+      std::vector<variables> vars;
+      std::vector<tic_variables *> pointers;
+      for (size_t i = 0; i < get_device_count(); i++)
+      {
+        tic_variables * p;
+        throw_if_needed(tic_variables_create(&p));
+        vars.push_back(variables(p));
+        pointers.push_back(p);
+      }
+      throw_if_needed(tic_serial_bus_get_variables(pointer, pointers.data(),
+          fields, clear_errors_occurred));
+      return vars;
+    }
+
+    /// Wrapper for tic_serial_bus_get_command_count().
+    uint64_t get_command_count() const noexcept
+    {
+      return tic_serial_bus_get_command_count(pointer);
+    }
+
+    /// Wrapper for tic_serial_bus_get_bytes_sent().
+    uint64_t get_bytes_sent() const noexcept
+    {
+      return tic_serial_bus_get_bytes_sent(pointer);
+    }
+
+    /// Wrapper for tic_serial_bus_get_bytes_received().
+    uint64_t get_bytes_received() const noexcept
+    {
+      return tic_serial_bus_get_bytes_received(pointer);
+    }
+
+    /// Wrapper for tic_serial_bus_get_busy_time_us().
+    uint64_t get_busy_time_us() const noexcept
+    {
+      return tic_serial_bus_get_busy_time_us(pointer);
+    }
+
+    /// Wrapper for tic_serial_bus_get_commands_per_second().
+    uint32_t get_commands_per_second() const noexcept
+    {
+      return tic_serial_bus_get_commands_per_second(pointer);
+    }
+
+    /// Wrapper for tic_serial_bus_get_theoretical_commands_per_second().
+    uint32_t get_theoretical_commands_per_second() const noexcept
+    {
+      return tic_serial_bus_get_theoretical_commands_per_second(pointer);
+    }
+
+    /// Wrapper for tic_serial_bus_reset_stats().
+    void reset_stats() noexcept
+    {
+      tic_serial_bus_reset_stats(pointer);
+    }
+  };
+
   /// Wrapper for tic_get_recommended_current_limit_codes().
   inline const std::vector<uint8_t> get_recommended_current_limit_codes(
     uint8_t product)
@@ -11,6 +11,193 @@ struct tic_device
   uint8_t product;
 };
 
+// The enumeration cache remembers every Tic that tic_list_connected_devices()
+// found last time, keyed by OS ID, so that listing devices again only has to
+// create a generic interface and read the serial number of devices that are
+// new.  Devices that are gone are removed from the cache.
+typedef struct tic_device_cache_entry
+{
+  tic_device * device;
+  char * plug_id;
+  bool seen;
+} tic_device_cache_entry;
+
+static tic_mutex device_cache_mutex = TIC_MUTEX_INITIALIZER;
+static tic_device_cache_entry * device_cache;
+static size_t device_cache_count;
+static size_t device_cache_capacity;
+static uint32_t device_cache_hits;
+static uint32_t device_cache_misses;
+
+// Gets a string that changes whenever a device gets plugged in, to make sure
+// a cached device is really the same one.  Returns NULL if there is no such
+// string, in which case the device should not be cached.
+//
+// On Linux, the OS ID is the sysfs path of the device, which only depends on
+// the port it is plugged into, so we use the device number, which the kernel
+// assigns each time a device is plugged in.  On Windows and macOS, the OS ID
+// already changes when a different device is plugged in, so we just use an
+// empty string.
+static char * get_plug_id(const char * os_id)
+{
+#ifdef __linux__
+  char path[512];
+  int length = snprintf(path, sizeof(path), "%s/devnum", os_id);
+  if (length < 0 || (size_t)length >= sizeof(path)) { return NULL; }
+
+  FILE * file = fopen(path, "r");
+  if (file == NULL) { return NULL; }
+  char devnum[16] = { 0 };
+  bool success = fgets(devnum, sizeof(devnum), file) != NULL;
+  fclose(file);
+  if (!success) { return NULL; }
+  return strdup(devnum);
+#else
+  (void)os_id;
+  return strdup("");
+#endif
+}
+
+static tic_device_cache_entry * device_cache_find(const char * os_id)
+{
+  for (size_t i = 0; i < device_cache_count; i++)
+  {
+    if (strcmp(device_cache[i].device->os_id, os_id) == 0)
+    {
+      return &device_cache[i];
+    }
+  }
+  return NULL;
+}
+
+static void device_cache_remove(tic_device_cache_entry * entry)
+{
+  tic_device_free(entry->device);
+  free(entry->plug_id);
+  *entry = device_cache[--device_cache_count];
+}
+
+// Adds a copy of the device to the cache.  Takes ownership of plug_id.  If
+// there is not enough memory, the device just does not get cached.
+static void device_cache_add(const tic_device * device, char * plug_id)
+{
+  tic_device_cache_entry * old = device_cache_find(device->os_id);
+  if (old) { device_cache_remove(old); }
+
+  if (device_cache_count == device_cache_capacity)
+  {
+    size_t new_capacity = device_cache_capacity ? device_cache_capacity * 2 : 4;
+    tic_device_cache_entry * new_cache = realloc(device_cache,
+      new_capacity * sizeof(tic_device_cache_entry));
+    if (new_cache == NULL)
+    {
+      free(plug_id);
+      return;
+    }
+    device_cache = new_cache;
+    device_cache_capacity = new_capacity;
+  }
+
+  tic_device * copy;
+  tic_error * error = tic_device_copy(device, &copy);
+  if (error)
+  {
+    tic_error_free(error);
+    free(plug_id);
+    return;
+  }
+
+  tic_device_cache_entry * entry = &device_cache[device_cache_count++];
+  entry->device = copy;
+  entry->plug_id = plug_id;
+  entry->seen = true;
+}
+
+// Returns the product code for a USB product ID, or 0 if it is not a Tic.
+static uint8_t product_from_usb_id(uint16_t product_id)
+{
+  switch (product_id)
+  {
+  case TIC_PRODUCT_ID_T825: return TIC_PRODUCT_T825;
+  case TIC_PRODUCT_ID_T834: return TIC_PRODUCT_T834;
+  case TIC_PRODUCT_ID_T500: return TIC_PRODUCT_T500;
+  case TIC_PRODUCT_ID_N825: return TIC_PRODUCT_N825;
+  case TIC_PRODUCT_ID_T249: return TIC_PRODUCT_T249;
+  case TIC_PRODUCT_ID_36V4: return TIC_PRODUCT_36V4;
+  default: return 0;
+  }
+}
+
+// Creates a device object for a USB device that we already know is a Tic.
+// If the device's interface is not ready to use yet, sets *device to NULL and
+// returns success.
+static tic_error * device_create_from_usb(const libusbp_device * usb_device,
+  uint8_t product, tic_device ** device)
+{
+  *device = NULL;
+
+  // Get the USB interface.
+  libusbp_generic_interface * usb_interface = NULL;
+  {
+    uint8_t interface_number = 0;
+    bool composite = false;
+    libusbp_error * usb_error = libusbp_generic_interface_create(
+      usb_device, interface_number, composite, &usb_interface);
+    if (usb_error)
+    {
+      if (libusbp_error_has_code(usb_error, LIBUSBP_ERROR_NOT_READY))
+      {
+        // An error occurred that is normal if the interface is simply
+        // not ready to use yet.  Silently ignore this device.
+        libusbp_error_free(usb_error);
+        return NULL;
+      }
+      return tic_usb_error(usb_error);
+    }
+  }
+
+  // Allocate the new device.
+  tic_device * new_device = calloc(1, sizeof(tic_device));
+  if (new_device == NULL)
+  {
+    libusbp_generic_interface_free(usb_interface);
+    return &tic_error_no_memory;
+  }
+
+  // Store the USB interface.  Must do this here so that it will get freed
+  // if any of the calls below fail.
+  new_device->usb_interface = usb_interface;
+  new_device->product = product;
+
+  // Get the serial number.
+  tic_error * error = tic_usb_error(libusbp_device_get_serial_number(
+      usb_device, &new_device->serial_number));
+
+  // Get the OS ID.
+  if (error == NULL)
+  {
+    error = tic_usb_error(libusbp_device_get_os_id(
+        usb_device, &new_device->os_id));
+  }
+
+  // Get the firmware version.
+  if (error == NULL)
+  {
+    error = tic_usb_error(libusbp_device_get_revision(
+        usb_device, &new_device->firmware_version));
+  }
+
+  if (error == NULL)
+  {
+    *device = new_device;
+    new_device = NULL;
+  }
+
+  tic_device_free(new_device);
+
+  return error;
+}
+
 tic_error * tic_list_connected_devices(
   tic_device *** device_list,
   size_t * device_count)
@@ -34,8 +221,15 @@ tic_error * tic_list_connected_devices(
         &usb_device_list, &usb_device_count));
   }
 
+  tic_mutex_lock(&device_cache_mutex);
+  for (size_t i = 0; i < device_cache_count; i++)
+  {
+    device_cache[i].seen = false;
+  }
+
   tic_device ** tic_device_list = NULL;
   size_t tic_device_count = 0;
+  char * plug_id = NULL;
   if (error == NULL)
   {
     // Allocate enough memory for the case where every USB device is
@@ -61,94 +255,67 @@ tic_error * tic_list_connected_devices(
     uint16_t product_id;
     error = tic_usb_error(libusbp_device_get_product_id(usb_device, &product_id));
     if (error) { break; }
-    if (product_id != TIC_PRODUCT_ID_T825 &&
-      product_id != TIC_PRODUCT_ID_T834 &&
-      product_id != TIC_PRODUCT_ID_T500 &&
-      product_id != TIC_PRODUCT_ID_N825 &&
-      product_id != TIC_PRODUCT_ID_T249 &&
-      product_id != TIC_PRODUCT_ID_36V4)
+    uint8_t product = product_from_usb_id(product_id);
+    if (product == 0) { continue; }
+
+    // Use the cached device if it is still plugged in.  Getting the OS ID and
+    // revision does not require any USB I/O.
+    char * os_id = NULL;
+    uint16_t revision;
+    error = tic_usb_error(libusbp_device_get_os_id(usb_device, &os_id));
+    if (error == NULL)
     {
-      continue;
+      error = tic_usb_error(libusbp_device_get_revision(usb_device, &revision));
     }
+    plug_id = error ? NULL : get_plug_id(os_id);
+    tic_device_cache_entry * entry = error ? NULL : device_cache_find(os_id);
+    libusbp_string_free(os_id);
+    if (error) { break; }
 
-    // Get the USB interface.
-    libusbp_generic_interface * usb_interface = NULL;
+    if (entry && plug_id && strcmp(entry->plug_id, plug_id) == 0 &&
+      entry->device->firmware_version == revision)
     {
-      uint8_t interface_number = 0;
-      bool composite = false;
-      libusbp_error * usb_error = libusbp_generic_interface_create(
-        usb_device, interface_number, composite, &usb_interface);
-      if (usb_error)
-      {
-        if (libusbp_error_has_code(usb_error, LIBUSBP_ERROR_NOT_READY))
-        {
-          // An error occurred that is normal if the interface is simply
-          // not ready to use yet.  Silently ignore this device.
-          continue;
-        }
-        error = tic_usb_error(usb_error);
-        break;
-      }
+      free(plug_id);
+      plug_id = NULL;
+      error = tic_device_copy(entry->device,
+        &tic_device_list[tic_device_count]);
+      if (error) { break; }
+      tic_device_count++;
+      entry->seen = true;
+      device_cache_hits++;
+      continue;
     }
+    device_cache_misses++;
 
-    // Allocate the new device.
-    tic_device * new_device = calloc(1, sizeof(tic_device));
+    tic_device * new_device;
+    error = device_create_from_usb(usb_device, product, &new_device);
+    if (error) { break; }
     if (new_device == NULL)
     {
-      error = &tic_error_no_memory;
-      break;
+      free(plug_id);
+      plug_id = NULL;
+      continue;
     }
     tic_device_list[tic_device_count++] = new_device;
 
-    // Store the USB interface.  Must do this here so that it will get freed
-    // if any of the calls below fail.
-    new_device->usb_interface = usb_interface;
-
-    // Get the serial number.
-    error = tic_usb_error(libusbp_device_get_serial_number(
-        usb_device, &new_device->serial_number));
-    if (error) { break; }
-
-    // Get the OS ID.
-    error = tic_usb_error(libusbp_device_get_os_id(
-        usb_device, &new_device->os_id));
-    if (error) { break; }
+    if (plug_id) { device_cache_add(new_device, plug_id); }
+    plug_id = NULL;
+  }
 
-    // Get the firmware version.
-    error = tic_usb_error(libusbp_device_get_revision(
-        usb_device, &new_device->firmware_version));
-    if (error) { break; }
+  free(plug_id);
 
-    // Get the product code.
-    switch (product_id)
-    {
-    case TIC_PRODUCT_ID_T825:
-      new_device->product = TIC_PRODUCT_T825;
-      break;
-    case TIC_PRODUCT_ID_T834:
-      new_device->product = TIC_PRODUCT_T834;
-      break;
-    case TIC_PRODUCT_ID_T500:
-      new_device->product = TIC_PRODUCT_T500;
-      break;
-    case TIC_PRODUCT_ID_N825:
-      new_device->product = TIC_PRODUCT_N825;
-      break;
-    case TIC_PRODUCT_ID_T249:
-      new_device->product = TIC_PRODUCT_T249;
-      break;
-    case TIC_PRODUCT_ID_36V4:
-      new_device->product = TIC_PRODUCT_36V4;
-      break;
-    }
-    if (new_device->product == 0)
+  if (error == NULL)
+  {
+    // Forget about devices that are no longer connected.
+    for (size_t i = 0; i < device_cache_count; )
     {
-      // Should not ever happen.
-      error = tic_error_create("Unknown product.");
-      break;
+      if (device_cache[i].seen) { i++; }
+      else { device_cache_remove(&device_cache[i]); }
     }
   }
 
+  tic_mutex_unlock(&device_cache_mutex);
+
   if (error == NULL)
   {
     // Success.  Give the list to the caller.
@@ -175,11 +342,97 @@ tic_error * tic_list_connected_devices(
   return error;
 }
 
+tic_error * tic_find_device_by_serial_number(const char * serial_number,
+  tic_device ** device)
+{
+  if (device == NULL)
+  {
+    return tic_error_create("Device output pointer is null.");
+  }
+
+  *device = NULL;
+
+  if (serial_number == NULL)
+  {
+    return tic_error_create("Serial number is null.");
+  }
+
+  tic_error * error = NULL;
+
+  libusbp_device ** usb_device_list = NULL;
+  size_t usb_device_count = 0;
+  error = tic_usb_error(libusbp_list_connected_devices(
+      &usb_device_list, &usb_device_count));
+
+  for (size_t i = 0; error == NULL && i < usb_device_count; i++)
+  {
+    libusbp_device * usb_device = usb_device_list[i];
+
+    uint16_t vendor_id;
+    error = tic_usb_error(libusbp_device_get_vendor_id(usb_device, &vendor_id));
+    if (error) { break; }
+    if (vendor_id != TIC_VENDOR_ID) { continue; }
+
+    uint16_t product_id;
+    error = tic_usb_error(libusbp_device_get_product_id(usb_device, &product_id));
+    if (error) { break; }
+    uint8_t product = product_from_usb_id(product_id);
+    if (product == 0) { continue; }
+
+    // Check the serial number before doing anything else, so we only create a
+    // generic interface for the device we want.
+    char * device_serial_number = NULL;
+    error = tic_usb_error(libusbp_device_get_serial_number(
+        usb_device, &device_serial_number));
+    if (error) { break; }
+    bool match = strcmp(device_serial_number, serial_number) == 0;
+    libusbp_string_free(device_serial_number);
+    if (!match) { continue; }
+
+    error = device_create_from_usb(usb_device, product, device);
+
+    // Serial numbers are unique, so there is no need to look further.
+    break;
+  }
+
+  for (size_t i = 0; i < usb_device_count; i++)
+  {
+    libusbp_device_free(usb_device_list[i]);
+  }
+
+  libusbp_list_free(usb_device_list);
+
+  return error;
+}
+
 void tic_list_free(tic_device ** list)
 {
   free(list);
 }
 
+void tic_device_cache_get_stats(uint32_t * hits, uint32_t * misses)
+{
+  tic_mutex_lock(&device_cache_mutex);
+  if (hits) { *hits = device_cache_hits; }
+  if (misses) { *misses = device_cache_misses; }
+  tic_mutex_unlock(&device_cache_mutex);
+}
+
+void tic_device_cache_clear(void)
+{
+  tic_mutex_lock(&device_cache_mutex);
+  while (device_cache_count)
+  {
+    device_cache_remove(&device_cache[0]);
+  }
+  free(device_cache);
+  device_cache = NULL;
+  device_cache_capacity = 0;
+  device_cache_hits = 0;
+  device_cache_misses = 0;
+  tic_mutex_unlock(&device_cache_mutex);
+}
+
 tic_error * tic_device_copy(const tic_device * source, tic_device ** dest)
 {
   if (dest == NULL)
@@ -202,7 +455,7 @@ tic_error * tic_device_copy(const tic_device * source, tic_device ** dest)
     error = &tic_error_no_memory;
   }
 
-  if (error == NULL)
+  if (error == NULL && source->usb_interface != NULL)
   {
     error = tic_usb_error(libusbp_generic_interface_copy(
         source->usb_interface, &new_device->usb_interface));
@@ -249,6 +502,47 @@ tic_error * tic_device_copy(const tic_device * source, tic_device ** dest)
   return error;
 }
 
+tic_error * tic_device_create_without_usb(uint8_t product,
+  uint16_t firmware_version, const char * serial_number, const char * os_id,
+  tic_device ** device)
+{
+  assert(serial_number != NULL);
+  assert(os_id != NULL);
+  assert(device != NULL);
+
+  *device = NULL;
+
+  tic_error * error = NULL;
+
+  tic_device * new_device = calloc(1, sizeof(tic_device));
+  if (new_device == NULL)
+  {
+    error = &tic_error_no_memory;
+  }
+
+  if (error == NULL)
+  {
+    new_device->product = product;
+    new_device->firmware_version = firmware_version;
+    new_device->serial_number = strdup(serial_number);
+    new_device->os_id = strdup(os_id);
+    if (new_device->serial_number == NULL || new_device->os_id == NULL)
+    {
+      error = &tic_error_no_memory;
+    }
+  }
+
+  if (error == NULL)
+  {
+    *device = new_device;
+    new_device = NULL;
+  }
+
+  tic_device_free(new_device);
+
+  return error;
+}
+
 void tic_device_free(tic_device * device)
 {
   if (device != NULL)
@@ -0,0 +1,470 @@
+// Functions for keeping a list of the connected Tics up to date without
+// scanning the USB bus over and over.
+//
+// On Linux, the monitor listens for uevents from the kernel and from udev on a
+// netlink socket, and only scans for devices after an event about a Pololu USB
+// device.  The events just tell us when to scan; we never trust their contents
+// beyond that, so a bogus event costs at most one scan.  On other systems, or
+// if the socket cannot be opened, the monitor scans at most once per
+// TIC_DEVICE_MONITOR_SCAN_INTERVAL_MS instead.
+
+#include "tic_internal.h"
+
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#endif
+
+// How often to scan when we do not get hotplug events.
+#define TIC_DEVICE_MONITOR_SCAN_INTERVAL_MS 1000
+
+// How long after a hotplug event to scan again.  A device that was just
+// plugged in might not be ready to use when we get the first event about it,
+// so scanning only once could miss it.
+#define TIC_DEVICE_MONITOR_SETTLE_MS 500
+
+// The most events we keep for the caller.  If the caller does not take them,
+// the oldest ones are discarded.
+#define TIC_DEVICE_MONITOR_MAX_EVENTS 64
+
+// The netlink multicast groups for uevents from the kernel and from udev.
+#define TIC_UEVENT_GROUP_KERNEL 1
+#define TIC_UEVENT_GROUP_UDEV 2
+
+typedef struct tic_device_monitor_event
+{
+  tic_device * device;
+  bool added;
+} tic_device_monitor_event;
+
+struct tic_device_monitor
+{
+  // The netlink socket, or -1 if we are not getting hotplug events.
+  int fd;
+
+  bool scan_needed;
+  uint64_t last_scan_us;
+
+  // The time of the follow-up scan after a hotplug event, or 0 if there is
+  // none scheduled.
+  uint64_t settle_scan_us;
+
+  uint32_t scan_count;
+  uint32_t hotplug_event_count;
+
+  tic_device ** devices;
+  size_t device_count;
+
+  // A queue of events that the caller has not taken yet.
+  tic_device_monitor_event events[TIC_DEVICE_MONITOR_MAX_EVENTS];
+  size_t event_head;
+  size_t event_count;
+};
+
+static void free_device_list(tic_device ** list, size_t count)
+{
+  for (size_t i = 0; i < count; i++) { tic_device_free(list[i]); }
+  tic_list_free(list);
+}
+
+static ssize_t find_device(tic_device * const * list, size_t count,
+  const tic_device * device)
+{
+  const char * os_id = tic_device_get_os_id(device);
+  for (size_t i = 0; i < count; i++)
+  {
+    if (strcmp(tic_device_get_os_id(list[i]), os_id) == 0) { return i; }
+  }
+  return -1;
+}
+
+// Adds an event to the queue, taking ownership of the device.
+static void push_event(tic_device_monitor * monitor, tic_device * device,
+  bool added)
+{
+  if (monitor->event_count == TIC_DEVICE_MONITOR_MAX_EVENTS)
+  {
+    tic_device_monitor_event * oldest = &monitor->events[monitor->event_head];
+    tic_device_free(oldest->device);
+    monitor->event_head = (monitor->event_head + 1) %
+      TIC_DEVICE_MONITOR_MAX_EVENTS;
+    monitor->event_count--;
+  }
+
+  size_t index = (monitor->event_head + monitor->event_count) %
+    TIC_DEVICE_MONITOR_MAX_EVENTS;
+  monitor->events[index].device = device;
+  monitor->events[index].added = added;
+  monitor->event_count++;
+}
+
+static tic_error * scan(tic_device_monitor * monitor, bool * changed)
+{
+  tic_device ** new_list = NULL;
+  size_t new_count = 0;
+  tic_error * error = tic_list_connected_devices(&new_list, &new_count);
+  if (error != NULL)
+  {
+    return tic_error_add(error, "Failed to scan for devices.");
+  }
+
+  monitor->scan_count++;
+  monitor->last_scan_us = tic_monotonic_us();
+
+  // Make the events for added devices first, so that if we run out of memory
+  // the old list is still intact.
+  tic_device * added[TIC_DEVICE_MONITOR_MAX_EVENTS];
+  size_t added_count = 0;
+  for (size_t i = 0; error == NULL && i < new_count; i++)
+  {
+    if (find_device(monitor->devices, monitor->device_count, new_list[i]) >= 0)
+    {
+      continue;
+    }
+    if (added_count == TIC_DEVICE_MONITOR_MAX_EVENTS) { break; }
+    error = tic_device_copy(new_list[i], &added[added_count]);
+    if (error == NULL) { added_count++; }
+  }
+
+  if (error != NULL)
+  {
+    for (size_t i = 0; i < added_count; i++) { tic_device_free(added[i]); }
+    free_device_list(new_list, new_count);
+    return error;
+  }
+
+  // Devices in the old list that are not in the new list were removed.  The
+  // event takes ownership of the old device object.
+  for (size_t i = 0; i < monitor->device_count; i++)
+  {
+    if (find_device(new_list, new_count, monitor->devices[i]) >= 0)
+    {
+      tic_device_free(monitor->devices[i]);
+    }
+    else
+    {
+      push_event(monitor, monitor->devices[i], false);
+      if (changed) { *changed = true; }
+    }
+  }
+  tic_list_free(monitor->devices);
+
+  for (size_t i = 0; i < added_count; i++)
+  {
+    push_event(monitor, added[i], true);
+    if (changed) { *changed = true; }
+  }
+
+  monitor->devices = new_list;
+  monitor->device_count = new_count;
+  return NULL;
+}
+
+#ifdef __linux__
+
+static int open_uevent_socket(void)
+{
+  int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+    NETLINK_KOBJECT_UEVENT);
+  if (fd < 0) { return -1; }
+
+  struct sockaddr_nl address;
+  memset(&address, 0, sizeof(address));
+  address.nl_family = AF_NETLINK;
+  address.nl_groups = TIC_UEVENT_GROUP_KERNEL | TIC_UEVENT_GROUP_UDEV;
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)))
+  {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static uint32_t read_be32(const uint8_t * p)
+{
+  return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 |
+    (uint32_t)p[2] << 8 | p[3];
+}
+
+static uint32_t read_host32(const uint8_t * p)
+{
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+// Returns true if a uevent is about a Pololu USB device or one of its
+// interfaces.  Messages from the kernel start with "ACTION@DEVPATH" and
+// messages from udev start with a "libudev" header; both are followed by
+// null-terminated KEY=VALUE properties.
+static bool uevent_is_interesting(const uint8_t * buffer, size_t length)
+{
+  size_t offset;
+  size_t end = length;
+  if (length >= 24 && memcmp(buffer, "libudev", 8) == 0)
+  {
+    if (read_be32(buffer + 8) != 0xfeedcafe) { return false; }
+    uint32_t properties_offset = read_host32(buffer + 16);
+    uint32_t properties_length = read_host32(buffer + 20);
+    if (properties_offset > length ||
+      properties_length > length - properties_offset)
+    {
+      return false;
+    }
+    offset = properties_offset;
+    end = properties_offset + properties_length;
+  }
+  else
+  {
+    const uint8_t * nul = memchr(buffer, 0, length);
+    if (nul == NULL || memchr(buffer, '@', nul - buffer) == NULL)
+    {
+      return false;
+    }
+    offset = nul - buffer + 1;
+  }
+
+  bool usb = false;
+  bool pololu = false;
+  char vendor[16];
+  snprintf(vendor, sizeof(vendor), "PRODUCT=%x/", TIC_VENDOR_ID);
+
+  while (offset < end)
+  {
+    const char * property = (const char *)buffer + offset;
+    const uint8_t * nul = memchr(buffer + offset, 0, end - offset);
+    size_t property_length = nul ? (size_t)(nul - buffer) - offset :
+      end - offset;
+
+    if (property_length == 13 && memcmp(property, "SUBSYSTEM=usb", 13) == 0)
+    {
+      usb = true;
+    }
+    if (property_length > strlen(vendor) &&
+      memcmp(property, vendor, strlen(vendor)) == 0)
+    {
+      pololu = true;
+    }
+
+    offset += property_length + 1;
+  }
+
+  return usb && pololu;
+}
+
+// Reads all the pending messages from the uevent socket.  Returns true if any
+// of them might mean that the list of Tics changed.
+static bool read_uevents(tic_device_monitor * monitor)
+{
+  bool interesting = false;
+  uint8_t buffer[8192];
+  while (true)
+  {
+    ssize_t received = recv(monitor->fd, buffer, sizeof(buffer), 0);
+    if (received < 0)
+    {
+      if (errno == EINTR) { continue; }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) { break; }
+
+      // ENOBUFS means the kernel dropped some events because we did not read
+      // them fast enough, so we have to scan.  For any other error, give up on
+      // hotplug events and fall back to scanning regularly.
+      if (errno != ENOBUFS)
+      {
+        close(monitor->fd);
+        monitor->fd = -1;
+      }
+      return true;
+    }
+
+    if (uevent_is_interesting(buffer, received))
+    {
+      monitor->hotplug_event_count++;
+      interesting = true;
+    }
+  }
+  return interesting;
+}
+
+#endif
+
+tic_error * tic_device_monitor_create(tic_device_monitor ** monitor)
+{
+  if (monitor == NULL)
+  {
+    return tic_error_create("Device monitor output pointer is null.");
+  }
+
+  *monitor = NULL;
+
+  tic_device_monitor * new_monitor = calloc(1, sizeof(tic_device_monitor));
+  if (new_monitor == NULL) { return &tic_error_no_memory; }
+
+  new_monitor->fd = -1;
+#ifdef __linux__
+  // Open the socket before the first scan so we do not miss any events that
+  // happen during it.
+  new_monitor->fd = open_uevent_socket();
+#endif
+
+  tic_error * error = scan(new_monitor, NULL);
+  if (error != NULL)
+  {
+    tic_device_monitor_free(new_monitor);
+    return error;
+  }
+
+  // The caller gets the initial list from tic_device_monitor_get_devices(),
+  // so it does not need an event for each device.
+  while (new_monitor->event_count)
+  {
+    tic_device_free(new_monitor->events[new_monitor->event_head].device);
+    new_monitor->event_head = (new_monitor->event_head + 1) %
+      TIC_DEVICE_MONITOR_MAX_EVENTS;
+    new_monitor->event_count--;
+  }
+
+  *monitor = new_monitor;
+  return NULL;
+}
+
+void tic_device_monitor_free(tic_device_monitor * monitor)
+{
+  if (monitor == NULL) { return; }
+
+  if (monitor->fd >= 0) { close(monitor->fd); }
+  free_device_list(monitor->devices, monitor->device_count);
+  for (size_t i = 0; i < monitor->event_count; i++)
+  {
+    size_t index = (monitor->event_head + i) % TIC_DEVICE_MONITOR_MAX_EVENTS;
+    tic_device_free(monitor->events[index].device);
+  }
+  free(monitor);
+}
+
+tic_error * tic_device_monitor_update(tic_device_monitor * monitor,
+  bool * changed)
+{
+  if (changed) { *changed = false; }
+
+  if (monitor == NULL)
+  {
+    return tic_error_create("Device monitor is null.");
+  }
+
+  uint64_t now = tic_monotonic_us();
+
+#ifdef __linux__
+  if (monitor->fd >= 0 && read_uevents(monitor))
+  {
+    monitor->scan_needed = true;
+    monitor->settle_scan_us = now + TIC_DEVICE_MONITOR_SETTLE_MS * 1000;
+  }
+#endif
+
+  if (monitor->fd < 0 &&
+    now - monitor->last_scan_us >= TIC_DEVICE_MONITOR_SCAN_INTERVAL_MS * 1000)
+  {
+    monitor->scan_needed = true;
+  }
+
+  if (monitor->settle_scan_us != 0 && now >= monitor->settle_scan_us)
+  {
+    monitor->scan_needed = true;
+    monitor->settle_scan_us = 0;
+  }
+
+  if (!monitor->scan_needed) { return NULL; }
+
+  // If the scan fails, scan_needed stays true so we try again next time.
+  tic_error * error = scan(monitor, changed);
+  if (error == NULL) { monitor->scan_needed = false; }
+  return error;
+}
+
+int tic_device_monitor_get_fd(const tic_device_monitor * monitor)
+{
+  if (monitor == NULL) { return -1; }
+  return monitor->fd;
+}
+
+tic_error * tic_device_monitor_get_devices(const tic_device_monitor * monitor,
+  tic_device *** device_list, size_t * device_count)
+{
+  if (device_count) { *device_count = 0; }
+
+  if (device_list == NULL)
+  {
+    return tic_error_create("Device list output pointer is null.");
+  }
+
+  *device_list = NULL;
+
+  if (monitor == NULL)
+  {
+    return tic_error_create("Device monitor is null.");
+  }
+
+  tic_device ** list = calloc(monitor->device_count + 1, sizeof(tic_device *));
+  if (list == NULL) { return &tic_error_no_memory; }
+
+  for (size_t i = 0; i < monitor->device_count; i++)
+  {
+    tic_error * error = tic_device_copy(monitor->devices[i], &list[i]);
+    if (error != NULL)
+    {
+      free_device_list(list, i);
+      return error;
+    }
+  }
+
+  *device_list = list;
+  if (device_count) { *device_count = monitor->device_count; }
+  return NULL;
+}
+
+size_t tic_device_monitor_get_device_count(const tic_device_monitor * monitor)
+{
+  if (monitor == NULL) { return 0; }
+  return monitor->device_count;
+}
+
+tic_error * tic_device_monitor_take_event(tic_device_monitor * monitor,
+  tic_device ** device, bool * added)
+{
+  if (device == NULL)
+  {
+    return tic_error_create("Device output pointer is null.");
+  }
+
+  *device = NULL;
+  if (added) { *added = false; }
+
+  if (monitor == NULL)
+  {
+    return tic_error_create("Device monitor is null.");
+  }
+
+  if (monitor->event_count == 0) { return NULL; }
+
+  tic_device_monitor_event * event = &monitor->events[monitor->event_head];
+  *device = event->device;
+  if (added) { *added = event->added; }
+  monitor->event_head = (monitor->event_head + 1) %
+    TIC_DEVICE_MONITOR_MAX_EVENTS;
+  monitor->event_count--;
+  return NULL;
+}
+
+uint32_t tic_device_monitor_get_scan_count(const tic_device_monitor * monitor)
+{
+  if (monitor == NULL) { return 0; }
+  return monitor->scan_count;
+}
+
+uint32_t tic_device_monitor_get_hotplug_event_count(
+  const tic_device_monitor * monitor)
+{
+  if (monitor == NULL) { return 0; }
+  return monitor->hotplug_event_count;
+}
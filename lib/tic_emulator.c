@@ -0,0 +1,732 @@
+// An emulated Tic that runs inside this process, for testing software without
+// hardware.
+//
+// The emulator answers the same USB control transfers as the firmware of a
+// real Tic.  It keeps a settings memory map laid out like the one on the
+// device, builds the variables map from its state each time it is read, and
+// runs a basic acceleration-limited motion planner in 1 ms ticks as time
+// passes.  It only models serial control mode: there are no inputs, limit
+// switches, encoders, or motor driver faults.  Homing uses a virtual limit
+// switch at the position the motor had at power up.
+
+#include "tic_internal.h"
+
+#define TIC_EMULATOR_FIRMWARE_VERSION 0x0106
+#define TIC_EMULATOR_TICK_US 1000
+#define TIC_EMULATOR_VIN_VOLTAGE 12000
+
+typedef struct tic_emulator
+{
+  tic_mutex mutex;
+  uint8_t product;
+
+  uint8_t settings[256];
+
+  uint64_t power_up_us;
+
+  // The time that the state below is valid for.
+  uint64_t now_us;
+
+  uint64_t last_command_us;
+  uint64_t last_step_us;
+
+  uint16_t error_status;
+  uint32_t errors_occurred;
+  bool position_uncertain;
+  uint8_t planning_mode;
+  int32_t target_position;
+  int32_t target_velocity;
+  uint32_t starting_speed;
+  uint32_t max_speed;
+  uint32_t max_decel;
+  uint32_t max_accel;
+  uint8_t step_mode;
+  uint8_t current_limit_code;
+  uint8_t decay_mode;
+  uint8_t agc_options[4];
+
+  bool homing_active;
+  uint8_t homing_direction;
+  bool homing_backing_off;
+
+  // The physical position of the motor, in microsteps, and its velocity, in
+  // microsteps per second.  The current position reported to the host is the
+  // physical position rounded to an integer plus position_offset.
+  double position;
+  double velocity;
+  int32_t position_offset;
+} tic_emulator;
+
+static int32_t tic_emulator_round(double x)
+{
+  return x < 0 ? -(int32_t)(-x + 0.5) : (int32_t)(x + 0.5);
+}
+
+static void tic_emulator_write_u16(uint8_t * p, uint16_t v)
+{
+  p[0] = v >> 0 & 0xFF;
+  p[1] = v >> 8 & 0xFF;
+}
+
+static void tic_emulator_write_u32(uint8_t * p, uint32_t v)
+{
+  tic_emulator_write_u16(p, v & 0xFFFF);
+  tic_emulator_write_u16(p + 2, v >> 16 & 0xFFFF);
+}
+
+static int32_t tic_emulator_current_position(const tic_emulator * emu)
+{
+  return tic_emulator_round(emu->position) + emu->position_offset;
+}
+
+static void tic_emulator_set_error(tic_emulator * emu, uint8_t error_bit)
+{
+  emu->error_status |= 1 << error_bit;
+  emu->errors_occurred |= 1 << error_bit;
+}
+
+static void tic_emulator_clear_error(tic_emulator * emu, uint8_t error_bit)
+{
+  emu->error_status &= ~(1 << error_bit);
+}
+
+static bool tic_emulator_safe_start_enabled(const tic_emulator * emu)
+{
+  return !emu->settings[TIC_SETTING_DISABLE_SAFE_START];
+}
+
+static void tic_emulator_halt(tic_emulator * emu)
+{
+  emu->velocity = 0;
+  emu->planning_mode = TIC_PLANNING_MODE_OFF;
+  emu->homing_active = false;
+}
+
+// Loads the settings that take effect when the Tic starts up or
+// reinitializes.
+static void tic_emulator_load_settings(tic_emulator * emu)
+{
+  const uint8_t * s = emu->settings;
+  emu->step_mode = s[TIC_SETTING_STEP_MODE];
+  emu->current_limit_code = s[TIC_SETTING_CURRENT_LIMIT];
+  emu->decay_mode = s[TIC_SETTING_DECAY_MODE];
+  emu->starting_speed = read_u32(s + TIC_SETTING_STARTING_SPEED);
+  emu->max_speed = read_u32(s + TIC_SETTING_MAX_SPEED);
+  emu->max_accel = read_u32(s + TIC_SETTING_MAX_ACCEL);
+  emu->max_decel = read_u32(s + TIC_SETTING_MAX_DECEL);
+  if (emu->max_decel == 0) { emu->max_decel = emu->max_accel; }
+
+  if (emu->product == TIC_PRODUCT_T249)
+  {
+    emu->agc_options[TIC_AGC_OPTION_MODE] = s[TIC_SETTING_AGC_MODE];
+    emu->agc_options[TIC_AGC_OPTION_BOTTOM_CURRENT_LIMIT] =
+      s[TIC_SETTING_AGC_BOTTOM_CURRENT_LIMIT];
+    emu->agc_options[TIC_AGC_OPTION_CURRENT_BOOST_STEPS] =
+      s[TIC_SETTING_AGC_CURRENT_BOOST_STEPS];
+    emu->agc_options[TIC_AGC_OPTION_FREQUENCY_LIMIT] =
+      s[TIC_SETTING_AGC_FREQUENCY_LIMIT];
+  }
+}
+
+// Puts the emulator into the state a Tic is in after starting up or receiving
+// a Reset command.  The motor does not move, but the Tic no longer knows where
+// it is.
+static void tic_emulator_reset_state(tic_emulator * emu)
+{
+  tic_emulator_halt(emu);
+  emu->target_position = 0;
+  emu->target_velocity = 0;
+  emu->position_uncertain = true;
+  emu->error_status = 0;
+  emu->last_command_us = emu->now_us;
+  tic_emulator_load_settings(emu);
+
+  if (tic_emulator_safe_start_enabled(emu))
+  {
+    tic_emulator_set_error(emu, TIC_ERROR_SAFE_START_VIOLATION);
+  }
+}
+
+static tic_error * tic_emulator_restore_default_settings(tic_emulator * emu)
+{
+  tic_settings * settings = NULL;
+  tic_error * error = tic_settings_create(&settings);
+  if (error == NULL)
+  {
+    tic_settings_set_product(settings, emu->product);
+    tic_settings_set_firmware_version(settings, TIC_EMULATOR_FIRMWARE_VERSION);
+    tic_settings_fill_with_defaults(settings);
+    memset(emu->settings, 0, sizeof(emu->settings));
+    tic_write_settings_to_buffer(settings, emu->settings);
+  }
+  tic_settings_free(settings);
+  return error;
+}
+
+// Returns true if the motor is being held because of an error.  Errors that
+// de-energize the motor also stop it.
+static bool tic_emulator_deenergized(const tic_emulator * emu)
+{
+  uint16_t hard_errors = (1 << TIC_ERROR_INTENTIONALLY_DEENERGIZED) |
+    (1 << TIC_ERROR_MOTOR_DRIVER_ERROR) | (1 << TIC_ERROR_LOW_VIN);
+  if (emu->error_status & hard_errors) { return true; }
+  return emu->error_status &&
+    emu->settings[TIC_SETTING_SOFT_ERROR_RESPONSE] == TIC_RESPONSE_DEENERGIZE;
+}
+
+static uint8_t tic_emulator_operation_state(const tic_emulator * emu)
+{
+  if (tic_emulator_deenergized(emu))
+  {
+    return TIC_OPERATION_STATE_DEENERGIZED;
+  }
+  if (emu->error_status)
+  {
+    return TIC_OPERATION_STATE_SOFT_ERROR;
+  }
+  return TIC_OPERATION_STATE_NORMAL;
+}
+
+// Called when a new error appears.  Errors stop homing, and errors that
+// de-energize the motor also make the Tic lose track of its position.  The
+// rest of the soft error response is applied by tic_emulator_update().
+static void tic_emulator_handle_new_error(tic_emulator * emu)
+{
+  emu->homing_active = false;
+
+  if (tic_emulator_deenergized(emu))
+  {
+    emu->velocity = 0;
+    emu->position_uncertain = true;
+  }
+}
+
+static tic_planner_limits tic_emulator_limits(const tic_emulator * emu)
+{
+  tic_planner_limits limits;
+  limits.max_speed = emu->max_speed;
+  limits.starting_speed = emu->starting_speed;
+  limits.max_accel = emu->max_accel;
+  limits.max_decel = emu->max_decel;
+  return limits;
+}
+
+static void tic_emulator_step_position(tic_emulator * emu,
+  int32_t target_position, double dt)
+{
+  tic_planner_limits limits = tic_emulator_limits(emu);
+  tic_planner_step_position(&limits, &emu->position, &emu->velocity,
+    (double)target_position - emu->position_offset, dt);
+}
+
+// Runs the homing procedure for one tick.  The virtual limit switch is active
+// on the side of physical position 0 that the Tic is homing towards.  The Tic
+// moves towards the switch until it is active, then backs off until it is
+// inactive, and then sets the current position to 0.
+static void tic_emulator_step_homing(tic_emulator * emu, double dt)
+{
+  double direction = emu->homing_direction == TIC_GO_HOME_FORWARD ? 1 : -1;
+  bool switch_active = emu->position * direction > 0;
+
+  if (!emu->homing_backing_off && switch_active)
+  {
+    emu->homing_backing_off = true;
+  }
+
+  if (emu->homing_backing_off && !switch_active)
+  {
+    tic_emulator_halt(emu);
+    emu->position_offset = -tic_emulator_round(emu->position);
+    emu->target_position = 0;
+    emu->position_uncertain = false;
+    return;
+  }
+
+  double desired;
+  if (emu->homing_backing_off)
+  {
+    desired = -direction *
+      read_u32(emu->settings + TIC_SETTING_HOMING_SPEED_AWAY);
+  }
+  else
+  {
+    desired = direction *
+      read_u32(emu->settings + TIC_SETTING_HOMING_SPEED_TOWARDS);
+  }
+  desired /= TIC_SPEED_UNITS_PER_HZ;
+
+  tic_planner_limits limits = tic_emulator_limits(emu);
+  emu->velocity = tic_planner_approach(&limits, emu->velocity, desired, dt);
+  emu->position += emu->velocity * dt;
+}
+
+// Runs the velocity planner for one tick.  The target velocity is in
+// microsteps per 10000 seconds.
+static void tic_emulator_step_velocity(tic_emulator * emu,
+  int32_t target_velocity, double dt)
+{
+  tic_planner_limits limits = tic_emulator_limits(emu);
+  tic_planner_step_velocity(&limits, &emu->position, &emu->velocity,
+    target_velocity / (double)TIC_SPEED_UNITS_PER_HZ, dt);
+}
+
+static bool tic_emulator_at_rest(const tic_emulator * emu)
+{
+  if (emu->velocity != 0 || emu->homing_active) { return false; }
+  if (emu->error_status)
+  {
+    uint8_t response = emu->settings[TIC_SETTING_SOFT_ERROR_RESPONSE];
+    return response != TIC_RESPONSE_GO_TO_POSITION ||
+      tic_emulator_deenergized(emu) || tic_emulator_current_position(emu) ==
+      read_i32(emu->settings + TIC_SETTING_SOFT_ERROR_POSITION);
+  }
+  switch (emu->planning_mode)
+  {
+  case TIC_PLANNING_MODE_TARGET_POSITION:
+    return tic_emulator_current_position(emu) == emu->target_position;
+  case TIC_PLANNING_MODE_TARGET_VELOCITY:
+    return emu->target_velocity == 0;
+  default:
+    return true;
+  }
+}
+
+static void tic_emulator_check_command_timeout(tic_emulator * emu)
+{
+  uint16_t timeout_ms = read_u16(emu->settings + TIC_SETTING_COMMAND_TIMEOUT);
+  if (timeout_ms == 0) { return; }
+  if (emu->error_status & (1 << TIC_ERROR_COMMAND_TIMEOUT)) { return; }
+  if (emu->now_us - emu->last_command_us < (uint64_t)timeout_ms * 1000)
+  {
+    return;
+  }
+  tic_emulator_set_error(emu, TIC_ERROR_COMMAND_TIMEOUT);
+  tic_emulator_handle_new_error(emu);
+}
+
+// Advances the emulator to the specified time.
+static void tic_emulator_update(tic_emulator * emu, uint64_t now)
+{
+  while (emu->now_us < now)
+  {
+    uint64_t dt_us = now - emu->now_us;
+    if (dt_us > TIC_EMULATOR_TICK_US && !tic_emulator_at_rest(emu))
+    {
+      dt_us = TIC_EMULATOR_TICK_US;
+    }
+    double dt = dt_us / 1000000.0;
+
+    int32_t old_position = tic_emulator_current_position(emu);
+
+    // While there is an error, the Tic remembers its targets but follows the
+    // soft error response instead.
+    uint8_t response = emu->settings[TIC_SETTING_SOFT_ERROR_RESPONSE];
+    if (tic_emulator_deenergized(emu) ||
+      (emu->error_status && response == TIC_RESPONSE_HALT_AND_HOLD))
+    {
+      emu->velocity = 0;
+    }
+    else if (emu->error_status && response == TIC_RESPONSE_GO_TO_POSITION)
+    {
+      tic_emulator_step_position(emu,
+        read_i32(emu->settings + TIC_SETTING_SOFT_ERROR_POSITION), dt);
+    }
+    else if (emu->error_status)
+    {
+      tic_emulator_step_velocity(emu, 0, dt);
+    }
+    else if (emu->homing_active)
+    {
+      tic_emulator_step_homing(emu, dt);
+    }
+    else if (emu->planning_mode == TIC_PLANNING_MODE_TARGET_POSITION)
+    {
+      tic_emulator_step_position(emu, emu->target_position, dt);
+    }
+    else if (emu->planning_mode == TIC_PLANNING_MODE_TARGET_VELOCITY)
+    {
+      tic_emulator_step_velocity(emu, emu->target_velocity, dt);
+    }
+
+    emu->now_us += dt_us;
+
+    if (tic_emulator_current_position(emu) != old_position)
+    {
+      emu->last_step_us = emu->now_us;
+    }
+
+    tic_emulator_check_command_timeout(emu);
+  }
+}
+
+static void tic_emulator_write_variables(const tic_emulator * emu,
+  uint8_t * buf)
+{
+  memset(buf, 0, 256);
+
+  buf[TIC_VAR_OPERATION_STATE] = tic_emulator_operation_state(emu);
+
+  bool energized = !tic_emulator_deenergized(emu);
+  buf[TIC_VAR_MISC_FLAGS1] =
+    energized << TIC_MISC_FLAGS1_ENERGIZED |
+    emu->position_uncertain << TIC_MISC_FLAGS1_POSITION_UNCERTAIN |
+    emu->homing_active << TIC_MISC_FLAGS1_HOMING_ACTIVE;
+
+  tic_emulator_write_u16(buf + TIC_VAR_ERROR_STATUS, emu->error_status);
+  tic_emulator_write_u32(buf + TIC_VAR_ERRORS_OCCURRED, emu->errors_occurred);
+  buf[TIC_VAR_PLANNING_MODE] = emu->planning_mode;
+  tic_emulator_write_u32(buf + TIC_VAR_TARGET_POSITION, emu->target_position);
+  tic_emulator_write_u32(buf + TIC_VAR_TARGET_VELOCITY, emu->target_velocity);
+  tic_emulator_write_u32(buf + TIC_VAR_STARTING_SPEED, emu->starting_speed);
+  tic_emulator_write_u32(buf + TIC_VAR_MAX_SPEED, emu->max_speed);
+  tic_emulator_write_u32(buf + TIC_VAR_MAX_DECEL, emu->max_decel);
+  tic_emulator_write_u32(buf + TIC_VAR_MAX_ACCEL, emu->max_accel);
+
+  int32_t position = tic_emulator_current_position(emu);
+  tic_emulator_write_u32(buf + TIC_VAR_CURRENT_POSITION, position);
+  tic_emulator_write_u32(buf + TIC_VAR_CURRENT_VELOCITY,
+    tic_emulator_round(emu->velocity * TIC_SPEED_UNITS_PER_HZ));
+
+  int32_t acting_target = position;
+  if (emu->planning_mode == TIC_PLANNING_MODE_TARGET_POSITION &&
+    !emu->homing_active)
+  {
+    acting_target = emu->target_position;
+  }
+  tic_emulator_write_u32(buf + TIC_VAR_ACTING_TARGET_POSITION, acting_target);
+
+  // Timer ticks are a third of a microsecond.
+  uint64_t ticks = (emu->now_us - emu->last_step_us) * 3;
+  if (ticks > 0xFFFFFFFF) { ticks = 0xFFFFFFFF; }
+  tic_emulator_write_u32(buf + TIC_VAR_TIME_SINCE_LAST_STEP, ticks);
+
+  buf[TIC_VAR_DEVICE_RESET] = TIC_RESET_POWER_UP;
+  tic_emulator_write_u16(buf + TIC_VAR_VIN_VOLTAGE, TIC_EMULATOR_VIN_VOLTAGE);
+  tic_emulator_write_u32(buf + TIC_VAR_UP_TIME,
+    (emu->now_us - emu->power_up_us) / 1000);
+  buf[TIC_VAR_STEP_MODE] = emu->step_mode;
+  buf[TIC_VAR_CURRENT_LIMIT] = emu->current_limit_code;
+  buf[TIC_VAR_DECAY_MODE] = emu->decay_mode;
+  buf[TIC_VAR_INPUT_STATE] = TIC_INPUT_STATE_NOT_READY;
+  tic_emulator_write_u16(buf + TIC_VAR_INPUT_AFTER_AVERAGING, TIC_INPUT_NULL);
+  tic_emulator_write_u16(buf + TIC_VAR_INPUT_AFTER_HYSTERESIS, TIC_INPUT_NULL);
+
+  if (emu->product == TIC_PRODUCT_T249)
+  {
+    buf[TIC_VAR_AGC_MODE] = emu->agc_options[TIC_AGC_OPTION_MODE];
+    buf[TIC_VAR_AGC_BOTTOM_CURRENT_LIMIT] =
+      emu->agc_options[TIC_AGC_OPTION_BOTTOM_CURRENT_LIMIT];
+    buf[TIC_VAR_AGC_CURRENT_BOOST_STEPS] =
+      emu->agc_options[TIC_AGC_OPTION_CURRENT_BOOST_STEPS];
+    buf[TIC_VAR_AGC_FREQUENCY_LIMIT] =
+      emu->agc_options[TIC_AGC_OPTION_FREQUENCY_LIMIT];
+  }
+}
+
+// Copies part of a 256-byte memory map into a read request's buffer.
+static tic_error * tic_emulator_read_map(const uint8_t * map,
+  uint16_t index, void * buffer, uint16_t length, size_t * transferred)
+{
+  if (index + length > 256)
+  {
+    return tic_error_create(
+      "The emulated Tic cannot read %u bytes at offset 0x%x.",
+      length, index);
+  }
+  memcpy(buffer, map + index, length);
+  *transferred = length;
+  return NULL;
+}
+
+// Handles a command that changes the state of the Tic.  All of these reset the
+// command timeout.
+static tic_error * tic_emulator_command(tic_emulator * emu,
+  uint8_t request, uint16_t value, uint16_t index)
+{
+  uint32_t value32 = (uint32_t)index << 16 | value;
+  uint16_t previous_errors = emu->error_status;
+
+  emu->last_command_us = emu->now_us;
+  tic_emulator_clear_error(emu, TIC_ERROR_COMMAND_TIMEOUT);
+
+  switch (request)
+  {
+  case TIC_CMD_SET_TARGET_POSITION:
+    emu->homing_active = false;
+    emu->planning_mode = TIC_PLANNING_MODE_TARGET_POSITION;
+    emu->target_position = (int32_t)value32;
+    break;
+
+  case TIC_CMD_SET_TARGET_VELOCITY:
+    emu->homing_active = false;
+    emu->planning_mode = TIC_PLANNING_MODE_TARGET_VELOCITY;
+    emu->target_velocity = (int32_t)value32;
+    break;
+
+  case TIC_CMD_HALT_AND_SET_POSITION:
+    tic_emulator_halt(emu);
+    emu->position_offset = (int32_t)value32 - tic_emulator_round(emu->position);
+    emu->position_uncertain = false;
+    break;
+
+  case TIC_CMD_HALT_AND_HOLD:
+    tic_emulator_halt(emu);
+    break;
+
+  case TIC_CMD_GO_HOME:
+    emu->planning_mode = TIC_PLANNING_MODE_OFF;
+    emu->homing_active = true;
+    emu->homing_direction = value ? TIC_GO_HOME_FORWARD : TIC_GO_HOME_REVERSE;
+    emu->homing_backing_off = false;
+    break;
+
+  case TIC_CMD_RESET_COMMAND_TIMEOUT:
+    break;
+
+  case TIC_CMD_DEENERGIZE:
+    tic_emulator_set_error(emu, TIC_ERROR_INTENTIONALLY_DEENERGIZED);
+    break;
+
+  case TIC_CMD_ENERGIZE:
+    tic_emulator_clear_error(emu, TIC_ERROR_INTENTIONALLY_DEENERGIZED);
+    break;
+
+  case TIC_CMD_EXIT_SAFE_START:
+    tic_emulator_clear_error(emu, TIC_ERROR_SAFE_START_VIOLATION);
+    break;
+
+  case TIC_CMD_ENTER_SAFE_START:
+    if (tic_emulator_safe_start_enabled(emu))
+    {
+      tic_emulator_set_error(emu, TIC_ERROR_SAFE_START_VIOLATION);
+    }
+    break;
+
+  case TIC_CMD_RESET:
+    tic_emulator_reset_state(emu);
+    break;
+
+  case TIC_CMD_CLEAR_DRIVER_ERROR:
+    tic_emulator_clear_error(emu, TIC_ERROR_MOTOR_DRIVER_ERROR);
+    break;
+
+  case TIC_CMD_SET_MAX_SPEED:
+    emu->max_speed = value32;
+    break;
+
+  case TIC_CMD_SET_STARTING_SPEED:
+    emu->starting_speed = value32;
+    break;
+
+  case TIC_CMD_SET_MAX_ACCEL:
+    emu->max_accel = value32;
+    break;
+
+  case TIC_CMD_SET_MAX_DECEL:
+    emu->max_decel = value32 ? value32 : emu->max_accel;
+    break;
+
+  case TIC_CMD_SET_STEP_MODE:
+    emu->step_mode = value;
+    break;
+
+  case TIC_CMD_SET_CURRENT_LIMIT:
+    emu->current_limit_code = value;
+    break;
+
+  case TIC_CMD_SET_DECAY_MODE:
+    emu->decay_mode = value;
+    break;
+
+  case TIC_CMD_SET_AGC_OPTION:
+    emu->agc_options[value >> 4 & 3] = value & 0x0F;
+    break;
+
+  case TIC_CMD_SET_SETTING:
+    if (index > 0xFF) { break; }
+    emu->settings[index] = value;
+    break;
+
+  case TIC_CMD_REINITIALIZE:
+    if (emu->settings[TIC_SETTING_NOT_INITIALIZED])
+    {
+      tic_error * error = tic_emulator_restore_default_settings(emu);
+      if (error != NULL) { return error; }
+    }
+    tic_emulator_load_settings(emu);
+    break;
+
+  default:
+    return tic_error_create(
+      "The emulated Tic does not support request 0x%02x.", request);
+  }
+
+  if (emu->error_status & ~previous_errors)
+  {
+    tic_emulator_handle_new_error(emu);
+  }
+  return NULL;
+}
+
+static tic_error * tic_emulator_control_transfer(void * context,
+  uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+  void * buffer, uint16_t length, size_t * transferred)
+{
+  tic_emulator * emu = context;
+  tic_error * error = NULL;
+
+  tic_mutex_lock(&emu->mutex);
+
+  tic_emulator_update(emu, tic_monotonic_us());
+
+  if (request_type == 0x80 && request == USB_REQUEST_GET_DESCRIPTOR)
+  {
+    // The firmware modification string, which is just a dash.
+    static const uint8_t descriptor[] = { 4, USB_DESCRIPTOR_TYPE_STRING, '-', 0 };
+    if (length > sizeof(descriptor)) { length = sizeof(descriptor); }
+    memcpy(buffer, descriptor, length);
+    *transferred = length;
+  }
+  else if (request_type == 0xC0 && (request == TIC_CMD_GET_VARIABLE ||
+    request == TIC_CMD_GET_VARIABLE_AND_CLEAR_ERRORS_OCCURRED))
+  {
+    uint8_t variables[256];
+    tic_emulator_write_variables(emu, variables);
+    error = tic_emulator_read_map(variables, index, buffer, length,
+      transferred);
+    if (error == NULL && request == TIC_CMD_GET_VARIABLE_AND_CLEAR_ERRORS_OCCURRED)
+    {
+      // Errors that are still present get flagged again right away.
+      emu->errors_occurred = emu->error_status;
+    }
+  }
+  else if (request_type == 0xC0 && request == TIC_CMD_GET_SETTING)
+  {
+    error = tic_emulator_read_map(emu->settings, index, buffer, length,
+      transferred);
+  }
+  else if (request_type == 0xC0 && request == TIC_CMD_GET_DEBUG_DATA)
+  {
+    *transferred = 0;
+  }
+  else if (request_type == 0x40 && request == TIC_CMD_START_BOOTLOADER)
+  {
+    error = tic_error_create("The emulated Tic does not have a bootloader.");
+  }
+  else if (request_type == 0x40)
+  {
+    error = tic_emulator_command(emu, request, value, index);
+  }
+  else
+  {
+    error = tic_error_create(
+      "The emulated Tic does not support request 0x%02x.", request);
+  }
+
+  tic_mutex_unlock(&emu->mutex);
+
+  return error;
+}
+
+static void tic_emulator_close(void * context)
+{
+  tic_emulator * emu = context;
+  if (emu == NULL) { return; }
+  tic_mutex_destroy(&emu->mutex);
+  free(emu);
+}
+
+const tic_transport tic_emulator_transport =
+{
+  .control_transfer = tic_emulator_control_transfer,
+  .close = tic_emulator_close,
+};
+
+static tic_error * tic_emulator_create(uint8_t product, tic_emulator ** emu)
+{
+  *emu = NULL;
+
+  tic_emulator * new_emu = calloc(1, sizeof(tic_emulator));
+  if (new_emu == NULL)
+  {
+    return &tic_error_no_memory;
+  }
+
+  new_emu->product = product;
+
+  tic_error * error = tic_emulator_restore_default_settings(new_emu);
+  if (error != NULL)
+  {
+    free(new_emu);
+    return error;
+  }
+
+  tic_mutex_init(&new_emu->mutex);
+  new_emu->power_up_us = new_emu->now_us = tic_monotonic_us();
+  new_emu->last_step_us = new_emu->now_us;
+  tic_emulator_reset_state(new_emu);
+
+  *emu = new_emu;
+  return NULL;
+}
+
+tic_error * tic_handle_open_emulated(uint8_t product, tic_handle ** handle)
+{
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle output pointer is null.");
+  }
+
+  *handle = NULL;
+
+  switch (product)
+  {
+  case TIC_PRODUCT_T825:
+  case TIC_PRODUCT_T834:
+  case TIC_PRODUCT_T500:
+  case TIC_PRODUCT_N825:
+  case TIC_PRODUCT_T249:
+  case TIC_PRODUCT_36V4:
+    break;
+  default:
+    return tic_error_create("Invalid product code: %u.", product);
+  }
+
+  // Give each emulated Tic its own serial number so that several of them can
+  // be told apart.
+  static uint32_t emulator_count;
+  uint32_t number = tic_atomic_add_u32(&emulator_count, 1);
+  char serial_number[16];
+  snprintf(serial_number, sizeof(serial_number), "E%07u", number % 10000000);
+
+  tic_error * error = NULL;
+
+  tic_device * device = NULL;
+  if (error == NULL)
+  {
+    error = tic_device_create_without_usb(product,
+      TIC_EMULATOR_FIRMWARE_VERSION, serial_number, "emulated", &device);
+  }
+
+  tic_emulator * emu = NULL;
+  if (error == NULL)
+  {
+    error = tic_emulator_create(product, &emu);
+  }
+
+  if (error == NULL)
+  {
+    error = tic_handle_open_transport(device, &tic_emulator_transport,
+      emu, handle);
+  }
+
+  tic_device_free(device);
+
+  if (error != NULL)
+  {
+    error = tic_error_add(error,
+      "There was an error opening an emulated Tic.");
+  }
+
+  return error;
+}
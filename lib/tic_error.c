@@ -28,6 +28,19 @@ tic_error tic_error_no_memory =
   .code_array = tic_mem_error_code_array,
 };
 
+static uint32_t tic_device_disconnected_code_array[1] =
+  { TIC_ERROR_DEVICE_DISCONNECTED };
+
+static char tic_error_device_disconnected_msg[] =
+  "The device was disconnected.";
+tic_error tic_error_device_disconnected =
+{
+  .do_not_free = true,
+  .message = tic_error_device_disconnected_msg,
+  .code_count = 1,
+  .code_array = tic_device_disconnected_code_array,
+};
+
 static char tic_error_masked_by_no_memory_msg[] =
   "Failed to allocate memory for reporting an error.";
 static tic_error tic_error_masked_by_no_memory =
@@ -226,6 +239,22 @@ const char * tic_error_get_message(const tic_error * error)
   return error->message;
 }
 
+// Like tic_usb_error, but if the error indicates that the device was
+// disconnected, returns tic_error_device_disconnected instead of allocating a
+// new error.  This keeps the error path of fast polling loops cheap.
+tic_error * tic_usb_error_quiet(libusbp_error * usb_error)
+{
+  if (usb_error == NULL) { return NULL; }
+
+  if (libusbp_error_has_code(usb_error, LIBUSBP_ERROR_DEVICE_DISCONNECTED))
+  {
+    libusbp_error_free(usb_error);
+    return &tic_error_device_disconnected;
+  }
+
+  return tic_usb_error(usb_error);
+}
+
 // Convert a libusbp_error into a tic_error and free the libusbp_error.
 tic_error * tic_usb_error(libusbp_error * usb_error)
 {
@@ -0,0 +1,271 @@
+// Functions for predicting where the motor is between reads of the variables.
+//
+// The estimator keeps the last snapshot of the variables and, when asked for
+// a prediction, runs the same planner model as the emulator forward from the
+// snapshot in 1 ms ticks.  Long stretches where nothing changes (holding
+// still, cruising at a constant speed) are skipped over in one step, so a
+// prediction usually costs a few hundred ticks at most.
+//
+// Because the estimator and the emulator share the planner model, the tests
+// check the estimator against ideal profiles computed in closed form instead
+// of against the emulator.
+
+#include "tic_internal.h"
+
+#define TIC_ESTIMATOR_TICK_US 1000
+
+// We stop simulating after this many ticks and assume the velocity stays the
+// same after that, so a prediction far in the future has a bounded cost.
+#define TIC_ESTIMATOR_MAX_TICKS 100000
+
+// What the estimator thinks the Tic's planner is doing.
+#define TIC_ESTIMATOR_HOLD 0
+#define TIC_ESTIMATOR_POSITION 1
+#define TIC_ESTIMATOR_VELOCITY 2
+#define TIC_ESTIMATOR_CONSTANT_VELOCITY 3
+
+struct tic_estimator
+{
+  bool valid;
+  uint64_t time_us;
+  uint8_t mode;
+  tic_planner_limits limits;
+  double target_position;
+  double target_velocity;
+  double position;
+  double velocity;
+
+  uint32_t update_count;
+  double last_error;
+  double max_error;
+};
+
+static double tic_estimator_abs(double x)
+{
+  return x < 0 ? -x : x;
+}
+
+tic_error * tic_estimator_create(tic_estimator ** estimator)
+{
+  if (estimator == NULL)
+  {
+    return tic_error_create("Estimator output pointer is null.");
+  }
+
+  *estimator = calloc(1, sizeof(tic_estimator));
+  if (*estimator == NULL)
+  {
+    return &tic_error_no_memory;
+  }
+
+  return NULL;
+}
+
+void tic_estimator_free(tic_estimator * estimator)
+{
+  free(estimator);
+}
+
+// Advances the state by dt seconds, where dt is at most one tick.
+static void tic_estimator_step(const tic_estimator * est,
+  double * position, double * velocity, double dt)
+{
+  switch (est->mode)
+  {
+  case TIC_ESTIMATOR_POSITION:
+    tic_planner_step_position(&est->limits, position, velocity,
+      est->target_position, dt);
+    break;
+
+  case TIC_ESTIMATOR_VELOCITY:
+    tic_planner_step_velocity(&est->limits, position, velocity,
+      est->target_velocity, dt);
+    break;
+
+  case TIC_ESTIMATOR_CONSTANT_VELOCITY:
+    *position += *velocity * dt;
+    break;
+  }
+}
+
+// Returns how many seconds we can skip ahead with the velocity staying the
+// same, or 0 if the velocity might change on the next tick.
+static double tic_estimator_steady_time(const tic_estimator * est,
+  double position, double velocity)
+{
+  switch (est->mode)
+  {
+  case TIC_ESTIMATOR_HOLD:
+  case TIC_ESTIMATOR_CONSTANT_VELOCITY:
+    return -1;
+
+  case TIC_ESTIMATOR_VELOCITY:
+  {
+    double max_speed = est->limits.max_speed / (double)TIC_SPEED_UNITS_PER_HZ;
+    double desired = est->target_velocity;
+    if (desired > max_speed) { desired = max_speed; }
+    if (desired < -max_speed) { desired = -max_speed; }
+    return velocity == desired ? -1 : 0;
+  }
+
+  case TIC_ESTIMATOR_POSITION:
+  {
+    double distance = est->target_position - position;
+    if (distance == 0 && velocity == 0) { return -1; }
+
+    // If we are cruising toward the target, we can skip ahead to a little
+    // before the point where we need to start slowing down.
+    double max_speed = est->limits.max_speed / (double)TIC_SPEED_UNITS_PER_HZ;
+    double decel = est->limits.max_decel / (double)TIC_ACCEL_UNITS_PER_HZ2;
+    double speed = tic_estimator_abs(velocity);
+    if (speed != max_speed || speed == 0 || velocity * distance <= 0)
+    {
+      return 0;
+    }
+    double braking_distance = speed * speed / (2 * decel);
+    double cruise_distance = tic_estimator_abs(distance) - braking_distance -
+      2 * speed * TIC_ESTIMATOR_TICK_US / 1000000.0;
+    return cruise_distance > 0 ? cruise_distance / speed : 0;
+  }
+  }
+
+  return 0;
+}
+
+// Predicts the position (in microsteps) and velocity (in microsteps per
+// second) at the specified time.
+static void tic_estimator_run(const tic_estimator * est, uint64_t time_us,
+  double * position, double * velocity)
+{
+  *position = est->position;
+  *velocity = est->velocity;
+  if (time_us <= est->time_us) { return; }
+
+  double remaining = (time_us - est->time_us) / 1000000.0;
+  double tick = TIC_ESTIMATOR_TICK_US / 1000000.0;
+
+  for (uint32_t i = 0; remaining > 0; i++)
+  {
+    double steady_time = tic_estimator_steady_time(est, *position, *velocity);
+    if (steady_time < 0 || i >= TIC_ESTIMATOR_MAX_TICKS)
+    {
+      // Nothing will change from now on.
+      *position += *velocity * remaining;
+      return;
+    }
+
+    if (steady_time > 0)
+    {
+      double dt = steady_time < remaining ? steady_time : remaining;
+      *position += *velocity * dt;
+      remaining -= dt;
+      continue;
+    }
+
+    double dt = tick < remaining ? tick : remaining;
+    tic_estimator_step(est, position, velocity, dt);
+    remaining -= dt;
+  }
+}
+
+void tic_estimator_update(tic_estimator * est,
+  const tic_variables * variables, uint64_t host_time_us)
+{
+  if (est == NULL || variables == NULL) { return; }
+
+  double actual = tic_variables_get_current_position(variables);
+
+  if (est->valid)
+  {
+    double predicted, velocity;
+    tic_estimator_run(est, host_time_us, &predicted, &velocity);
+    est->last_error = actual - predicted;
+    double abs_error = tic_estimator_abs(est->last_error);
+    if (abs_error > est->max_error) { est->max_error = abs_error; }
+    est->update_count++;
+  }
+
+  est->valid = true;
+  est->time_us = host_time_us;
+  est->position = actual;
+  est->velocity = tic_variables_get_current_velocity(variables) /
+    (double)TIC_SPEED_UNITS_PER_HZ;
+  est->limits.max_speed = tic_variables_get_max_speed(variables);
+  est->limits.starting_speed = tic_variables_get_starting_speed(variables);
+  est->limits.max_accel = tic_variables_get_max_accel(variables);
+  est->limits.max_decel = tic_variables_get_max_decel(variables);
+  est->target_position = tic_variables_get_target_position(variables);
+  est->target_velocity = tic_variables_get_target_velocity(variables) /
+    (double)TIC_SPEED_UNITS_PER_HZ;
+
+  uint8_t state = tic_variables_get_operation_state(variables);
+  uint8_t planning_mode = tic_variables_get_planning_mode(variables);
+  if (state == TIC_OPERATION_STATE_RESET ||
+    state == TIC_OPERATION_STATE_DEENERGIZED)
+  {
+    // The motor is not being driven, so the position does not change.
+    est->mode = TIC_ESTIMATOR_HOLD;
+    est->velocity = 0;
+  }
+  else if (state != TIC_OPERATION_STATE_NORMAL)
+  {
+    // Assume the default soft error response: decelerate to a stop.
+    est->mode = TIC_ESTIMATOR_VELOCITY;
+    est->target_velocity = 0;
+  }
+  else if (tic_variables_get_homing_active(variables))
+  {
+    // We do not know where the limit switch is.
+    est->mode = TIC_ESTIMATOR_CONSTANT_VELOCITY;
+  }
+  else if (planning_mode == TIC_PLANNING_MODE_TARGET_POSITION)
+  {
+    est->mode = TIC_ESTIMATOR_POSITION;
+  }
+  else if (planning_mode == TIC_PLANNING_MODE_TARGET_VELOCITY)
+  {
+    est->mode = TIC_ESTIMATOR_VELOCITY;
+  }
+  else
+  {
+    est->mode = TIC_ESTIMATOR_HOLD;
+    est->velocity = 0;
+  }
+}
+
+bool tic_estimator_predict(const tic_estimator * est, uint64_t host_time_us,
+  double * position, double * velocity)
+{
+  double p = 0, v = 0;
+  bool valid = est != NULL && est->valid;
+  if (valid) { tic_estimator_run(est, host_time_us, &p, &v); }
+  if (position) { *position = p; }
+  if (velocity) { *velocity = v * TIC_SPEED_UNITS_PER_HZ; }
+  return valid;
+}
+
+uint32_t tic_estimator_get_update_count(const tic_estimator * est)
+{
+  if (est == NULL) { return 0; }
+  return est->update_count;
+}
+
+double tic_estimator_get_last_error(const tic_estimator * est)
+{
+  if (est == NULL) { return 0; }
+  return est->last_error;
+}
+
+double tic_estimator_get_max_error(const tic_estimator * est)
+{
+  if (est == NULL) { return 0; }
+  return est->max_error;
+}
+
+void tic_estimator_clear_stats(tic_estimator * est)
+{
+  if (est == NULL) { return; }
+  est->update_count = 0;
+  est->last_error = 0;
+  est->max_error = 0;
+}
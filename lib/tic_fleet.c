@@ -0,0 +1,383 @@
+// Functions for polling several Tics in parallel.
+
+#include "tic_internal.h"
+
+typedef struct tic_fleet_device
+{
+  tic_handle * handle;
+
+  // The following members are protected by the fleet's mutex, except that
+  // while busy is true the worker that is reading from the device owns
+  // work_variables and work_error.
+  bool queued;
+  bool busy;
+  bool has_result;
+  tic_variables * work_variables;
+  tic_error * work_error;
+  uint64_t work_start_us;
+  uint64_t work_end_us;
+
+  // The snapshot, which is only touched by tic_fleet_poll() and the getters.
+  tic_variables * variables;
+  tic_error * error;
+  uint8_t status;
+  uint32_t latency_us;
+  uint64_t sample_time_us;
+} tic_fleet_device;
+
+struct tic_fleet
+{
+  tic_fleet_device * devices;
+  size_t device_count;
+  uint32_t fields;
+
+  tic_thread * workers;
+  size_t worker_count;
+
+  tic_mutex mutex;
+  tic_cond work_available;
+  tic_cond work_done;
+  bool stop_requested;
+
+  // Queue of device indices waiting for a worker.  Each device is in the queue
+  // at most once, so it never holds more than device_count entries.
+  size_t * queue;
+  size_t queue_head;
+  size_t queue_length;
+
+  uint32_t cycle_count;
+  uint64_t cycle_time_us;
+};
+
+static void * tic_fleet_worker(void * arg)
+{
+  tic_fleet * fleet = arg;
+
+  tic_mutex_lock(&fleet->mutex);
+  while (true)
+  {
+    while (!fleet->stop_requested && fleet->queue_length == 0)
+    {
+      tic_cond_wait(&fleet->work_available, &fleet->mutex);
+    }
+    if (fleet->stop_requested) { break; }
+
+    size_t index = fleet->queue[fleet->queue_head];
+    fleet->queue_head = (fleet->queue_head + 1) % fleet->device_count;
+    fleet->queue_length--;
+
+    tic_fleet_device * device = &fleet->devices[index];
+    device->queued = false;
+    device->busy = true;
+    tic_mutex_unlock(&fleet->mutex);
+
+    // Do the I/O without holding the mutex so that a device that is slow to
+    // respond only ties up this worker.
+    uint64_t start = tic_monotonic_us();
+    tic_error * error = tic_get_variables_fields(device->handle,
+      device->work_variables, fleet->fields, false);
+    uint64_t end = tic_monotonic_us();
+
+    tic_mutex_lock(&fleet->mutex);
+    tic_error_free(device->work_error);
+    device->work_error = error;
+    device->work_start_us = start;
+    device->work_end_us = end;
+    device->busy = false;
+    device->has_result = true;
+    tic_cond_broadcast(&fleet->work_done);
+  }
+  tic_mutex_unlock(&fleet->mutex);
+  return NULL;
+}
+
+static void tic_fleet_stop_workers(tic_fleet * fleet)
+{
+  tic_mutex_lock(&fleet->mutex);
+  fleet->stop_requested = true;
+  tic_cond_broadcast(&fleet->work_available);
+  tic_mutex_unlock(&fleet->mutex);
+
+  for (size_t i = 0; i < fleet->worker_count; i++)
+  {
+    tic_thread_join(fleet->workers[i]);
+  }
+  fleet->worker_count = 0;
+}
+
+tic_error * tic_fleet_create(tic_handle * const * handles, size_t handle_count,
+  size_t worker_count, uint32_t fields, tic_fleet ** fleet)
+{
+  if (fleet == NULL)
+  {
+    return tic_error_create("Fleet output pointer is null.");
+  }
+
+  *fleet = NULL;
+
+  if (handle_count == 0)
+  {
+    return tic_error_create("No handles were specified.");
+  }
+
+  if (handles == NULL)
+  {
+    return tic_error_create("Handle list is null.");
+  }
+
+  for (size_t i = 0; i < handle_count; i++)
+  {
+    if (handles[i] == NULL)
+    {
+      return tic_error_create("Handle %u is null.", (unsigned int)i);
+    }
+  }
+
+  if (worker_count == 0 || worker_count > handle_count)
+  {
+    worker_count = handle_count;
+  }
+
+  tic_error * error = NULL;
+
+  tic_fleet * new_fleet = NULL;
+  bool sync_initialized = false;
+
+  if (error == NULL)
+  {
+    new_fleet = calloc(1, sizeof(tic_fleet));
+    if (new_fleet == NULL) { error = &tic_error_no_memory; }
+  }
+
+  if (error == NULL)
+  {
+    new_fleet->fields = fields;
+    new_fleet->device_count = handle_count;
+    new_fleet->devices = calloc(handle_count, sizeof(tic_fleet_device));
+    new_fleet->queue = calloc(handle_count, sizeof(size_t));
+    new_fleet->workers = calloc(worker_count, sizeof(tic_thread));
+    if (new_fleet->devices == NULL || new_fleet->queue == NULL ||
+      new_fleet->workers == NULL)
+    {
+      error = &tic_error_no_memory;
+    }
+  }
+
+  for (size_t i = 0; error == NULL && i < handle_count; i++)
+  {
+    tic_fleet_device * device = &new_fleet->devices[i];
+    device->handle = handles[i];
+    device->status = TIC_FLEET_STATUS_NO_DATA;
+    error = tic_variables_create(&device->work_variables);
+    if (error == NULL)
+    {
+      error = tic_variables_create(&device->variables);
+    }
+  }
+
+  if (error == NULL)
+  {
+    tic_mutex_init(&new_fleet->mutex);
+    tic_cond_init(&new_fleet->work_available);
+    tic_cond_init(&new_fleet->work_done);
+    sync_initialized = true;
+  }
+
+  while (error == NULL && new_fleet->worker_count < worker_count)
+  {
+    int result = tic_thread_create(
+      &new_fleet->workers[new_fleet->worker_count],
+      tic_fleet_worker, new_fleet);
+    if (result != 0)
+    {
+      error = tic_error_create(
+        "Failed to start a fleet worker thread.  Error code %d.", result);
+      break;
+    }
+    new_fleet->worker_count++;
+  }
+
+  if (error == NULL)
+  {
+    *fleet = new_fleet;
+    new_fleet = NULL;
+  }
+
+  if (new_fleet != NULL && sync_initialized)
+  {
+    tic_fleet_free(new_fleet);
+  }
+  else if (new_fleet != NULL)
+  {
+    if (new_fleet->devices != NULL)
+    {
+      for (size_t i = 0; i < handle_count; i++)
+      {
+        tic_variables_free(new_fleet->devices[i].work_variables);
+        tic_variables_free(new_fleet->devices[i].variables);
+      }
+    }
+    free(new_fleet->devices);
+    free(new_fleet->queue);
+    free(new_fleet->workers);
+    free(new_fleet);
+  }
+
+  return error;
+}
+
+void tic_fleet_free(tic_fleet * fleet)
+{
+  if (fleet == NULL) { return; }
+
+  tic_fleet_stop_workers(fleet);
+
+  tic_cond_destroy(&fleet->work_done);
+  tic_cond_destroy(&fleet->work_available);
+  tic_mutex_destroy(&fleet->mutex);
+
+  for (size_t i = 0; i < fleet->device_count; i++)
+  {
+    tic_fleet_device * device = &fleet->devices[i];
+    tic_variables_free(device->work_variables);
+    tic_variables_free(device->variables);
+    tic_error_free(device->work_error);
+    tic_error_free(device->error);
+  }
+  free(fleet->devices);
+  free(fleet->queue);
+  free(fleet->workers);
+  free(fleet);
+}
+
+// Must be called with the mutex held.
+static bool tic_fleet_all_done(const tic_fleet * fleet)
+{
+  for (size_t i = 0; i < fleet->device_count; i++)
+  {
+    const tic_fleet_device * device = &fleet->devices[i];
+    if (device->queued || device->busy) { return false; }
+  }
+  return true;
+}
+
+tic_error * tic_fleet_poll(tic_fleet * fleet, uint32_t timeout_ms)
+{
+  if (fleet == NULL)
+  {
+    return tic_error_create("Fleet is null.");
+  }
+
+  uint64_t start = tic_monotonic_us();
+  uint64_t deadline = start + (uint64_t)timeout_ms * 1000;
+
+  tic_mutex_lock(&fleet->mutex);
+
+  // Queue a read for every device that is not still busy with a read from an
+  // earlier cycle.
+  for (size_t i = 0; i < fleet->device_count; i++)
+  {
+    tic_fleet_device * device = &fleet->devices[i];
+    if (device->queued || device->busy) { continue; }
+    size_t tail = (fleet->queue_head + fleet->queue_length) % fleet->device_count;
+    fleet->queue[tail] = i;
+    fleet->queue_length++;
+    device->queued = true;
+  }
+  tic_cond_broadcast(&fleet->work_available);
+
+  // Wait for the reads to finish, or for the timeout.
+  while (!tic_fleet_all_done(fleet))
+  {
+    uint64_t now = tic_monotonic_us();
+    if (now >= deadline) { break; }
+    tic_cond_wait_us(&fleet->work_done, &fleet->mutex, deadline - now);
+  }
+
+  // Publish the snapshot.
+  for (size_t i = 0; i < fleet->device_count; i++)
+  {
+    tic_fleet_device * device = &fleet->devices[i];
+    if (device->queued || device->busy)
+    {
+      device->status = TIC_FLEET_STATUS_STALLED;
+      continue;
+    }
+
+    if (!device->has_result) { continue; }
+    device->has_result = false;
+
+    device->latency_us = (uint32_t)(device->work_end_us - device->work_start_us);
+    device->sample_time_us = device->work_end_us;
+    tic_error_free(device->error);
+    device->error = device->work_error;
+    device->work_error = NULL;
+    if (device->error == NULL)
+    {
+      tic_variables_copy_into(device->variables, device->work_variables);
+      device->status = TIC_FLEET_STATUS_OK;
+    }
+    else
+    {
+      device->status = TIC_FLEET_STATUS_ERROR;
+    }
+  }
+
+  tic_mutex_unlock(&fleet->mutex);
+
+  fleet->cycle_count++;
+  fleet->cycle_time_us = tic_monotonic_us() - start;
+  return NULL;
+}
+
+size_t tic_fleet_get_device_count(const tic_fleet * fleet)
+{
+  if (fleet == NULL) { return 0; }
+  return fleet->device_count;
+}
+
+uint32_t tic_fleet_get_cycle_count(const tic_fleet * fleet)
+{
+  if (fleet == NULL) { return 0; }
+  return fleet->cycle_count;
+}
+
+uint32_t tic_fleet_get_cycle_time_us(const tic_fleet * fleet)
+{
+  if (fleet == NULL) { return 0; }
+  return (uint32_t)fleet->cycle_time_us;
+}
+
+uint8_t tic_fleet_get_status(const tic_fleet * fleet, size_t index)
+{
+  if (fleet == NULL || index >= fleet->device_count)
+  {
+    return TIC_FLEET_STATUS_NO_DATA;
+  }
+  return fleet->devices[index].status;
+}
+
+const tic_variables * tic_fleet_get_variables(const tic_fleet * fleet,
+  size_t index)
+{
+  if (fleet == NULL || index >= fleet->device_count) { return NULL; }
+  return fleet->devices[index].variables;
+}
+
+const tic_error * tic_fleet_get_error(const tic_fleet * fleet, size_t index)
+{
+  if (fleet == NULL || index >= fleet->device_count) { return NULL; }
+  return fleet->devices[index].error;
+}
+
+uint32_t tic_fleet_get_latency_us(const tic_fleet * fleet, size_t index)
+{
+  if (fleet == NULL || index >= fleet->device_count) { return 0; }
+  return fleet->devices[index].latency_us;
+}
+
+uint64_t tic_fleet_get_sample_time_us(const tic_fleet * fleet, size_t index)
+{
+  if (fleet == NULL || index >= fleet->device_count) { return 0; }
+  return fleet->devices[index].sample_time_us;
+}
@@ -1,14 +1,102 @@
-// Functions for communicating with Tic devices over USB.
+// Functions for communicating with Tic devices.
 
 #include "tic_internal.h"
 
+// Statistics for the control transfers with one request code.
+typedef struct tic_io_counters
+{
+  uint32_t transfer_count;
+  uint32_t error_count;
+  uint32_t timeout_count;
+  uint32_t max_latency_us;
+  uint64_t byte_count;
+  uint64_t total_latency_us;
+  uint32_t latency_histogram[TIC_HANDLE_STATS_HISTOGRAM_SIZE];
+} tic_io_counters;
+
+struct tic_handle_stats
+{
+  tic_io_counters counters[256];
+  uint64_t first_transfer_latency_us;
+};
+
 struct tic_handle
 {
-  libusbp_generic_handle * usb_handle;
+  const tic_transport * transport;
+  void * transport_context;
   tic_device * device;
   char * cached_firmware_version_string;
+
+  // Transfer statistics for each request code, allocated the first time a
+  // request with that code is sent.  These are written only by the thread
+  // using the handle, but can be read from any thread.
+  tic_io_counters * io_counters[256];
+
+  // The time taken by the first transfer, which includes any work the
+  // operating system or device does when a handle is first used.
+  bool first_transfer_done;
+  uint64_t first_transfer_latency_us;
 };
 
+static tic_error * tic_usb_control_transfer(void * context,
+  uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+  void * buffer, uint16_t length, size_t * transferred)
+{
+  return tic_usb_error_quiet(libusbp_control_transfer(context,
+    request_type, request, value, index, buffer, length, transferred));
+}
+
+static void tic_usb_close(void * context)
+{
+  libusbp_generic_handle_close(context);
+}
+
+static const tic_transport tic_usb_transport =
+{
+  .control_transfer = tic_usb_control_transfer,
+  .close = tic_usb_close,
+};
+
+tic_error * tic_handle_open_transport(const tic_device * device,
+  const tic_transport * transport, void * context, tic_handle ** handle)
+{
+  assert(device != NULL);
+  assert(transport != NULL);
+  assert(handle != NULL);
+
+  *handle = NULL;
+
+  tic_error * error = NULL;
+
+  tic_handle * new_handle = calloc(1, sizeof(tic_handle));
+  if (new_handle == NULL)
+  {
+    error = &tic_error_no_memory;
+  }
+
+  if (error == NULL)
+  {
+    error = tic_device_copy(device, &new_handle->device);
+  }
+
+  if (error == NULL)
+  {
+    // Success.  The handle owns the transport context from now on.
+    new_handle->transport = transport;
+    new_handle->transport_context = context;
+    *handle = new_handle;
+    new_handle = NULL;
+  }
+  else
+  {
+    transport->close(context);
+  }
+
+  tic_handle_close(new_handle);
+
+  return error;
+}
+
 tic_error * tic_handle_open(const tic_device * device, tic_handle ** handle)
 {
   if (handle == NULL)
@@ -37,28 +125,18 @@ tic_error * tic_handle_open(const tic_device * device, tic_handle ** handle)
     }
   }
 
-  tic_handle * new_handle = NULL;
-  if (error == NULL)
+  const libusbp_generic_interface * usb_interface =
+    tic_device_get_generic_interface(device);
+  if (error == NULL && usb_interface == NULL)
   {
-    new_handle = calloc(1, sizeof(tic_handle));
-    if (new_handle == NULL)
-    {
-      error = &tic_error_no_memory;
-    }
+    error = tic_error_create("The device is not connected over USB.");
   }
 
+  libusbp_generic_handle * usb_handle = NULL;
   if (error == NULL)
   {
-    error = tic_device_copy(device, &new_handle->device);
-  }
-
-
-  if (error == NULL)
-  {
-    const libusbp_generic_interface * usb_interface =
-      tic_device_get_generic_interface(device);
     error = tic_usb_error(libusbp_generic_handle_open(
-        usb_interface, &new_handle->usb_handle));
+        usb_interface, &usb_handle));
   }
 
   if (error == NULL)
@@ -68,17 +146,17 @@ tic_error * tic_handle_open(const tic_device * device, tic_handle ** handle)
     // long the Tic might take to respond after restoring its settings to their
     // defaults.
     error = tic_usb_error(libusbp_generic_handle_set_timeout(
-        new_handle->usb_handle, 0, 1600));
+        usb_handle, 0, 1600));
   }
 
   if (error == NULL)
   {
-    // Success.  Pass the handle to the caller.
-    *handle = new_handle;
-    new_handle = NULL;
+    error = tic_handle_open_transport(device, &tic_usb_transport,
+      usb_handle, handle);
+    usb_handle = NULL;
   }
 
-  tic_handle_close(new_handle);
+  libusbp_generic_handle_close(usb_handle);
 
   return error;
 }
@@ -87,13 +165,221 @@ void tic_handle_close(tic_handle * handle)
 {
   if (handle != NULL)
   {
-    libusbp_generic_handle_close(handle->usb_handle);
+    if (handle->transport != NULL)
+    {
+      handle->transport->close(handle->transport_context);
+    }
     tic_device_free(handle->device);
     free(handle->cached_firmware_version_string);
+    for (size_t i = 0; i < 256; i++) { free(handle->io_counters[i]); }
     free(handle);
   }
 }
 
+tic_error * tic_handle_control_transfer(tic_handle * handle,
+  uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+  void * buffer, uint16_t length, size_t * transferred)
+{
+  assert(handle != NULL);
+  size_t ignored;
+  if (transferred == NULL) { transferred = &ignored; }
+  *transferred = 0;
+
+  uint64_t start = tic_monotonic_us();
+  tic_error * error = handle->transport->control_transfer(
+    handle->transport_context, request_type, request, value, index,
+    buffer, length, transferred);
+  uint64_t end = tic_monotonic_us();
+
+  if (!handle->first_transfer_done)
+  {
+    handle->first_transfer_done = true;
+    tic_atomic_store_u64(&handle->first_transfer_latency_us, end - start);
+  }
+
+  tic_io_counters * counters = handle->io_counters[request];
+  if (counters == NULL)
+  {
+    // If this fails, we just do not keep statistics for this request.
+    counters = calloc(1, sizeof(tic_io_counters));
+    tic_atomic_store_ptr((void **)&handle->io_counters[request], counters);
+  }
+
+  if (counters != NULL)
+  {
+    tic_atomic_add_u32(&counters->transfer_count, 1);
+    tic_atomic_add_u64(&counters->byte_count, *transferred);
+    tic_atomic_add_u64(&counters->total_latency_us, end - start);
+    tic_latency_record(counters->latency_histogram,
+      TIC_HANDLE_STATS_HISTOGRAM_SIZE, &counters->max_latency_us, end - start);
+    if (error != NULL)
+    {
+      tic_atomic_add_u32(&counters->error_count, 1);
+      if (tic_error_has_code(error, TIC_ERROR_TIMEOUT))
+      {
+        tic_atomic_add_u32(&counters->timeout_count, 1);
+      }
+    }
+  }
+
+  return error;
+}
+
+tic_error * tic_handle_get_stats(const tic_handle * handle,
+  tic_handle_stats ** stats)
+{
+  if (stats == NULL)
+  {
+    return tic_error_create("Stats output pointer is null.");
+  }
+
+  *stats = NULL;
+
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle is null.");
+  }
+
+  tic_handle_stats * new_stats = calloc(1, sizeof(tic_handle_stats));
+  if (new_stats == NULL)
+  {
+    return &tic_error_no_memory;
+  }
+
+  new_stats->first_transfer_latency_us =
+    tic_atomic_load_u64(&handle->first_transfer_latency_us);
+
+  for (size_t i = 0; i < 256; i++)
+  {
+    tic_io_counters * src =
+      tic_atomic_load_ptr((void * const *)&handle->io_counters[i]);
+    if (src == NULL) { continue; }
+    tic_io_counters * dest = &new_stats->counters[i];
+    dest->transfer_count = tic_atomic_load_u32(&src->transfer_count);
+    dest->error_count = tic_atomic_load_u32(&src->error_count);
+    dest->timeout_count = tic_atomic_load_u32(&src->timeout_count);
+    dest->max_latency_us = tic_atomic_load_u32(&src->max_latency_us);
+    dest->byte_count = tic_atomic_load_u64(&src->byte_count);
+    dest->total_latency_us = tic_atomic_load_u64(&src->total_latency_us);
+    for (size_t j = 0; j < TIC_HANDLE_STATS_HISTOGRAM_SIZE; j++)
+    {
+      dest->latency_histogram[j] =
+        tic_atomic_load_u32(&src->latency_histogram[j]);
+    }
+  }
+
+  *stats = new_stats;
+  return NULL;
+}
+
+void tic_handle_reset_stats(tic_handle * handle)
+{
+  if (handle == NULL) { return; }
+
+  for (size_t i = 0; i < 256; i++)
+  {
+    tic_io_counters * counters = handle->io_counters[i];
+    if (counters == NULL) { continue; }
+    tic_atomic_store_u32(&counters->transfer_count, 0);
+    tic_atomic_store_u32(&counters->error_count, 0);
+    tic_atomic_store_u32(&counters->timeout_count, 0);
+    tic_atomic_store_u32(&counters->max_latency_us, 0);
+    tic_atomic_store_u64(&counters->byte_count, 0);
+    tic_atomic_store_u64(&counters->total_latency_us, 0);
+    for (size_t j = 0; j < TIC_HANDLE_STATS_HISTOGRAM_SIZE; j++)
+    {
+      tic_atomic_store_u32(&counters->latency_histogram[j], 0);
+    }
+  }
+}
+
+tic_error * tic_handle_stats_copy(const tic_handle_stats * source,
+  tic_handle_stats ** dest)
+{
+  if (dest == NULL)
+  {
+    return tic_error_create("Stats output pointer is null.");
+  }
+
+  *dest = NULL;
+
+  if (source == NULL) { return NULL; }
+
+  tic_handle_stats * new_stats = malloc(sizeof(tic_handle_stats));
+  if (new_stats == NULL)
+  {
+    return &tic_error_no_memory;
+  }
+
+  memcpy(new_stats, source, sizeof(tic_handle_stats));
+  *dest = new_stats;
+  return NULL;
+}
+
+void tic_handle_stats_free(tic_handle_stats * stats)
+{
+  free(stats);
+}
+
+uint32_t tic_handle_stats_get_transfer_count(const tic_handle_stats * stats,
+  uint8_t request)
+{
+  if (stats == NULL) { return 0; }
+  return stats->counters[request].transfer_count;
+}
+
+uint64_t tic_handle_stats_get_byte_count(const tic_handle_stats * stats,
+  uint8_t request)
+{
+  if (stats == NULL) { return 0; }
+  return stats->counters[request].byte_count;
+}
+
+uint32_t tic_handle_stats_get_error_count(const tic_handle_stats * stats,
+  uint8_t request)
+{
+  if (stats == NULL) { return 0; }
+  return stats->counters[request].error_count;
+}
+
+uint32_t tic_handle_stats_get_timeout_count(const tic_handle_stats * stats,
+  uint8_t request)
+{
+  if (stats == NULL) { return 0; }
+  return stats->counters[request].timeout_count;
+}
+
+uint64_t tic_handle_stats_get_total_latency_us(const tic_handle_stats * stats,
+  uint8_t request)
+{
+  if (stats == NULL) { return 0; }
+  return stats->counters[request].total_latency_us;
+}
+
+uint32_t tic_handle_stats_get_max_latency_us(const tic_handle_stats * stats,
+  uint8_t request)
+{
+  if (stats == NULL) { return 0; }
+  return stats->counters[request].max_latency_us;
+}
+
+void tic_handle_stats_get_latency_histogram(const tic_handle_stats * stats,
+  uint8_t request, uint32_t * counts)
+{
+  for (size_t i = 0; i < TIC_HANDLE_STATS_HISTOGRAM_SIZE; i++)
+  {
+    counts[i] = stats == NULL ? 0 :
+      stats->counters[request].latency_histogram[i];
+  }
+}
+
+uint64_t tic_handle_stats_get_first_transfer_latency_us(
+  const tic_handle_stats * stats)
+{
+  if (stats == NULL) { return 0; }
+  return stats->first_transfer_latency_us;
+}
+
 const tic_device * tic_handle_get_device(const tic_handle * handle)
 {
   if (handle == NULL) { return NULL; }
@@ -136,15 +422,17 @@ const char * tic_get_firmware_version_string(tic_handle * handle)
   // Get the firmware modification string from the device.
   size_t transferred = 0;
   uint8_t buffer[256];
-  libusbp_error * usb_error = libusbp_control_transfer(handle->usb_handle,
+  tic_error * error = tic_handle_control_transfer(handle,
     0x80, USB_REQUEST_GET_DESCRIPTOR,
     (USB_DESCRIPTOR_TYPE_STRING << 8) | TIC_FIRMWARE_MODIFICATION_STRING_INDEX,
     0,
     buffer, sizeof(buffer), &transferred);
-  if (usb_error)
+  if (error)
   {
     // Let's make this be a non-fatal error because it's not so important.
     // Just add a question mark so we can tell if something is wrong.
+    tic_error_free(error);
+    transferred = 0;
     new_string[index++] = '0';
   }
 
@@ -178,8 +466,8 @@ tic_error * tic_set_target_position(tic_handle * handle, int32_t position)
 
   uint16_t wValue = (uint32_t)position & 0xFFFF;
   uint16_t wIndex = (uint32_t)position >> 16 & 0xFFFF;
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_TARGET_POSITION, wValue, wIndex, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_TARGET_POSITION, wValue, wIndex, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -201,8 +489,8 @@ tic_error * tic_set_target_velocity(tic_handle * handle, int32_t velocity)
 
   uint16_t wValue = (uint32_t)velocity & 0xFFFF;
   uint16_t wIndex = (uint32_t)velocity >> 16 & 0xFFFF;
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_TARGET_VELOCITY, wValue, wIndex, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_TARGET_VELOCITY, wValue, wIndex, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -224,8 +512,8 @@ tic_error * tic_halt_and_set_position(tic_handle * handle, int32_t position)
 
   uint16_t wValue = (uint32_t)position & 0xFFFF;
   uint16_t wIndex = (uint32_t)position >> 16 & 0xFFFF;
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_HALT_AND_SET_POSITION, wValue, wIndex, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_HALT_AND_SET_POSITION, wValue, wIndex, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -245,8 +533,8 @@ tic_error * tic_halt_and_hold(tic_handle * handle)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_HALT_AND_HOLD, 0, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_HALT_AND_HOLD, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -266,8 +554,8 @@ tic_error * tic_go_home(tic_handle * handle, uint8_t direction)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_GO_HOME, direction, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_GO_HOME, direction, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -287,8 +575,8 @@ tic_error * tic_reset_command_timeout(tic_handle * handle)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_RESET_COMMAND_TIMEOUT, 0, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_RESET_COMMAND_TIMEOUT, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -308,8 +596,8 @@ tic_error * tic_deenergize(tic_handle * handle)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_DEENERGIZE, 0, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_DEENERGIZE, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -329,8 +617,8 @@ tic_error * tic_energize(tic_handle * handle)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_ENERGIZE, 0, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_ENERGIZE, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -350,8 +638,8 @@ tic_error * tic_exit_safe_start(tic_handle * handle)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_EXIT_SAFE_START, 0, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_EXIT_SAFE_START, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -371,8 +659,8 @@ tic_error * tic_enter_safe_start(tic_handle * handle)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_ENTER_SAFE_START, 0, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_ENTER_SAFE_START, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -392,8 +680,8 @@ tic_error * tic_reset(tic_handle * handle)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_RESET, 0, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_RESET, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -413,8 +701,8 @@ tic_error * tic_clear_driver_error(tic_handle * handle)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_CLEAR_DRIVER_ERROR, 0, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_CLEAR_DRIVER_ERROR, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -436,8 +724,8 @@ tic_error * tic_set_max_speed(tic_handle * handle, uint32_t max_speed)
 
   uint16_t wValue = (uint32_t)max_speed & 0xFFFF;
   uint16_t wIndex = (uint32_t)max_speed >> 16 & 0xFFFF;
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_MAX_SPEED, wValue, wIndex, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_MAX_SPEED, wValue, wIndex, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -459,8 +747,8 @@ tic_error * tic_set_starting_speed(tic_handle * handle, uint32_t starting_speed)
 
   uint16_t wValue = (uint32_t)starting_speed & 0xFFFF;
   uint16_t wIndex = (uint32_t)starting_speed >> 16 & 0xFFFF;
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_STARTING_SPEED, wValue, wIndex, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_STARTING_SPEED, wValue, wIndex, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -482,8 +770,8 @@ tic_error * tic_set_max_accel(tic_handle * handle, uint32_t max_accel)
 
   uint16_t wValue = (uint32_t)max_accel & 0xFFFF;
   uint16_t wIndex = (uint32_t)max_accel >> 16 & 0xFFFF;
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_MAX_ACCEL, wValue, wIndex, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_MAX_ACCEL, wValue, wIndex, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -505,8 +793,8 @@ tic_error * tic_set_max_decel(tic_handle * handle, uint32_t max_decel)
 
   uint16_t wValue = (uint32_t)max_decel & 0xFFFF;
   uint16_t wIndex = (uint32_t)max_decel >> 16 & 0xFFFF;
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_MAX_DECEL, wValue, wIndex, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_MAX_DECEL, wValue, wIndex, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -527,8 +815,8 @@ tic_error * tic_set_step_mode(tic_handle * handle, uint8_t step_mode)
   tic_error * error = NULL;
 
   uint16_t wValue = step_mode;
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_STEP_MODE, wValue, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_STEP_MODE, wValue, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -562,8 +850,8 @@ tic_error * tic_set_current_limit_code(tic_handle * handle, uint8_t code)
 
   tic_error * error = NULL;
 
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_CURRENT_LIMIT, code, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_CURRENT_LIMIT, code, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -608,8 +896,8 @@ tic_error * tic_set_decay_mode(tic_handle * handle, uint8_t decay_mode)
   if (error == NULL)
   {
     uint16_t wValue = decay_mode;
-    error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-      0x40, TIC_CMD_SET_DECAY_MODE, wValue, 0, NULL, 0, NULL));
+    error = tic_handle_control_transfer(handle,
+      0x40, TIC_CMD_SET_DECAY_MODE, wValue, 0, NULL, 0, NULL);
   }
 
   if (error != NULL)
@@ -640,8 +928,8 @@ static tic_error * tic_set_agc_option(tic_handle * handle,
   tic_error * error = NULL;
 
   uint16_t wValue = ((option & 0x07) << 4) | (value & 0x0F);
-  error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_AGC_OPTION, wValue, 0, NULL, 0, NULL));
+  error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_AGC_OPTION, wValue, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -677,8 +965,8 @@ tic_error * tic_set_setting_byte(tic_handle * handle,
 {
   assert(handle != NULL);
 
-  tic_error * error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_SET_SETTING, byte, address, NULL, 0, NULL));
+  tic_error * error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_SET_SETTING, byte, address, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -707,8 +995,8 @@ tic_error * tic_get_setting_segment(tic_handle * handle,
   assert(length && length <= TIC_MAX_USB_RESPONSE_SIZE);
 
   size_t transferred;
-  tic_error * error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0xC0, TIC_CMD_GET_SETTING, 0, index, output, length, &transferred));
+  tic_error * error = tic_handle_control_transfer(handle,
+    0xC0, TIC_CMD_GET_SETTING, 0, index, output, length, &transferred);
   if (error != NULL)
   {
     return error;
@@ -738,8 +1026,8 @@ tic_error * tic_get_variable_segment(tic_handle * handle,
     cmd = TIC_CMD_GET_VARIABLE_AND_CLEAR_ERRORS_OCCURRED;
   }
   size_t transferred;
-  tic_error * error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0xC0, cmd, 0, index, output, length, &transferred));
+  tic_error * error = tic_handle_control_transfer(handle,
+    0xC0, cmd, 0, index, output, length, &transferred);
   if (error != NULL)
   {
     return error;
@@ -824,8 +1112,8 @@ tic_error * tic_reinitialize(tic_handle * handle)
     return tic_error_create("Handle is null.");
   }
 
-  tic_error * error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_REINITIALIZE, 0, 0, NULL, 0, NULL));
+  tic_error * error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_REINITIALIZE, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -843,8 +1131,8 @@ tic_error * tic_start_bootloader(tic_handle * handle)
     return tic_error_create("Handle is null.");
   }
 
-  tic_error * error = tic_usb_error(libusbp_control_transfer(handle->usb_handle,
-    0x40, TIC_CMD_START_BOOTLOADER, 0, 0, NULL, 0, NULL));
+  tic_error * error = tic_handle_control_transfer(handle,
+    0x40, TIC_CMD_START_BOOTLOADER, 0, 0, NULL, 0, NULL);
 
   if (error != NULL)
   {
@@ -873,12 +1161,12 @@ tic_error * tic_get_debug_data(tic_handle * handle, uint8_t * data, size_t * siz
   }
 
   size_t transferred;
-  libusbp_error * usb_error = libusbp_control_transfer(handle->usb_handle,
+  tic_error * error = tic_handle_control_transfer(handle,
     0xC0, TIC_CMD_GET_DEBUG_DATA, 0, 0, data, *size, &transferred);
-  if (usb_error)
+  if (error)
   {
     *size = 0;
-    return tic_usb_error(usb_error);
+    return error;
   }
 
   *size = transferred;
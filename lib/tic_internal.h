@@ -15,6 +15,8 @@
 #include <time.h>
 #include <unistd.h>
 
+#include "tic_thread.h"
+
 #ifdef _MSC_VER
 #define TIC_PRINTF(f, a)
 #else
@@ -80,6 +82,80 @@ extern const tic_name tic_hp_driver_error_names_ui[];
 
 void tic_variables_set_from_device(tic_variables *, const uint8_t * buffer);
 
+void tic_variables_copy_into(tic_variables * dest, const tic_variables * source);
+
+// A range of consecutive variable bytes that holds one or more fields.
+typedef struct tic_variables_segment
+{
+  uint8_t offset;
+  uint8_t size;
+  bool includes_errors_occurred;
+} tic_variables_segment;
+
+// The most segments that tic_variables_fields_segments() can return: one for
+// each group of variables selected by a TIC_VARIABLES_FIELD_* bit.
+#define TIC_VARIABLES_MAX_SEGMENTS 32
+
+// Groups the bytes holding the specified fields into as few segments as
+// possible, each at most max_size bytes long unless a single field is longer.
+// Returns the number of segments written to the array, which must hold
+// TIC_VARIABLES_MAX_SEGMENTS elements.
+size_t tic_variables_fields_segments(uint32_t fields, size_t max_size,
+  tic_variables_segment * segments);
+
+// Returns the subset of the specified fields that are meaningful for the
+// specified product.
+uint32_t tic_variables_fields_for_product(uint32_t fields, uint8_t product);
+
+// Stores the specified fields from a buffer of variables read from a device.
+void tic_variables_write_from_buffer(tic_variables * variables,
+  uint8_t product, const uint8_t * buf, uint32_t fields);
+
+
+// Internal time functions.
+
+// Returns the time from a monotonic clock, in microseconds.
+uint64_t tic_monotonic_us(void);
+
+// Sleeps until tic_monotonic_us() returns a value greater than or equal to
+// the specified deadline.
+void tic_sleep_until_us(uint64_t deadline);
+
+// Counts a time in a histogram with bucket_count log2 buckets, as described
+// for ::TIC_STREAMER_HISTOGRAM_SIZE, and raises *max if the time is longer.
+// This uses atomic operations so other threads can read the histogram while
+// it is being updated, but there must be only one writer.
+void tic_latency_record(uint32_t * histogram, size_t bucket_count,
+  uint32_t * max, uint64_t time_us);
+
+
+// Internal motion planner model.  Positions are in microsteps and velocities
+// are in microsteps per second.
+
+// The motion limits, in the same units as the Tic's variables.
+typedef struct tic_planner_limits
+{
+  uint32_t max_speed;
+  uint32_t starting_speed;
+  uint32_t max_accel;
+  uint32_t max_decel;
+} tic_planner_limits;
+
+// Changes the velocity toward the desired velocity for one tick, respecting
+// the acceleration and deceleration limits.  Speeds at or below the starting
+// speed can be reached instantly.
+double tic_planner_approach(const tic_planner_limits *,
+  double velocity, double desired, double dt);
+
+// Runs the position planner for one tick.
+void tic_planner_step_position(const tic_planner_limits *,
+  double * position, double * velocity, double target, double dt);
+
+// Runs the velocity planner for one tick.  The desired velocity is limited to
+// the maximum speed.
+void tic_planner_step_velocity(const tic_planner_limits *,
+  double * position, double * velocity, double desired, double dt);
+
 
 // Internal settings conversion functions.
 
@@ -89,12 +165,101 @@ uint16_t tic_baud_rate_to_brg(uint32_t baud_rate);
 
 // Internal tic_device functions.
 
+// Returns NULL if the device is not connected over USB.
 const libusbp_generic_interface *
 tic_device_get_generic_interface(const tic_device * device);
 
+// Creates a device object for a Tic that is reached some way other than USB.
+tic_error * tic_device_create_without_usb(uint8_t product,
+  uint16_t firmware_version, const char * serial_number, const char * os_id,
+  tic_device ** device);
+
+
+// Internal transport interface.
+//
+// A tic_handle sends every request to its device through a transport.  The
+// requests are USB control transfers, with the same meanings as they have on
+// a real Tic, so other transports translate them as needed.
+
+typedef struct tic_transport
+{
+  // Performs a control transfer.  For requests that read data, sets
+  // *transferred to the number of bytes read.  transferred is never NULL.
+  tic_error * (*control_transfer)(void * context,
+    uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+    void * buffer, uint16_t length, size_t * transferred);
+
+  // Frees the context.
+  void (*close)(void * context);
+} tic_transport;
+
+// Opens a handle that uses the specified transport.  The handle takes
+// ownership of the context, and closes it if this function fails.
+tic_error * tic_handle_open_transport(const tic_device * device,
+  const tic_transport * transport, void * context, tic_handle ** handle);
+
+// The transport used by handles from tic_handle_open_emulated().
+extern const tic_transport tic_emulator_transport;
+
+
+// Internal serial functions.
+
+// Computes the CRC7 that the Tic uses for serial commands and responses.
+uint8_t tic_serial_crc7(const uint8_t * message, size_t length);
+
+// Encodes a serial command, given the data bytes that follow the command byte,
+// into the buffer, which must hold at least data_length + 5 bytes.  The flags
+// are TIC_SERIAL_FLAG_* macros.  Returns the length of the command.
+size_t tic_serial_encode_command(uint16_t device_number, uint32_t flags,
+  uint8_t command, const uint8_t * data, size_t data_length, uint8_t * buffer);
+
+// Encodes the serial command for a request that tic_handle would send as a
+// USB control transfer with the specified request and 32-bit value.  Returns
+// 0 if the request is not available over serial.
+size_t tic_serial_encode_request(uint16_t device_number, uint32_t flags,
+  uint8_t request, uint32_t value, uint8_t * buffer);
+
+// Encodes a Get variable or Get setting command for a block of bytes.
+size_t tic_serial_encode_read(uint16_t device_number, uint32_t flags,
+  uint8_t command, uint8_t offset, uint8_t length, uint8_t * buffer);
+
+// Returns the longest block that one serial read can return.
+size_t tic_serial_max_block_size(uint32_t flags);
+
+// Returns the number of bytes in the response to a read of a block, which
+// includes the 7-bit MSbs byte and the CRC byte if they are enabled.
+size_t tic_serial_response_length(uint32_t flags, uint8_t length);
+
+// Checks and decodes the response to a read of a block.
+tic_error * tic_serial_decode_response(uint32_t flags,
+  const uint8_t * response, uint8_t length, uint8_t * output);
+
+// How long to wait for a response to a serial read.
+#define TIC_SERIAL_TIMEOUT_MS 250
+
+#ifndef _WIN32
+
+tic_error * tic_serial_open_port(const char * port_name,
+  uint32_t baud_rate, int * fd);
+
+tic_error * tic_serial_write(int fd, const uint8_t * buffer, size_t length);
+
+// Waits until the deadline (from tic_monotonic_us()) for at least one byte and
+// reads as many bytes as are available, up to length.
+tic_error * tic_serial_read_some(int fd, uint8_t * buffer, size_t length,
+  uint64_t deadline, size_t * received);
+
+// Reads exactly length bytes, waiting at most TIC_SERIAL_TIMEOUT_MS.
+tic_error * tic_serial_read(int fd, uint8_t * buffer, size_t length);
+
+#endif
+
 
 // Internal tic_handle functions.
 
+tic_error * tic_set_setting_byte(tic_handle * handle,
+  uint8_t address, uint8_t byte);
+
 tic_error * tic_set_setting_segment(tic_handle * handle,
   uint8_t address, size_t length, const uint8_t * input);
 
@@ -105,6 +270,12 @@ tic_error * tic_get_variable_segment(tic_handle * handle,
   size_t index, size_t length, uint8_t * buf,
   bool clear_errors_occurred);
 
+// Sends a control transfer through the handle's transport.  transferred can
+// be NULL.
+tic_error * tic_handle_control_transfer(tic_handle * handle,
+  uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+  void * buffer, uint16_t length, size_t * transferred);
+
 
 // Error creation functions.
 
@@ -117,8 +288,10 @@ TIC_PRINTF(1, 2)
 tic_error * tic_error_create(const char * format, ...);
 
 tic_error * tic_usb_error(libusbp_error *);
+tic_error * tic_usb_error_quiet(libusbp_error *);
 
 extern tic_error tic_error_no_memory;
+extern tic_error tic_error_device_disconnected;
 
 
 // Static helper functions
@@ -249,5 +422,9 @@ typedef struct tic_settings_segments
 
 tic_settings_segments tic_get_settings_segments(uint8_t product);
 
+// Writes the settings to a 256-byte buffer laid out like the settings on the
+// device.  The buffer should be zeroed beforehand.
+void tic_write_settings_to_buffer(const tic_settings * settings, uint8_t * buf);
+
 uint32_t tic_settings_get_hp_toff_ns(const tic_settings *);
 bool tic_settings_hp_gate_charge_ok(const tic_settings *);
@@ -0,0 +1,322 @@
+// Functions for sampling a Tic's variables at a fixed rate on a background
+// thread.
+
+#include "tic_internal.h"
+
+typedef struct tic_monitor_slot
+{
+  uint64_t host_time_us;
+  tic_variables * variables;
+} tic_monitor_slot;
+
+struct tic_monitor
+{
+  tic_handle * handle;
+  uint32_t interval_us;
+  uint32_t fields;
+
+  // The ring buffer.  Only the sampler thread writes to head, and only the
+  // consumer writes to tail.  Both only ever increase; the slot used for a
+  // given count is count % capacity.
+  tic_monitor_slot * slots;
+  size_t capacity;
+  size_t head;
+  size_t tail;
+
+  // Samples taken while the buffer is full are read into here and discarded.
+  tic_variables * scratch;
+
+  // Statistics written by the sampler thread.
+  uint32_t dropped_count;
+  uint32_t missed_deadline_count;
+
+  tic_thread thread;
+  bool thread_started;
+  bool stop_requested;
+  bool running;
+
+  // Set by the sampler thread before it clears the running flag.
+  tic_error * error;
+};
+
+tic_error * tic_monitor_create(tic_handle * handle, uint32_t interval_us,
+  size_t capacity, uint32_t fields, tic_monitor ** monitor)
+{
+  if (monitor == NULL)
+  {
+    return tic_error_create("Monitor output pointer is null.");
+  }
+
+  *monitor = NULL;
+
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle is null.");
+  }
+
+  if (interval_us == 0)
+  {
+    return tic_error_create("Sampling interval is zero.");
+  }
+
+  if (capacity == 0)
+  {
+    return tic_error_create("Sample buffer capacity is zero.");
+  }
+
+  tic_error * error = NULL;
+
+  tic_monitor * new_monitor = NULL;
+  if (error == NULL)
+  {
+    new_monitor = calloc(1, sizeof(tic_monitor));
+    if (new_monitor == NULL) { error = &tic_error_no_memory; }
+  }
+
+  if (error == NULL)
+  {
+    new_monitor->handle = handle;
+    new_monitor->interval_us = interval_us;
+    new_monitor->fields = fields | TIC_VARIABLES_FIELD_UP_TIME;
+    new_monitor->capacity = capacity;
+    new_monitor->slots = calloc(capacity, sizeof(tic_monitor_slot));
+    if (new_monitor->slots == NULL) { error = &tic_error_no_memory; }
+  }
+
+  if (error == NULL)
+  {
+    error = tic_variables_create(&new_monitor->scratch);
+  }
+
+  for (size_t i = 0; error == NULL && i < capacity; i++)
+  {
+    error = tic_variables_create(&new_monitor->slots[i].variables);
+  }
+
+  if (error == NULL)
+  {
+    *monitor = new_monitor;
+    new_monitor = NULL;
+  }
+
+  tic_monitor_free(new_monitor);
+
+  return error;
+}
+
+void tic_monitor_free(tic_monitor * monitor)
+{
+  if (monitor == NULL) { return; }
+
+  tic_monitor_stop(monitor);
+
+  if (monitor->slots != NULL)
+  {
+    for (size_t i = 0; i < monitor->capacity; i++)
+    {
+      tic_variables_free(monitor->slots[i].variables);
+    }
+  }
+  free(monitor->slots);
+  tic_variables_free(monitor->scratch);
+  tic_error_free(monitor->error);
+  free(monitor);
+}
+
+static void * tic_monitor_thread(void * arg)
+{
+  tic_monitor * monitor = arg;
+
+  uint64_t deadline = tic_monotonic_us();
+
+  while (!tic_atomic_load_bool(&monitor->stop_requested))
+  {
+    size_t head = monitor->head;
+    size_t tail = tic_atomic_load_size(&monitor->tail);
+    bool full = head - tail >= monitor->capacity;
+
+    // If the buffer is full, we still read from the device so the timing of
+    // the samples stays regular, but the sample is thrown away.
+    tic_variables * variables = full ? monitor->scratch :
+      monitor->slots[head % monitor->capacity].variables;
+
+    tic_error * error = tic_get_variables_fields(monitor->handle,
+      variables, monitor->fields, false);
+    uint64_t host_time_us = tic_monotonic_us();
+
+    if (error != NULL)
+    {
+      monitor->error = error;
+      break;
+    }
+
+    if (full)
+    {
+      tic_atomic_add_u32(&monitor->dropped_count, 1);
+    }
+    else
+    {
+      monitor->slots[head % monitor->capacity].host_time_us = host_time_us;
+      tic_atomic_store_size(&monitor->head, head + 1);
+    }
+
+    // Schedule the next sample relative to the previous deadline, not the
+    // current time, so that the time it takes to do the transfer does not
+    // accumulate as drift.  If we fell behind by more than a whole interval,
+    // skip the deadlines we missed instead of sampling in a burst.
+    deadline += monitor->interval_us;
+    uint64_t now = tic_monotonic_us();
+    if (now >= deadline + monitor->interval_us)
+    {
+      uint64_t missed = (now - deadline) / monitor->interval_us;
+      deadline += missed * monitor->interval_us;
+      tic_atomic_add_u32(&monitor->missed_deadline_count, (uint32_t)missed);
+    }
+    tic_sleep_until_us(deadline);
+  }
+
+  tic_atomic_store_bool(&monitor->running, false);
+  return NULL;
+}
+
+tic_error * tic_monitor_start(tic_monitor * monitor)
+{
+  if (monitor == NULL)
+  {
+    return tic_error_create("Monitor is null.");
+  }
+
+  if (monitor->thread_started && tic_atomic_load_bool(&monitor->running))
+  {
+    return tic_error_create("The monitor is already running.");
+  }
+
+  // If this monitor ran before, collect its thread and start over with an
+  // empty buffer so nothing from the previous run is mistaken for new data.
+  tic_monitor_stop(monitor);
+  tic_error_free(monitor->error);
+  monitor->error = NULL;
+  monitor->head = 0;
+  monitor->tail = 0;
+  monitor->dropped_count = 0;
+  monitor->missed_deadline_count = 0;
+
+  monitor->stop_requested = false;
+  monitor->running = true;
+
+  int result = tic_thread_create(&monitor->thread,
+    tic_monitor_thread, monitor);
+  if (result != 0)
+  {
+    monitor->running = false;
+    return tic_error_create(
+      "Failed to start the monitor thread.  Error code %d.", result);
+  }
+
+  monitor->thread_started = true;
+  return NULL;
+}
+
+void tic_monitor_stop(tic_monitor * monitor)
+{
+  if (monitor == NULL || !monitor->thread_started) { return; }
+
+  tic_atomic_store_bool(&monitor->stop_requested, true);
+  tic_thread_join(monitor->thread);
+  monitor->thread_started = false;
+}
+
+bool tic_monitor_read_sample(tic_monitor * monitor,
+  tic_variables * variables, uint64_t * host_time_us)
+{
+  if (monitor == NULL || variables == NULL) { return false; }
+
+  size_t tail = monitor->tail;
+  size_t head = tic_atomic_load_size(&monitor->head);
+  if (tail == head) { return false; }
+
+  const tic_monitor_slot * slot = &monitor->slots[tail % monitor->capacity];
+  tic_variables_copy_into(variables, slot->variables);
+  if (host_time_us != NULL) { *host_time_us = slot->host_time_us; }
+
+  tic_atomic_store_size(&monitor->tail, tail + 1);
+  return true;
+}
+
+tic_error * tic_monitor_read_samples(tic_monitor * monitor,
+  tic_variables * const * samples, size_t capacity, size_t * count)
+{
+  if (count == NULL)
+  {
+    return tic_error_create("Sample count output pointer is null.");
+  }
+
+  *count = 0;
+
+  if (monitor == NULL)
+  {
+    return tic_error_create("Monitor is null.");
+  }
+
+  if (samples == NULL && capacity != 0)
+  {
+    return tic_error_create("Sample array is null.");
+  }
+
+  size_t tail = monitor->tail;
+  size_t head = tic_atomic_load_size(&monitor->head);
+  size_t available = head - tail;
+  size_t n = available < capacity ? available : capacity;
+
+  for (size_t i = 0; i < n; i++)
+  {
+    if (samples[i] == NULL)
+    {
+      return tic_error_create("Sample %u is null.", (unsigned int)i);
+    }
+  }
+
+  for (size_t i = 0; i < n; i++)
+  {
+    const tic_monitor_slot * slot =
+      &monitor->slots[(tail + i) % monitor->capacity];
+    tic_variables_copy_into(samples[i], slot->variables);
+  }
+
+  tic_atomic_store_size(&monitor->tail, tail + n);
+  *count = n;
+  return NULL;
+}
+
+size_t tic_monitor_get_sample_count(const tic_monitor * monitor)
+{
+  if (monitor == NULL) { return 0; }
+  size_t head = tic_atomic_load_size(&monitor->head);
+  size_t tail = tic_atomic_load_size(&monitor->tail);
+  return head - tail;
+}
+
+bool tic_monitor_is_running(const tic_monitor * monitor)
+{
+  if (monitor == NULL) { return false; }
+  return tic_atomic_load_bool(&monitor->running);
+}
+
+const tic_error * tic_monitor_get_error(const tic_monitor * monitor)
+{
+  if (monitor == NULL) { return NULL; }
+  if (tic_atomic_load_bool(&monitor->running)) { return NULL; }
+  return monitor->error;
+}
+
+uint32_t tic_monitor_get_dropped_count(const tic_monitor * monitor)
+{
+  if (monitor == NULL) { return 0; }
+  return tic_atomic_load_u32(&monitor->dropped_count);
+}
+
+uint32_t tic_monitor_get_missed_deadline_count(const tic_monitor * monitor)
+{
+  if (monitor == NULL) { return 0; }
+  return tic_atomic_load_u32(&monitor->missed_deadline_count);
+}
@@ -0,0 +1,113 @@
+// A simple model of the Tic's acceleration-limited motion planner, shared by
+// the emulator and the position estimator.
+
+#include "tic_internal.h"
+
+static double tic_planner_abs(double x)
+{
+  return x < 0 ? -x : x;
+}
+
+double tic_planner_approach(const tic_planner_limits * limits,
+  double velocity, double desired, double dt)
+{
+  double starting = limits->starting_speed / (double)TIC_SPEED_UNITS_PER_HZ;
+  double accel = limits->max_accel / (double)TIC_ACCEL_UNITS_PER_HZ2;
+  double decel = limits->max_decel / (double)TIC_ACCEL_UNITS_PER_HZ2;
+
+  // Stop before changing direction.
+  if ((velocity > 0 && desired < 0) || (velocity < 0 && desired > 0))
+  {
+    desired = 0;
+  }
+
+  double direction = velocity != 0 ? velocity : desired;
+  double speed = tic_planner_abs(velocity);
+  double target_speed = tic_planner_abs(desired);
+
+  if (target_speed > speed)
+  {
+    speed = speed < starting ? starting : speed + accel * dt;
+    if (speed > target_speed) { speed = target_speed; }
+  }
+  else if (target_speed < speed)
+  {
+    speed -= decel * dt;
+    if (speed < target_speed || speed <= starting) { speed = target_speed; }
+  }
+
+  return direction < 0 ? -speed : speed;
+}
+
+void tic_planner_step_position(const tic_planner_limits * limits,
+  double * position, double * velocity, double target, double dt)
+{
+  double max_speed = limits->max_speed / (double)TIC_SPEED_UNITS_PER_HZ;
+  double starting = limits->starting_speed / (double)TIC_SPEED_UNITS_PER_HZ;
+  double decel = limits->max_decel / (double)TIC_ACCEL_UNITS_PER_HZ2;
+
+  double distance = target - *position;
+  if (distance == 0 && *velocity == 0) { return; }
+
+  double direction = distance < 0 ? -1 : 1;
+  double desired;
+  double braking_decel = 0;
+  if (*velocity * direction < 0)
+  {
+    // Moving away from the target.
+    desired = 0;
+  }
+  else if (*velocity * *velocity >= 2 * decel * tic_planner_abs(distance))
+  {
+    // Time to slow down.  We usually notice this partway through a tick, so
+    // we brake just hard enough to stop on the target instead of coasting
+    // past it.  If the target is so close that this would take much more
+    // than the deceleration limit, we overshoot and come back instead.
+    desired = 0;
+    braking_decel = *velocity * *velocity / (2 * tic_planner_abs(distance));
+    if (braking_decel > 2 * decel) { braking_decel = 0; }
+  }
+  else
+  {
+    desired = direction * max_speed;
+  }
+
+  if (braking_decel > 0)
+  {
+    double speed = tic_planner_abs(*velocity) - braking_decel * dt;
+    if (speed <= starting) { speed = 0; }
+    *velocity = direction * speed;
+  }
+  else
+  {
+    *velocity = tic_planner_approach(limits, *velocity, desired, dt);
+  }
+  if (*velocity == 0 && desired == 0 && *velocity * direction >= 0)
+  {
+    // We slowed down a little early; creep up on the target.
+    *velocity = tic_planner_approach(limits, 0, direction * max_speed, dt);
+  }
+
+  double step = *velocity * dt;
+  bool passes_target = step * direction >= tic_planner_abs(distance);
+  if (passes_target &&
+    tic_planner_abs(*velocity) <= starting + 2 * decel * dt)
+  {
+    *position = target;
+    *velocity = 0;
+  }
+  else
+  {
+    *position += step;
+  }
+}
+
+void tic_planner_step_velocity(const tic_planner_limits * limits,
+  double * position, double * velocity, double desired, double dt)
+{
+  double max_speed = limits->max_speed / (double)TIC_SPEED_UNITS_PER_HZ;
+  if (desired > max_speed) { desired = max_speed; }
+  if (desired < -max_speed) { desired = -max_speed; }
+  *velocity = tic_planner_approach(limits, *velocity, desired, dt);
+  *position += *velocity * dt;
+}
@@ -0,0 +1,525 @@
+// Functions for communicating with Tic devices over a TTL serial port.
+//
+// The serial transport translates the USB control transfers that tic_handle
+// sends into serial commands.  It supports the Pololu protocol, with 7-bit or
+// 14-bit device numbers, and the compact protocol, with optional CRC7 bytes on
+// commands and responses and optional 7-bit responses.  Requests that are only
+// available over USB, like setting a setting, fail with an error.
+
+#include "tic_internal.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#endif
+
+// The longest block that a serial Get variable or Get setting command can read.
+#define TIC_SERIAL_MAX_BLOCK_SIZE 15
+
+// With 7-bit responses, a response holds at most 7 data bytes followed by one
+// byte holding their most-significant bits.
+#define TIC_SERIAL_MAX_BLOCK_SIZE_7BIT 7
+
+// The Tic only adds CRC bytes to responses shorter than this.
+#define TIC_SERIAL_MAX_CRC_RESPONSE_SIZE 14
+
+uint8_t tic_serial_crc7(const uint8_t * message, size_t length)
+{
+  uint8_t crc = 0;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= message[i];
+    for (uint8_t j = 0; j < 8; j++)
+    {
+      if (crc & 1) { crc ^= 0x91; }
+      crc >>= 1;
+    }
+  }
+  return crc;
+}
+
+size_t tic_serial_encode_command(uint16_t device_number, uint32_t flags,
+  uint8_t command, const uint8_t * data, size_t data_length, uint8_t * buffer)
+{
+  size_t length = 0;
+
+  if (flags & TIC_SERIAL_FLAG_COMPACT_PROTOCOL)
+  {
+    buffer[length++] = command;
+  }
+  else
+  {
+    buffer[length++] = 0xAA;
+    buffer[length++] = device_number & 0x7F;
+    if (flags & TIC_SERIAL_FLAG_14BIT_DEVICE_NUMBER)
+    {
+      buffer[length++] = device_number >> 7 & 0x7F;
+    }
+    buffer[length++] = command & 0x7F;
+  }
+
+  memcpy(buffer + length, data, data_length);
+  length += data_length;
+
+  if (flags & TIC_SERIAL_FLAG_CRC_FOR_COMMANDS)
+  {
+    buffer[length] = tic_serial_crc7(buffer, length);
+    length++;
+  }
+
+  return length;
+}
+
+// Returns the serial command format of a request: the number of data bytes
+// that follow the command byte, or -1 if the request is not available over
+// serial.  Block reads are handled separately.
+static int tic_serial_command_data_length(uint8_t request)
+{
+  switch (request)
+  {
+  case TIC_CMD_SET_TARGET_POSITION:
+  case TIC_CMD_SET_TARGET_VELOCITY:
+  case TIC_CMD_HALT_AND_SET_POSITION:
+  case TIC_CMD_SET_MAX_SPEED:
+  case TIC_CMD_SET_STARTING_SPEED:
+  case TIC_CMD_SET_MAX_ACCEL:
+  case TIC_CMD_SET_MAX_DECEL:
+    return 5;
+
+  case TIC_CMD_SET_STEP_MODE:
+  case TIC_CMD_SET_CURRENT_LIMIT:
+  case TIC_CMD_SET_DECAY_MODE:
+  case TIC_CMD_GO_HOME:
+  case TIC_CMD_SET_AGC_OPTION:
+    return 1;
+
+  case TIC_CMD_HALT_AND_HOLD:
+  case TIC_CMD_RESET_COMMAND_TIMEOUT:
+  case TIC_CMD_DEENERGIZE:
+  case TIC_CMD_ENERGIZE:
+  case TIC_CMD_EXIT_SAFE_START:
+  case TIC_CMD_ENTER_SAFE_START:
+  case TIC_CMD_RESET:
+  case TIC_CMD_CLEAR_DRIVER_ERROR:
+    return 0;
+
+  default:
+    return -1;
+  }
+}
+
+size_t tic_serial_encode_request(uint16_t device_number, uint32_t flags,
+  uint8_t request, uint32_t value, uint8_t * buffer)
+{
+  int data_length = tic_serial_command_data_length(request);
+  if (data_length < 0) { return 0; }
+
+  uint8_t data[5];
+  if (data_length == 5)
+  {
+    // 32-bit write: a byte with the most-significant bits of the four data
+    // bytes, then the data bytes with those bits cleared.
+    data[0] = 0;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+      uint8_t byte = value >> (8 * i) & 0xFF;
+      data[0] |= (byte >> 7) << i;
+      data[1 + i] = byte & 0x7F;
+    }
+  }
+  else if (data_length == 1)
+  {
+    data[0] = value & 0x7F;
+  }
+
+  return tic_serial_encode_command(device_number, flags, request,
+    data, data_length, buffer);
+}
+
+size_t tic_serial_encode_read(uint16_t device_number, uint32_t flags,
+  uint8_t command, uint8_t offset, uint8_t length, uint8_t * buffer)
+{
+  // The most-significant bit of the offset goes in bit 6 of the length byte.
+  uint8_t data[2] = { offset & 0x7F, length | (offset >> 1 & 0x40) };
+  return tic_serial_encode_command(device_number, flags, command,
+    data, 2, buffer);
+}
+
+size_t tic_serial_max_block_size(uint32_t flags)
+{
+  return (flags & TIC_SERIAL_FLAG_7BIT_RESPONSES) ?
+    TIC_SERIAL_MAX_BLOCK_SIZE_7BIT : TIC_SERIAL_MAX_BLOCK_SIZE;
+}
+
+size_t tic_serial_response_length(uint32_t flags, uint8_t length)
+{
+  bool seven_bit = flags & TIC_SERIAL_FLAG_7BIT_RESPONSES;
+  bool crc = (flags & TIC_SERIAL_FLAG_CRC_FOR_RESPONSES) &&
+    length < TIC_SERIAL_MAX_CRC_RESPONSE_SIZE;
+  return length + seven_bit + crc;
+}
+
+tic_error * tic_serial_decode_response(uint32_t flags,
+  const uint8_t * response, uint8_t length, uint8_t * output)
+{
+  size_t response_length = tic_serial_response_length(flags, length);
+  bool seven_bit = flags & TIC_SERIAL_FLAG_7BIT_RESPONSES;
+  bool crc = response_length > (size_t)length + seven_bit;
+
+  if (crc && tic_serial_crc7(response, response_length - 1) !=
+    response[response_length - 1])
+  {
+    return tic_error_create("Incorrect CRC byte in serial response.");
+  }
+
+  memcpy(output, response, length);
+  if (seven_bit)
+  {
+    uint8_t msbs = response[length];
+    for (uint8_t i = 0; i < length; i++)
+    {
+      if (output[i] & 0x80 || msbs & 0x80)
+      {
+        return tic_error_create("Invalid byte in 7-bit serial response.");
+      }
+      output[i] |= (msbs >> i & 1) << 7;
+    }
+  }
+
+  return NULL;
+}
+
+#ifndef _WIN32
+
+tic_error * tic_serial_write(int fd, const uint8_t * buffer, size_t length)
+{
+  while (length)
+  {
+    ssize_t written = write(fd, buffer, length);
+    if (written < 0 && errno == EINTR) { continue; }
+    if (written < 0)
+    {
+      return tic_error_create("Failed to write to the serial port: %s.",
+        strerror(errno));
+    }
+    buffer += written;
+    length -= written;
+  }
+  return NULL;
+}
+
+tic_error * tic_serial_read_some(int fd, uint8_t * buffer, size_t length,
+  uint64_t deadline, size_t * received)
+{
+  *received = 0;
+  while (true)
+  {
+    uint64_t now = tic_monotonic_us();
+    int timeout_ms = now >= deadline ? 0 : (int)((deadline - now + 999) / 1000);
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int result = poll(&pfd, 1, timeout_ms);
+    if (result < 0 && errno == EINTR) { continue; }
+    if (result < 0)
+    {
+      return tic_error_create("Failed to wait for the serial port: %s.",
+        strerror(errno));
+    }
+    if (result == 0)
+    {
+      tic_error * error = tic_error_create(
+        "Timed out waiting for a serial response.");
+      return tic_error_add_code(error, TIC_ERROR_TIMEOUT);
+    }
+
+    ssize_t count = read(fd, buffer, length);
+    if (count < 0 && (errno == EINTR || errno == EAGAIN)) { continue; }
+    if (count < 0)
+    {
+      return tic_error_create("Failed to read from the serial port: %s.",
+        strerror(errno));
+    }
+    if (count == 0)
+    {
+      tic_error * error = tic_error_create("The serial port was closed.");
+      return tic_error_add_code(error, TIC_ERROR_DEVICE_DISCONNECTED);
+    }
+    *received = count;
+    return NULL;
+  }
+}
+
+tic_error * tic_serial_read(int fd, uint8_t * buffer, size_t length)
+{
+  uint64_t deadline = tic_monotonic_us() + TIC_SERIAL_TIMEOUT_MS * 1000;
+  while (length)
+  {
+    size_t received;
+    tic_error * error = tic_serial_read_some(fd, buffer, length,
+      deadline, &received);
+    if (error != NULL) { return error; }
+    buffer += received;
+    length -= received;
+  }
+  return NULL;
+}
+
+typedef struct tic_serial
+{
+  int fd;
+  uint16_t device_number;
+  uint32_t flags;
+} tic_serial;
+
+// Sends a Get variable or Get setting command for a block of at most
+// TIC_SERIAL_MAX_BLOCK_SIZE bytes and decodes the response.
+static tic_error * tic_serial_read_block(tic_serial * serial,
+  uint8_t command, uint8_t offset, uint8_t length, uint8_t * output)
+{
+  // Discard any stray bytes so they are not mistaken for the response.
+  tcflush(serial->fd, TCIFLUSH);
+
+  uint8_t request[16];
+  size_t request_length = tic_serial_encode_read(serial->device_number,
+    serial->flags, command, offset, length, request);
+  tic_error * error = tic_serial_write(serial->fd, request, request_length);
+  if (error != NULL) { return error; }
+
+  uint8_t response[TIC_SERIAL_MAX_BLOCK_SIZE + 2];
+  error = tic_serial_read(serial->fd, response,
+    tic_serial_response_length(serial->flags, length));
+  if (error != NULL) { return error; }
+
+  return tic_serial_decode_response(serial->flags, response, length, output);
+}
+
+static tic_error * tic_serial_control_transfer(void * context,
+  uint8_t request_type, uint8_t request, uint16_t value, uint16_t index,
+  void * buffer, uint16_t length, size_t * transferred)
+{
+  tic_serial * serial = context;
+
+  if (request_type == 0x80 && request == USB_REQUEST_GET_DESCRIPTOR)
+  {
+    // There is no way to read the firmware modification string over serial,
+    // so report that there is none.
+    static const uint8_t descriptor[] = { 4, USB_DESCRIPTOR_TYPE_STRING, '-', 0 };
+    if (length > sizeof(descriptor)) { length = sizeof(descriptor); }
+    memcpy(buffer, descriptor, length);
+    *transferred = length;
+    return NULL;
+  }
+
+  if (request_type == 0xC0 && (request == TIC_CMD_GET_VARIABLE ||
+    request == TIC_CMD_GET_VARIABLE_AND_CLEAR_ERRORS_OCCURRED ||
+    request == TIC_CMD_GET_SETTING))
+  {
+    if (index + length > 256)
+    {
+      return tic_error_create("Invalid serial read at offset 0x%x.", index);
+    }
+
+    size_t max_block = tic_serial_max_block_size(serial->flags);
+
+    // Only the first block clears the errors occurred bits, because callers
+    // always start a read that clears them at or before that variable.
+    uint8_t command = request;
+    size_t done = 0;
+    while (done < length)
+    {
+      size_t block = length - done;
+      if (block > max_block) { block = max_block; }
+      tic_error * error = tic_serial_read_block(serial, command,
+        index + done, block, (uint8_t *)buffer + done);
+      if (error != NULL) { return error; }
+      done += block;
+      if (command == TIC_CMD_GET_VARIABLE_AND_CLEAR_ERRORS_OCCURRED)
+      {
+        command = TIC_CMD_GET_VARIABLE;
+      }
+    }
+    *transferred = done;
+    return NULL;
+  }
+
+  uint8_t command[16];
+  size_t command_length = 0;
+  if (request_type == 0x40)
+  {
+    command_length = tic_serial_encode_request(serial->device_number,
+      serial->flags, request, (uint32_t)index << 16 | value, command);
+  }
+  if (command_length == 0)
+  {
+    return tic_error_create(
+      "Request 0x%02x is not available over serial.", request);
+  }
+
+  return tic_serial_write(serial->fd, command, command_length);
+}
+
+static void tic_serial_close(void * context)
+{
+  tic_serial * serial = context;
+  if (serial == NULL) { return; }
+  close(serial->fd);
+  free(serial);
+}
+
+static const tic_transport tic_serial_transport =
+{
+  .control_transfer = tic_serial_control_transfer,
+  .close = tic_serial_close,
+};
+
+static bool tic_serial_baud_rate_code(uint32_t baud_rate, speed_t * code)
+{
+  static const struct { uint32_t rate; speed_t code; } table[] = {
+    { 1200, B1200 }, { 2400, B2400 }, { 4800, B4800 }, { 9600, B9600 },
+    { 19200, B19200 }, { 38400, B38400 }, { 57600, B57600 },
+    { 115200, B115200 },
+  };
+  for (size_t i = 0; i < sizeof(table) / sizeof(table[0]); i++)
+  {
+    if (table[i].rate == baud_rate)
+    {
+      *code = table[i].code;
+      return true;
+    }
+  }
+  return false;
+}
+
+tic_error * tic_serial_open_port(const char * port_name,
+  uint32_t baud_rate, int * fd)
+{
+  *fd = -1;
+
+  speed_t speed;
+  if (!tic_serial_baud_rate_code(baud_rate, &speed))
+  {
+    return tic_error_create("Unsupported serial baud rate: %u.",
+      (unsigned int)baud_rate);
+  }
+
+  int new_fd = open(port_name, O_RDWR | O_NOCTTY);
+  if (new_fd < 0)
+  {
+    tic_error * error = tic_error_create("Failed to open %s: %s.",
+      port_name, strerror(errno));
+    if (errno == EACCES)
+    {
+      error = tic_error_add_code(error, TIC_ERROR_ACCESS_DENIED);
+    }
+    return error;
+  }
+
+  struct termios options;
+  if (tcgetattr(new_fd, &options) != 0)
+  {
+    tic_error * error = tic_error_create(
+      "Failed to get the settings of %s: %s.", port_name, strerror(errno));
+    close(new_fd);
+    return error;
+  }
+
+  cfmakeraw(&options);
+  options.c_cflag |= CLOCAL | CREAD;
+  options.c_cflag &= ~(CSTOPB | CRTSCTS);
+  cfsetispeed(&options, speed);
+  cfsetospeed(&options, speed);
+
+  if (tcsetattr(new_fd, TCSANOW, &options) != 0)
+  {
+    tic_error * error = tic_error_create(
+      "Failed to configure %s: %s.", port_name, strerror(errno));
+    close(new_fd);
+    return error;
+  }
+
+  tcflush(new_fd, TCIOFLUSH);
+  *fd = new_fd;
+  return NULL;
+}
+
+#endif
+
+tic_error * tic_handle_open_serial(const char * port_name, uint32_t baud_rate,
+  uint8_t product, uint16_t device_number, uint32_t flags, tic_handle ** handle)
+{
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle output pointer is null.");
+  }
+
+  *handle = NULL;
+
+  if (port_name == NULL)
+  {
+    return tic_error_create("Port name is null.");
+  }
+
+  if (tic_look_up_product_name_short(product)[0] == 0)
+  {
+    return tic_error_create("Invalid product code: %u.", product);
+  }
+
+  uint16_t max_device_number =
+    (flags & TIC_SERIAL_FLAG_14BIT_DEVICE_NUMBER) ? 0x3FFF : 0x7F;
+  if (device_number > max_device_number)
+  {
+    return tic_error_create("Invalid device number: %u.", device_number);
+  }
+
+#ifdef _WIN32
+  (void)baud_rate;
+  return tic_error_create("Serial ports are not supported on Windows.");
+#else
+  tic_error * error = NULL;
+
+  tic_serial * serial = calloc(1, sizeof(tic_serial));
+  if (serial == NULL)
+  {
+    error = &tic_error_no_memory;
+  }
+
+  if (error == NULL)
+  {
+    serial->device_number = device_number;
+    serial->flags = flags;
+    error = tic_serial_open_port(port_name, baud_rate, &serial->fd);
+    if (error != NULL)
+    {
+      free(serial);
+      serial = NULL;
+    }
+  }
+
+  // The firmware version cannot be read over serial, so it is unknown (0).
+  tic_device * device = NULL;
+  if (error == NULL)
+  {
+    error = tic_device_create_without_usb(product, 0, "", port_name, &device);
+    if (error != NULL)
+    {
+      tic_serial_close(serial);
+    }
+  }
+
+  if (error == NULL)
+  {
+    error = tic_handle_open_transport(device, &tic_serial_transport,
+      serial, handle);
+  }
+
+  tic_device_free(device);
+
+  if (error != NULL)
+  {
+    error = tic_error_add(error,
+      "There was an error opening the serial port.");
+  }
+
+  return error;
+#endif
+}
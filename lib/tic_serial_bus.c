@@ -0,0 +1,621 @@
+// Functions for talking to several Tics that share one TTL serial line.
+//
+// The bus builds serial commands with the same encoder as the serial
+// transport (tic_serial.c), but instead of sending each one and waiting for
+// it, it queues commands so they can be sent back to back and pipelines the
+// reads of variables.
+
+#include "tic_internal.h"
+
+#ifndef _WIN32
+#include <termios.h>
+#endif
+
+typedef struct tic_serial_bus_device
+{
+  uint8_t product;
+  uint16_t device_number;
+
+  // TIC_SERIAL_FLAG_* macros, not including the compact protocol.
+  uint32_t flags;
+
+  uint8_t response_delay_us;
+} tic_serial_bus_device;
+
+// One block read in a pipelined sequence of reads.
+typedef struct tic_serial_bus_read
+{
+  size_t device;
+  uint8_t offset;
+  uint8_t length;
+  uint8_t request[8];
+  uint8_t request_length;
+  uint8_t response_length;
+} tic_serial_bus_read;
+
+struct tic_serial_bus
+{
+  int fd;
+
+  // The baud rate that the Tics actually use for the requested baud rate.
+  uint32_t line_baud_rate;
+
+  tic_serial_bus_device * devices;
+  size_t device_count;
+
+  uint8_t * queue;
+  size_t queue_length;
+  size_t queue_capacity;
+  uint32_t queue_command_count;
+
+  uint64_t command_count;
+  uint64_t bytes_sent;
+  uint64_t bytes_received;
+  uint64_t busy_time_us;
+};
+
+tic_error * tic_serial_bus_create(const char * port_name, uint32_t baud_rate,
+  tic_serial_bus ** bus)
+{
+  if (bus == NULL)
+  {
+    return tic_error_create("Bus output pointer is null.");
+  }
+
+  *bus = NULL;
+
+  if (port_name == NULL)
+  {
+    return tic_error_create("Port name is null.");
+  }
+
+#ifdef _WIN32
+  (void)baud_rate;
+  return tic_error_create("Serial ports are not supported on Windows.");
+#else
+  tic_error * error = NULL;
+
+  tic_serial_bus * new_bus = calloc(1, sizeof(tic_serial_bus));
+  if (new_bus == NULL)
+  {
+    error = &tic_error_no_memory;
+  }
+
+  if (error == NULL)
+  {
+    new_bus->fd = -1;
+    new_bus->line_baud_rate =
+      tic_baud_rate_from_brg(tic_baud_rate_to_brg(baud_rate));
+    error = tic_serial_open_port(port_name, baud_rate, &new_bus->fd);
+  }
+
+  if (error == NULL)
+  {
+    *bus = new_bus;
+    new_bus = NULL;
+  }
+
+  tic_serial_bus_free(new_bus);
+
+  if (error != NULL)
+  {
+    error = tic_error_add(error,
+      "There was an error opening the serial bus.");
+  }
+
+  return error;
+#endif
+}
+
+void tic_serial_bus_free(tic_serial_bus * bus)
+{
+  if (bus == NULL) { return; }
+#ifndef _WIN32
+  if (bus->fd >= 0) { close(bus->fd); }
+#endif
+  free(bus->devices);
+  free(bus->queue);
+  free(bus);
+}
+
+tic_error * tic_serial_bus_add_device(tic_serial_bus * bus,
+  const tic_settings * settings, bool use_alt_device_number)
+{
+  if (bus == NULL)
+  {
+    return tic_error_create("Bus is null.");
+  }
+
+  if (settings == NULL)
+  {
+    return tic_error_create("Settings pointer is null.");
+  }
+
+  // Queued commands were framed for the devices that were on the bus when
+  // they were queued.
+  if (bus->queue_length != 0)
+  {
+    return tic_error_create(
+      "Devices cannot be added to the bus while commands are queued.");
+  }
+
+  tic_serial_bus_device device = { 0 };
+  device.product = tic_settings_get_product(settings);
+  device.response_delay_us = tic_settings_get_serial_response_delay(settings);
+
+  if (tic_settings_get_serial_14bit_device_number(settings))
+  {
+    device.flags |= TIC_SERIAL_FLAG_14BIT_DEVICE_NUMBER;
+  }
+  if (tic_settings_get_serial_crc_for_commands(settings))
+  {
+    device.flags |= TIC_SERIAL_FLAG_CRC_FOR_COMMANDS;
+  }
+  if (tic_settings_get_serial_crc_for_responses(settings))
+  {
+    device.flags |= TIC_SERIAL_FLAG_CRC_FOR_RESPONSES;
+  }
+  if (tic_settings_get_serial_7bit_responses(settings))
+  {
+    device.flags |= TIC_SERIAL_FLAG_7BIT_RESPONSES;
+  }
+
+  if (use_alt_device_number)
+  {
+    if (!tic_settings_get_serial_enable_alt_device_number(settings))
+    {
+      return tic_error_create(
+        "The alternative device number is not enabled in the settings.");
+    }
+    device.device_number = tic_settings_get_serial_alt_device_number(settings);
+  }
+  else
+  {
+    device.device_number = tic_settings_get_serial_device_number_u16(settings);
+  }
+
+  if (!(device.flags & TIC_SERIAL_FLAG_14BIT_DEVICE_NUMBER))
+  {
+    device.device_number &= 0x7F;
+  }
+
+  for (size_t i = 0; i < bus->device_count; i++)
+  {
+    if (bus->devices[i].device_number == device.device_number)
+    {
+      return tic_error_create(
+        "Device number %u is already used by another device on the bus.",
+        device.device_number);
+    }
+  }
+
+  uint32_t device_baud_rate = tic_settings_get_serial_baud_rate(settings);
+  if (tic_baud_rate_from_brg(tic_baud_rate_to_brg(device_baud_rate)) !=
+    bus->line_baud_rate)
+  {
+    return tic_error_create(
+      "The baud rate of the device (%u) does not match the bus (%u).",
+      (unsigned int)device_baud_rate, (unsigned int)bus->line_baud_rate);
+  }
+
+  tic_serial_bus_device * new_devices = realloc(bus->devices,
+    (bus->device_count + 1) * sizeof(tic_serial_bus_device));
+  if (new_devices == NULL)
+  {
+    return &tic_error_no_memory;
+  }
+
+  bus->devices = new_devices;
+  bus->devices[bus->device_count++] = device;
+  return NULL;
+}
+
+size_t tic_serial_bus_get_device_count(const tic_serial_bus * bus)
+{
+  if (bus == NULL) { return 0; }
+  return bus->device_count;
+}
+
+// Returns the flags to use for a command to the specified device.  When there
+// is only one device on the bus, the compact protocol reaches it with fewer
+// bytes.
+static uint32_t tic_serial_bus_frame_flags(const tic_serial_bus * bus,
+  const tic_serial_bus_device * device)
+{
+  uint32_t flags = device->flags;
+  if (bus->device_count == 1)
+  {
+    flags |= TIC_SERIAL_FLAG_COMPACT_PROTOCOL;
+  }
+  return flags;
+}
+
+tic_error * tic_serial_bus_queue_command(tic_serial_bus * bus, size_t index,
+  uint8_t command, int32_t value)
+{
+  if (bus == NULL)
+  {
+    return tic_error_create("Bus is null.");
+  }
+
+  if (index >= bus->device_count)
+  {
+    return tic_error_create("Invalid device index: %u.", (unsigned int)index);
+  }
+
+  const tic_serial_bus_device * device = &bus->devices[index];
+
+  uint8_t frame[16];
+  size_t frame_length = tic_serial_encode_request(device->device_number,
+    tic_serial_bus_frame_flags(bus, device), command, value, frame);
+  if (frame_length == 0)
+  {
+    return tic_error_create(
+      "Command 0x%02x is not available over serial.", command);
+  }
+
+  if (bus->queue_length + frame_length > bus->queue_capacity)
+  {
+    size_t new_capacity = bus->queue_capacity ? bus->queue_capacity * 2 : 256;
+    uint8_t * new_queue = realloc(bus->queue, new_capacity);
+    if (new_queue == NULL)
+    {
+      return &tic_error_no_memory;
+    }
+    bus->queue = new_queue;
+    bus->queue_capacity = new_capacity;
+  }
+
+  memcpy(bus->queue + bus->queue_length, frame, frame_length);
+  bus->queue_length += frame_length;
+  bus->queue_command_count++;
+  return NULL;
+}
+
+#ifndef _WIN32
+
+static tic_error * tic_serial_bus_send_queue(tic_serial_bus * bus)
+{
+  if (bus->queue_length == 0) { return NULL; }
+
+  tic_error * error = tic_serial_write(bus->fd, bus->queue, bus->queue_length);
+  if (error == NULL)
+  {
+    bus->command_count += bus->queue_command_count;
+    bus->bytes_sent += bus->queue_length;
+  }
+
+  // Never resend commands after a failed write, since some of them might
+  // have been sent already.
+  bus->queue_length = 0;
+  bus->queue_command_count = 0;
+  return error;
+}
+
+// Returns true if the request for the next read can be sent now without its
+// response colliding with the response that is arriving, which has
+// `remaining` bytes left.  The next response starts after its request has been
+// sent and the device's response delay has passed.  One extra byte time is
+// left as a margin.
+static bool tic_serial_bus_can_send_next(const tic_serial_bus * bus,
+  const tic_serial_bus_read * next, size_t remaining)
+{
+  uint64_t byte_time_ns = 10000000000 / bus->line_baud_rate;
+  uint64_t busy_ns = (remaining + 1) * byte_time_ns;
+  uint64_t next_start_ns = next->request_length * byte_time_ns +
+    bus->devices[next->device].response_delay_us * 1000;
+  return busy_ns <= next_start_ns;
+}
+
+static tic_error * tic_serial_bus_send_read(tic_serial_bus * bus,
+  const tic_serial_bus_read * read)
+{
+  tic_error * error = tic_serial_write(bus->fd, read->request,
+    read->request_length);
+  if (error == NULL)
+  {
+    bus->command_count++;
+    bus->bytes_sent += read->request_length;
+  }
+  return error;
+}
+
+// Performs a sequence of block reads.  The request for each read is sent once
+// the first byte of the previous response has arrived and the rest of that
+// response will be finished before the new response starts.  We wait for
+// that first byte because until then we do not know when the previous
+// response will end.
+static tic_error * tic_serial_bus_run_reads(tic_serial_bus * bus,
+  const tic_serial_bus_read * reads, size_t read_count, uint8_t * buffers)
+{
+  // Discard any stray bytes so they are not mistaken for a response.
+  tcflush(bus->fd, TCIFLUSH);
+
+  tic_error * error = NULL;
+  size_t sent_count = 0;
+
+  for (size_t i = 0; error == NULL && i < read_count; i++)
+  {
+    const tic_serial_bus_read * read = &reads[i];
+    const tic_serial_bus_read * next = i + 1 < read_count ? &reads[i + 1] : NULL;
+
+    if (sent_count == i)
+    {
+      error = tic_serial_bus_send_read(bus, read);
+      if (error != NULL) { break; }
+      sent_count++;
+    }
+
+    uint8_t response[32];
+    size_t received = 0;
+    uint64_t deadline = tic_monotonic_us() + TIC_SERIAL_TIMEOUT_MS * 1000;
+    while (error == NULL && received < read->response_length)
+    {
+      if (next != NULL && sent_count == i + 1 && received > 0 &&
+        tic_serial_bus_can_send_next(bus, next,
+          read->response_length - received))
+      {
+        error = tic_serial_bus_send_read(bus, next);
+        if (error != NULL) { break; }
+        sent_count++;
+      }
+
+      size_t count;
+      error = tic_serial_read_some(bus->fd, response + received,
+        read->response_length - received, deadline, &count);
+      received += count;
+    }
+
+    if (error == NULL)
+    {
+      bus->bytes_received += received;
+      const tic_serial_bus_device * device = &bus->devices[read->device];
+      error = tic_serial_decode_response(device->flags, response,
+        read->length, buffers + read->device * 256 + read->offset);
+    }
+
+    if (error != NULL)
+    {
+      error = tic_error_add(error,
+        "There was an error reading from device number %u.",
+        bus->devices[read->device].device_number);
+    }
+  }
+
+  return error;
+}
+
+// Adds the block reads needed to read the specified segment from a device,
+// or just counts them if reads is NULL.  Returns the number of reads.
+static size_t tic_serial_bus_plan_segment(const tic_serial_bus * bus,
+  size_t device_index, const tic_variables_segment * segment,
+  bool clear_errors_occurred, tic_serial_bus_read * reads)
+{
+  const tic_serial_bus_device * device = &bus->devices[device_index];
+  uint32_t flags = tic_serial_bus_frame_flags(bus, device);
+  size_t max_block = tic_serial_max_block_size(flags);
+
+  // Only the first block clears the errors occurred bits, like in
+  // tic_serial.c.
+  uint8_t command = (clear_errors_occurred && segment->includes_errors_occurred)
+    ? TIC_CMD_GET_VARIABLE_AND_CLEAR_ERRORS_OCCURRED : TIC_CMD_GET_VARIABLE;
+
+  size_t count = 0;
+  size_t done = 0;
+  while (done < segment->size)
+  {
+    size_t block = segment->size - done;
+    if (block > max_block) { block = max_block; }
+
+    if (reads != NULL)
+    {
+      tic_serial_bus_read * read = &reads[count];
+      read->device = device_index;
+      read->offset = segment->offset + done;
+      read->length = block;
+      read->request_length = tic_serial_encode_read(device->device_number,
+        flags, command, read->offset, read->length, read->request);
+      read->response_length = tic_serial_response_length(flags, block);
+    }
+
+    count++;
+    done += block;
+    command = TIC_CMD_GET_VARIABLE;
+  }
+  return count;
+}
+
+// Plans the block reads for all of the devices, or just counts them if reads
+// is NULL.  Returns the number of reads.
+static size_t tic_serial_bus_plan_reads(const tic_serial_bus * bus,
+  uint32_t fields, bool clear_errors_occurred, tic_serial_bus_read * reads)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < bus->device_count; i++)
+  {
+    tic_variables_segment segments[TIC_VARIABLES_MAX_SEGMENTS];
+    size_t max_block = tic_serial_max_block_size(
+      tic_serial_bus_frame_flags(bus, &bus->devices[i]));
+    size_t segment_count = tic_variables_fields_segments(
+      tic_variables_fields_for_product(fields, bus->devices[i].product),
+      max_block, segments);
+    for (size_t j = 0; j < segment_count; j++)
+    {
+      count += tic_serial_bus_plan_segment(bus, i, &segments[j],
+        clear_errors_occurred, reads ? reads + count : NULL);
+    }
+  }
+  return count;
+}
+
+#endif
+
+tic_error * tic_serial_bus_flush(tic_serial_bus * bus)
+{
+  if (bus == NULL)
+  {
+    return tic_error_create("Bus is null.");
+  }
+
+#ifdef _WIN32
+  return tic_error_create("Serial ports are not supported on Windows.");
+#else
+  uint64_t start = tic_monotonic_us();
+  tic_error * error = tic_serial_bus_send_queue(bus);
+
+  // Count the time until the commands have actually been transmitted, so
+  // that the statistics reflect the line and not the write buffer.
+  tcdrain(bus->fd);
+  bus->busy_time_us += tic_monotonic_us() - start;
+
+  if (error != NULL)
+  {
+    error = tic_error_add(error,
+      "There was an error sending commands on the serial bus.");
+  }
+  return error;
+#endif
+}
+
+tic_error * tic_serial_bus_get_variables(tic_serial_bus * bus,
+  tic_variables * const * variables, uint32_t fields,
+  bool clear_errors_occurred)
+{
+  if (bus == NULL)
+  {
+    return tic_error_create("Bus is null.");
+  }
+
+  if (variables == NULL)
+  {
+    return tic_error_create("Variables pointer is null.");
+  }
+
+  for (size_t i = 0; i < bus->device_count; i++)
+  {
+    if (variables[i] == NULL)
+    {
+      return tic_error_create("Variables pointer is null.");
+    }
+  }
+
+#ifdef _WIN32
+  (void)fields;
+  (void)clear_errors_occurred;
+  return tic_error_create("Serial ports are not supported on Windows.");
+#else
+  if (clear_errors_occurred)
+  {
+    fields |= TIC_VARIABLES_FIELD_ERRORS_OCCURRED;
+  }
+
+  tic_error * error = NULL;
+
+  size_t read_count = tic_serial_bus_plan_reads(bus, fields,
+    clear_errors_occurred, NULL);
+
+  tic_serial_bus_read * reads = NULL;
+  uint8_t * buffers = NULL;
+  if (error == NULL)
+  {
+    reads = calloc(read_count ? read_count : 1, sizeof(tic_serial_bus_read));
+    buffers = calloc(bus->device_count ? bus->device_count : 1, 256);
+    if (reads == NULL || buffers == NULL)
+    {
+      error = &tic_error_no_memory;
+    }
+  }
+
+  if (error == NULL)
+  {
+    tic_serial_bus_plan_reads(bus, fields, clear_errors_occurred, reads);
+  }
+
+  uint64_t start = tic_monotonic_us();
+
+  if (error == NULL)
+  {
+    error = tic_serial_bus_send_queue(bus);
+  }
+
+  if (error == NULL)
+  {
+    error = tic_serial_bus_run_reads(bus, reads, read_count, buffers);
+  }
+
+  bus->busy_time_us += tic_monotonic_us() - start;
+
+  if (error == NULL)
+  {
+    for (size_t i = 0; i < bus->device_count; i++)
+    {
+      tic_variables_write_from_buffer(variables[i], bus->devices[i].product,
+        buffers + i * 256, fields);
+    }
+  }
+
+  free(reads);
+  free(buffers);
+
+  if (error != NULL)
+  {
+    error = tic_error_add(error,
+      "There was an error reading variables on the serial bus.");
+  }
+
+  return error;
+#endif
+}
+
+uint64_t tic_serial_bus_get_command_count(const tic_serial_bus * bus)
+{
+  if (bus == NULL) { return 0; }
+  return bus->command_count;
+}
+
+uint64_t tic_serial_bus_get_bytes_sent(const tic_serial_bus * bus)
+{
+  if (bus == NULL) { return 0; }
+  return bus->bytes_sent;
+}
+
+uint64_t tic_serial_bus_get_bytes_received(const tic_serial_bus * bus)
+{
+  if (bus == NULL) { return 0; }
+  return bus->bytes_received;
+}
+
+uint64_t tic_serial_bus_get_busy_time_us(const tic_serial_bus * bus)
+{
+  if (bus == NULL) { return 0; }
+  return bus->busy_time_us;
+}
+
+uint32_t tic_serial_bus_get_commands_per_second(const tic_serial_bus * bus)
+{
+  if (bus == NULL || bus->busy_time_us == 0) { return 0; }
+  return bus->command_count * 1000000 / bus->busy_time_us;
+}
+
+uint32_t tic_serial_bus_get_theoretical_commands_per_second(
+  const tic_serial_bus * bus)
+{
+  if (bus == NULL) { return 0; }
+
+  // Commands and responses travel on separate wires at the same time, so the
+  // busier direction is the limit.
+  uint64_t bytes = bus->bytes_sent;
+  if (bus->bytes_received > bytes) { bytes = bus->bytes_received; }
+  if (bytes == 0) { return 0; }
+
+  return bus->command_count * bus->line_baud_rate / 10 / bytes;
+}
+
+void tic_serial_bus_reset_stats(tic_serial_bus * bus)
+{
+  if (bus == NULL) { return; }
+  bus->command_count = 0;
+  bus->bytes_sent = 0;
+  bus->bytes_received = 0;
+  bus->busy_time_us = 0;
+}
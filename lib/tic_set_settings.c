@@ -2,7 +2,7 @@
 
 #include "tic_internal.h"
 
-static void tic_write_settings_to_buffer(const tic_settings * settings, uint8_t * buf)
+void tic_write_settings_to_buffer(const tic_settings * settings, uint8_t * buf)
 {
   assert(settings != NULL);
   assert(buf != NULL);
@@ -383,8 +383,39 @@ static void tic_write_settings_to_buffer(const tic_settings * settings, uint8_t
   }
 }
 
-tic_error * tic_set_settings(tic_handle * handle, const tic_settings * settings)
+// Writes the bytes of a settings segment that are different from the
+// corresponding bytes in old_buf, or all of the bytes if old_buf is NULL.
+// Adds the number of bytes written to *bytes_written.
+static tic_error * tic_write_setting_segment(tic_handle * handle,
+  uint8_t address, size_t length, const uint8_t * buf,
+  const uint8_t * old_buf, size_t * bytes_written)
+{
+  if (old_buf == NULL)
+  {
+    tic_error * error = tic_set_setting_segment(handle,
+      address, length, buf + address);
+    if (error == NULL) { *bytes_written += length; }
+    return error;
+  }
+
+  tic_error * error = NULL;
+  for (size_t i = address; i < address + length && error == NULL; i++)
+  {
+    if (buf[i] == old_buf[i]) { continue; }
+    error = tic_set_setting_byte(handle, i, buf[i]);
+    if (error == NULL) { (*bytes_written)++; }
+  }
+  return error;
+}
+
+static tic_error * tic_set_settings_core(tic_handle * handle,
+  const tic_settings * settings, bool diff, size_t * bytes_written)
 {
+  if (bytes_written != NULL)
+  {
+    *bytes_written = 0;
+  }
+
   if (handle == NULL)
   {
     return tic_error_create("Handle is null.");
@@ -421,23 +452,58 @@ tic_error * tic_set_settings(tic_handle * handle, const tic_settings * settings)
 
   // Construct a buffer holding the bytes we want to write.
   uint8_t buf[256] = { 0 };
-  tic_write_settings_to_buffer(fixed_settings, buf);
+  if (error == NULL)
+  {
+    tic_write_settings_to_buffer(fixed_settings, buf);
+  }
 
-  // Write the bytes to the device.
   uint8_t product = tic_device_get_product(tic_handle_get_device(handle));
   tic_settings_segments segments = tic_get_settings_segments(product);
+
+  // In diff mode, read what is on the device right now.  We do not trust an
+  // earlier read because the settings can change behind our back: another
+  // program can write them, and restoring the defaults rewrites them all.
+  // Reading them only takes a couple of transfers.
+  uint8_t old_buf[256] = { 0 };
+  const uint8_t * old = NULL;
+  if (error == NULL && diff)
+  {
+    error = tic_get_setting_segment(handle,
+      segments.general_offset, segments.general_size,
+      old_buf + segments.general_offset);
+
+    if (error == NULL && segments.product_specific_size)
+    {
+      error = tic_get_setting_segment(handle,
+        segments.product_specific_offset, segments.product_specific_size,
+        old_buf + segments.product_specific_offset);
+    }
+
+    if (error == NULL)
+    {
+      old = old_buf;
+    }
+  }
+
+  // Write the bytes to the device.
+  size_t count = 0;
   if (error == NULL)
   {
-    error = tic_set_setting_segment(handle,
+    error = tic_write_setting_segment(handle,
       segments.general_offset, segments.general_size,
-      buf + segments.general_offset);
+      buf, old, &count);
   }
 
   if (error == NULL && segments.product_specific_size)
   {
-    error = tic_set_setting_segment(handle,
+    error = tic_write_setting_segment(handle,
       segments.product_specific_offset, segments.product_specific_size,
-      buf + segments.product_specific_offset);
+      buf, old, &count);
+  }
+
+  if (bytes_written != NULL)
+  {
+    *bytes_written = count;
   }
 
   tic_settings_free(fixed_settings);
@@ -450,3 +516,14 @@ tic_error * tic_set_settings(tic_handle * handle, const tic_settings * settings)
 
   return error;
 }
+
+tic_error * tic_set_settings(tic_handle * handle, const tic_settings * settings)
+{
+  return tic_set_settings_core(handle, settings, false, NULL);
+}
+
+tic_error * tic_set_settings_diff(tic_handle * handle,
+  const tic_settings * settings, size_t * bytes_written)
+{
+  return tic_set_settings_core(handle, settings, true, bytes_written);
+}
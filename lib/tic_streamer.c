@@ -0,0 +1,306 @@
+// Functions for sending a timed sequence of targets to a Tic from a background
+// thread.
+
+#include "tic_internal.h"
+
+typedef struct tic_stream_point
+{
+  uint64_t time_us;
+  int32_t value;
+  uint8_t command;
+} tic_stream_point;
+
+struct tic_streamer
+{
+  tic_handle * handle;
+  uint32_t max_lateness_us;
+
+  tic_stream_point * points;
+  size_t point_count;
+  size_t point_capacity;
+
+  // Statistics written by the streaming thread.
+  uint32_t sent_count;
+  uint32_t merged_count;
+  uint32_t dropped_count;
+  uint32_t max_jitter_us;
+  uint32_t max_latency_us;
+  uint32_t jitter_histogram[TIC_STREAMER_HISTOGRAM_SIZE];
+  uint32_t latency_histogram[TIC_STREAMER_HISTOGRAM_SIZE];
+
+  tic_thread thread;
+  bool thread_started;
+  bool stop_requested;
+
+  // Set by the first call to tic_streamer_start() and never cleared, so the
+  // statistics and error always describe one run of the sequence.
+  bool started_once;
+  bool running;
+
+  // Set by the streaming thread before it clears the running flag.
+  tic_error * error;
+};
+
+tic_error * tic_streamer_create(tic_handle * handle, uint32_t max_lateness_us,
+  tic_streamer ** streamer)
+{
+  if (streamer == NULL)
+  {
+    return tic_error_create("Streamer output pointer is null.");
+  }
+
+  *streamer = NULL;
+
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle is null.");
+  }
+
+  tic_streamer * new_streamer = calloc(1, sizeof(tic_streamer));
+  if (new_streamer == NULL)
+  {
+    return &tic_error_no_memory;
+  }
+
+  new_streamer->handle = handle;
+  new_streamer->max_lateness_us = max_lateness_us;
+  *streamer = new_streamer;
+  return NULL;
+}
+
+void tic_streamer_free(tic_streamer * streamer)
+{
+  if (streamer == NULL) { return; }
+
+  tic_streamer_stop(streamer);
+  free(streamer->points);
+  tic_error_free(streamer->error);
+  free(streamer);
+}
+
+tic_error * tic_streamer_add_point(tic_streamer * streamer, uint64_t time_us,
+  uint8_t command, int32_t value)
+{
+  if (streamer == NULL)
+  {
+    return tic_error_create("Streamer is null.");
+  }
+
+  if (streamer->started_once)
+  {
+    return tic_error_create("Points cannot be added after the streamer starts.");
+  }
+
+  if (command != TIC_STREAM_TARGET_POSITION &&
+    command != TIC_STREAM_TARGET_VELOCITY)
+  {
+    return tic_error_create("Invalid stream command: %u.", command);
+  }
+
+  if (streamer->point_count &&
+    time_us < streamer->points[streamer->point_count - 1].time_us)
+  {
+    return tic_error_create("Stream points must be in order of time.");
+  }
+
+  if (streamer->point_count == streamer->point_capacity)
+  {
+    size_t new_capacity = streamer->point_capacity ?
+      streamer->point_capacity * 2 : 64;
+    tic_stream_point * new_points = realloc(streamer->points,
+      new_capacity * sizeof(tic_stream_point));
+    if (new_points == NULL)
+    {
+      return &tic_error_no_memory;
+    }
+    streamer->points = new_points;
+    streamer->point_capacity = new_capacity;
+  }
+
+  tic_stream_point * point = &streamer->points[streamer->point_count++];
+  point->time_us = time_us;
+  point->command = command;
+  point->value = value;
+  return NULL;
+}
+
+size_t tic_streamer_get_point_count(const tic_streamer * streamer)
+{
+  if (streamer == NULL) { return 0; }
+  return streamer->point_count;
+}
+
+static tic_error * tic_streamer_send(tic_streamer * streamer,
+  const tic_stream_point * point)
+{
+  if (point->command == TIC_STREAM_TARGET_VELOCITY)
+  {
+    return tic_set_target_velocity(streamer->handle, point->value);
+  }
+  return tic_set_target_position(streamer->handle, point->value);
+}
+
+static void * tic_streamer_thread(void * arg)
+{
+  tic_streamer * streamer = arg;
+
+  uint64_t start = tic_monotonic_us();
+
+  size_t i = 0;
+  while (i < streamer->point_count &&
+    !tic_atomic_load_bool(&streamer->stop_requested))
+  {
+    const tic_stream_point * point = &streamer->points[i];
+    uint64_t deadline = start + point->time_us;
+    tic_sleep_until_us(deadline);
+
+    // If we are so late that the next point is also due and it is the same
+    // kind of command, it would just overwrite this one, so skip ahead to it.
+    uint64_t now = tic_monotonic_us();
+    if (i + 1 < streamer->point_count &&
+      start + streamer->points[i + 1].time_us <= now &&
+      streamer->points[i + 1].command == point->command)
+    {
+      tic_atomic_add_u32(&streamer->merged_count, 1);
+      i++;
+      continue;
+    }
+
+    // Drop points that are too late to be useful, except the last one, since
+    // it is where the motor should end up.
+    uint64_t lateness = now - deadline;
+    if (streamer->max_lateness_us && lateness > streamer->max_lateness_us &&
+      i + 1 < streamer->point_count)
+    {
+      tic_atomic_add_u32(&streamer->dropped_count, 1);
+      i++;
+      continue;
+    }
+
+    tic_error * error = tic_streamer_send(streamer, point);
+    uint64_t done = tic_monotonic_us();
+    if (error != NULL)
+    {
+      streamer->error = error;
+      break;
+    }
+
+    tic_latency_record(streamer->jitter_histogram,
+      TIC_STREAMER_HISTOGRAM_SIZE, &streamer->max_jitter_us, lateness);
+    tic_latency_record(streamer->latency_histogram,
+      TIC_STREAMER_HISTOGRAM_SIZE, &streamer->max_latency_us, done - now);
+    tic_atomic_add_u32(&streamer->sent_count, 1);
+    i++;
+  }
+
+  tic_atomic_store_bool(&streamer->running, false);
+  return NULL;
+}
+
+tic_error * tic_streamer_start(tic_streamer * streamer)
+{
+  if (streamer == NULL)
+  {
+    return tic_error_create("Streamer is null.");
+  }
+
+  if (streamer->started_once)
+  {
+    return tic_error_create("The streamer was already started.");
+  }
+
+  streamer->stop_requested = false;
+  streamer->running = true;
+
+  int result = tic_thread_create(&streamer->thread,
+    tic_streamer_thread, streamer);
+  if (result != 0)
+  {
+    streamer->running = false;
+    return tic_error_create(
+      "Failed to start the streamer thread.  Error code %d.", result);
+  }
+
+  streamer->thread_started = true;
+  streamer->started_once = true;
+  return NULL;
+}
+
+void tic_streamer_wait(tic_streamer * streamer)
+{
+  if (streamer == NULL || !streamer->thread_started) { return; }
+
+  tic_thread_join(streamer->thread);
+  streamer->thread_started = false;
+}
+
+void tic_streamer_stop(tic_streamer * streamer)
+{
+  if (streamer == NULL) { return; }
+
+  tic_atomic_store_bool(&streamer->stop_requested, true);
+  tic_streamer_wait(streamer);
+}
+
+bool tic_streamer_is_running(const tic_streamer * streamer)
+{
+  if (streamer == NULL) { return false; }
+  return tic_atomic_load_bool(&streamer->running);
+}
+
+const tic_error * tic_streamer_get_error(const tic_streamer * streamer)
+{
+  if (streamer == NULL) { return NULL; }
+  if (tic_atomic_load_bool(&streamer->running)) { return NULL; }
+  return streamer->error;
+}
+
+uint32_t tic_streamer_get_sent_count(const tic_streamer * streamer)
+{
+  if (streamer == NULL) { return 0; }
+  return tic_atomic_load_u32(&streamer->sent_count);
+}
+
+uint32_t tic_streamer_get_merged_count(const tic_streamer * streamer)
+{
+  if (streamer == NULL) { return 0; }
+  return tic_atomic_load_u32(&streamer->merged_count);
+}
+
+uint32_t tic_streamer_get_dropped_count(const tic_streamer * streamer)
+{
+  if (streamer == NULL) { return 0; }
+  return tic_atomic_load_u32(&streamer->dropped_count);
+}
+
+uint32_t tic_streamer_get_max_jitter_us(const tic_streamer * streamer)
+{
+  if (streamer == NULL) { return 0; }
+  return tic_atomic_load_u32(&streamer->max_jitter_us);
+}
+
+uint32_t tic_streamer_get_max_latency_us(const tic_streamer * streamer)
+{
+  if (streamer == NULL) { return 0; }
+  return tic_atomic_load_u32(&streamer->max_latency_us);
+}
+
+void tic_streamer_get_jitter_histogram(const tic_streamer * streamer,
+  uint32_t * counts)
+{
+  for (size_t i = 0; i < TIC_STREAMER_HISTOGRAM_SIZE; i++)
+  {
+    counts[i] = streamer == NULL ? 0 :
+      tic_atomic_load_u32(&streamer->jitter_histogram[i]);
+  }
+}
+
+void tic_streamer_get_latency_histogram(const tic_streamer * streamer,
+  uint32_t * counts)
+{
+  for (size_t i = 0; i < TIC_STREAMER_HISTOGRAM_SIZE; i++)
+  {
+    counts[i] = streamer == NULL ? 0 :
+      tic_atomic_load_u32(&streamer->latency_histogram[i]);
+  }
+}
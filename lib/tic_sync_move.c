@@ -0,0 +1,537 @@
+// Functions for moving several Tics so that they all arrive at the same time.
+//
+// If every axis follows the same speed profile, scaled by the distance it has
+// to travel, then every axis starts, stops accelerating, starts decelerating,
+// and arrives at the same time, and the tool moves in a straight line.  So we
+// pick a profile for a move of distance 1 that is as fast as the slowest axis
+// allows, and scale its starting speed, speed, and acceleration by each
+// axis's distance.
+
+#include "tic_internal.h"
+
+typedef struct tic_sync_move_axis
+{
+  tic_sync_move * move;
+  tic_handle * handle;
+  bool moving;
+  int32_t target;
+  int32_t distance;
+
+  // The axis's own limits, read before the first move.  The limits the Tic
+  // reports after that are the ones we set for the move.
+  bool limits_known;
+  uint32_t limit_starting_speed;
+  uint32_t limit_max_speed;
+  uint32_t limit_accel;
+
+  uint32_t starting_speed;
+  uint32_t max_speed;
+  uint32_t max_accel;
+
+  tic_thread thread;
+  bool thread_started;
+
+  // Written by the axis's thread.
+  tic_error * error;
+  uint64_t send_start_us;
+  uint64_t send_end_us;
+  int32_t snapshot_velocity;
+  uint64_t snapshot_time_us;
+  int64_t start_offset_us;
+} tic_sync_move_axis;
+
+struct tic_sync_move
+{
+  tic_sync_move_axis * axes;
+  size_t axis_count;
+
+  // The barrier that the axis threads wait at before sending their targets.
+  // If abort is set when they are released, they do not send anything.
+  uint32_t ready_count;
+  bool release;
+  bool abort;
+
+  uint32_t duration_us;
+  uint32_t send_skew_us;
+  uint32_t start_skew_us;
+};
+
+tic_error * tic_sync_move_create(tic_handle * const * handles,
+  size_t handle_count, tic_sync_move ** move)
+{
+  if (move == NULL)
+  {
+    return tic_error_create("Sync move output pointer is null.");
+  }
+
+  *move = NULL;
+
+  if (handle_count == 0)
+  {
+    return tic_error_create("No handles were specified.");
+  }
+
+  if (handles == NULL)
+  {
+    return tic_error_create("Handle list is null.");
+  }
+
+  for (size_t i = 0; i < handle_count; i++)
+  {
+    if (handles[i] == NULL)
+    {
+      return tic_error_create("Handle %u is null.", (unsigned int)i);
+    }
+  }
+
+  tic_sync_move * new_move = calloc(1, sizeof(tic_sync_move));
+  if (new_move == NULL)
+  {
+    return &tic_error_no_memory;
+  }
+
+  new_move->axes = calloc(handle_count, sizeof(tic_sync_move_axis));
+  if (new_move->axes == NULL)
+  {
+    free(new_move);
+    return &tic_error_no_memory;
+  }
+
+  new_move->axis_count = handle_count;
+  for (size_t i = 0; i < handle_count; i++)
+  {
+    new_move->axes[i].move = new_move;
+    new_move->axes[i].handle = handles[i];
+  }
+
+  *move = new_move;
+  return NULL;
+}
+
+static void tic_sync_move_clear_errors(tic_sync_move * move)
+{
+  for (size_t i = 0; i < move->axis_count; i++)
+  {
+    tic_error_free(move->axes[i].error);
+    move->axes[i].error = NULL;
+  }
+}
+
+void tic_sync_move_free(tic_sync_move * move)
+{
+  if (move == NULL) { return; }
+
+  tic_sync_move_clear_errors(move);
+  free(move->axes);
+  free(move);
+}
+
+static double tic_sync_move_abs(double x)
+{
+  return x < 0 ? -x : x;
+}
+
+static double tic_sync_move_sqrt(double x)
+{
+  if (x <= 0) { return 0; }
+  double r = x < 1 ? 1 : x;
+  for (int i = 0; i < 64; i++)
+  {
+    double next = (r + x / r) / 2;
+    if (next >= r) { break; }
+    r = next;
+  }
+  return r;
+}
+
+static uint32_t tic_sync_move_round(double x, uint32_t min, uint32_t max)
+{
+  if (x < min) { return min; }
+  if (x > max) { return max; }
+  return (uint32_t)(x + 0.5);
+}
+
+// Reads the state of every axis and works out the limits for each one.
+static tic_error * tic_sync_move_plan(tic_sync_move * move,
+  const int32_t * targets)
+{
+  tic_variables * vars = NULL;
+  tic_error * error = tic_variables_create(&vars);
+
+  // The fastest profile for a move of distance 1 that no axis objects to,
+  // with speeds in distances per second and accelerations in distances per
+  // second squared.
+  double starting_speed = -1, max_speed = -1, max_accel = -1;
+  size_t speed_axis = 0, accel_axis = 0;
+
+  for (size_t i = 0; error == NULL && i < move->axis_count; i++)
+  {
+    tic_sync_move_axis * axis = &move->axes[i];
+    error = tic_get_variables(axis->handle, &vars, false);
+    if (error)
+    {
+      error = tic_error_add(error, "Failed to read the state of axis %u.",
+        (unsigned int)i);
+      break;
+    }
+
+    if (tic_variables_get_current_velocity(vars) != 0)
+    {
+      error = tic_error_create("Axis %u is moving.", (unsigned int)i);
+      break;
+    }
+
+    int64_t distance = (int64_t)targets[i] -
+      tic_variables_get_current_position(vars);
+    if (distance > INT32_MAX || distance < -INT32_MAX)
+    {
+      error = tic_error_create("The move for axis %u is too long.",
+        (unsigned int)i);
+      break;
+    }
+
+    if (!axis->limits_known)
+    {
+      uint32_t decel = tic_variables_get_max_decel(vars);
+      uint32_t accel = tic_variables_get_max_accel(vars);
+      axis->limit_starting_speed = tic_variables_get_starting_speed(vars);
+      axis->limit_max_speed = tic_variables_get_max_speed(vars);
+      axis->limit_accel = decel < accel ? decel : accel;
+      axis->limits_known = true;
+    }
+
+    axis->target = targets[i];
+    axis->distance = (int32_t)distance;
+    axis->moving = distance != 0;
+    if (!axis->moving) { continue; }
+
+    double d = tic_sync_move_abs((double)distance);
+    double s = axis->limit_starting_speed / (double)TIC_SPEED_UNITS_PER_HZ / d;
+    double v = axis->limit_max_speed / (double)TIC_SPEED_UNITS_PER_HZ / d;
+    double a = axis->limit_accel / (double)TIC_ACCEL_UNITS_PER_HZ2 / d;
+    if (starting_speed < 0 || s < starting_speed) { starting_speed = s; }
+    if (max_speed < 0 || v < max_speed) { max_speed = v; speed_axis = i; }
+    if (max_accel < 0 || a < max_accel) { max_accel = a; accel_axis = i; }
+  }
+
+  tic_variables_free(vars);
+
+  if (error) { return error; }
+
+  if (max_speed < 0) { return NULL; }  // No axis needs to move.
+
+  if (max_speed == 0)
+  {
+    return tic_error_create("The maximum speed of an axis is 0.");
+  }
+
+  if (starting_speed > max_speed) { starting_speed = max_speed; }
+
+  // The Tic cannot accelerate more slowly than TIC_MIN_ALLOWED_ACCEL or
+  // cruise more slowly than one speed unit.  If an axis's move is so much
+  // shorter than another's that its scaled profile would need that, it would
+  // get a faster profile and arrive early, so we refuse to do the move.
+  // Making the profile slower would only make this worse.
+  for (size_t i = 0; i < move->axis_count; i++)
+  {
+    tic_sync_move_axis * axis = &move->axes[i];
+    if (!axis->moving) { continue; }
+    double d = tic_sync_move_abs((double)axis->distance);
+    if (max_accel * d * TIC_ACCEL_UNITS_PER_HZ2 + 0.5 < TIC_MIN_ALLOWED_ACCEL)
+    {
+      return tic_error_create(
+        "The move for axis %u is too short to finish at the same time as "
+        "the move for axis %u: axis %u would need an acceleration below the "
+        "minimum of %u.",
+        (unsigned int)i, (unsigned int)accel_axis, (unsigned int)i,
+        TIC_MIN_ALLOWED_ACCEL);
+    }
+    if (max_speed * d * TIC_SPEED_UNITS_PER_HZ + 0.5 < 1)
+    {
+      return tic_error_create(
+        "The move for axis %u is too short to finish at the same time as "
+        "the move for axis %u: axis %u would need a max speed below the "
+        "minimum of 1.",
+        (unsigned int)i, (unsigned int)speed_axis, (unsigned int)i);
+    }
+  }
+
+  for (size_t i = 0; i < move->axis_count; i++)
+  {
+    tic_sync_move_axis * axis = &move->axes[i];
+    if (!axis->moving) { continue; }
+    double d = tic_sync_move_abs((double)axis->distance);
+    axis->starting_speed = tic_sync_move_round(
+      starting_speed * d * TIC_SPEED_UNITS_PER_HZ, 0, TIC_MAX_ALLOWED_SPEED);
+    axis->max_speed = tic_sync_move_round(
+      max_speed * d * TIC_SPEED_UNITS_PER_HZ, 1, TIC_MAX_ALLOWED_SPEED);
+    axis->max_accel = tic_sync_move_round(
+      max_accel * d * TIC_ACCEL_UNITS_PER_HZ2,
+      TIC_MIN_ALLOWED_ACCEL, TIC_MAX_ALLOWED_ACCEL);
+  }
+
+  // Work out how long the move takes: the time to speed up, cruise, and slow
+  // down, or just to speed up and slow down if it never reaches full speed.
+  double ramp_time = (max_speed - starting_speed) / max_accel;
+  double ramp_distance = (max_speed * max_speed -
+    starting_speed * starting_speed) / (2 * max_accel);
+  double duration;
+  if (2 * ramp_distance <= 1)
+  {
+    duration = 2 * ramp_time + (1 - 2 * ramp_distance) / max_speed;
+  }
+  else
+  {
+    double peak_speed = tic_sync_move_sqrt(
+      starting_speed * starting_speed + max_accel);
+    duration = 2 * (peak_speed - starting_speed) / max_accel;
+  }
+  move->duration_us = tic_sync_move_round(duration * 1000000, 0, UINT32_MAX);
+
+  return NULL;
+}
+
+static tic_error * tic_sync_move_stage(tic_sync_move_axis * axis)
+{
+  tic_error * error = tic_set_starting_speed(axis->handle, axis->starting_speed);
+  if (error == NULL)
+  {
+    error = tic_set_max_speed(axis->handle, axis->max_speed);
+  }
+  if (error == NULL)
+  {
+    error = tic_set_max_accel(axis->handle, axis->max_accel);
+  }
+  if (error == NULL)
+  {
+    error = tic_set_max_decel(axis->handle, axis->max_accel);
+  }
+  return error;
+}
+
+static void * tic_sync_move_thread(void * arg)
+{
+  tic_sync_move_axis * axis = arg;
+  tic_sync_move * move = axis->move;
+
+  // Wait at the barrier.  The wait is only as long as it takes to start the
+  // other threads, so we spin instead of sleeping, which would add the
+  // scheduler's wake-up latency to the skew.
+  tic_atomic_add_u32(&move->ready_count, 1);
+  while (!tic_atomic_load_bool(&move->release)) { tic_thread_yield(); }
+  if (move->abort) { return NULL; }
+
+  axis->send_start_us = tic_monotonic_us();
+  tic_error * error = tic_set_target_position(axis->handle, axis->target);
+  axis->send_end_us = tic_monotonic_us();
+
+  // Read the velocity right away, so we can tell how long ago the axis
+  // started moving.
+  tic_variables * vars = NULL;
+  if (error == NULL)
+  {
+    error = tic_variables_create(&vars);
+  }
+  if (error == NULL)
+  {
+    uint64_t start = tic_monotonic_us();
+    error = tic_get_variables_fields(axis->handle, vars,
+      TIC_VARIABLES_FIELD_CURRENT_VELOCITY, false);
+    uint64_t end = tic_monotonic_us();
+    axis->snapshot_time_us = start + (end - start) / 2;
+  }
+  if (error == NULL)
+  {
+    axis->snapshot_velocity = tic_variables_get_current_velocity(vars);
+  }
+  tic_variables_free(vars);
+
+  axis->error = error;
+  return NULL;
+}
+
+// Works out when each axis started moving from the snapshot its thread took:
+// the axis has been speeding up since it started, so the speed it has gained
+// divided by its acceleration is how long ago that was.
+static void tic_sync_move_measure(tic_sync_move * move)
+{
+  uint64_t min_end = UINT64_MAX, max_end = 0;
+  int64_t min_start = INT64_MAX, max_start = INT64_MIN;
+
+  for (size_t i = 0; i < move->axis_count; i++)
+  {
+    tic_sync_move_axis * axis = &move->axes[i];
+    if (!axis->moving) { continue; }
+
+    if (axis->send_end_us < min_end) { min_end = axis->send_end_us; }
+    if (axis->send_end_us > max_end) { max_end = axis->send_end_us; }
+
+    double speed_gained = tic_sync_move_abs((double)axis->snapshot_velocity) -
+      axis->starting_speed;
+    if (speed_gained < 0) { speed_gained = 0; }
+    double moving_us = speed_gained * TIC_ACCEL_UNITS_PER_HZ2 /
+      TIC_SPEED_UNITS_PER_HZ / axis->max_accel * 1000000;
+    axis->start_offset_us = (int64_t)axis->snapshot_time_us -
+      (int64_t)(moving_us + 0.5);
+
+    if (axis->start_offset_us < min_start) { min_start = axis->start_offset_us; }
+    if (axis->start_offset_us > max_start) { max_start = axis->start_offset_us; }
+  }
+
+  if (max_end == 0)
+  {
+    move->send_skew_us = move->start_skew_us = 0;
+    return;
+  }
+
+  move->send_skew_us = (uint32_t)(max_end - min_end);
+  move->start_skew_us = (uint32_t)(max_start - min_start);
+  for (size_t i = 0; i < move->axis_count; i++)
+  {
+    tic_sync_move_axis * axis = &move->axes[i];
+    if (axis->moving) { axis->start_offset_us -= min_start; }
+  }
+}
+
+tic_error * tic_sync_move_start(tic_sync_move * move, const int32_t * targets,
+  size_t target_count)
+{
+  if (move == NULL)
+  {
+    return tic_error_create("Sync move is null.");
+  }
+
+  if (targets == NULL)
+  {
+    return tic_error_create("Target list is null.");
+  }
+
+  if (target_count != move->axis_count)
+  {
+    return tic_error_create("Expected %u targets but got %u.",
+      (unsigned int)move->axis_count, (unsigned int)target_count);
+  }
+
+  tic_sync_move_clear_errors(move);
+  move->duration_us = move->send_skew_us = move->start_skew_us = 0;
+  for (size_t i = 0; i < move->axis_count; i++)
+  {
+    tic_sync_move_axis * axis = &move->axes[i];
+    axis->moving = false;
+    axis->starting_speed = axis->max_speed = axis->max_accel = 0;
+    axis->start_offset_us = 0;
+  }
+
+  tic_error * error = tic_sync_move_plan(move, targets);
+
+  for (size_t i = 0; error == NULL && i < move->axis_count; i++)
+  {
+    tic_sync_move_axis * axis = &move->axes[i];
+    if (!axis->moving) { continue; }
+    error = tic_sync_move_stage(axis);
+    if (error)
+    {
+      error = tic_error_add(error, "Failed to set the limits of axis %u.",
+        (unsigned int)i);
+    }
+  }
+
+  // Start a thread for each axis that needs to move.
+  move->ready_count = 0;
+  move->release = false;
+  uint32_t thread_count = 0;
+  for (size_t i = 0; error == NULL && i < move->axis_count; i++)
+  {
+    tic_sync_move_axis * axis = &move->axes[i];
+    if (!axis->moving) { continue; }
+    int result = tic_thread_create(&axis->thread, tic_sync_move_thread, axis);
+    if (result != 0)
+    {
+      error = tic_error_create(
+        "Failed to start a sync move thread.  Error code %d.", result);
+      break;
+    }
+    axis->thread_started = true;
+    thread_count++;
+  }
+
+  // If we could not start every thread, the threads we did start still have
+  // to be released so they can finish, but they will not send anything.
+  while (error == NULL &&
+    tic_atomic_load_u32(&move->ready_count) < thread_count)
+  {
+    tic_thread_yield();
+  }
+  move->abort = error != NULL;
+  tic_atomic_store_bool(&move->release, true);
+
+  for (size_t i = 0; i < move->axis_count; i++)
+  {
+    tic_sync_move_axis * axis = &move->axes[i];
+    if (!axis->thread_started) { continue; }
+    tic_thread_join(axis->thread);
+    axis->thread_started = false;
+    if (error == NULL && axis->error != NULL)
+    {
+      error = tic_error_add(tic_error_copy(axis->error),
+        "Failed to start the move of axis %u.", (unsigned int)i);
+    }
+  }
+
+  if (error == NULL)
+  {
+    tic_sync_move_measure(move);
+  }
+
+  return error;
+}
+
+size_t tic_sync_move_get_axis_count(const tic_sync_move * move)
+{
+  if (move == NULL) { return 0; }
+  return move->axis_count;
+}
+
+uint32_t tic_sync_move_get_duration_us(const tic_sync_move * move)
+{
+  if (move == NULL) { return 0; }
+  return move->duration_us;
+}
+
+uint32_t tic_sync_move_get_max_speed(const tic_sync_move * move, size_t index)
+{
+  if (move == NULL || index >= move->axis_count) { return 0; }
+  return move->axes[index].max_speed;
+}
+
+uint32_t tic_sync_move_get_max_accel(const tic_sync_move * move, size_t index)
+{
+  if (move == NULL || index >= move->axis_count) { return 0; }
+  return move->axes[index].max_accel;
+}
+
+uint32_t tic_sync_move_get_starting_speed(const tic_sync_move * move,
+  size_t index)
+{
+  if (move == NULL || index >= move->axis_count) { return 0; }
+  return move->axes[index].starting_speed;
+}
+
+uint32_t tic_sync_move_get_send_skew_us(const tic_sync_move * move)
+{
+  if (move == NULL) { return 0; }
+  return move->send_skew_us;
+}
+
+uint32_t tic_sync_move_get_start_skew_us(const tic_sync_move * move)
+{
+  if (move == NULL) { return 0; }
+  return move->start_skew_us;
+}
+
+uint32_t tic_sync_move_get_start_offset_us(const tic_sync_move * move,
+  size_t index)
+{
+  if (move == NULL || index >= move->axis_count) { return 0; }
+  return (uint32_t)move->axes[index].start_offset_us;
+}
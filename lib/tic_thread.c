@@ -0,0 +1,170 @@
+// Threads, mutexes, and condition variables for Windows and POSIX systems.
+
+#include "tic_internal.h"
+
+#ifdef _WIN32
+
+typedef struct tic_thread_start
+{
+  void * (*function)(void *);
+  void * arg;
+} tic_thread_start;
+
+static DWORD WINAPI tic_thread_trampoline(LPVOID param)
+{
+  tic_thread_start start = *(tic_thread_start *)param;
+  free(param);
+  start.function(start.arg);
+  return 0;
+}
+
+int tic_thread_create(tic_thread * thread, void * (*function)(void *),
+  void * arg)
+{
+  tic_thread_start * start = malloc(sizeof(tic_thread_start));
+  if (start == NULL) { return ERROR_NOT_ENOUGH_MEMORY; }
+  start->function = function;
+  start->arg = arg;
+
+  *thread = CreateThread(NULL, 0, tic_thread_trampoline, start, 0, NULL);
+  if (*thread == NULL)
+  {
+    free(start);
+    return (int)GetLastError();
+  }
+  return 0;
+}
+
+void tic_thread_join(tic_thread thread)
+{
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
+}
+
+void tic_thread_yield(void)
+{
+  SwitchToThread();
+}
+
+void tic_mutex_init(tic_mutex * mutex)
+{
+  InitializeSRWLock(mutex);
+}
+
+void tic_mutex_destroy(tic_mutex * mutex)
+{
+  // SRW locks do not need to be destroyed.
+  (void)mutex;
+}
+
+void tic_mutex_lock(tic_mutex * mutex)
+{
+  AcquireSRWLockExclusive(mutex);
+}
+
+void tic_mutex_unlock(tic_mutex * mutex)
+{
+  ReleaseSRWLockExclusive(mutex);
+}
+
+void tic_cond_init(tic_cond * cond)
+{
+  InitializeConditionVariable(cond);
+}
+
+void tic_cond_destroy(tic_cond * cond)
+{
+  // Condition variables do not need to be destroyed.
+  (void)cond;
+}
+
+void tic_cond_wait(tic_cond * cond, tic_mutex * mutex)
+{
+  SleepConditionVariableSRW(cond, mutex, INFINITE, 0);
+}
+
+void tic_cond_broadcast(tic_cond * cond)
+{
+  WakeAllConditionVariable(cond);
+}
+
+void tic_cond_wait_us(tic_cond * cond, tic_mutex * mutex, uint64_t timeout_us)
+{
+  // Round up so that a short timeout does not turn into a busy loop.
+  uint64_t timeout_ms = (timeout_us + 999) / 1000;
+  if (timeout_ms >= INFINITE) { timeout_ms = INFINITE - 1; }
+  SleepConditionVariableSRW(cond, mutex, (DWORD)timeout_ms, 0);
+}
+
+#else
+
+#include <sched.h>
+
+int tic_thread_create(tic_thread * thread, void * (*function)(void *),
+  void * arg)
+{
+  return pthread_create(thread, NULL, function, arg);
+}
+
+void tic_thread_join(tic_thread thread)
+{
+  pthread_join(thread, NULL);
+}
+
+void tic_thread_yield(void)
+{
+  sched_yield();
+}
+
+void tic_mutex_init(tic_mutex * mutex)
+{
+  pthread_mutex_init(mutex, NULL);
+}
+
+void tic_mutex_destroy(tic_mutex * mutex)
+{
+  pthread_mutex_destroy(mutex);
+}
+
+void tic_mutex_lock(tic_mutex * mutex)
+{
+  pthread_mutex_lock(mutex);
+}
+
+void tic_mutex_unlock(tic_mutex * mutex)
+{
+  pthread_mutex_unlock(mutex);
+}
+
+void tic_cond_init(tic_cond * cond)
+{
+  pthread_cond_init(cond, NULL);
+}
+
+void tic_cond_destroy(tic_cond * cond)
+{
+  pthread_cond_destroy(cond);
+}
+
+void tic_cond_wait(tic_cond * cond, tic_mutex * mutex)
+{
+  pthread_cond_wait(cond, mutex);
+}
+
+void tic_cond_broadcast(tic_cond * cond)
+{
+  pthread_cond_broadcast(cond);
+}
+
+void tic_cond_wait_us(tic_cond * cond, tic_mutex * mutex, uint64_t timeout_us)
+{
+  // pthread_cond_timedwait takes a time from the realtime clock.
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  uint64_t nsec = ts.tv_nsec + timeout_us % 1000000 * 1000;
+  ts.tv_sec += timeout_us / 1000000 + nsec / 1000000000;
+  ts.tv_nsec = nsec % 1000000000;
+  pthread_cond_timedwait(cond, mutex, &ts);
+}
+
+#endif
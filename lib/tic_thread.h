@@ -0,0 +1,194 @@
+// Internal threads, mutexes, condition variables, and atomic operations.
+//
+// The library uses POSIX threads where they are available and Windows threads
+// on Windows.  The atomic operations use the GCC/Clang __atomic builtins,
+// which MinGW also has, and the Interlocked functions with MSVC.  Loads have
+// acquire semantics, stores have release semantics, and additions are full
+// barriers, which is stronger than some callers need but simple to port.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+
+// Threads.
+
+#ifdef _WIN32
+typedef HANDLE tic_thread;
+#else
+typedef pthread_t tic_thread;
+#endif
+
+// Starts a thread that runs function(arg).  Returns 0 on success or a
+// platform error code.
+int tic_thread_create(tic_thread * thread, void * (*function)(void *),
+  void * arg);
+
+// Waits for a thread to finish and releases it.
+void tic_thread_join(tic_thread thread);
+
+// Lets other threads run, for spin loops.
+void tic_thread_yield(void);
+
+
+// Mutexes, which are not recursive.
+
+#ifdef _WIN32
+typedef SRWLOCK tic_mutex;
+#define TIC_MUTEX_INITIALIZER SRWLOCK_INIT
+#else
+typedef pthread_mutex_t tic_mutex;
+#define TIC_MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+#endif
+
+void tic_mutex_init(tic_mutex * mutex);
+void tic_mutex_destroy(tic_mutex * mutex);
+void tic_mutex_lock(tic_mutex * mutex);
+void tic_mutex_unlock(tic_mutex * mutex);
+
+
+// Condition variables.
+
+#ifdef _WIN32
+typedef CONDITION_VARIABLE tic_cond;
+#else
+typedef pthread_cond_t tic_cond;
+#endif
+
+void tic_cond_init(tic_cond * cond);
+void tic_cond_destroy(tic_cond * cond);
+void tic_cond_wait(tic_cond * cond, tic_mutex * mutex);
+void tic_cond_broadcast(tic_cond * cond);
+
+// Like tic_cond_wait(), but returns after at most timeout_us microseconds.
+// It can also return early, so callers must check their condition again.
+void tic_cond_wait_us(tic_cond * cond, tic_mutex * mutex, uint64_t timeout_us);
+
+
+// Atomic operations.
+
+#if defined(__GNUC__) || defined(__clang__)
+
+#define TIC_ATOMIC_LOAD_STORE(name, type) \
+  static inline type tic_atomic_load_##name(const type * p) \
+    { return __atomic_load_n(p, __ATOMIC_ACQUIRE); } \
+  static inline void tic_atomic_store_##name(type * p, type value) \
+    { __atomic_store_n(p, value, __ATOMIC_RELEASE); }
+
+#define TIC_ATOMIC_ADD(name, type) \
+  static inline type tic_atomic_add_##name(type * p, type value) \
+    { return __atomic_add_fetch(p, value, __ATOMIC_SEQ_CST); }
+
+TIC_ATOMIC_LOAD_STORE(bool, bool)
+TIC_ATOMIC_LOAD_STORE(u32, uint32_t)
+TIC_ATOMIC_LOAD_STORE(u64, uint64_t)
+TIC_ATOMIC_LOAD_STORE(size, size_t)
+TIC_ATOMIC_ADD(u32, uint32_t)
+TIC_ATOMIC_ADD(u64, uint64_t)
+
+#undef TIC_ATOMIC_LOAD_STORE
+#undef TIC_ATOMIC_ADD
+
+static inline void * tic_atomic_load_ptr(void * const * p)
+{
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void tic_atomic_store_ptr(void ** p, void * value)
+{
+  __atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+
+#elif defined(_MSC_VER)
+
+// MSVC makes volatile accesses acquire and release on x86 but not on ARM, so
+// the bool functions add explicit barriers.
+
+static inline bool tic_atomic_load_bool(const bool * p)
+{
+  bool value = *(const volatile bool *)p;
+  MemoryBarrier();
+  return value;
+}
+
+static inline void tic_atomic_store_bool(bool * p, bool value)
+{
+  MemoryBarrier();
+  *(volatile bool *)p = value;
+  MemoryBarrier();
+}
+
+// The Interlocked functions do not take const pointers, so the loads are
+// compare-exchanges that never change the value.
+
+static inline uint32_t tic_atomic_load_u32(const uint32_t * p)
+{
+  return (uint32_t)InterlockedCompareExchange((volatile LONG *)p, 0, 0);
+}
+
+static inline void tic_atomic_store_u32(uint32_t * p, uint32_t value)
+{
+  InterlockedExchange((volatile LONG *)p, (LONG)value);
+}
+
+static inline uint32_t tic_atomic_add_u32(uint32_t * p, uint32_t value)
+{
+  return (uint32_t)InterlockedExchangeAdd((volatile LONG *)p, (LONG)value)
+    + value;
+}
+
+static inline uint64_t tic_atomic_load_u64(const uint64_t * p)
+{
+  return (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)p, 0, 0);
+}
+
+static inline void tic_atomic_store_u64(uint64_t * p, uint64_t value)
+{
+  InterlockedExchange64((volatile LONG64 *)p, (LONG64)value);
+}
+
+static inline uint64_t tic_atomic_add_u64(uint64_t * p, uint64_t value)
+{
+  return (uint64_t)InterlockedExchangeAdd64((volatile LONG64 *)p,
+    (LONG64)value) + value;
+}
+
+static inline size_t tic_atomic_load_size(const size_t * p)
+{
+#ifdef _WIN64
+  return (size_t)tic_atomic_load_u64((const uint64_t *)p);
+#else
+  return (size_t)tic_atomic_load_u32((const uint32_t *)p);
+#endif
+}
+
+static inline void tic_atomic_store_size(size_t * p, size_t value)
+{
+#ifdef _WIN64
+  tic_atomic_store_u64((uint64_t *)p, value);
+#else
+  tic_atomic_store_u32((uint32_t *)p, value);
+#endif
+}
+
+static inline void * tic_atomic_load_ptr(void * const * p)
+{
+  return InterlockedCompareExchangePointer((PVOID volatile *)p, NULL, NULL);
+}
+
+static inline void tic_atomic_store_ptr(void ** p, void * value)
+{
+  InterlockedExchangePointer((PVOID volatile *)p, value);
+}
+
+#else
+#error "No atomic operations are available for this compiler."
+#endif
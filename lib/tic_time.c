@@ -0,0 +1,82 @@
+// Functions for reading the monotonic clock, sleeping until a deadline, and
+// keeping histograms of how long things take.
+
+#include "tic_internal.h"
+
+#ifdef _WIN32
+
+uint64_t tic_monotonic_us(void)
+{
+  static LARGE_INTEGER frequency;
+  if (frequency.QuadPart == 0) { QueryPerformanceFrequency(&frequency); }
+  LARGE_INTEGER count;
+  QueryPerformanceCounter(&count);
+  return (uint64_t)(count.QuadPart / frequency.QuadPart) * 1000000 +
+    (uint64_t)(count.QuadPart % frequency.QuadPart) * 1000000 /
+    frequency.QuadPart;
+}
+
+void tic_sleep_until_us(uint64_t deadline)
+{
+  while (true)
+  {
+    uint64_t now = tic_monotonic_us();
+    if (now >= deadline) { return; }
+
+    // Sleep() only has millisecond resolution, so we sleep until about a
+    // millisecond before the deadline and yield for the rest.
+    uint64_t remaining = deadline - now;
+    if (remaining >= 2000) { Sleep((DWORD)(remaining / 1000 - 1)); }
+    else { SwitchToThread(); }
+  }
+}
+
+#else
+
+uint64_t tic_monotonic_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void tic_sleep_until_us(uint64_t deadline)
+{
+  while (true)
+  {
+    uint64_t now = tic_monotonic_us();
+    if (now >= deadline) { return; }
+
+    // nanosleep can return early because of a signal, so we loop and check
+    // the clock again instead of trusting it.
+    uint64_t remaining = deadline - now;
+    struct timespec ts;
+    ts.tv_sec = remaining / 1000000;
+    ts.tv_nsec = remaining % 1000000 * 1000;
+    nanosleep(&ts, NULL);
+  }
+}
+
+#endif
+
+void tic_latency_record(uint32_t * histogram, size_t bucket_count,
+  uint32_t * max, uint64_t time_us)
+{
+  size_t bucket = 0;
+  for (uint64_t t = time_us; t && bucket < bucket_count - 1; t >>= 1)
+  {
+    bucket++;
+  }
+  tic_atomic_add_u32(&histogram[bucket], 1);
+
+  uint32_t clamped = time_us > UINT32_MAX ? UINT32_MAX : (uint32_t)time_us;
+  if (clamped > tic_atomic_load_u32(max))
+  {
+    tic_atomic_store_u32(max, clamped);
+  }
+}
+
+uint64_t tic_get_time_us(void)
+{
+  return tic_monotonic_us();
+}
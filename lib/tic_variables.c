@@ -126,128 +126,287 @@ void tic_variables_free(tic_variables * variables)
   free(variables);
 }
 
+void tic_variables_copy_into(tic_variables * dest, const tic_variables * source)
+{
+  assert(dest != NULL);
+  assert(source != NULL);
+  memcpy(dest, source, sizeof(tic_variables));
+}
+
+// Describes where each group of variables selected by a TIC_VARIABLES_FIELD_*
+// bit is stored in the device's variables.  Sorted by offset.
+typedef struct tic_variables_field_location
+{
+  uint32_t field;
+  uint8_t offset;
+  uint8_t size;
+} tic_variables_field_location;
+
+static const tic_variables_field_location tic_variables_field_locations[] =
+{
+  { TIC_VARIABLES_FIELD_OPERATION_STATE, TIC_VAR_OPERATION_STATE, 1 },
+  { TIC_VARIABLES_FIELD_MISC_FLAGS, TIC_VAR_MISC_FLAGS1, 1 },
+  { TIC_VARIABLES_FIELD_ERROR_STATUS, TIC_VAR_ERROR_STATUS, 2 },
+  { TIC_VARIABLES_FIELD_ERRORS_OCCURRED, TIC_VAR_ERRORS_OCCURRED, 4 },
+  { TIC_VARIABLES_FIELD_PLANNING_MODE, TIC_VAR_PLANNING_MODE, 1 },
+  { TIC_VARIABLES_FIELD_TARGET_POSITION, TIC_VAR_TARGET_POSITION, 4 },
+  { TIC_VARIABLES_FIELD_TARGET_VELOCITY, TIC_VAR_TARGET_VELOCITY, 4 },
+  { TIC_VARIABLES_FIELD_STARTING_SPEED, TIC_VAR_STARTING_SPEED, 4 },
+  { TIC_VARIABLES_FIELD_MAX_SPEED, TIC_VAR_MAX_SPEED, 4 },
+  { TIC_VARIABLES_FIELD_MAX_DECEL, TIC_VAR_MAX_DECEL, 4 },
+  { TIC_VARIABLES_FIELD_MAX_ACCEL, TIC_VAR_MAX_ACCEL, 4 },
+  { TIC_VARIABLES_FIELD_CURRENT_POSITION, TIC_VAR_CURRENT_POSITION, 4 },
+  { TIC_VARIABLES_FIELD_CURRENT_VELOCITY, TIC_VAR_CURRENT_VELOCITY, 4 },
+  { TIC_VARIABLES_FIELD_ACTING_TARGET_POSITION, TIC_VAR_ACTING_TARGET_POSITION, 4 },
+  { TIC_VARIABLES_FIELD_TIME_SINCE_LAST_STEP, TIC_VAR_TIME_SINCE_LAST_STEP, 4 },
+  { TIC_VARIABLES_FIELD_DEVICE_RESET, TIC_VAR_DEVICE_RESET, 1 },
+  { TIC_VARIABLES_FIELD_VIN_VOLTAGE, TIC_VAR_VIN_VOLTAGE, 2 },
+  { TIC_VARIABLES_FIELD_UP_TIME, TIC_VAR_UP_TIME, 4 },
+  { TIC_VARIABLES_FIELD_ENCODER_POSITION, TIC_VAR_ENCODER_POSITION, 4 },
+  { TIC_VARIABLES_FIELD_RC_PULSE_WIDTH, TIC_VAR_RC_PULSE_WIDTH, 2 },
+  { TIC_VARIABLES_FIELD_PIN_INFO, TIC_VAR_ANALOG_READING_SCL,
+    TIC_VAR_PIN_STATES + 1 - TIC_VAR_ANALOG_READING_SCL },
+  { TIC_VARIABLES_FIELD_STEP_MODE, TIC_VAR_STEP_MODE, 1 },
+  { TIC_VARIABLES_FIELD_CURRENT_LIMIT, TIC_VAR_CURRENT_LIMIT, 1 },
+  { TIC_VARIABLES_FIELD_DECAY_MODE, TIC_VAR_DECAY_MODE, 1 },
+  { TIC_VARIABLES_FIELD_INPUT_STATE, TIC_VAR_INPUT_STATE, 1 },
+  { TIC_VARIABLES_FIELD_INPUT_AFTER_AVERAGING, TIC_VAR_INPUT_AFTER_AVERAGING, 2 },
+  { TIC_VARIABLES_FIELD_INPUT_AFTER_HYSTERESIS, TIC_VAR_INPUT_AFTER_HYSTERESIS, 2 },
+  { TIC_VARIABLES_FIELD_INPUT_AFTER_SCALING, TIC_VAR_INPUT_AFTER_SCALING, 4 },
+  { TIC_VARIABLES_FIELD_LAST_MOTOR_DRIVER_ERROR, TIC_VAR_LAST_MOTOR_DRIVER_ERROR, 1 },
+  { TIC_VARIABLES_FIELD_AGC, TIC_VAR_AGC_MODE,
+    TIC_VAR_AGC_FREQUENCY_LIMIT + 1 - TIC_VAR_AGC_MODE },
+  { TIC_VARIABLES_FIELD_LAST_HP_DRIVER_ERRORS, TIC_VAR_LAST_HP_DRIVER_ERRORS, 1 },
+};
+
+#define TIC_VARIABLES_FIELD_LOCATION_COUNT \
+  (sizeof(tic_variables_field_locations) / sizeof(tic_variables_field_locations[0]))
+
+// Returns the subset of the specified fields that are meaningful for the
+// specified product.
+uint32_t tic_variables_fields_for_product(uint32_t fields,
+  uint8_t product)
+{
+  fields &= TIC_VARIABLES_FIELD_ALL;
+
+  if (product != TIC_PRODUCT_T825 &&
+    product != TIC_PRODUCT_N825 &&
+    product != TIC_PRODUCT_T834)
+  {
+    fields &= ~TIC_VARIABLES_FIELD_DECAY_MODE;
+  }
+
+  if (product != TIC_PRODUCT_T249)
+  {
+    fields &= ~(TIC_VARIABLES_FIELD_LAST_MOTOR_DRIVER_ERROR |
+      TIC_VARIABLES_FIELD_AGC);
+  }
+
+  if (product != TIC_PRODUCT_36V4)
+  {
+    fields &= ~TIC_VARIABLES_FIELD_LAST_HP_DRIVER_ERRORS;
+  }
+
+  return fields;
+}
+
 static void write_buffer_to_variables(const uint8_t * buf,
-  tic_variables * vars, uint8_t product)
+  tic_variables * vars, uint8_t product, uint32_t fields)
 {
   assert(vars != NULL);
   assert(buf != NULL);
 
-  vars->operation_state = buf[TIC_VAR_OPERATION_STATE];
-  uint8_t misc_flags1 = buf[TIC_VAR_MISC_FLAGS1];
-  vars->energized = misc_flags1 >> TIC_MISC_FLAGS1_ENERGIZED & 1;
-  vars->position_uncertain = misc_flags1 >> TIC_MISC_FLAGS1_POSITION_UNCERTAIN & 1;
-  vars->forward_limit_active = misc_flags1 >> TIC_MISC_FLAGS1_FORWARD_LIMIT_ACTIVE & 1;
-  vars->reverse_limit_active = misc_flags1 >> TIC_MISC_FLAGS1_REVERSE_LIMIT_ACTIVE & 1;
-  vars->homing_active = misc_flags1 >> TIC_MISC_FLAGS1_HOMING_ACTIVE & 1;
-  vars->error_status = read_u16(buf + TIC_VAR_ERROR_STATUS);
-  vars->errors_occurred = read_u32(buf + TIC_VAR_ERRORS_OCCURRED);
-  vars->planning_mode = buf[TIC_VAR_PLANNING_MODE];
-  vars->target_position = read_i32(buf + TIC_VAR_TARGET_POSITION);
-  vars->target_velocity = read_i32(buf + TIC_VAR_TARGET_VELOCITY);
-  vars->starting_speed = read_u32(buf + TIC_VAR_STARTING_SPEED);
-  vars->max_speed = read_u32(buf + TIC_VAR_MAX_SPEED);
-  vars->max_decel = read_u32(buf + TIC_VAR_MAX_DECEL);
-  vars->max_accel = read_u32(buf + TIC_VAR_MAX_ACCEL);
-  vars->current_position = read_i32(buf + TIC_VAR_CURRENT_POSITION);
-  vars->current_velocity = read_i32(buf + TIC_VAR_CURRENT_VELOCITY);
-  vars->acting_target_position = read_i32(buf + TIC_VAR_ACTING_TARGET_POSITION);
-  vars->time_since_last_step = read_i32(buf + TIC_VAR_TIME_SINCE_LAST_STEP);
-  vars->device_reset = buf[TIC_VAR_DEVICE_RESET];
-  vars->vin_voltage = read_u16(buf + TIC_VAR_VIN_VOLTAGE);
-  vars->up_time = read_u32(buf + TIC_VAR_UP_TIME);
-  vars->encoder_position = read_i32(buf + TIC_VAR_ENCODER_POSITION);
-  vars->rc_pulse_width = read_u16(buf + TIC_VAR_RC_PULSE_WIDTH);
-  vars->step_mode = buf[TIC_VAR_STEP_MODE];
-  vars->current_limit_code = buf[TIC_VAR_CURRENT_LIMIT];
-
-  if (product == TIC_PRODUCT_T825 ||
-    product == TIC_PRODUCT_N825 ||
-    product == TIC_PRODUCT_T834)
-  {
-    vars->decay_mode = buf[TIC_VAR_DECAY_MODE];
-  }
-  else
-  {
-    // Ignore the Decay mode variable here since it does not really apply,
-    // and ignoring it here makes it safer to reuse its byte for a different
-    // variable in the future.
-  }
-
-  vars->input_state = buf[TIC_VAR_INPUT_STATE];
-  vars->input_after_averaging = read_u16(buf + TIC_VAR_INPUT_AFTER_AVERAGING);
-  vars->input_after_hysteresis = read_u16(buf + TIC_VAR_INPUT_AFTER_HYSTERESIS);
-  vars->input_after_scaling = read_i32(buf + TIC_VAR_INPUT_AFTER_SCALING);
-
-  {
-    uint8_t d = buf[TIC_VAR_DIGITAL_READINGS];
-    vars->pin_info[TIC_PIN_NUM_SCL].digital_reading = d >> TIC_PIN_NUM_SCL & 1;
-    vars->pin_info[TIC_PIN_NUM_SDA].digital_reading = d >> TIC_PIN_NUM_SDA & 1;
-    vars->pin_info[TIC_PIN_NUM_TX].digital_reading = d >> TIC_PIN_NUM_TX & 1;
-    vars->pin_info[TIC_PIN_NUM_RX].digital_reading = d >> TIC_PIN_NUM_RX & 1;
-    vars->pin_info[TIC_PIN_NUM_RC].digital_reading = d >> TIC_PIN_NUM_RC & 1;
-  }
-
-  {
-    uint8_t s = buf[TIC_VAR_PIN_STATES];
-    vars->pin_info[TIC_PIN_NUM_SCL].pin_state = s >> (TIC_PIN_NUM_SCL * 2) & 3;
-    vars->pin_info[TIC_PIN_NUM_SDA].pin_state = s >> (TIC_PIN_NUM_SDA * 2) & 3;
-    vars->pin_info[TIC_PIN_NUM_TX].pin_state = s >> (TIC_PIN_NUM_TX * 2) & 3;
-    vars->pin_info[TIC_PIN_NUM_RX].pin_state = s >> (TIC_PIN_NUM_RX * 2) & 3;
-  }
-
-  vars->pin_info[TIC_PIN_NUM_SCL].analog_reading =
-    read_u16(buf + TIC_VAR_ANALOG_READING_SCL);
-  vars->pin_info[TIC_PIN_NUM_SDA].analog_reading =
-    read_u16(buf + TIC_VAR_ANALOG_READING_SDA);
-  vars->pin_info[TIC_PIN_NUM_TX].analog_reading =
-    read_u16(buf + TIC_VAR_ANALOG_READING_TX);
-  vars->pin_info[TIC_PIN_NUM_RX].analog_reading =
-    read_u16(buf + TIC_VAR_ANALOG_READING_RX);
-
-  // Because of hardware limitations, the RC pin is always an input and it
-  // cannot do analog readings.
-  vars->pin_info[TIC_PIN_NUM_RC].pin_state = TIC_PIN_STATE_HIGH_IMPEDANCE;
-  vars->pin_info[TIC_PIN_NUM_RC].analog_reading = 0;
+  if (fields & TIC_VARIABLES_FIELD_OPERATION_STATE)
+  {
+    vars->operation_state = buf[TIC_VAR_OPERATION_STATE];
+  }
 
-  if (vars->product == TIC_PRODUCT_T249)
+  if (fields & TIC_VARIABLES_FIELD_MISC_FLAGS)
   {
-    vars->last_motor_driver_error = buf[TIC_VAR_LAST_MOTOR_DRIVER_ERROR];
-    vars->agc_mode = buf[TIC_VAR_AGC_MODE];
-    vars->agc_bottom_current_limit = buf[TIC_VAR_AGC_BOTTOM_CURRENT_LIMIT];
-    vars->agc_current_boost_steps = buf[TIC_VAR_AGC_CURRENT_BOOST_STEPS];
-    vars->agc_frequency_limit = buf[TIC_VAR_AGC_FREQUENCY_LIMIT];
+    uint8_t misc_flags1 = buf[TIC_VAR_MISC_FLAGS1];
+    vars->energized = misc_flags1 >> TIC_MISC_FLAGS1_ENERGIZED & 1;
+    vars->position_uncertain = misc_flags1 >> TIC_MISC_FLAGS1_POSITION_UNCERTAIN & 1;
+    vars->forward_limit_active = misc_flags1 >> TIC_MISC_FLAGS1_FORWARD_LIMIT_ACTIVE & 1;
+    vars->reverse_limit_active = misc_flags1 >> TIC_MISC_FLAGS1_REVERSE_LIMIT_ACTIVE & 1;
+    vars->homing_active = misc_flags1 >> TIC_MISC_FLAGS1_HOMING_ACTIVE & 1;
   }
 
-  if (vars->product == TIC_PRODUCT_36V4)
+  if (fields & TIC_VARIABLES_FIELD_ERROR_STATUS)
   {
-    vars->last_hp_driver_errors = buf[TIC_VAR_LAST_HP_DRIVER_ERRORS];
+    vars->error_status = read_u16(buf + TIC_VAR_ERROR_STATUS);
+  }
+  if (fields & TIC_VARIABLES_FIELD_ERRORS_OCCURRED)
+  {
+    vars->errors_occurred = read_u32(buf + TIC_VAR_ERRORS_OCCURRED);
+  }
+  if (fields & TIC_VARIABLES_FIELD_PLANNING_MODE)
+  {
+    vars->planning_mode = buf[TIC_VAR_PLANNING_MODE];
+  }
+  if (fields & TIC_VARIABLES_FIELD_TARGET_POSITION)
+  {
+    vars->target_position = read_i32(buf + TIC_VAR_TARGET_POSITION);
+  }
+  if (fields & TIC_VARIABLES_FIELD_TARGET_VELOCITY)
+  {
+    vars->target_velocity = read_i32(buf + TIC_VAR_TARGET_VELOCITY);
+  }
+  if (fields & TIC_VARIABLES_FIELD_STARTING_SPEED)
+  {
+    vars->starting_speed = read_u32(buf + TIC_VAR_STARTING_SPEED);
+  }
+  if (fields & TIC_VARIABLES_FIELD_MAX_SPEED)
+  {
+    vars->max_speed = read_u32(buf + TIC_VAR_MAX_SPEED);
+  }
+  if (fields & TIC_VARIABLES_FIELD_MAX_DECEL)
+  {
+    vars->max_decel = read_u32(buf + TIC_VAR_MAX_DECEL);
+  }
+  if (fields & TIC_VARIABLES_FIELD_MAX_ACCEL)
+  {
+    vars->max_accel = read_u32(buf + TIC_VAR_MAX_ACCEL);
+  }
+  if (fields & TIC_VARIABLES_FIELD_CURRENT_POSITION)
+  {
+    vars->current_position = read_i32(buf + TIC_VAR_CURRENT_POSITION);
+  }
+  if (fields & TIC_VARIABLES_FIELD_CURRENT_VELOCITY)
+  {
+    vars->current_velocity = read_i32(buf + TIC_VAR_CURRENT_VELOCITY);
+  }
+  if (fields & TIC_VARIABLES_FIELD_ACTING_TARGET_POSITION)
+  {
+    vars->acting_target_position = read_i32(buf + TIC_VAR_ACTING_TARGET_POSITION);
+  }
+  if (fields & TIC_VARIABLES_FIELD_TIME_SINCE_LAST_STEP)
+  {
+    vars->time_since_last_step = read_i32(buf + TIC_VAR_TIME_SINCE_LAST_STEP);
+  }
+  if (fields & TIC_VARIABLES_FIELD_DEVICE_RESET)
+  {
+    vars->device_reset = buf[TIC_VAR_DEVICE_RESET];
+  }
+  if (fields & TIC_VARIABLES_FIELD_VIN_VOLTAGE)
+  {
+    vars->vin_voltage = read_u16(buf + TIC_VAR_VIN_VOLTAGE);
+  }
+  if (fields & TIC_VARIABLES_FIELD_UP_TIME)
+  {
+    vars->up_time = read_u32(buf + TIC_VAR_UP_TIME);
+  }
+  if (fields & TIC_VARIABLES_FIELD_ENCODER_POSITION)
+  {
+    vars->encoder_position = read_i32(buf + TIC_VAR_ENCODER_POSITION);
+  }
+  if (fields & TIC_VARIABLES_FIELD_RC_PULSE_WIDTH)
+  {
+    vars->rc_pulse_width = read_u16(buf + TIC_VAR_RC_PULSE_WIDTH);
+  }
+  if (fields & TIC_VARIABLES_FIELD_STEP_MODE)
+  {
+    vars->step_mode = buf[TIC_VAR_STEP_MODE];
+  }
+  if (fields & TIC_VARIABLES_FIELD_CURRENT_LIMIT)
+  {
+    vars->current_limit_code = buf[TIC_VAR_CURRENT_LIMIT];
   }
-}
 
-tic_error * tic_get_variables(tic_handle * handle, tic_variables ** variables,
-  bool clear_errors_occurred)
-{
-  if (variables == NULL)
+  if (fields & TIC_VARIABLES_FIELD_DECAY_MODE)
   {
-    return tic_error_create("Variables output pointer is null.");
+    if (product == TIC_PRODUCT_T825 ||
+      product == TIC_PRODUCT_N825 ||
+      product == TIC_PRODUCT_T834)
+    {
+      vars->decay_mode = buf[TIC_VAR_DECAY_MODE];
+    }
+    else
+    {
+      // Ignore the Decay mode variable here since it does not really apply,
+      // and ignoring it here makes it safer to reuse its byte for a different
+      // variable in the future.
+    }
   }
 
-  *variables = NULL;
+  if (fields & TIC_VARIABLES_FIELD_INPUT_STATE)
+  {
+    vars->input_state = buf[TIC_VAR_INPUT_STATE];
+  }
+  if (fields & TIC_VARIABLES_FIELD_INPUT_AFTER_AVERAGING)
+  {
+    vars->input_after_averaging = read_u16(buf + TIC_VAR_INPUT_AFTER_AVERAGING);
+  }
+  if (fields & TIC_VARIABLES_FIELD_INPUT_AFTER_HYSTERESIS)
+  {
+    vars->input_after_hysteresis = read_u16(buf + TIC_VAR_INPUT_AFTER_HYSTERESIS);
+  }
+  if (fields & TIC_VARIABLES_FIELD_INPUT_AFTER_SCALING)
+  {
+    vars->input_after_scaling = read_i32(buf + TIC_VAR_INPUT_AFTER_SCALING);
+  }
 
-  if (handle == NULL)
+  if (fields & TIC_VARIABLES_FIELD_PIN_INFO)
   {
-    return tic_error_create("Handle is null.");
+    {
+      uint8_t d = buf[TIC_VAR_DIGITAL_READINGS];
+      vars->pin_info[TIC_PIN_NUM_SCL].digital_reading = d >> TIC_PIN_NUM_SCL & 1;
+      vars->pin_info[TIC_PIN_NUM_SDA].digital_reading = d >> TIC_PIN_NUM_SDA & 1;
+      vars->pin_info[TIC_PIN_NUM_TX].digital_reading = d >> TIC_PIN_NUM_TX & 1;
+      vars->pin_info[TIC_PIN_NUM_RX].digital_reading = d >> TIC_PIN_NUM_RX & 1;
+      vars->pin_info[TIC_PIN_NUM_RC].digital_reading = d >> TIC_PIN_NUM_RC & 1;
+    }
+
+    {
+      uint8_t s = buf[TIC_VAR_PIN_STATES];
+      vars->pin_info[TIC_PIN_NUM_SCL].pin_state = s >> (TIC_PIN_NUM_SCL * 2) & 3;
+      vars->pin_info[TIC_PIN_NUM_SDA].pin_state = s >> (TIC_PIN_NUM_SDA * 2) & 3;
+      vars->pin_info[TIC_PIN_NUM_TX].pin_state = s >> (TIC_PIN_NUM_TX * 2) & 3;
+      vars->pin_info[TIC_PIN_NUM_RX].pin_state = s >> (TIC_PIN_NUM_RX * 2) & 3;
+    }
+
+    vars->pin_info[TIC_PIN_NUM_SCL].analog_reading =
+      read_u16(buf + TIC_VAR_ANALOG_READING_SCL);
+    vars->pin_info[TIC_PIN_NUM_SDA].analog_reading =
+      read_u16(buf + TIC_VAR_ANALOG_READING_SDA);
+    vars->pin_info[TIC_PIN_NUM_TX].analog_reading =
+      read_u16(buf + TIC_VAR_ANALOG_READING_TX);
+    vars->pin_info[TIC_PIN_NUM_RX].analog_reading =
+      read_u16(buf + TIC_VAR_ANALOG_READING_RX);
+
+    // Because of hardware limitations, the RC pin is always an input and it
+    // cannot do analog readings.
+    vars->pin_info[TIC_PIN_NUM_RC].pin_state = TIC_PIN_STATE_HIGH_IMPEDANCE;
+    vars->pin_info[TIC_PIN_NUM_RC].analog_reading = 0;
   }
 
-  tic_error * error = NULL;
+  if (vars->product == TIC_PRODUCT_T249)
+  {
+    if (fields & TIC_VARIABLES_FIELD_LAST_MOTOR_DRIVER_ERROR)
+    {
+      vars->last_motor_driver_error = buf[TIC_VAR_LAST_MOTOR_DRIVER_ERROR];
+    }
+    if (fields & TIC_VARIABLES_FIELD_AGC)
+    {
+      vars->agc_mode = buf[TIC_VAR_AGC_MODE];
+      vars->agc_bottom_current_limit = buf[TIC_VAR_AGC_BOTTOM_CURRENT_LIMIT];
+      vars->agc_current_boost_steps = buf[TIC_VAR_AGC_CURRENT_BOOST_STEPS];
+      vars->agc_frequency_limit = buf[TIC_VAR_AGC_FREQUENCY_LIMIT];
+    }
+  }
 
-  // Create a variables object.
-  tic_variables * new_variables = NULL;
-  if (error == NULL)
+  if (vars->product == TIC_PRODUCT_36V4)
   {
-    error = tic_variables_create(&new_variables);
+    if (fields & TIC_VARIABLES_FIELD_LAST_HP_DRIVER_ERRORS)
+    {
+      vars->last_hp_driver_errors = buf[TIC_VAR_LAST_HP_DRIVER_ERRORS];
+    }
   }
+}
 
+// Reads the variables from the device into the specified buffer.
+static tic_error * tic_read_variables_buffer(tic_handle * handle,
+  uint8_t * buf, bool clear_errors_occurred)
+{
   uint8_t product = tic_device_get_product(tic_handle_get_device(handle));
 
   // Define the different variable segments we will read.
@@ -266,8 +425,8 @@ tic_error * tic_get_variables(tic_handle * handle, tic_variables ** variables,
     product_specific_offset = TIC_VAR_LAST_HP_DRIVER_ERRORS;
   }
 
-  // Read all the variables from the device.
-  uint8_t buf[256] = { 0 };
+  tic_error * error = NULL;
+
   if (error == NULL)
   {
     uint8_t offset = 0;
@@ -282,11 +441,47 @@ tic_error * tic_get_variables(tic_handle * handle, tic_variables ** variables,
       size, buf + product_specific_offset, false);
   }
 
+  return error;
+}
+
+tic_error * tic_get_variables(tic_handle * handle, tic_variables ** variables,
+  bool clear_errors_occurred)
+{
+  if (variables == NULL)
+  {
+    return tic_error_create("Variables output pointer is null.");
+  }
+
+  *variables = NULL;
+
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle is null.");
+  }
+
+  tic_error * error = NULL;
+
+  // Create a variables object.
+  tic_variables * new_variables = NULL;
+  if (error == NULL)
+  {
+    error = tic_variables_create(&new_variables);
+  }
+
+  // Read all the variables from the device.
+  uint8_t buf[256] = { 0 };
+  if (error == NULL)
+  {
+    error = tic_read_variables_buffer(handle, buf, clear_errors_occurred);
+  }
+
   // Store the variables in the new variables object.
   if (error == NULL)
   {
-    new_variables->product = tic_device_get_product(tic_handle_get_device(handle));
-    write_buffer_to_variables(buf, new_variables, product);
+    uint8_t product = tic_device_get_product(tic_handle_get_device(handle));
+    new_variables->product = product;
+    write_buffer_to_variables(buf, new_variables, product,
+      TIC_VARIABLES_FIELD_ALL);
   }
 
   // Pass the new variables to the caller.
@@ -307,6 +502,162 @@ tic_error * tic_get_variables(tic_handle * handle, tic_variables ** variables,
   return error;
 }
 
+tic_error * tic_get_variables_into(tic_handle * handle,
+  tic_variables * variables, bool clear_errors_occurred)
+{
+  if (variables == NULL)
+  {
+    return tic_error_create("Variables pointer is null.");
+  }
+
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle is null.");
+  }
+
+  uint8_t buf[256] = { 0 };
+  tic_error * error = tic_read_variables_buffer(handle, buf,
+    clear_errors_occurred);
+
+  if (error == &tic_error_device_disconnected)
+  {
+    // Pass the error on without adding a message, which would require
+    // allocating memory.
+    return error;
+  }
+
+  if (error != NULL)
+  {
+    return tic_error_add(error,
+      "There was an error reading variables from the device.");
+  }
+
+  // Clear any fields left over from a different product.
+  uint8_t product = tic_device_get_product(tic_handle_get_device(handle));
+  memset(variables, 0, sizeof(tic_variables));
+  variables->product = product;
+  write_buffer_to_variables(buf, variables, product,
+    TIC_VARIABLES_FIELD_ALL);
+
+  return NULL;
+}
+
+size_t tic_variables_fields_segments(uint32_t fields, size_t max_size,
+  tic_variables_segment * segments)
+{
+  size_t count = 0;
+
+  size_t i = 0;
+  while (i < TIC_VARIABLES_FIELD_LOCATION_COUNT)
+  {
+    const tic_variables_field_location * loc = &tic_variables_field_locations[i++];
+    if (!(fields & loc->field)) { continue; }
+
+    size_t start = loc->offset;
+    size_t end = loc->offset + loc->size;
+    bool includes_errors_occurred =
+      loc->field == TIC_VARIABLES_FIELD_ERRORS_OCCURRED;
+
+    while (i < TIC_VARIABLES_FIELD_LOCATION_COUNT)
+    {
+      const tic_variables_field_location * next = &tic_variables_field_locations[i];
+      if (!(fields & next->field)) { i++; continue; }
+      size_t next_end = next->offset + next->size;
+      if (next_end - start > max_size) { break; }
+      end = next_end;
+      if (next->field == TIC_VARIABLES_FIELD_ERRORS_OCCURRED)
+      {
+        includes_errors_occurred = true;
+      }
+      i++;
+    }
+
+    segments[count].offset = start;
+    segments[count].size = end - start;
+    segments[count].includes_errors_occurred = includes_errors_occurred;
+    count++;
+  }
+
+  return count;
+}
+
+void tic_variables_write_from_buffer(tic_variables * variables,
+  uint8_t product, const uint8_t * buf, uint32_t fields)
+{
+  variables->product = product;
+  write_buffer_to_variables(buf, variables, product,
+    tic_variables_fields_for_product(fields, product));
+}
+
+// Reads the bytes holding the specified fields from the device.  Requested
+// fields are grouped into ranges of consecutive bytes, and each range is made
+// as long as possible (up to TIC_MAX_USB_RESPONSE_SIZE) so that we use the
+// smallest number of transfers, and then trimmed so that it starts at the first
+// requested field and ends at the last one.
+static tic_error * tic_read_variables_fields_buffer(tic_handle * handle,
+  uint8_t * buf, uint32_t fields, bool clear_errors_occurred)
+{
+  tic_variables_segment segments[TIC_VARIABLES_MAX_SEGMENTS];
+  size_t count = tic_variables_fields_segments(fields,
+    TIC_MAX_USB_RESPONSE_SIZE, segments);
+
+  tic_error * error = NULL;
+  for (size_t i = 0; error == NULL && i < count; i++)
+  {
+    const tic_variables_segment * segment = &segments[i];
+    error = tic_get_variable_segment(handle, segment->offset, segment->size,
+      buf + segment->offset,
+      clear_errors_occurred && segment->includes_errors_occurred);
+  }
+
+  return error;
+}
+
+tic_error * tic_get_variables_fields(tic_handle * handle,
+  tic_variables * variables, uint32_t fields, bool clear_errors_occurred)
+{
+  if (variables == NULL)
+  {
+    return tic_error_create("Variables pointer is null.");
+  }
+
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle is null.");
+  }
+
+  uint8_t product = tic_device_get_product(tic_handle_get_device(handle));
+
+  if (clear_errors_occurred)
+  {
+    fields |= TIC_VARIABLES_FIELD_ERRORS_OCCURRED;
+  }
+
+  fields = tic_variables_fields_for_product(fields, product);
+
+  uint8_t buf[256] = { 0 };
+  tic_error * error = tic_read_variables_fields_buffer(handle, buf, fields,
+    clear_errors_occurred);
+
+  if (error == &tic_error_device_disconnected)
+  {
+    // Pass the error on without adding a message, which would require
+    // allocating memory.
+    return error;
+  }
+
+  if (error != NULL)
+  {
+    return tic_error_add(error,
+      "There was an error reading variables from the device.");
+  }
+
+  variables->product = product;
+  write_buffer_to_variables(buf, variables, product, fields);
+
+  return NULL;
+}
+
 uint8_t tic_variables_get_operation_state(const tic_variables * variables)
 {
   if (variables == NULL) { return 0; }
@@ -0,0 +1,172 @@
+// Functions for waiting until the Tic finishes a move or homing.
+
+#include "tic_internal.h"
+
+// The variables we read while waiting.  tic_get_variables_fields() reads these
+// with a single Get Variables command because they are close together.
+#define TIC_WAIT_POSITION_FIELDS (TIC_VARIABLES_FIELD_OPERATION_STATE | \
+  TIC_VARIABLES_FIELD_PLANNING_MODE | TIC_VARIABLES_FIELD_TARGET_POSITION | \
+  TIC_VARIABLES_FIELD_CURRENT_POSITION | TIC_VARIABLES_FIELD_CURRENT_VELOCITY)
+#define TIC_WAIT_HOMING_FIELDS (TIC_VARIABLES_FIELD_OPERATION_STATE | \
+  TIC_VARIABLES_FIELD_MISC_FLAGS)
+
+// The motor usually takes longer than the remaining distance divided by its
+// speed because it has to decelerate, so we only wait for half that time.
+uint32_t tic_wait_get_position_interval_us(int32_t target_position,
+  int32_t current_position, int32_t current_velocity)
+{
+  int64_t distance = (int64_t)target_position - current_position;
+  int64_t velocity = current_velocity;
+  if (distance < 0) { distance = -distance; }
+  if (velocity < 0) { velocity = -velocity; }
+
+  // If the motor is not moving yet, it is probably about to start.
+  if (velocity == 0) { return TIC_WAIT_MIN_INTERVAL_US; }
+
+  double remaining_us = (double)distance * TIC_SPEED_UNITS_PER_HZ * 1000000 /
+    velocity;
+  double interval_us = remaining_us / 2;
+  if (interval_us < TIC_WAIT_MIN_INTERVAL_US) { return TIC_WAIT_MIN_INTERVAL_US; }
+  if (interval_us > TIC_WAIT_MAX_INTERVAL_US) { return TIC_WAIT_MAX_INTERVAL_US; }
+  return (uint32_t)interval_us;
+}
+
+static tic_error * check_operation_state(const tic_variables * vars)
+{
+  uint8_t state = tic_variables_get_operation_state(vars);
+  if (state == TIC_OPERATION_STATE_NORMAL) { return NULL; }
+  return tic_error_create("The motor stopped because the Tic is not in normal "
+    "operation (operation state: %s).",
+    tic_look_up_operation_state_name_ui(state));
+}
+
+// Sends a Reset Command Timeout command if it has been a while since the
+// last one.
+static tic_error * keep_alive(tic_handle * handle, uint64_t now,
+  uint64_t * last_keep_alive)
+{
+  if (now - *last_keep_alive < TIC_WAIT_KEEP_ALIVE_US) { return NULL; }
+  *last_keep_alive = now;
+  return tic_reset_command_timeout(handle);
+}
+
+static tic_error * wait_timeout_error(uint32_t timeout_ms, const char * what)
+{
+  return tic_error_add_code(
+    tic_error_create("Timed out after %u ms waiting for %s.",
+      (unsigned int)timeout_ms, what),
+    TIC_ERROR_TIMEOUT);
+}
+
+tic_error * tic_wait_for_position_reached(tic_handle * handle,
+  uint32_t timeout_ms)
+{
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle is null.");
+  }
+
+  tic_variables * vars = NULL;
+  tic_error * error = tic_variables_create(&vars);
+
+  uint64_t start = tic_monotonic_us();
+  uint64_t deadline = start + (uint64_t)timeout_ms * 1000;
+  uint64_t last_keep_alive = start;
+
+  while (error == NULL)
+  {
+    error = tic_get_variables_fields(handle, vars,
+      TIC_WAIT_POSITION_FIELDS, false);
+    if (error) { break; }
+
+    error = check_operation_state(vars);
+    if (error) { break; }
+
+    if (tic_variables_get_planning_mode(vars) !=
+      TIC_PLANNING_MODE_TARGET_POSITION)
+    {
+      error = tic_error_create("The Tic is not moving to a target position.");
+      break;
+    }
+
+    if (tic_variables_get_current_position(vars) ==
+      tic_variables_get_target_position(vars) &&
+      tic_variables_get_current_velocity(vars) == 0)
+    {
+      // Success.
+      break;
+    }
+
+    uint64_t now = tic_monotonic_us();
+    if (now >= deadline)
+    {
+      error = wait_timeout_error(timeout_ms, "the target position");
+      break;
+    }
+
+    error = keep_alive(handle, now, &last_keep_alive);
+    if (error) { break; }
+
+    uint64_t next = now + tic_wait_get_position_interval_us(
+      tic_variables_get_target_position(vars),
+      tic_variables_get_current_position(vars),
+      tic_variables_get_current_velocity(vars));
+    tic_sleep_until_us(next < deadline ? next : deadline);
+  }
+
+  tic_variables_free(vars);
+
+  return error;
+}
+
+tic_error * tic_wait_for_homing_complete(tic_handle * handle,
+  uint32_t timeout_ms)
+{
+  if (handle == NULL)
+  {
+    return tic_error_create("Handle is null.");
+  }
+
+  tic_variables * vars = NULL;
+  tic_error * error = tic_variables_create(&vars);
+
+  uint64_t start = tic_monotonic_us();
+  uint64_t deadline = start + (uint64_t)timeout_ms * 1000;
+  uint64_t last_keep_alive = start;
+
+  while (error == NULL)
+  {
+    error = tic_get_variables_fields(handle, vars,
+      TIC_WAIT_HOMING_FIELDS, false);
+    if (error) { break; }
+
+    error = check_operation_state(vars);
+    if (error) { break; }
+
+    if (!tic_variables_get_homing_active(vars))
+    {
+      if (tic_variables_get_position_uncertain(vars))
+      {
+        error = tic_error_create("Homing stopped before it was complete.");
+      }
+      break;
+    }
+
+    uint64_t now = tic_monotonic_us();
+    if (now >= deadline)
+    {
+      error = wait_timeout_error(timeout_ms, "homing to finish");
+      break;
+    }
+
+    error = keep_alive(handle, now, &last_keep_alive);
+    if (error) { break; }
+
+    uint64_t next = now + TIC_WAIT_HOMING_INTERVAL_US;
+    tic_sleep_until_us(next < deadline ? next : deadline);
+  }
+
+  tic_variables_free(vars);
+
+  return error;
+}
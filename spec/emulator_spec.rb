@@ -0,0 +1,27 @@
+require_relative 'spec_helper'
+
+describe 'emulated Tic' do
+  it 'can be listed' do
+    stdout, stderr, result = run_ticcmd('--emulate T825 --list')
+    expect(stderr).to eq ''
+    expect(stdout).to match(/\AE\d{7},\s+Tic T825 Stepper Motor Controller\s+\n\z/)
+    expect(result).to eq 0
+  end
+
+  it 'remembers a target across script lines' do
+    script = "--exit-safe-start --position 300\n-s\n"
+    stdout, stderr, result = run_ticcmd('--emulate 36v4 --stdin-commands',
+      input: script)
+    expect(stderr).to eq ''
+    expect(stdout).to include "Operation state:              Normal\n"
+    expect(stdout).to include "Target position:              300\n"
+    expect(result).to eq 0
+  end
+
+  it 'rejects an invalid product' do
+    stdout, stderr, result = run_ticcmd('--emulate T999 -s')
+    expect(stdout).to eq ''
+    expect(stderr).to eq "Error: The product specified is invalid.\n"
+    expect(result).to eq EXIT_BAD_ARGS
+  end
+end
@@ -0,0 +1,87 @@
+require_relative 'spec_helper'
+
+# These run G-code on emulated Tics with their default settings, so an axis
+# with no scale moves at 200 microsteps per second and accelerates at 400
+# microsteps per second squared.  We cannot read the positions of the axes
+# after ticcmd exits, so the motion specs compare how long the programs take.
+
+def run_gcode(gcode, axes = '--axis X:E1')
+  start = Process.clock_gettime(Process::CLOCK_MONOTONIC)
+  stdout, stderr, result = run_ticcmd("--emulate T825 #{axes} --gcode -",
+    input: gcode)
+  time = Process.clock_gettime(Process::CLOCK_MONOTONIC) - start
+  [stdout, stderr, result, time]
+end
+
+def expect_gcode_success(gcode, axes = '--axis X:E1')
+  stdout, stderr, result, time = run_gcode(gcode, axes)
+  expect(stderr).to eq ''
+  expect(stdout).to eq ''
+  expect(result).to eq 0
+  time
+end
+
+describe 'G-code' do
+  it 'moves each axis with G0' do
+    time = expect_gcode_success("M17\nG0 X10 Y-5\n",
+      '--axis X:E1 --axis Y:E2')
+    expect(time).to be > 0.25
+  end
+
+  it 'limits the speed of G1 to the feed rate' do
+    rapid = expect_gcode_success("M17\nG0 X10\n")
+    feed = expect_gcode_success("M17\nG1 X10 F600\n")
+    expect(feed).to be > 0.9
+    expect(feed).to be > rapid + 0.4
+  end
+
+  it 'dwells with G4' do
+    time = expect_gcode_success("G4 P300\nG4 S0.2\n")
+    expect(time).to be > 0.49
+  end
+
+  it 'treats repeated G90 targets as absolute and G91 targets as relative' do
+    moves = "G0 X10\n" * 4
+    absolute = expect_gcode_success("M17\nG90\n" + moves)
+    relative = expect_gcode_success("M17\nG91\n" + moves)
+    expect(relative).to be > absolute + 0.2
+  end
+
+  it 'homes with G28 in either direction' do
+    expect_gcode_success("M17\nG0 X-20\nG28\n")
+    expect_gcode_success("M17\nG0 X-20\nG28 X1\n")
+  end
+
+  it 'rejects an unsupported code before moving' do
+    stdout, stderr, result, time = run_gcode("M17\nG0 X1000\nG2 X1\n")
+    expect(stdout).to eq ''
+    expect(stderr).to eq "Error: Line 3 of the G-code file: " \
+      "Unsupported code: G2.\n"
+    expect(result).to eq EXIT_BAD_ARGS
+    expect(time).to be < 0.5
+  end
+
+  it 'rejects G1 without a feed rate' do
+    stdout, stderr, result = run_gcode("G1 X5\n")
+    expect(stdout).to eq ''
+    expect(stderr).to eq "Error: Line 1 of the G-code file: " \
+      "No feed rate was specified for G1.\n"
+    expect(result).to eq EXIT_BAD_ARGS
+  end
+
+  it 'rejects an axis that has no Tic' do
+    stdout, stderr, result = run_gcode("G0 Z5\n")
+    expect(stdout).to eq ''
+    expect(stderr).to eq "Error: Line 1 of the G-code file: " \
+      "No Tic is assigned to axis Z.\n"
+    expect(result).to eq EXIT_BAD_ARGS
+  end
+
+  it 'names the line of an error while running' do
+    stdout, stderr, result = run_gcode("M17\nG0 X10\nG0 X1e12\n")
+    expect(stdout).to eq ''
+    expect(stderr).to eq "Error: Line 3 of the G-code file: " \
+      "Axis X target is out of range.\n"
+    expect(result).to eq EXIT_OPERATION_FAILED
+  end
+end
@@ -0,0 +1,28 @@
+require_relative 'spec_helper'
+
+describe 'script mode' do
+  it 'reports the line number of an error' do
+    script = "# comment\n\n-p 1\n--max-speed x\n"
+    stdout, stderr, result = run_ticcmd('-d x --stdin-commands', input: script)
+    expect(stdout).to eq ''
+    expect(stderr).to eq "Error: Line 3: No device was found with " \
+      "serial number 'x'.\n"
+    expect(result).to eq EXIT_DEVICE_NOT_FOUND
+  end
+
+  it 'rejects options that only make sense on the command line' do
+    stdout, stderr, result = run_ticcmd('--stdin-commands', input: "-d 123\n")
+    expect(stdout).to eq ''
+    expect(stderr).to eq "Error: Line 1: That option can only be used " \
+      "on the command line.\n"
+    expect(result).to eq EXIT_BAD_ARGS
+  end
+
+  it 'rejects unterminated quotes' do
+    stdout, stderr, result = run_ticcmd('--stdin-commands',
+      input: "--settings \"foo\n")
+    expect(stdout).to eq ''
+    expect(stderr).to eq "Error: Line 1: Unterminated quote.\n"
+    expect(result).to eq EXIT_BAD_ARGS
+  end
+end
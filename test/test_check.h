@@ -0,0 +1,32 @@
+// Checks shared by the tests, which count failures instead of stopping at the
+// first one.
+
+#pragma once
+
+#include <tic.h>
+
+#include <stdio.h>
+
+static int test_failure_count;
+
+#define TEST_CHECK(condition) test_check((condition), #condition, __LINE__)
+
+static inline void test_check(bool condition, const char * text, int line)
+{
+  if (condition) { return; }
+  fprintf(stderr, "line %d: check failed: %s\n", line, text);
+  test_failure_count++;
+}
+
+// Frees the error and returns true if there was one.
+static inline bool test_error(tic_error * error, int line)
+{
+  if (error == NULL) { return false; }
+  fprintf(stderr, "line %d: unexpected error: %s\n", line,
+    tic_error_get_message(error));
+  tic_error_free(error);
+  test_failure_count++;
+  return true;
+}
+
+#define TEST_NO_ERROR(expression) test_error((expression), __LINE__)
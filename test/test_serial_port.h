@@ -0,0 +1,93 @@
+// Helpers for the serial tests, which connect the library to a pseudoterminal
+// and play the part of the Tics on the other end.
+
+#pragma once
+
+// For posix_openpt() and cfmakeraw().
+#define _GNU_SOURCE
+
+#include "test_check.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Opens a pseudoterminal in raw mode.  The returned file descriptor is the
+// device side, and the name of the port for the library is written to
+// port_name.
+static inline int test_serial_open(char * port_name, size_t port_name_size)
+{
+  int fd = posix_openpt(O_RDWR | O_NOCTTY);
+  if (fd < 0 || grantpt(fd) || unlockpt(fd))
+  {
+    perror("Failed to open a pseudoterminal");
+    exit(1);
+  }
+  snprintf(port_name, port_name_size, "%s", ptsname(fd));
+
+  struct termios options;
+  tcgetattr(fd, &options);
+  cfmakeraw(&options);
+  tcsetattr(fd, TCSANOW, &options);
+  return fd;
+}
+
+// Reads exactly length bytes, or returns false if they do not arrive within
+// a second.
+static inline bool test_serial_read(int fd, uint8_t * buffer, size_t length)
+{
+  while (length)
+  {
+    struct pollfd pfd = { .fd = fd, .events = POLLIN };
+    int result = poll(&pfd, 1, 1000);
+    if (result < 0 && errno == EINTR) { continue; }
+    if (result <= 0) { return false; }
+    ssize_t count = read(fd, buffer, length);
+    if (count < 0 && errno == EINTR) { continue; }
+    if (count <= 0) { return false; }
+    buffer += count;
+    length -= count;
+  }
+  return true;
+}
+
+static inline void test_serial_write(int fd, const uint8_t * buffer,
+  size_t length)
+{
+  while (length)
+  {
+    ssize_t count = write(fd, buffer, length);
+    if (count < 0 && errno == EINTR) { continue; }
+    if (count < 0) { return; }
+    buffer += count;
+    length -= count;
+  }
+}
+
+// Computes the CRC7 the slow way, as the remainder of dividing the message by
+// x^7 + x^3 + 1, with the bits of each byte taken least-significant first.
+// This is written differently from the library's version on purpose.
+static inline uint8_t test_crc7(const uint8_t * message, size_t length)
+{
+  uint16_t remainder = 0;
+  for (size_t i = 0; i < length * 8 + 7; i++)
+  {
+    uint8_t bit = i < length * 8 ? message[i / 8] >> (i % 8) & 1 : 0;
+    remainder = remainder << 1 | bit;
+    if (remainder & 0x80) { remainder ^= 0x89; }
+  }
+
+  // The remainder's x^6 coefficient is in bit 6, but the Tic sends it in bit
+  // 0, like the message bits.
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < 7; i++)
+  {
+    crc |= (remainder >> i & 1) << (6 - i);
+  }
+  return crc;
+}
@@ -0,0 +1,247 @@
+// Tests tic_estimator against motion profiles computed in closed form from
+// the Tic's limits, so the check does not depend on the planner model that
+// the estimator and the emulator share.  The emulated Tic is only used to get
+// a snapshot of the variables right after a target is set.
+
+#include "test_check.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+// Limits in steps per second and steps per second squared.  The deceleration
+// is different from the acceleration so that mixing them up shows.
+#define MAX_SPEED 2000.0
+#define MAX_ACCEL 4000.0
+#define MAX_DECEL 8000.0
+
+// How far the predictions may be from the ideal profile.  The estimator runs
+// the planner in 1 ms ticks, so it can start slowing down up to a tick later
+// than the ideal profile, but it must not overshoot the target.
+#define POSITION_TOLERANCE 1.5
+#define VELOCITY_TOLERANCE (2 * MAX_DECEL / 1000)
+
+// A move of a given distance in the positive direction, starting at speed v0:
+// accelerate to peak_speed, cruise, and decelerate to a stop.  When the
+// distance is too short to reach the maximum speed, the cruise time is 0 and
+// the profile is a triangle.
+typedef struct profile
+{
+  double v0;
+  double peak_speed;
+  double accel_time;
+  double cruise_time;
+  double decel_time;
+  double accel_distance;
+  double cruise_distance;
+} profile;
+
+static profile position_profile(double distance, double v0)
+{
+  profile p = { .v0 = v0 };
+
+  // The peak speed where the acceleration and deceleration distances add up
+  // to the whole distance.
+  double peak_squared = (2 * MAX_ACCEL * MAX_DECEL * distance +
+    MAX_DECEL * v0 * v0) / (MAX_ACCEL + MAX_DECEL);
+  p.peak_speed = fmin(sqrt(peak_squared), MAX_SPEED);
+
+  p.accel_time = (p.peak_speed - v0) / MAX_ACCEL;
+  p.accel_distance = (p.peak_speed * p.peak_speed - v0 * v0) / (2 * MAX_ACCEL);
+  double decel_distance = p.peak_speed * p.peak_speed / (2 * MAX_DECEL);
+  p.decel_time = p.peak_speed / MAX_DECEL;
+  if (p.peak_speed == MAX_SPEED)
+  {
+    p.cruise_distance = distance - p.accel_distance - decel_distance;
+    p.cruise_time = p.cruise_distance / p.peak_speed;
+  }
+  return p;
+}
+
+static void profile_at(const profile * p, double t,
+  double * position, double * velocity)
+{
+  if (t < p->accel_time)
+  {
+    *velocity = p->v0 + MAX_ACCEL * t;
+    *position = p->v0 * t + MAX_ACCEL * t * t / 2;
+    return;
+  }
+  t -= p->accel_time;
+
+  if (t < p->cruise_time)
+  {
+    *velocity = p->peak_speed;
+    *position = p->accel_distance + p->peak_speed * t;
+    return;
+  }
+  t -= p->cruise_time;
+
+  if (t > p->decel_time) { t = p->decel_time; }
+  *velocity = p->peak_speed - MAX_DECEL * t;
+  *position = p->accel_distance + p->cruise_distance +
+    p->peak_speed * t - MAX_DECEL * t * t / 2;
+}
+
+static double profile_total_time(const profile * p)
+{
+  return p->accel_time + p->cruise_time + p->decel_time;
+}
+
+// Opens an emulated Tic with our limits, ready to move.
+static tic_handle * open_tic(void)
+{
+  tic_handle * handle = NULL;
+  if (TEST_NO_ERROR(tic_handle_open_emulated(TIC_PRODUCT_T825, &handle)))
+  {
+    exit(1);
+  }
+  TEST_NO_ERROR(tic_set_max_speed(handle,
+    (uint32_t)(MAX_SPEED * TIC_SPEED_UNITS_PER_HZ)));
+  TEST_NO_ERROR(tic_set_starting_speed(handle, 0));
+  TEST_NO_ERROR(tic_set_max_accel(handle,
+    (uint32_t)(MAX_ACCEL * TIC_ACCEL_UNITS_PER_HZ2)));
+  TEST_NO_ERROR(tic_set_max_decel(handle,
+    (uint32_t)(MAX_DECEL * TIC_ACCEL_UNITS_PER_HZ2)));
+  TEST_NO_ERROR(tic_energize(handle));
+  TEST_NO_ERROR(tic_exit_safe_start(handle));
+  return handle;
+}
+
+// Reads the variables into a new estimator and returns the time of the
+// snapshot.
+static uint64_t take_snapshot(tic_handle * handle, tic_estimator * estimator,
+  tic_variables * variables)
+{
+  uint64_t start = tic_get_time_us();
+  TEST_NO_ERROR(tic_get_variables_fields(handle, variables,
+    TIC_ESTIMATOR_FIELDS, false));
+  uint64_t end = tic_get_time_us();
+  uint64_t time = start + (end - start) / 2;
+  tic_estimator_update(estimator, variables, time);
+  return time;
+}
+
+// Compares a prediction with the ideal position and velocity, which are in
+// steps and steps per second, and returns the position error.
+static double check_prediction(const char * name, tic_estimator * estimator,
+  uint64_t time, double t, double position, double velocity)
+{
+  double predicted_position, predicted_velocity;
+  TEST_CHECK(tic_estimator_predict(estimator, time,
+    &predicted_position, &predicted_velocity));
+  predicted_velocity /= TIC_SPEED_UNITS_PER_HZ;
+
+  double position_error = fabs(predicted_position - position);
+  double velocity_error = fabs(predicted_velocity - velocity);
+  if (position_error > POSITION_TOLERANCE ||
+    velocity_error > VELOCITY_TOLERANCE)
+  {
+    fprintf(stderr, "%s at %.3f s: predicted %.2f steps at %.1f steps/s, "
+      "expected %.2f steps at %.1f steps/s\n", name, t,
+      predicted_position, predicted_velocity, position, velocity);
+    test_failure_count++;
+  }
+  return position_error;
+}
+
+static void test_position_move(const char * name, int32_t target,
+  bool expect_cruise)
+{
+  tic_handle * handle = open_tic();
+  tic_estimator * estimator = NULL;
+  tic_variables * variables = NULL;
+  TEST_NO_ERROR(tic_estimator_create(&estimator));
+  TEST_NO_ERROR(tic_variables_create(&variables));
+
+  TEST_NO_ERROR(tic_set_target_position(handle, target));
+  uint64_t snapshot_time = take_snapshot(handle, estimator, variables);
+
+  // Build the ideal profile from whatever state the snapshot caught, working
+  // in the direction of the move.
+  double p0 = tic_variables_get_current_position(variables);
+  double direction = target < p0 ? -1 : 1;
+  double v0 = direction * tic_variables_get_current_velocity(variables) /
+    TIC_SPEED_UNITS_PER_HZ;
+  TEST_CHECK(v0 >= 0 && v0 < MAX_SPEED);
+  profile p = position_profile(fabs(target - p0), v0);
+  TEST_CHECK((p.peak_speed == MAX_SPEED) == expect_cruise);
+
+  double max_error = 0;
+  double end = profile_total_time(&p) + 0.2;
+  for (double t = 0; t <= end; t += 0.005)
+  {
+    double position, velocity;
+    profile_at(&p, t, &position, &velocity);
+    double error = check_prediction(name, estimator,
+      snapshot_time + (uint64_t)(t * 1000000), t,
+      p0 + direction * position, direction * velocity);
+    if (error > max_error) { max_error = error; }
+  }
+
+  // The move has to end exactly on the target.
+  double final_position;
+  tic_estimator_predict(estimator,
+    snapshot_time + (uint64_t)(end * 1000000), &final_position, NULL);
+  TEST_CHECK(final_position == target);
+
+  printf("%s: largest position error %.2f steps\n", name, max_error);
+
+  tic_variables_free(variables);
+  tic_estimator_free(estimator);
+  tic_handle_close(handle);
+}
+
+static void test_velocity_ramp(void)
+{
+  const double target = -1500;
+
+  tic_handle * handle = open_tic();
+  tic_estimator * estimator = NULL;
+  tic_variables * variables = NULL;
+  TEST_NO_ERROR(tic_estimator_create(&estimator));
+  TEST_NO_ERROR(tic_variables_create(&variables));
+
+  TEST_NO_ERROR(tic_set_target_velocity(handle,
+    (int32_t)(target * TIC_SPEED_UNITS_PER_HZ)));
+  uint64_t snapshot_time = take_snapshot(handle, estimator, variables);
+
+  double p0 = tic_variables_get_current_position(variables);
+  double v0 = -tic_variables_get_current_velocity(variables) /
+    TIC_SPEED_UNITS_PER_HZ;
+  TEST_CHECK(v0 >= 0 && v0 < -target);
+
+  // Accelerate to the target speed and keep going.
+  double ramp_time = (-target - v0) / MAX_ACCEL;
+  double max_error = 0;
+  for (double t = 0; t <= ramp_time + 1; t += 0.005)
+  {
+    double ramp = fmin(t, ramp_time);
+    double speed = v0 + MAX_ACCEL * ramp;
+    double distance = v0 * ramp + MAX_ACCEL * ramp * ramp / 2 +
+      speed * (t - ramp);
+    double error = check_prediction("velocity ramp", estimator,
+      snapshot_time + (uint64_t)(t * 1000000), t, p0 - distance, -speed);
+    if (error > max_error) { max_error = error; }
+  }
+
+  printf("velocity ramp: largest position error %.2f steps\n", max_error);
+
+  tic_variables_free(variables);
+  tic_estimator_free(estimator);
+  tic_handle_close(handle);
+}
+
+int main(void)
+{
+  test_position_move("trapezoid", 3000, true);
+  test_position_move("reverse trapezoid", -3000, true);
+  test_position_move("triangle", 300, false);
+  test_velocity_ramp();
+
+  if (test_failure_count)
+  {
+    fprintf(stderr, "%d checks failed.\n", test_failure_count);
+    return 1;
+  }
+  return 0;
+}
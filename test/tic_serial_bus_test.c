@@ -0,0 +1,305 @@
+// Tests that tic_serial_bus addresses each device correctly and matches each
+// pipelined response to its request.  Three fake Tics with different serial
+// formats share a pseudoterminal, and each one answers reads from its own
+// variables, so a response given to the wrong device shows up as a wrong
+// value.
+
+#include "test_serial_port.h"
+
+#include <pthread.h>
+
+#define DEVICE_COUNT 3
+
+typedef struct fake_device
+{
+  uint16_t device_number;
+  bool fourteen_bit;
+  bool crc_for_commands;
+  bool crc_for_responses;
+  bool seven_bit_responses;
+  uint8_t variables[256];
+} fake_device;
+
+typedef struct fake_bus
+{
+  int fd;
+  fake_device devices[DEVICE_COUNT];
+  volatile bool stop;
+
+  // The number of times the next request had already arrived while a
+  // response was being sent, which means the reads were pipelined.
+  uint32_t overlap_count;
+} fake_bus;
+
+static void write_u32(uint8_t * p, uint32_t value)
+{
+  for (uint8_t i = 0; i < 4; i++) { p[i] = value >> (8 * i) & 0xFF; }
+}
+
+static uint32_t read_u32(const uint8_t * p)
+{
+  return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// Reads one byte, waiting until the bus is stopped if necessary.
+static bool fake_bus_read_byte(fake_bus * bus, uint8_t * byte)
+{
+  while (true)
+  {
+    struct pollfd pfd = { .fd = bus->fd, .events = POLLIN };
+    int result = poll(&pfd, 1, 20);
+    if (result > 0) { return test_serial_read(bus->fd, byte, 1); }
+    if (result < 0 && errno != EINTR) { return false; }
+    if (bus->stop) { return false; }
+  }
+}
+
+// Reads one Pololu protocol frame and returns the device it was for, or NULL
+// if the frame was bad.
+static fake_device * fake_bus_read_frame(fake_bus * bus, uint8_t * frame,
+  size_t * frame_length, uint8_t * command, uint8_t * data)
+{
+  size_t length = 0;
+  if (!fake_bus_read_byte(bus, &frame[length])) { return NULL; }
+  if (frame[length++] != 0xAA)
+  {
+    fprintf(stderr, "expected 0xAA, got 0x%02X\n", frame[0]);
+    test_failure_count++;
+    return NULL;
+  }
+
+  if (!fake_bus_read_byte(bus, &frame[length])) { return NULL; }
+  uint8_t low = frame[length++];
+  fake_device * device = NULL;
+  for (size_t i = 0; i < DEVICE_COUNT; i++)
+  {
+    if ((bus->devices[i].device_number & 0x7F) == low)
+    {
+      device = &bus->devices[i];
+    }
+  }
+  if (device == NULL)
+  {
+    fprintf(stderr, "no device has a number ending in 0x%02X\n", low);
+    test_failure_count++;
+    return NULL;
+  }
+
+  if (device->fourteen_bit)
+  {
+    if (!fake_bus_read_byte(bus, &frame[length])) { return NULL; }
+    if (frame[length++] != device->device_number >> 7)
+    {
+      fprintf(stderr, "wrong upper bits for device %u\n",
+        device->device_number);
+      test_failure_count++;
+      return NULL;
+    }
+  }
+
+  if (!fake_bus_read_byte(bus, &frame[length])) { return NULL; }
+  *command = frame[length++] | 0x80;
+
+  size_t data_length;
+  if (*command == TIC_CMD_SET_TARGET_POSITION) { data_length = 5; }
+  else if (*command == TIC_CMD_GET_VARIABLE) { data_length = 2; }
+  else
+  {
+    fprintf(stderr, "unexpected command 0x%02X\n", *command);
+    test_failure_count++;
+    return NULL;
+  }
+
+  for (size_t i = 0; i < data_length; i++)
+  {
+    if (!fake_bus_read_byte(bus, &frame[length])) { return NULL; }
+    data[i] = frame[length++];
+  }
+
+  if (device->crc_for_commands)
+  {
+    uint8_t crc;
+    if (!fake_bus_read_byte(bus, &crc)) { return NULL; }
+    if (crc != test_crc7(frame, length))
+    {
+      fprintf(stderr, "wrong CRC for device %u\n", device->device_number);
+      test_failure_count++;
+    }
+    frame[length++] = crc;
+  }
+
+  *frame_length = length;
+  return device;
+}
+
+static void fake_bus_respond(fake_bus * bus, const fake_device * device,
+  const uint8_t * data)
+{
+  uint8_t offset = data[0] | (data[1] & 0x40) << 1;
+  uint8_t length = data[1] & 0x3F;
+
+  uint8_t response[32];
+  memcpy(response, device->variables + offset, length);
+  size_t response_length = length;
+  if (device->seven_bit_responses)
+  {
+    uint8_t msbs = 0;
+    for (uint8_t i = 0; i < length; i++)
+    {
+      msbs |= (response[i] >> 7) << i;
+      response[i] &= 0x7F;
+    }
+    response[response_length++] = msbs;
+  }
+  if (device->crc_for_responses && length < 14)
+  {
+    response[response_length] = test_crc7(response, response_length);
+    response_length++;
+  }
+
+  // Send the first byte, give the bus time to send its next request, and then
+  // send the rest, like a slow serial line would.
+  test_serial_write(bus->fd, response, 1);
+  usleep(2000);
+  struct pollfd pfd = { .fd = bus->fd, .events = POLLIN };
+  if (poll(&pfd, 1, 0) > 0) { bus->overlap_count++; }
+  test_serial_write(bus->fd, response + 1, response_length - 1);
+}
+
+static void * fake_bus_thread(void * arg)
+{
+  fake_bus * bus = arg;
+  while (true)
+  {
+    uint8_t frame[16], data[8], command;
+    size_t frame_length;
+    fake_device * device = fake_bus_read_frame(bus, frame, &frame_length,
+      &command, data);
+    if (device == NULL) { break; }
+
+    if (command == TIC_CMD_SET_TARGET_POSITION)
+    {
+      uint32_t value = 0;
+      for (uint8_t i = 0; i < 4; i++)
+      {
+        value |= (uint32_t)(data[1 + i] | (data[0] >> i & 1) << 7) << (8 * i);
+      }
+      write_u32(device->variables + TIC_VAR_TARGET_POSITION, value);
+    }
+    else
+    {
+      fake_bus_respond(bus, device, data);
+    }
+  }
+  return NULL;
+}
+
+static tic_settings * settings_for(const fake_device * device)
+{
+  tic_settings * settings = NULL;
+  if (TEST_NO_ERROR(tic_settings_create(&settings))) { exit(1); }
+  tic_settings_set_product(settings, TIC_PRODUCT_T825);
+  tic_settings_fill_with_defaults(settings);
+  tic_settings_set_serial_device_number_u16(settings, device->device_number);
+  tic_settings_set_serial_14bit_device_number(settings, device->fourteen_bit);
+  tic_settings_set_serial_crc_for_commands(settings, device->crc_for_commands);
+  tic_settings_set_serial_crc_for_responses(settings,
+    device->crc_for_responses);
+  tic_settings_set_serial_7bit_responses(settings,
+    device->seven_bit_responses);
+  return settings;
+}
+
+int main(void)
+{
+  static fake_bus bus = {
+    .devices = {
+      { .device_number = 5 },
+      { .device_number = 0x123, .fourteen_bit = true,
+        .crc_for_commands = true, .crc_for_responses = true },
+      { .device_number = 17, .seven_bit_responses = true,
+        .crc_for_responses = true },
+    },
+  };
+
+  // Give each device different variables, with bytes that have their
+  // most-significant bits set so the 7-bit responses have something to do.
+  for (size_t i = 0; i < DEVICE_COUNT; i++)
+  {
+    for (size_t j = 0; j < 256; j++)
+    {
+      bus.devices[i].variables[j] = (uint8_t)(0x91 * (i + 1) + 7 * j);
+    }
+  }
+
+  char port_name[64];
+  bus.fd = test_serial_open(port_name, sizeof(port_name));
+
+  tic_serial_bus * tic_bus = NULL;
+  if (TEST_NO_ERROR(tic_serial_bus_create(port_name, 9600, &tic_bus)))
+  {
+    return 1;
+  }
+
+  for (size_t i = 0; i < DEVICE_COUNT; i++)
+  {
+    tic_settings * settings = settings_for(&bus.devices[i]);
+    TEST_NO_ERROR(tic_serial_bus_add_device(tic_bus, settings, false));
+    tic_settings_free(settings);
+  }
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, fake_bus_thread, &bus);
+
+  // Queue the commands out of order, with two for one device, so each one is
+  // only right if it was framed with its own device number.
+  TEST_NO_ERROR(tic_serial_bus_queue_command(tic_bus, 1,
+    TIC_CMD_SET_TARGET_POSITION, -2000));
+  TEST_NO_ERROR(tic_serial_bus_queue_command(tic_bus, 0,
+    TIC_CMD_SET_TARGET_POSITION, 1));
+  TEST_NO_ERROR(tic_serial_bus_queue_command(tic_bus, 2,
+    TIC_CMD_SET_TARGET_POSITION, 300000));
+  TEST_NO_ERROR(tic_serial_bus_queue_command(tic_bus, 0,
+    TIC_CMD_SET_TARGET_POSITION, 1000));
+
+  tic_variables * variables[DEVICE_COUNT] = { NULL };
+  for (size_t i = 0; i < DEVICE_COUNT; i++)
+  {
+    TEST_NO_ERROR(tic_variables_create(&variables[i]));
+  }
+
+  const uint32_t fields = TIC_VARIABLES_FIELD_TARGET_POSITION |
+    TIC_VARIABLES_FIELD_CURRENT_POSITION | TIC_VARIABLES_FIELD_UP_TIME;
+  TEST_NO_ERROR(tic_serial_bus_get_variables(tic_bus, variables, fields,
+    false));
+
+  const int32_t targets[DEVICE_COUNT] = { 1000, -2000, 300000 };
+  for (size_t i = 0; i < DEVICE_COUNT; i++)
+  {
+    const uint8_t * vars = bus.devices[i].variables;
+    TEST_CHECK(tic_variables_get_target_position(variables[i]) == targets[i]);
+    TEST_CHECK(tic_variables_get_current_position(variables[i]) ==
+      (int32_t)read_u32(vars + TIC_VAR_CURRENT_POSITION));
+    TEST_CHECK(tic_variables_get_up_time(variables[i]) ==
+      read_u32(vars + TIC_VAR_UP_TIME));
+  }
+
+  TEST_CHECK(bus.overlap_count > 0);
+
+  bus.stop = true;
+  pthread_join(thread, NULL);
+
+  for (size_t i = 0; i < DEVICE_COUNT; i++)
+  {
+    tic_variables_free(variables[i]);
+  }
+  tic_serial_bus_free(tic_bus);
+  close(bus.fd);
+
+  if (test_failure_count)
+  {
+    fprintf(stderr, "%d checks failed.\n", test_failure_count);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,216 @@
+// Tests the framing of serial commands and responses in tic_serial.c by
+// opening a handle on a pseudoterminal and answering it with frames encoded
+// by hand, following the serial command encoding in the Tic user's guide.
+
+#include "test_serial_port.h"
+
+#include <pthread.h>
+
+// One request that the device side expects, and what it sends back.
+typedef struct exchange
+{
+  const char * name;
+  uint8_t request[16];
+  size_t request_length;
+  uint8_t response[16];
+  size_t response_length;
+} exchange;
+
+typedef struct fake_tic
+{
+  int fd;
+  const exchange * exchanges;
+  size_t exchange_count;
+} fake_tic;
+
+static void * fake_tic_thread(void * arg)
+{
+  fake_tic * tic = arg;
+  for (size_t i = 0; i < tic->exchange_count; i++)
+  {
+    const exchange * ex = &tic->exchanges[i];
+    uint8_t request[16];
+    if (!test_serial_read(tic->fd, request, ex->request_length))
+    {
+      fprintf(stderr, "%s: the request did not arrive\n", ex->name);
+      test_failure_count++;
+      return NULL;
+    }
+    if (memcmp(request, ex->request, ex->request_length))
+    {
+      fprintf(stderr, "%s: wrong request:", ex->name);
+      for (size_t j = 0; j < ex->request_length; j++)
+      {
+        fprintf(stderr, " %02X", request[j]);
+      }
+      fprintf(stderr, "\n");
+      test_failure_count++;
+    }
+    test_serial_write(tic->fd, ex->response, ex->response_length);
+  }
+  return NULL;
+}
+
+// Opens a handle with the specified flags, runs the exchanges while calling
+// the specified function, and closes the handle.
+static void run_exchanges(uint16_t device_number, uint32_t flags,
+  const exchange * exchanges, size_t exchange_count,
+  void (*function)(tic_handle *))
+{
+  char port_name[64];
+  fake_tic tic = { 0 };
+  tic.fd = test_serial_open(port_name, sizeof(port_name));
+  tic.exchanges = exchanges;
+  tic.exchange_count = exchange_count;
+
+  tic_handle * handle = NULL;
+  if (TEST_NO_ERROR(tic_handle_open_serial(port_name, 9600, TIC_PRODUCT_T825,
+    device_number, flags, &handle)))
+  {
+    close(tic.fd);
+    return;
+  }
+
+  pthread_t thread;
+  pthread_create(&thread, NULL, fake_tic_thread, &tic);
+  function(handle);
+  pthread_join(thread, NULL);
+
+  tic_handle_close(handle);
+  close(tic.fd);
+}
+
+static void set_target_200(tic_handle * handle)
+{
+  TEST_NO_ERROR(tic_set_target_position(handle, 200));
+}
+
+static void set_target_minus_1000(tic_handle * handle)
+{
+  TEST_NO_ERROR(tic_set_target_position(handle, -1000));
+}
+
+static void exit_safe_start(tic_handle * handle)
+{
+  TEST_NO_ERROR(tic_exit_safe_start(handle));
+}
+
+static void expect_position_minus_1000(tic_handle * handle)
+{
+  tic_variables * vars = NULL;
+  if (TEST_NO_ERROR(tic_variables_create(&vars))) { return; }
+  if (!TEST_NO_ERROR(tic_get_variables_fields(handle, vars,
+    TIC_VARIABLES_FIELD_CURRENT_POSITION, false)))
+  {
+    TEST_CHECK(tic_variables_get_current_position(vars) == -1000);
+  }
+  tic_variables_free(vars);
+}
+
+static void expect_crc_error(tic_handle * handle)
+{
+  tic_variables * vars = NULL;
+  if (TEST_NO_ERROR(tic_variables_create(&vars))) { return; }
+  tic_error * error = tic_get_variables_fields(handle, vars,
+    TIC_VARIABLES_FIELD_CURRENT_POSITION, false);
+  TEST_CHECK(error != NULL);
+  TEST_CHECK(error != NULL && strstr(tic_error_get_message(error),
+    "Incorrect CRC byte") != NULL);
+  tic_error_free(error);
+  tic_variables_free(vars);
+}
+
+static void test_crc7_example(void)
+{
+  // The example from the CRC section of the Tic user's guide.
+  const uint8_t message[] = { 0x83, 0x01 };
+  TEST_CHECK(test_crc7(message, sizeof(message)) == 0x17);
+}
+
+static void test_pololu_protocol(void)
+{
+  // Set target position 200 (0x000000C8) for device 14, with a CRC.  The
+  // most-significant bit of the first data byte moves into the byte after
+  // the command.
+  static const exchange exchanges[] = {
+    { "Pololu protocol with CRC",
+      { 0xAA, 0x0E, 0x60, 0x01, 0x48, 0x00, 0x00, 0x00, 0x0A }, 9,
+      { 0 }, 0 },
+  };
+  TEST_CHECK(test_crc7(exchanges[0].request, 8) == 0x0A);
+  run_exchanges(14, TIC_SERIAL_FLAG_CRC_FOR_COMMANDS,
+    exchanges, 1, set_target_200);
+}
+
+static void test_14bit_device_number(void)
+{
+  // Exit safe start for device 0x1234: the low 7 bits, then the high 7 bits.
+  static const exchange exchanges[] = {
+    { "14-bit device number", { 0xAA, 0x34, 0x24, 0x03 }, 4, { 0 }, 0 },
+  };
+  run_exchanges(0x1234, TIC_SERIAL_FLAG_14BIT_DEVICE_NUMBER,
+    exchanges, 1, exit_safe_start);
+}
+
+static void test_compact_protocol(void)
+{
+  // Set target position -1000 (0xFFFFFC18).
+  static const exchange exchanges[] = {
+    { "compact protocol", { 0xE0, 0x0E, 0x18, 0x7C, 0x7F, 0x7F }, 6, { 0 }, 0 },
+  };
+  run_exchanges(14, TIC_SERIAL_FLAG_COMPACT_PROTOCOL,
+    exchanges, 1, set_target_minus_1000);
+
+  static const exchange crc_exchanges[] = {
+    { "compact protocol with CRC", { 0x83, 0x1A }, 2, { 0 }, 0 },
+  };
+  run_exchanges(14, TIC_SERIAL_FLAG_COMPACT_PROTOCOL |
+    TIC_SERIAL_FLAG_CRC_FOR_COMMANDS, crc_exchanges, 1, exit_safe_start);
+}
+
+static void test_responses(void)
+{
+  // Get variable for the current position (offset 0x22, 4 bytes), which is
+  // -1000 (0xFFFFFC18).
+  static const exchange exchanges[] = {
+    { "8-bit response", { 0xA1, 0x22, 0x04 }, 3,
+      { 0x18, 0xFC, 0xFF, 0xFF }, 4 },
+  };
+  run_exchanges(14, TIC_SERIAL_FLAG_COMPACT_PROTOCOL,
+    exchanges, 1, expect_position_minus_1000);
+
+  // With 7-bit responses, the most-significant bits of the data bytes come in
+  // an extra byte, bit 0 for the first data byte.  The CRC covers that byte.
+  static const exchange seven_bit_exchanges[] = {
+    { "7-bit response with CRC", { 0xA1, 0x22, 0x04 }, 3,
+      { 0x18, 0x7C, 0x7F, 0x7F, 0x0E, 0x6A }, 6 },
+  };
+  TEST_CHECK(test_crc7(seven_bit_exchanges[0].response, 5) == 0x6A);
+  run_exchanges(14, TIC_SERIAL_FLAG_COMPACT_PROTOCOL |
+    TIC_SERIAL_FLAG_7BIT_RESPONSES | TIC_SERIAL_FLAG_CRC_FOR_RESPONSES,
+    seven_bit_exchanges, 1, expect_position_minus_1000);
+
+  static const exchange bad_crc_exchanges[] = {
+    { "response with a bad CRC", { 0xA1, 0x22, 0x04 }, 3,
+      { 0x18, 0x7C, 0x7F, 0x7F, 0x0E, 0x6B }, 6 },
+  };
+  run_exchanges(14, TIC_SERIAL_FLAG_COMPACT_PROTOCOL |
+    TIC_SERIAL_FLAG_7BIT_RESPONSES | TIC_SERIAL_FLAG_CRC_FOR_RESPONSES,
+    bad_crc_exchanges, 1, expect_crc_error);
+}
+
+int main(void)
+{
+  test_crc7_example();
+  test_pololu_protocol();
+  test_14bit_device_number();
+  test_compact_protocol();
+  test_responses();
+
+  if (test_failure_count)
+  {
+    fprintf(stderr, "%d checks failed.\n", test_failure_count);
+    return 1;
+  }
+  return 0;
+}